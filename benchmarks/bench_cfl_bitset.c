@@ -0,0 +1,82 @@
+/*
+ * Intersecting two random bit sets bit by bit and word by word, and scanning
+ * the set bits of the result.
+ *
+ * Usage: bench_cfl_bitset [bits] [repetitions]
+ */
+#include "cfl_bench.h"
+
+#include "cfl_bitset.h"
+
+int main(int argc, char **argv) {
+  long bits = cfl_bench_arg(argc, argv, 1, 16000000);
+  long repetitions = cfl_bench_arg(argc, argv, 2, 5);
+  CFL_BITSETP set1 = cfl_bitset_new((CFL_UINT64)bits);
+  CFL_BITSETP set2 = cfl_bitset_new((CFL_UINT64)bits);
+  CFL_BITSETP result = cfl_bitset_new((CFL_UINT64)bits);
+  CFL_UINT64 seed = 1;
+  CFL_UINT64 expected = 0;
+  CFL_UINT64 count;
+  CFL_INT64 pos;
+  double start;
+  long i;
+  long r;
+
+  printf("%ld bits, %ld repetitions\n\n", bits, repetitions);
+  for (i = 0; i < bits; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    if ((seed >> 40) & 1) {
+      cfl_bitset_set(set1, (CFL_UINT32)i);
+    }
+    if ((seed >> 50) & 1) {
+      cfl_bitset_set(set2, (CFL_UINT32)i);
+    }
+  }
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    count = 0;
+    for (i = 0; i < bits; i++) {
+      if (cfl_bitset_get(set1, (CFL_UINT32)i) && cfl_bitset_get(set2, (CFL_UINT32)i)) {
+        cfl_bitset_set(result, (CFL_UINT32)i);
+        ++count;
+      }
+    }
+    expected = count;
+  }
+  cfl_bench_report("bit by bit and", (double)bits * repetitions, cfl_bench_now() - start);
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    cfl_bitset_clear(result);
+    cfl_bitset_or(result, set1);
+    cfl_bitset_and(result, set2);
+  }
+  cfl_bench_report("cfl_bitset_and", (double)bits * repetitions, cfl_bench_now() - start);
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    count = cfl_bitset_count(result);
+  }
+  cfl_bench_report("cfl_bitset_count", (double)bits * repetitions, cfl_bench_now() - start);
+  if (count != expected) {
+    printf("  ERROR: wrong count\n");
+  }
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    count = 0;
+    for (pos = cfl_bitset_nextSet(result, 0); pos >= 0; pos = cfl_bitset_nextSet(result, (CFL_UINT32)pos + 1)) {
+      ++count;
+    }
+  }
+  cfl_bench_report("cfl_bitset_nextSet scan", (double)bits * repetitions, cfl_bench_now() - start);
+  if (count != expected) {
+    printf("  ERROR: wrong scan count\n");
+  }
+
+  cfl_bitset_free(set1);
+  cfl_bitset_free(set2);
+  cfl_bitset_free(result);
+  return 0;
+}
@@ -0,0 +1,88 @@
+/*
+ * Writing and reading arrays of numbers one value at a time and with the bulk
+ * array functions, in host and big endian byte order.
+ *
+ * Usage: bench_cfl_buffer [values] [repetitions]
+ */
+#include "cfl_bench.h"
+
+#include "cfl_buffer.h"
+#include "cfl_mem.h"
+
+int main(int argc, char **argv) {
+  long count = cfl_bench_arg(argc, argv, 1, 100000);
+  long repetitions = cfl_bench_arg(argc, argv, 2, 200);
+  CFL_INT32 *ints = (CFL_INT32 *)CFL_MEM_ALLOC(count * sizeof(CFL_INT32));
+  double *doubles = (double *)CFL_MEM_ALLOC(count * sizeof(double));
+  CFL_BUFFERP buffer = cfl_buffer_new();
+  double start;
+  double total = 0;
+  long i;
+  long r;
+
+  printf("%ld values, %ld repetitions\n\n", count, repetitions);
+  for (i = 0; i < count; i++) {
+    ints[i] = (CFL_INT32)(i * 2654435761U);
+    doubles[i] = (double)i / 3.0;
+  }
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    cfl_buffer_reset(buffer);
+    for (i = 0; i < count; i++) {
+      cfl_buffer_putInt32(buffer, ints[i]);
+    }
+  }
+  cfl_bench_report("cfl_buffer_putInt32 loop", (double)count * repetitions, cfl_bench_now() - start);
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    cfl_buffer_reset(buffer);
+    cfl_buffer_putInt32Array(buffer, ints, (CFL_UINT32)count);
+  }
+  cfl_bench_report("cfl_buffer_putInt32Array", (double)count * repetitions, cfl_bench_now() - start);
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    cfl_buffer_reset(buffer);
+    for (i = 0; i < count; i++) {
+      cfl_buffer_putInt32BE(buffer, ints[i]);
+    }
+  }
+  cfl_bench_report("cfl_buffer_putInt32BE loop", (double)count * repetitions, cfl_bench_now() - start);
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    cfl_buffer_reset(buffer);
+    cfl_buffer_putInt32ArrayBE(buffer, ints, (CFL_UINT32)count);
+  }
+  cfl_bench_report("cfl_buffer_putInt32ArrayBE", (double)count * repetitions, cfl_bench_now() - start);
+
+  cfl_buffer_reset(buffer);
+  cfl_buffer_putDoubleArrayBE(buffer, doubles, (CFL_UINT32)count);
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    cfl_buffer_rewind(buffer);
+    for (i = 0; i < count; i++) {
+      doubles[i] = cfl_buffer_getDoubleBE(buffer);
+    }
+    total += doubles[count - 1];
+  }
+  cfl_bench_report("cfl_buffer_getDoubleBE loop", (double)count * repetitions, cfl_bench_now() - start);
+
+  start = cfl_bench_now();
+  for (r = 0; r < repetitions; r++) {
+    cfl_buffer_rewind(buffer);
+    cfl_buffer_getDoubleArrayBE(buffer, doubles, (CFL_UINT32)count);
+    total -= doubles[count - 1];
+  }
+  cfl_bench_report("cfl_buffer_getDoubleArrayBE", (double)count * repetitions, cfl_bench_now() - start);
+  if (total != 0) {
+    printf("  ERROR: wrong values\n");
+  }
+
+  cfl_buffer_free(buffer);
+  CFL_MEM_FREE(ints);
+  CFL_MEM_FREE(doubles);
+  return 0;
+}
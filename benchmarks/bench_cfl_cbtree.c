@@ -0,0 +1,141 @@
+/*
+ * Lookups running in parallel with a thread inserting new keys, comparing
+ * cfl_cbtree with a cfl_btree64 protected by a global lock.
+ *
+ * Usage: bench_cfl_cbtree [readers] [preloaded keys] [inserted keys]
+ */
+#include "cfl_bench.h"
+
+#include "cfl_atomic.h"
+#include "cfl_btree64.h"
+#include "cfl_cbtree.h"
+#include "cfl_lock.h"
+#include "cfl_thread.h"
+
+#define MAX_READERS 64
+
+typedef struct {
+  CFL_BOOL concurrent;
+  CFL_CBTREEP cbtree;
+  CFL_BTREE64P btree;
+  CFL_LOCKP lock;
+  long preloaded;
+  long inserted;
+  CFL_BOOL stop;
+} BENCH_TREE;
+
+typedef struct {
+  BENCH_TREE *tree;
+  CFL_UINT64 seed;
+  long lookups;
+  long misses;
+} READER;
+
+static void *lookup(BENCH_TREE *tree, CFL_INT64 key) {
+  void *value;
+  if (tree->concurrent) {
+    return cfl_cbtree_search(tree->cbtree, key);
+  }
+  cfl_lock_acquire(tree->lock);
+  value = cfl_btree64_search(tree->btree, key);
+  cfl_lock_release(tree->lock);
+  return value;
+}
+
+static void insert(BENCH_TREE *tree, CFL_INT64 key) {
+  if (tree->concurrent) {
+    cfl_cbtree_add(tree->cbtree, key, (void *)tree);
+  } else {
+    cfl_lock_acquire(tree->lock);
+    cfl_btree64_add(tree->btree, key, (void *)tree);
+    cfl_lock_release(tree->lock);
+  }
+}
+
+static void reader_func(void *param) {
+  READER *reader = (READER *)param;
+  BENCH_TREE *tree = reader->tree;
+  while (!cfl_atomic_getBoolean(&tree->stop)) {
+    int i;
+    for (i = 0; i < 256; i++) {
+      reader->seed = reader->seed * 6364136223846793005ULL + 1442695040888963407ULL;
+      // preloaded keys are the even numbers
+      if (lookup(tree, (CFL_INT64)((reader->seed >> 17) % tree->preloaded) * 2) == NULL) {
+        ++reader->misses;
+      }
+    }
+    reader->lookups += 256;
+  }
+}
+
+static void run(const char *name, BENCH_TREE *tree, long readers) {
+  CFL_THREADP threads[MAX_READERS];
+  READER args[MAX_READERS];
+  double lookups = 0;
+  double start;
+  double elapsed;
+  long misses = 0;
+  long i;
+
+  for (i = 0; i < tree->preloaded; i++) {
+    insert(tree, (CFL_INT64)i * 2);
+  }
+  tree->stop = CFL_FALSE;
+  for (i = 0; i < readers; i++) {
+    args[i].tree = tree;
+    args[i].seed = (CFL_UINT64)i + 1;
+    args[i].lookups = 0;
+    args[i].misses = 0;
+    threads[i] = cfl_thread_new(reader_func);
+    cfl_thread_start(threads[i], &args[i]);
+  }
+  start = cfl_bench_now();
+  // the writer inserts the odd keys, spread over the whole tree
+  for (i = 0; i < tree->inserted; i++) {
+    insert(tree, ((CFL_INT64)((i * 7919) % tree->preloaded) * 2) + 1 + ((CFL_INT64)(i / tree->preloaded) * 2 * tree->preloaded));
+  }
+  elapsed = cfl_bench_now() - start;
+  cfl_atomic_setBoolean(&tree->stop, CFL_TRUE);
+  for (i = 0; i < readers; i++) {
+    cfl_thread_wait(threads[i]);
+    cfl_thread_free(threads[i]);
+    lookups += args[i].lookups;
+    misses += args[i].misses;
+  }
+  printf("%s\n", name);
+  cfl_bench_report("  inserts (writer thread)", (double)tree->inserted, elapsed);
+  cfl_bench_report("  lookups (all reader threads)", lookups, elapsed);
+  if (misses > 0) {
+    printf("  ERROR: %ld lookups missed preloaded keys\n", misses);
+  }
+}
+
+int main(int argc, char **argv) {
+  long readers = cfl_bench_arg(argc, argv, 1, 4);
+  long preloaded = cfl_bench_arg(argc, argv, 2, 1000000);
+  long inserted = cfl_bench_arg(argc, argv, 3, 1000000);
+  BENCH_TREE tree;
+
+  if (readers > MAX_READERS) {
+    readers = MAX_READERS;
+  }
+  printf("%ld reader threads, %ld preloaded keys, %ld inserted keys\n\n", readers, preloaded, inserted);
+
+  tree.concurrent = CFL_FALSE;
+  tree.btree = cfl_btree64_new(0);
+  tree.lock = cfl_lock_new();
+  tree.cbtree = NULL;
+  tree.preloaded = preloaded;
+  tree.inserted = inserted;
+  run("cfl_btree64 + global lock", &tree, readers);
+  cfl_btree64_free(tree.btree, NULL);
+  cfl_lock_free(tree.lock);
+
+  tree.concurrent = CFL_TRUE;
+  tree.cbtree = cfl_cbtree_new(0);
+  tree.btree = NULL;
+  tree.lock = NULL;
+  run("cfl_cbtree (optimistic lock coupling)", &tree, readers);
+  cfl_cbtree_free(tree.cbtree, NULL);
+  return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * A FIFO and a LIFO work stack of pointers, kept at a steady size while items
+ * go through, with cfl_llist (node cache enabled) and with cfl_deque.
+ *
+ * Usage: bench_cfl_deque [operations] [queue size]
+ */
+#include "cfl_bench.h"
+
+#include "cfl_deque.h"
+#include "cfl_llist.h"
+
+int main(int argc, char **argv) {
+  long ops = cfl_bench_arg(argc, argv, 1, 20000000);
+  long size = cfl_bench_arg(argc, argv, 2, 1000);
+  CFL_LLISTP llist = cfl_llist_new((CFL_UINT32)size);
+  CFL_DEQUEP deque = cfl_deque_new(0);
+  CFL_UINT64 sum = 0;
+  CFL_UINT64 llistSum;
+  double start;
+  long i;
+
+  printf("%ld operations, %ld items queued\n\n", ops, size);
+  for (i = 0; i < size; i++) {
+    cfl_llist_addLast(llist, (void *)(size_t)(i + 1));
+    cfl_deque_addLast(deque, (void *)(size_t)(i + 1));
+  }
+
+  start = cfl_bench_now();
+  for (i = 0; i < ops; i++) {
+    void *item = cfl_llist_removeFirst(llist);
+    sum += (size_t)item;
+    cfl_llist_addLast(llist, item);
+  }
+  cfl_bench_report("cfl_llist fifo", (double)ops, cfl_bench_now() - start);
+  llistSum = sum;
+  sum = 0;
+  start = cfl_bench_now();
+  for (i = 0; i < ops; i++) {
+    void *item = cfl_deque_removeFirst(deque);
+    sum += (size_t)item;
+    cfl_deque_addLast(deque, item);
+  }
+  cfl_bench_report("cfl_deque fifo", (double)ops, cfl_bench_now() - start);
+  if (sum != llistSum) {
+    printf("  ERROR: different items\n");
+  }
+
+  start = cfl_bench_now();
+  for (i = 0; i < ops; i++) {
+    void *item = cfl_llist_removeLast(llist);
+    sum += (size_t)item;
+    cfl_llist_addLast(llist, item);
+  }
+  cfl_bench_report("cfl_llist stack", (double)ops, cfl_bench_now() - start);
+  start = cfl_bench_now();
+  for (i = 0; i < ops; i++) {
+    void *item = cfl_deque_removeLast(deque);
+    sum += (size_t)item;
+    cfl_deque_addLast(deque, item);
+  }
+  cfl_bench_report("cfl_deque stack", (double)ops, cfl_bench_now() - start);
+
+  cfl_llist_free(llist);
+  cfl_deque_free(deque);
+  return sum == 0;
+}
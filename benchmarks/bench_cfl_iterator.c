@@ -0,0 +1,89 @@
+/*
+ * Scanning lists, arrays and B-trees element by element with
+ * cfl_iterator_next and in blocks with cfl_iterator_nextBatch.
+ *
+ * Usage: bench_cfl_iterator [items] [batch size]
+ */
+#include "cfl_bench.h"
+
+#include "cfl_array.h"
+#include "cfl_btree.h"
+#include "cfl_list.h"
+
+static CFL_INT16 compare_ints(void *k1, void *k2, CFL_BOOL bExact) {
+  CFL_INT32 i1 = *(CFL_INT32 *)k1;
+  CFL_INT32 i2 = *(CFL_INT32 *)k2;
+  CFL_UNUSED(bExact);
+  return (CFL_INT16)(i1 < i2 ? -1 : (i1 > i2 ? 1 : 0));
+}
+
+static CFL_INT64 scan_next(CFL_ITERATORP it) {
+  CFL_INT64 sum = 0;
+  while (cfl_iterator_hasNext(it)) {
+    sum += *(CFL_INT32 *)cfl_iterator_next(it);
+  }
+  return sum;
+}
+
+static CFL_INT64 scan_batch(CFL_ITERATORP it, void **batch, CFL_UINT32 batchSize) {
+  CFL_INT64 sum = 0;
+  CFL_UINT32 n;
+  CFL_UINT32 i;
+  while ((n = cfl_iterator_nextBatch(it, batch, batchSize)) > 0) {
+    for (i = 0; i < n; i++) {
+      sum += *(CFL_INT32 *)batch[i];
+    }
+  }
+  return sum;
+}
+
+static void run(const char *name, CFL_ITERATORP it, CFL_ITERATORP batchIt, long count, void **batch,
+                CFL_UINT32 batchSize) {
+  char label[64];
+  CFL_INT64 sum1;
+  CFL_INT64 sum2;
+  double start;
+
+  start = cfl_bench_now();
+  sum1 = scan_next(it);
+  sprintf(label, "%s next", name);
+  cfl_bench_report(label, (double)count, cfl_bench_now() - start);
+
+  start = cfl_bench_now();
+  sum2 = scan_batch(batchIt, batch, batchSize);
+  sprintf(label, "%s nextBatch", name);
+  cfl_bench_report(label, (double)count, cfl_bench_now() - start);
+  if (sum1 != sum2) {
+    printf("  ERROR: sums differ\n");
+  }
+  cfl_iterator_free(it);
+  cfl_iterator_free(batchIt);
+}
+
+int main(int argc, char **argv) {
+  long count = cfl_bench_arg(argc, argv, 1, 5000000);
+  CFL_UINT32 batchSize = (CFL_UINT32)cfl_bench_arg(argc, argv, 2, 256);
+  CFL_ARRAYP array = cfl_array_newLen((CFL_UINT32)count, sizeof(CFL_INT32));
+  CFL_LISTP list = cfl_list_new((CFL_UINT32)count);
+  CFL_BTREEP tree = cfl_btree_new(32, compare_ints);
+  void **batch = (void **)malloc(batchSize * sizeof(void *));
+  long i;
+
+  printf("%ld items, batches of %u\n\n", count, batchSize);
+  for (i = 0; i < count; i++) {
+    CFL_INT32 *item = (CFL_INT32 *)cfl_array_get(array, (CFL_UINT32)i);
+    *item = (CFL_INT32)i;
+    cfl_list_add(list, item);
+    cfl_btree_add(tree, item);
+  }
+
+  run("array", cfl_array_iterator(array), cfl_array_iterator(array), count, batch, batchSize);
+  run("list", cfl_list_iterator(list), cfl_list_iterator(list), count, batch, batchSize);
+  run("btree", cfl_btree_iterator(tree), cfl_btree_iterator(tree), count, batch, batchSize);
+
+  free(batch);
+  cfl_btree_free(tree, NULL);
+  cfl_list_free(list);
+  cfl_array_free(array);
+  return 0;
+}
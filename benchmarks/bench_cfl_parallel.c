@@ -0,0 +1,83 @@
+/*
+ * Sorting and summing large arrays of random 32-bit integers on a single
+ * thread and on worker pools of increasing size.
+ *
+ * Usage: bench_cfl_parallel [items] [largest pool size]
+ */
+#include "cfl_bench.h"
+
+#include <string.h>
+
+#include "cfl_mem.h"
+#include "cfl_parallel.h"
+
+static int compare_ints(const void *a, const void *b) {
+  CFL_INT32 i1 = *(const CFL_INT32 *)a;
+  CFL_INT32 i2 = *(const CFL_INT32 *)b;
+  return i1 < i2 ? -1 : (i1 > i2 ? 1 : 0);
+}
+
+static void sum_item(void *partial, void *item, void *context) {
+  CFL_UNUSED(context);
+  *(CFL_INT64 *)partial += *(CFL_INT32 *)item;
+}
+
+static void add_partial(void *result, const void *partial, void *context) {
+  CFL_UNUSED(context);
+  *(CFL_INT64 *)result += *(const CFL_INT64 *)partial;
+}
+
+int main(int argc, char **argv) {
+  long count = cfl_bench_arg(argc, argv, 1, 10000000);
+  long largest = cfl_bench_arg(argc, argv, 2, (long)cfl_parallel_cpuCount());
+  CFL_ARRAYP source = cfl_array_newLen((CFL_UINT32)count, sizeof(CFL_INT32));
+  CFL_ARRAYP array = cfl_array_newLen((CFL_UINT32)count, sizeof(CFL_INT32));
+  CFL_UINT64 seed = 1;
+  CFL_INT64 expected = 0;
+  double start;
+  long threads;
+  long i;
+
+  printf("%ld items, %u processors\n\n", count, cfl_parallel_cpuCount());
+  for (i = 0; i < count; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    ((CFL_INT32 *)source->items)[i] = (CFL_INT32)(seed >> 32);
+    expected += ((CFL_INT32 *)source->items)[i];
+  }
+
+  memcpy(array->items, source->items, count * sizeof(CFL_INT32));
+  start = cfl_bench_now();
+  cfl_array_sort(array, compare_ints);
+  cfl_bench_report("cfl_array_sort", (double)count, cfl_bench_now() - start);
+
+  for (threads = 1; threads <= largest; threads *= 2) {
+    CFL_PARALLELP pool = cfl_parallel_new((CFL_UINT32)threads);
+    CFL_INT64 sum = 0;
+    char name[64];
+
+    memcpy(array->items, source->items, count * sizeof(CFL_INT32));
+    start = cfl_bench_now();
+    cfl_parallel_sortArray(pool, array, compare_ints);
+    sprintf(name, "cfl_parallel_sortArray %ld threads", threads);
+    cfl_bench_report(name, (double)count, cfl_bench_now() - start);
+    for (i = 1; i < count; i++) {
+      if (((CFL_INT32 *)array->items)[i - 1] > ((CFL_INT32 *)array->items)[i]) {
+        printf("  ERROR: not sorted\n");
+        break;
+      }
+    }
+
+    start = cfl_bench_now();
+    cfl_parallel_reduceArray(pool, source, &sum, sizeof(sum), sum_item, add_partial, NULL);
+    sprintf(name, "cfl_parallel_reduceArray %ld threads", threads);
+    cfl_bench_report(name, (double)count, cfl_bench_now() - start);
+    if (sum != expected) {
+      printf("  ERROR: wrong sum\n");
+    }
+    cfl_parallel_free(pool);
+  }
+
+  cfl_array_free(source);
+  cfl_array_free(array);
+  return 0;
+}
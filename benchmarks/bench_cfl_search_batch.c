@@ -0,0 +1,107 @@
+/*
+ * Random lookups on large trees and hash tables, comparing a loop of single
+ * searches with the batched search functions.
+ *
+ * Usage: bench_cfl_search_batch [keys] [lookups] [batch size]
+ */
+#include "cfl_bench.h"
+
+#include "cfl_btree.h"
+#include "cfl_hash.h"
+#include "cfl_mem.h"
+
+static CFL_INT16 compare_keys(void *k1, void *k2, CFL_BOOL bExact) {
+  CFL_INT64 i1 = *(CFL_INT64 *)k1;
+  CFL_INT64 i2 = *(CFL_INT64 *)k2;
+  CFL_UNUSED(bExact);
+  return (CFL_INT16)(i1 < i2 ? -1 : (i1 > i2 ? 1 : 0));
+}
+
+static CFL_UINT32 hash_key(void *k) {
+  CFL_UINT64 key = (CFL_UINT64) * (CFL_INT64 *)k;
+  return (CFL_UINT32)(key ^ (key >> 32));
+}
+
+static int equal_keys(void *k1, void *k2) {
+  return *(CFL_INT64 *)k1 == *(CFL_INT64 *)k2;
+}
+
+int main(int argc, char **argv) {
+  long keyCount = cfl_bench_arg(argc, argv, 1, 2000000);
+  long lookupCount = cfl_bench_arg(argc, argv, 2, 4000000);
+  long batchSize = cfl_bench_arg(argc, argv, 3, 64);
+  CFL_INT64 *keys = (CFL_INT64 *)CFL_MEM_ALLOC(sizeof(CFL_INT64) * keyCount);
+  CFL_INT64 *searched = (CFL_INT64 *)CFL_MEM_ALLOC(sizeof(CFL_INT64) * lookupCount);
+  void **searchKeys = (void **)CFL_MEM_ALLOC(sizeof(void *) * lookupCount);
+  void **results = (void **)CFL_MEM_ALLOC(sizeof(void *) * lookupCount);
+  CFL_BTREEP tree = cfl_btree_new(32, compare_keys);
+  CFL_HASHP hash = cfl_hash_new((CFL_UINT32)keyCount, hash_key, equal_keys, NULL);
+  CFL_UINT64 seed = 1;
+  long found = 0;
+  double start;
+  long i;
+
+  printf("%ld keys, %ld lookups, batches of %ld\n\n", keyCount, lookupCount, batchSize);
+  for (i = 0; i < keyCount; i++) {
+    keys[i] = (CFL_INT64)i * 2;
+  }
+  // insert in random order so that the keys are not laid out in memory in tree order
+  for (i = keyCount - 1; i > 0; i--) {
+    long j;
+    CFL_INT64 tmp;
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    j = (long)((seed >> 17) % (CFL_UINT64)(i + 1));
+    tmp = keys[i];
+    keys[i] = keys[j];
+    keys[j] = tmp;
+  }
+  for (i = 0; i < keyCount; i++) {
+    cfl_btree_add(tree, &keys[i]);
+    cfl_hash_insert(hash, &keys[i], &keys[i]);
+  }
+  // half of the lookups miss
+  for (i = 0; i < lookupCount; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    searched[i] = (CFL_INT64)((seed >> 17) % (CFL_UINT64)(keyCount * 2));
+    searchKeys[i] = &searched[i];
+  }
+
+  start = cfl_bench_now();
+  for (i = 0; i < lookupCount; i++) {
+    results[i] = cfl_btree_search(tree, searchKeys[i]);
+  }
+  cfl_bench_report("cfl_btree_search", (double)lookupCount, cfl_bench_now() - start);
+  start = cfl_bench_now();
+  for (i = 0; i < lookupCount; i += batchSize) {
+    cfl_btree_searchBatch(tree, &searchKeys[i], &results[i], (CFL_INT32)(lookupCount - i < batchSize ? lookupCount - i : batchSize));
+  }
+  cfl_bench_report("cfl_btree_searchBatch", (double)lookupCount, cfl_bench_now() - start);
+  for (i = 0; i < lookupCount; i++) {
+    found += results[i] != NULL;
+  }
+
+  start = cfl_bench_now();
+  for (i = 0; i < lookupCount; i++) {
+    results[i] = cfl_hash_search(hash, searchKeys[i]);
+  }
+  cfl_bench_report("cfl_hash_search", (double)lookupCount, cfl_bench_now() - start);
+  start = cfl_bench_now();
+  for (i = 0; i < lookupCount; i += batchSize) {
+    cfl_hash_searchBatch(hash, &searchKeys[i], &results[i], (CFL_UINT32)(lookupCount - i < batchSize ? lookupCount - i : batchSize));
+  }
+  cfl_bench_report("cfl_hash_searchBatch", (double)lookupCount, cfl_bench_now() - start);
+  for (i = 0; i < lookupCount; i++) {
+    found -= results[i] != NULL;
+  }
+  if (found != 0) {
+    printf("ERROR: tree and hash found different keys\n");
+  }
+
+  cfl_hash_free(hash, CFL_FALSE);
+  cfl_btree_free(tree, NULL);
+  CFL_MEM_FREE(keys);
+  CFL_MEM_FREE(searched);
+  CFL_MEM_FREE(searchKeys);
+  CFL_MEM_FREE(results);
+  return 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * Sorting random 32-bit integers and lists of pointers with qsort and with
+ * the cfl_array / cfl_list sort functions, at 1K, 1M and 10M elements.
+ * Small sizes are repeated so that every size sorts about the same number of
+ * elements in total.
+ *
+ * Usage: bench_cfl_sort [largest size]
+ */
+#include "cfl_bench.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfl_array.h"
+#include "cfl_list.h"
+#include "cfl_mem.h"
+
+static int compare_ints(const void *a, const void *b) {
+  CFL_INT32 i1 = *(const CFL_INT32 *)a;
+  CFL_INT32 i2 = *(const CFL_INT32 *)b;
+  return i1 < i2 ? -1 : (i1 > i2 ? 1 : 0);
+}
+
+static int compare_pointed_ints(const void *a, const void *b) {
+  return compare_ints(*(void *const *)a, *(void *const *)b);
+}
+
+static CFL_UINT64 pointed_int_key(void *item) {
+  // flip the sign bit so that negative values come first
+  return (CFL_UINT32)(*(CFL_INT32 *)item) ^ 0x80000000u;
+}
+
+static CFL_BOOL is_sorted(CFL_INT32 *values, CFL_UINT32 count) {
+  CFL_UINT32 i;
+  for (i = 1; i < count; i++) {
+    if (values[i - 1] > values[i]) {
+      return CFL_FALSE;
+    }
+  }
+  return CFL_TRUE;
+}
+
+#define METHOD_QSORT 0
+#define METHOD_SORT 1
+#define METHOD_STABLE 2
+#define METHOD_RADIX 3
+
+static void bench_array(const char *name, int method, CFL_INT32 *source, CFL_UINT32 size, long repeat) {
+  CFL_ARRAYP array = cfl_array_newLen(size, sizeof(CFL_INT32));
+  double elapsed = 0;
+  long r;
+
+  for (r = 0; r < repeat; r++) {
+    double start;
+    memcpy(array->items, &source[(r * size) % (size * 4)], size * sizeof(CFL_INT32));
+    start = cfl_bench_now();
+    switch (method) {
+      case METHOD_QSORT: qsort(array->items, size, sizeof(CFL_INT32), compare_ints); break;
+      case METHOD_SORT: cfl_array_sort(array, compare_ints); break;
+      case METHOD_STABLE: cfl_array_sortStable(array, compare_ints); break;
+      default: cfl_array_sortByKey(array, 0, sizeof(CFL_INT32), CFL_SORT_KEY_SIGNED); break;
+    }
+    elapsed += cfl_bench_now() - start;
+  }
+  cfl_bench_report(name, (double)size * repeat, elapsed);
+  if (!is_sorted((CFL_INT32 *)array->items, size)) {
+    printf("  ERROR: not sorted\n");
+  }
+  cfl_array_free(array);
+}
+
+static void bench_list(const char *name, int method, CFL_INT32 *source, CFL_UINT32 size, long repeat) {
+  CFL_LISTP list = cfl_list_newLen(size);
+  double elapsed = 0;
+  CFL_UINT32 i;
+  long r;
+
+  for (r = 0; r < repeat; r++) {
+    double start;
+    for (i = 0; i < size; i++) {
+      list->items[i] = &source[(r * size) % (size * 4) + i];
+    }
+    start = cfl_bench_now();
+    switch (method) {
+      case METHOD_QSORT: qsort(list->items, size, sizeof(void *), compare_pointed_ints); break;
+      case METHOD_SORT: cfl_list_sort(list, compare_pointed_ints); break;
+      case METHOD_STABLE: cfl_list_sortStable(list, compare_pointed_ints); break;
+      default: cfl_list_sortByKey(list, pointed_int_key); break;
+    }
+    elapsed += cfl_bench_now() - start;
+  }
+  cfl_bench_report(name, (double)size * repeat, elapsed);
+  for (i = 1; i < size; i++) {
+    if (*(CFL_INT32 *)list->items[i - 1] > *(CFL_INT32 *)list->items[i]) {
+      printf("  ERROR: not sorted\n");
+      break;
+    }
+  }
+  cfl_list_free(list);
+}
+
+int main(int argc, char **argv) {
+  long largest = cfl_bench_arg(argc, argv, 1, 10000000);
+  CFL_UINT32 sizes[3];
+  CFL_UINT64 seed = 1;
+  CFL_INT32 *source;
+  long total;
+  int s;
+  long i;
+
+  sizes[0] = 1000;
+  sizes[1] = 1000000;
+  sizes[2] = (CFL_UINT32)largest;
+  total = largest;
+  // random data for 4 different inputs of the largest size
+  source = (CFL_INT32 *)CFL_MEM_ALLOC(sizeof(CFL_INT32) * largest * 4);
+  for (i = 0; i < largest * 4; i++) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    source[i] = (CFL_INT32)(seed >> 32);
+  }
+  for (s = 0; s < 3; s++) {
+    CFL_UINT32 size = sizes[s];
+    long repeat = total / size > 0 ? total / size : 1;
+    if (size > (CFL_UINT32)largest || (s > 0 && size == sizes[s - 1])) {
+      continue;
+    }
+    printf("%u elements x %ld\n", size, repeat);
+    bench_array("  int32 qsort", METHOD_QSORT, source, size, repeat);
+    bench_array("  int32 cfl_array_sort", METHOD_SORT, source, size, repeat);
+    bench_array("  int32 cfl_array_sortStable", METHOD_STABLE, source, size, repeat);
+    bench_array("  int32 cfl_array_sortByKey", METHOD_RADIX, source, size, repeat);
+    bench_list("  pointers qsort", METHOD_QSORT, source, size, repeat);
+    bench_list("  pointers cfl_list_sort", METHOD_SORT, source, size, repeat);
+    bench_list("  pointers cfl_list_sortStable", METHOD_STABLE, source, size, repeat);
+    bench_list("  pointers cfl_list_sortByKey", METHOD_RADIX, source, size, repeat);
+  }
+  CFL_MEM_FREE(source);
+  return 0;
+}
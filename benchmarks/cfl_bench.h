@@ -0,0 +1,66 @@
+/**
+ * @file cfl_bench.h
+ * @brief Helpers shared by the benchmark programs.
+ *
+ * Provides a monotonic wall clock and a report line format, so that every
+ * benchmark prints comparable results without external dependencies.
+ */
+
+#ifndef CFL_BENCH_H_
+#define CFL_BENCH_H_
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/**
+ * @brief Returns a monotonic timestamp in seconds.
+ */
+static double cfl_bench_now(void) {
+#if defined(_WIN32)
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+#endif
+}
+
+/**
+ * @brief Prints the throughput of a measured operation.
+ * @param name Name of the measured case.
+ * @param operations Number of operations executed.
+ * @param seconds Elapsed wall clock time.
+ */
+static void cfl_bench_report(const char *name, double operations, double seconds) {
+  printf("%-40s %12.0f ops %9.3f s %14.0f ops/s\n", name, operations, seconds,
+         seconds > 0 ? operations / seconds : 0.0);
+}
+
+/**
+ * @brief Reads an optional positive integer argument.
+ */
+static long cfl_bench_arg(int argc, char **argv, int index, long defaultValue) {
+  if (argc > index) {
+    long value = atol(argv[index]);
+    if (value > 0) {
+      return value;
+    }
+  }
+  return defaultValue;
+}
+
+#endif
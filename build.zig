@@ -19,13 +19,22 @@ pub fn build(b: *std.Build) void {
     const c_sources = [_][]const u8{
         "cfl_array.c",
         "cfl_atomic.c",
+        "cfl_atomic_bitmap.c",
         "cfl_bitmap.c",
+        "cfl_bitset.c",
+        "cfl_bptree.c",
         "cfl_btree.c",
+        "cfl_btree64.c",
+        "cfl_btree_file.c",
         "cfl_buffer.c",
+        "cfl_buffer_chain.c",
+        "cfl_cbtree.c",
         "cfl_date.c",
+        "cfl_deque.c",
         "cfl_error.c",
         "cfl_event.c",
         "cfl_hash.c",
+        "cfl_ilist.c",
         "cfl_iterator.c",
         "cfl_list.c",
         "cfl_llist.c",
@@ -35,8 +44,11 @@ pub fn build(b: *std.Build) void {
         "cfl_map_str.c",
         "cfl_mem.c",
         "cfl_number.c",
+        "cfl_parallel.c",
         "cfl_process.c",
+        "cfl_roaring.c",
         "cfl_socket.c",
+        "cfl_sort.c",
         "cfl_sql.c",
         "cfl_str.c",
         "cfl_sync_queue.c",
@@ -78,13 +90,22 @@ pub fn build(b: *std.Build) void {
     const test_files = [_][]const u8{
         "test_cfl_array.c",
         "test_cfl_atomic.c",
+        "test_cfl_atomic_bitmap.c",
         "test_cfl_bitmap.c",
+        "test_cfl_bitset.c",
+        "test_cfl_bptree.c",
         "test_cfl_btree.c",
+        "test_cfl_btree64.c",
+        "test_cfl_btree_file.c",
         "test_cfl_buffer.c",
+        "test_cfl_buffer_chain.c",
+        "test_cfl_cbtree.c",
         "test_cfl_date.c",
+        "test_cfl_deque.c",
         "test_cfl_error.c",
         "test_cfl_event.c",
         "test_cfl_hash.c",
+        "test_cfl_ilist.c",
         "test_cfl_iterator.c",
         "test_cfl_list.c",
         "test_cfl_llist.c",
@@ -95,8 +116,11 @@ pub fn build(b: *std.Build) void {
         "test_cfl_mem.c",
         "test_cfl_number.c",
         "test_cfl_os.c",
+        "test_cfl_parallel.c",
         "test_cfl_process.c",
+        "test_cfl_roaring.c",
         "test_cfl_socket.c",
+        "test_cfl_sort.c",
         "test_cfl_sql.c",
         "test_cfl_str.c",
         "test_cfl_sync_queue.c",
@@ -123,4 +147,37 @@ pub fn build(b: *std.Build) void {
         const run_cmd = b.addRunArtifact(test_exe);
         test_step.dependOn(&run_cmd.step);
     }
+
+    // Benchmarks
+    const bench_files = [_][]const u8{
+        "bench_cfl_bitset.c",
+        "bench_cfl_buffer.c",
+        "bench_cfl_cbtree.c",
+        "bench_cfl_deque.c",
+        "bench_cfl_iterator.c",
+        "bench_cfl_parallel.c",
+        "bench_cfl_search_batch.c",
+        "bench_cfl_sort.c",
+    };
+
+    const bench_step = b.step("bench", "Build the benchmarks");
+
+    for (bench_files) |bench_file| {
+        const bench_exe = b.addExecutable(.{
+            .name = bench_file[0 .. bench_file.len - 2], // Remove .c
+            .root_module = b.createModule(.{
+                .target = target,
+                .optimize = optimize,
+            }),
+        });
+
+        bench_exe.addCSourceFile(.{ .file = b.path(b.fmt("benchmarks/{s}", .{bench_file})), .flags = &.{ "-std=c99" } });
+        bench_exe.addIncludePath(b.path("cfl-headers/src/main/headers"));
+        bench_exe.addIncludePath(b.path("benchmarks"));
+        bench_exe.linkLibrary(lib);
+        bench_exe.linkLibC();
+
+        const install_bench = b.addInstallArtifact(bench_exe, .{});
+        bench_step.dependOn(&install_bench.step);
+    }
 }
@@ -12,6 +12,7 @@
 #define CFL_ARRAY_H_
 
 #include "cfl_iterator.h"
+#include "cfl_sort.h"
 #include "cfl_types.h"
 
 
@@ -132,6 +133,78 @@ extern CFL_UINT32 cfl_array_length(CFL_ARRAYP array);
  */
 extern void cfl_array_setLength(CFL_ARRAYP array, CFL_UINT32 newLen);
 
+/**
+ * @brief Makes room for at least ulCapacity elements, so that adding up to
+ * that many elements does not reallocate.
+ * @param array Pointer to the array.
+ * @param ulCapacity Minimum capacity (number of elements).
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_array_reserve(CFL_ARRAYP array, CFL_UINT32 ulCapacity);
+
+/**
+ * @brief Reduces the capacity to the current length, releasing the unused
+ * memory.
+ * @param array Pointer to the array.
+ */
+extern void cfl_array_shrinkToFit(CFL_ARRAYP array);
+
+/**
+ * @brief Adds ulCount elements to the end of the array with a single copy.
+ * @param array Pointer to the array.
+ * @param items Pointer to ulCount contiguous elements to copy, or NULL to
+ *        leave the new elements uninitialized.
+ * @param ulCount Number of elements to add.
+ * @return Pointer to the first added element, or NULL on failure.
+ */
+extern void *cfl_array_appendN(CFL_ARRAYP array, const void *items,
+                               CFL_UINT32 ulCount);
+
+/**
+ * @brief Adds all elements of another array to the end of the array.
+ * @param array Pointer to the array.
+ * @param other Pointer to the array with the elements to add.
+ * @return CFL_TRUE on success, CFL_FALSE if the item sizes differ or memory
+ *         cannot be allocated.
+ */
+extern CFL_BOOL cfl_array_addAll(CFL_ARRAYP array, const CFL_ARRAYP other);
+
+/**
+ * @brief Inserts ulCount elements at the specified index, moving the
+ * following elements only once.
+ * @param array Pointer to the array.
+ * @param ulIndex Index at which to insert, up to the array length.
+ * @param items Pointer to ulCount contiguous elements to copy, or NULL to
+ *        leave the new elements uninitialized.
+ * @param ulCount Number of elements to insert.
+ * @return Pointer to the first inserted element, or NULL if the index is out
+ *         of bounds or memory cannot be allocated.
+ */
+extern void *cfl_array_insertRange(CFL_ARRAYP array, CFL_UINT32 ulIndex,
+                                   const void *items, CFL_UINT32 ulCount);
+
+/**
+ * @brief Deletes ulCount elements starting at the specified index, moving the
+ * following elements only once.
+ * @param array Pointer to the array.
+ * @param ulIndex Index of the first element to delete.
+ * @param ulCount Number of elements to delete, limited to the end of the array.
+ */
+extern void cfl_array_deleteRange(CFL_ARRAYP array, CFL_UINT32 ulIndex,
+                                  CFL_UINT32 ulCount);
+
+/**
+ * @brief Sets the length of the array, optionally without zeroing the new
+ * elements.
+ * @param array Pointer to the array.
+ * @param newLen New length for the array.
+ * @param bZeroFill If CFL_TRUE, new elements are zeroed as in
+ *        cfl_array_setLength. If CFL_FALSE they are left uninitialized.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_array_resize(CFL_ARRAYP array, CFL_UINT32 newLen,
+                                 CFL_BOOL bZeroFill);
+
 /**
  * @brief Creates a copy of an array.
  * @param other Pointer to the array to clone.
@@ -146,6 +219,46 @@ extern CFL_ARRAYP cfl_array_clone(const CFL_ARRAYP other);
  */
 extern CFL_ITERATORP cfl_array_iterator(CFL_ARRAYP array);
 
+/**
+ * @brief Initializes an iterator for the array in caller-provided storage,
+ * without allocating memory. Release it with cfl_iterator_dispose.
+ * @param it Iterator storage, usually the iterator of a CFL_ITERATOR_BUFFER.
+ * @param array Pointer to the array.
+ * @return The initialized iterator.
+ */
+extern CFL_ITERATORP cfl_array_iteratorInit(CFL_ITERATORP it, CFL_ARRAYP array);
+
+/**
+ * @brief Sorts the elements with pattern-defeating quicksort. Not stable.
+ * @param array Pointer to the array.
+ * @param cmp Comparison function receiving pointers to two elements.
+ */
+extern void cfl_array_sort(CFL_ARRAYP array, CFL_SORT_CMP_FUNC cmp);
+
+/**
+ * @brief Sorts the elements with merge sort, keeping the order of equal
+ * elements.
+ * @param array Pointer to the array.
+ * @param cmp Comparison function receiving pointers to two elements.
+ * @return CFL_TRUE if sorted, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_array_sortStable(CFL_ARRAYP array, CFL_SORT_CMP_FUNC cmp);
+
+/**
+ * @brief Sorts the elements by an integer or fixed width key stored inside
+ * them, with a stable radix sort.
+ * @param array Pointer to the array.
+ * @param keyOffset Offset of the key inside each element.
+ * @param keySize Size of the key in bytes.
+ * @param keyType How the key bytes are ordered.
+ * @return CFL_TRUE if sorted, CFL_FALSE if the key is invalid or memory cannot
+ *         be allocated.
+ * @see cfl_sort_radix
+ */
+extern CFL_BOOL cfl_array_sortByKey(CFL_ARRAYP array, CFL_UINT32 keyOffset,
+                                    CFL_UINT32 keySize,
+                                    CFL_SORT_KEY_TYPE keyType);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,122 @@
+/**
+ * @file cfl_atomic_bitmap.h
+ * @brief Lock-free bitmap for allocating slots shared by threads.
+ *
+ * This module provides a bitmap whose bits can be acquired and released by
+ * several threads at the same time without a lock. Each bit stands for a
+ * slot: acquiring sets a clear bit with an atomic OR and fails over to the
+ * next clear bit if another thread set it first.
+ *
+ * The search for a clear bit starts at a hint owned by the caller, usually a
+ * variable local to each thread. Threads starting at different words rarely
+ * compete for the same word, and a thread keeps reusing the area where it
+ * last found a free slot.
+ */
+
+#ifndef CFL_ATOMIC_BITMAP_H_
+
+#define CFL_ATOMIC_BITMAP_H_
+
+#include "cfl_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Atomic word of the bitmap, 32 bits where 64-bit atomics are not available */
+#if defined(CFL_OS_WINDOWS) && !defined(CFL_ARCH_64)
+typedef CFL_INT32 CFL_ATOMIC_BITMAP_WORD;
+#else
+typedef CFL_INT64 CFL_ATOMIC_BITMAP_WORD;
+#endif
+
+/**
+ * @brief Atomic bitmap structure.
+ */
+typedef struct _CFL_ATOMIC_BITMAP {
+  CFL_ATOMIC_BITMAP_WORD *words; /**< Bits, updated only with atomic operations */
+  CFL_UINT32 numBits;            /**< Number of bits in the bitmap */
+  CFL_UINT32 wordCount;          /**< Number of words */
+  CFL_BOOL allocated;            /**< Whether the structure was dynamically allocated */
+} CFL_ATOMIC_BITMAP, *CFL_ATOMIC_BITMAPP;
+
+/**
+ * @brief Initializes an atomic bitmap with all bits clear.
+ * @param bitmap Pointer to the bitmap structure to initialize.
+ * @param numBits Number of bits.
+ * @return CFL_TRUE on success, CFL_FALSE if the words cannot be allocated.
+ */
+extern CFL_BOOL cfl_atomic_bitmap_init(CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 numBits);
+
+/**
+ * @brief Creates a new atomic bitmap with all bits clear.
+ * @param numBits Number of bits.
+ * @return Pointer to the new bitmap, or NULL if allocation fails.
+ */
+extern CFL_ATOMIC_BITMAPP cfl_atomic_bitmap_new(CFL_UINT32 numBits);
+
+/**
+ * @brief Frees the memory used by an atomic bitmap. No other thread may be
+ * using it.
+ * @param bitmap Pointer to the bitmap.
+ */
+extern void cfl_atomic_bitmap_free(CFL_ATOMIC_BITMAPP bitmap);
+
+/**
+ * @brief Returns the number of bits in the bitmap.
+ * @param bitmap Pointer to the bitmap.
+ * @return Number of bits.
+ */
+extern CFL_UINT32 cfl_atomic_bitmap_size(const CFL_ATOMIC_BITMAPP bitmap);
+
+/**
+ * @brief Sets the first clear bit found from a hint, wrapping around to the
+ * beginning of the bitmap.
+ * @param bitmap Pointer to the bitmap.
+ * @param hint Pointer to the position where the search starts, updated to
+ *        the acquired position. It should be private to the calling thread;
+ *        NULL starts the search at 0.
+ * @return Position of the acquired bit, or -1 if all bits are set.
+ */
+extern CFL_INT64 cfl_atomic_bitmap_tryAcquireFirstClear(CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 *hint);
+
+/**
+ * @brief Sets a given bit if it is clear.
+ * @param bitmap Pointer to the bitmap.
+ * @param pos Position of the bit.
+ * @return CFL_TRUE if the bit was clear and is now owned by the caller,
+ *         CFL_FALSE if it was already set or is out of the bitmap.
+ */
+extern CFL_BOOL cfl_atomic_bitmap_tryAcquire(CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 pos);
+
+/**
+ * @brief Clears a bit acquired before.
+ * @param bitmap Pointer to the bitmap.
+ * @param pos Position of the bit.
+ * @return CFL_TRUE if the bit was set, CFL_FALSE if it was already clear or
+ *         is out of the bitmap.
+ */
+extern CFL_BOOL cfl_atomic_bitmap_release(CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 pos);
+
+/**
+ * @brief Gets the value of a bit.
+ * @param bitmap Pointer to the bitmap.
+ * @param pos Position of the bit.
+ * @return CFL_TRUE if the bit is set, CFL_FALSE if it is clear or out of the
+ *         bitmap.
+ */
+extern CFL_BOOL cfl_atomic_bitmap_get(const CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 pos);
+
+/**
+ * @brief Counts the set bits. While other threads acquire or release bits,
+ * the result is only an approximation.
+ * @param bitmap Pointer to the bitmap.
+ * @return Number of bits set to 1.
+ */
+extern CFL_UINT32 cfl_atomic_bitmap_count(const CFL_ATOMIC_BITMAPP bitmap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+/**
+ * @file cfl_bitset.h
+ * @brief Large bit set stored in 64-bit words.
+ *
+ * This module provides a fixed-size set of bits addressed by 32-bit
+ * positions, for up to 2^32 bits. Bits are kept in 64-bit words, so counting,
+ * searching and combining bit sets work on 64 bits at a time. Bits beyond
+ * the size of the set are always zero.
+ */
+
+#ifndef CFL_BITSET_H_
+
+#define CFL_BITSET_H_
+
+#include "cfl_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Largest number of bits in a bit set */
+#define CFL_BITSET_MAX_BITS 0x100000000ULL
+
+/** @brief Called by cfl_bitset_forEach for each set bit, returns CFL_FALSE to stop */
+typedef CFL_BOOL (*CFL_BITSET_FUNC)(CFL_UINT32 pos, void *context);
+
+/**
+ * @brief Bit set structure.
+ */
+typedef struct _CFL_BITSET {
+  CFL_UINT64 *words;    /**< Bits, position 0 is the lowest bit of the first word */
+  CFL_UINT64 numBits;   /**< Number of bits in the set */
+  CFL_UINT32 wordCount; /**< Number of words */
+  CFL_BOOL allocated;   /**< Whether the structure was dynamically allocated */
+} CFL_BITSET, *CFL_BITSETP;
+
+/**
+ * @brief Initializes a bit set structure with all bits clear.
+ * @param bitset Pointer to the bit set structure to initialize.
+ * @param numBits Number of bits, up to CFL_BITSET_MAX_BITS.
+ * @return CFL_TRUE on success, CFL_FALSE if the size is too large or the
+ *         words cannot be allocated.
+ */
+extern CFL_BOOL cfl_bitset_init(CFL_BITSETP bitset, CFL_UINT64 numBits);
+
+/**
+ * @brief Creates a new bit set with all bits clear.
+ * @param numBits Number of bits, up to CFL_BITSET_MAX_BITS.
+ * @return Pointer to the new bit set, or NULL on failure.
+ */
+extern CFL_BITSETP cfl_bitset_new(CFL_UINT64 numBits);
+
+/**
+ * @brief Frees the memory used by a bit set.
+ * @param bitset Pointer to the bit set.
+ */
+extern void cfl_bitset_free(CFL_BITSETP bitset);
+
+/**
+ * @brief Creates a copy of a bit set.
+ * @param bitset Pointer to the bit set to clone.
+ * @return Pointer to the new bit set, or NULL if allocation fails.
+ */
+extern CFL_BITSETP cfl_bitset_clone(const CFL_BITSETP bitset);
+
+/**
+ * @brief Changes the number of bits. New bits are clear.
+ * @param bitset Pointer to the bit set.
+ * @param numBits New number of bits, up to CFL_BITSET_MAX_BITS.
+ * @return CFL_TRUE on success, CFL_FALSE if the words cannot be reallocated,
+ *         in which case the bit set is unchanged.
+ */
+extern CFL_BOOL cfl_bitset_resize(CFL_BITSETP bitset, CFL_UINT64 numBits);
+
+/**
+ * @brief Returns the number of bits in the set.
+ * @param bitset Pointer to the bit set.
+ * @return Number of bits.
+ */
+extern CFL_UINT64 cfl_bitset_size(const CFL_BITSETP bitset);
+
+/**
+ * @brief Sets a bit to 1. Positions out of the set are ignored.
+ * @param bitset Pointer to the bit set.
+ * @param pos Position of the bit.
+ */
+extern void cfl_bitset_set(CFL_BITSETP bitset, CFL_UINT32 pos);
+
+/**
+ * @brief Resets a bit to 0. Positions out of the set are ignored.
+ * @param bitset Pointer to the bit set.
+ * @param pos Position of the bit.
+ */
+extern void cfl_bitset_reset(CFL_BITSETP bitset, CFL_UINT32 pos);
+
+/**
+ * @brief Gets the value of a bit.
+ * @param bitset Pointer to the bit set.
+ * @param pos Position of the bit.
+ * @return CFL_TRUE if the bit is set, CFL_FALSE if it is clear or out of the
+ *         set.
+ */
+extern CFL_BOOL cfl_bitset_get(const CFL_BITSETP bitset, CFL_UINT32 pos);
+
+/**
+ * @brief Clears all bits.
+ * @param bitset Pointer to the bit set.
+ */
+extern void cfl_bitset_clear(CFL_BITSETP bitset);
+
+/**
+ * @brief Sets all bits.
+ * @param bitset Pointer to the bit set.
+ */
+extern void cfl_bitset_fill(CFL_BITSETP bitset);
+
+/**
+ * @brief Counts the set bits.
+ * @param bitset Pointer to the bit set.
+ * @return Number of bits set to 1.
+ */
+extern CFL_UINT64 cfl_bitset_count(const CFL_BITSETP bitset);
+
+/**
+ * @brief Finds the first set bit at or after a position.
+ * @param bitset Pointer to the bit set.
+ * @param from Position where the search starts.
+ * @return Position of the bit, or -1 if there is none.
+ */
+extern CFL_INT64 cfl_bitset_nextSet(const CFL_BITSETP bitset, CFL_UINT32 from);
+
+/**
+ * @brief Finds the first clear bit at or after a position.
+ * @param bitset Pointer to the bit set.
+ * @param from Position where the search starts.
+ * @return Position of the bit, or -1 if there is none.
+ */
+extern CFL_INT64 cfl_bitset_nextClear(const CFL_BITSETP bitset, CFL_UINT32 from);
+
+/**
+ * @brief Calls a function for each set bit, in increasing position order.
+ * @param bitset Pointer to the bit set.
+ * @param func Function called with the position of each set bit.
+ * @param context Pointer passed to the function.
+ * @return CFL_TRUE if all bits were visited, CFL_FALSE if stopped by func.
+ */
+extern CFL_BOOL cfl_bitset_forEach(const CFL_BITSETP bitset, CFL_BITSET_FUNC func, void *context);
+
+/**
+ * @brief Stores the positions of the set bits starting at a position.
+ * @param bitset Pointer to the bit set.
+ * @param from Position where the search starts.
+ * @param out Array receiving up to maxCount positions.
+ * @param maxCount Maximum number of positions to store.
+ * @return Number of positions stored.
+ */
+extern CFL_UINT32 cfl_bitset_toArray(const CFL_BITSETP bitset, CFL_UINT32 from, CFL_UINT32 *out,
+                                     CFL_UINT32 maxCount);
+
+/**
+ * @brief Keeps only the bits also set in another bit set. Bits beyond the
+ * size of the other set are cleared.
+ * @param bitset Pointer to the bit set to modify.
+ * @param other Pointer to the other bit set.
+ */
+extern void cfl_bitset_and(CFL_BITSETP bitset, const CFL_BITSETP other);
+
+/**
+ * @brief Sets the bits set in another bit set. Bits of the other set beyond
+ * the size of the modified set are ignored.
+ * @param bitset Pointer to the bit set to modify.
+ * @param other Pointer to the other bit set.
+ */
+extern void cfl_bitset_or(CFL_BITSETP bitset, const CFL_BITSETP other);
+
+/**
+ * @brief Flips the bits set in another bit set. Bits of the other set beyond
+ * the size of the modified set are ignored.
+ * @param bitset Pointer to the bit set to modify.
+ * @param other Pointer to the other bit set.
+ */
+extern void cfl_bitset_xor(CFL_BITSETP bitset, const CFL_BITSETP other);
+
+/**
+ * @brief Clears the bits set in another bit set.
+ * @param bitset Pointer to the bit set to modify.
+ * @param other Pointer to the other bit set.
+ */
+extern void cfl_bitset_andNot(CFL_BITSETP bitset, const CFL_BITSETP other);
+
+/**
+ * @brief Counts the bits set in both bit sets without modifying them.
+ * @param bitset1 Pointer to the first bit set.
+ * @param bitset2 Pointer to the second bit set.
+ * @return Number of positions set in both.
+ */
+extern CFL_UINT64 cfl_bitset_andCount(const CFL_BITSETP bitset1, const CFL_BITSETP bitset2);
+
+/**
+ * @brief Checks if two bit sets have the same size and bits.
+ * @param bitset1 Pointer to the first bit set.
+ * @param bitset2 Pointer to the second bit set.
+ * @return CFL_TRUE if the bit sets are equal.
+ */
+extern CFL_BOOL cfl_bitset_equals(const CFL_BITSETP bitset1, const CFL_BITSETP bitset2);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ * @file cfl_bptree.h
+ * @brief B+tree data structure implementation.
+ *
+ * This module provides a B+tree variant of cfl_btree. All keys live in the
+ * leaf nodes, which are chained by next/previous pointers, while the internal
+ * nodes only hold separator keys used for routing. Searches are O(log n) and
+ * range or prefix ("Like") scans descend the tree once and then walk the leaf
+ * chain sequentially.
+ *
+ * Keys are stored by reference and compared with the same comparison
+ * function used by cfl_btree (BTREE_CMP_VALUE_FUNC). Partial comparisons
+ * (bExact == CFL_FALSE) must be consistent with the exact order, so that all
+ * keys matching a prefix are contiguous in the tree.
+ */
+
+#ifndef _CFL_BPTREE_H_
+
+#define _CFL_BPTREE_H_
+
+#include "cfl_btree.h"
+#include "cfl_iterator.h"
+#include "cfl_types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+struct _CFL_BPTREE;
+typedef struct _CFL_BPTREE CFL_BPTREE;
+typedef CFL_BPTREE *CFL_BPTREEP;
+
+struct _CFL_BPTREE_NODE;
+typedef struct _CFL_BPTREE_NODE CFL_BPTREE_NODE;
+typedef CFL_BPTREE_NODE *CFL_BPTREE_NODEP;
+
+/**
+ * @brief B+tree node structure.
+ */
+struct _CFL_BPTREE_NODE {
+  CFL_BPTREEP pTree;          /**< Pointer to the tree this node belongs to */
+  CFL_INT32 lNumKeys;         /**< Number of keys in this node */
+  CFL_BOOL bIsLeafNode;       /**< Whether this node is a leaf */
+  CFL_BPTREE_NODEP pPrevLeaf; /**< Previous leaf in key order (leaves only) */
+  CFL_BPTREE_NODEP pNextLeaf; /**< Next leaf in key order (leaves only) */
+  void *pPointers[];          /**< Keys followed by the children pointers */
+};
+
+/**
+ * @brief B+tree structure.
+ */
+struct _CFL_BPTREE {
+  CFL_BPTREE_NODEP pRoot;              /**< Root node of the tree */
+  CFL_BPTREE_NODEP pFirstLeaf;         /**< Leaf with the smallest keys */
+  CFL_BPTREE_NODEP pLastLeaf;          /**< Leaf with the greatest keys */
+  BTREE_CMP_VALUE_FUNC pCompareValues; /**< Comparison function */
+  CFL_INT32 lKeys;                     /**< Maximum keys per node */
+  CFL_INT32 lCount;                    /**< Number of keys in the tree */
+};
+
+/**
+ * @brief Creates a new B+tree.
+ * @param lKeys Maximum number of keys per node (at least 2).
+ * @param pCompareValues Function to compare keys.
+ * @return Pointer to the new B+tree, or NULL if allocation fails.
+ */
+extern CFL_BPTREEP cfl_bptree_new(CFL_INT32 lKeys,
+                                  BTREE_CMP_VALUE_FUNC pCompareValues);
+
+/**
+ * @brief Frees a B+tree and all its nodes.
+ * @param pTree Pointer to the B+tree.
+ * @param pFreeKey Optional function to free each key (can be NULL).
+ */
+extern void cfl_bptree_free(CFL_BPTREEP pTree, BTREE_FREE_KEY_FUNC pFreeKey);
+
+/**
+ * @brief Adds a key to the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @param pKey Pointer to the key to add.
+ * @return CFL_TRUE if added, CFL_FALSE if key already exists or memory cannot
+ *         be allocated, in which case the tree is unchanged.
+ */
+extern CFL_BOOL cfl_bptree_add(CFL_BPTREEP pTree, void *pKey);
+
+/**
+ * @brief Deletes a key from the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @param pKey Pointer to the key to delete.
+ * @return Pointer to the deleted key, or NULL if not found.
+ */
+extern void *cfl_bptree_delete(CFL_BPTREEP pTree, void *pKey);
+
+/**
+ * @brief Searches for an exact key match.
+ * @param pTree Pointer to the B+tree.
+ * @param pKey Pointer to the key to search for.
+ * @return Pointer to the found key, or NULL if not found.
+ */
+extern void *cfl_bptree_search(CFL_BPTREEP pTree, void *pKey);
+
+/**
+ * @brief Searches for the first key partially matching the given key.
+ * @param pTree Pointer to the B+tree.
+ * @param pKey Pointer to the key (prefix) to search for.
+ * @return Pointer to the first matching key, or NULL if not found.
+ */
+extern void *cfl_bptree_searchLike(CFL_BPTREEP pTree, void *pKey);
+
+/**
+ * @brief Returns the number of keys in the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @return Number of keys.
+ */
+extern CFL_INT32 cfl_bptree_count(CFL_BPTREEP pTree);
+
+/**
+ * @brief Creates an iterator starting from the first key.
+ * @param pTree Pointer to the B+tree.
+ * @return Iterator for traversing the tree in order.
+ */
+extern CFL_ITERATORP cfl_bptree_iterator(CFL_BPTREEP pTree);
+
+/**
+ * @brief Creates an iterator positioned after the last key.
+ * @param pTree Pointer to the B+tree.
+ * @return Iterator for traversing the tree in reverse order.
+ */
+extern CFL_ITERATORP cfl_bptree_iteratorLast(CFL_BPTREEP pTree);
+
+/**
+ * @brief Creates an iterator starting at a specific key.
+ * @param pTree Pointer to the B+tree.
+ * @param pKey Key to start from.
+ * @return Iterator whose next key is pKey, or NULL if key not found.
+ */
+extern CFL_ITERATORP cfl_bptree_iteratorSearch(CFL_BPTREEP pTree, void *pKey);
+
+/**
+ * @brief Creates an iterator over the keys partially matching the given key.
+ * @param pTree Pointer to the B+tree.
+ * @param pKey Key pattern (prefix) to match.
+ * @return Iterator positioned at the first match and limited to the matching
+ *         keys, or NULL if no match found.
+ */
+extern CFL_ITERATORP cfl_bptree_iteratorSearchLike(CFL_BPTREEP pTree,
+                                                   void *pKey);
+
+/**
+ * @brief Creates an iterator over the matching keys positioned after the last
+ *        match, to be traversed backwards with cfl_iterator_previous.
+ * @param pTree Pointer to the B+tree.
+ * @param pKey Key pattern (prefix) to match.
+ * @return Iterator limited to the matching keys, or NULL if no match found.
+ */
+extern CFL_ITERATORP cfl_bptree_iteratorSearchLastLike(CFL_BPTREEP pTree,
+                                                       void *pKey);
+
+/**
+ * @brief Creates an iterator over the keys in the range [pFromKey, pToKey].
+ * @param pTree Pointer to the B+tree.
+ * @param pFromKey Lower bound (inclusive) or NULL for no lower bound.
+ * @param pToKey Upper bound (inclusive) or NULL for no upper bound.
+ * @return Iterator limited to the keys in the range.
+ */
+extern CFL_ITERATORP cfl_bptree_iteratorRange(CFL_BPTREEP pTree,
+                                              void *pFromKey, void *pToKey);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -48,7 +48,9 @@ typedef CFL_BOOL (*BTREE_WALK_CALLBACK)(void *pValue);
 struct _CFL_BTREE_NODE {
   CFL_BTREEP pTree;     /**< Pointer to the tree this node belongs to */
   CFL_INT32 lNumKeys;   /**< Number of keys in this node */
+  CFL_INT32 lCount;     /**< Number of keys in the subtree rooted at this node */
   CFL_BOOL bIsLeafNode; /**< Whether this node is a leaf */
+  CFL_INT32 lRefCount;  /**< Number of parents, trees and snapshots referencing this node */
   void *pPointers[];    /**< Flexible array for keys and children */
 };
 
@@ -59,6 +61,8 @@ struct _CFL_BTREE {
   CFL_BTREE_NODEP pRoot;               /**< Root node of the tree */
   BTREE_CMP_VALUE_FUNC pCompareValues; /**< Comparison function */
   CFL_INT32 lKeys;                     /**< Maximum keys per node */
+  CFL_BTREEP pSource;                  /**< Tree a snapshot was taken from, NULL if not a snapshot */
+  CFL_INT32 lSnapshots;                /**< Number of live snapshots taken from this tree */
 };
 
 /**
@@ -71,25 +75,76 @@ extern CFL_BTREEP cfl_btree_new(CFL_INT32 lKeys,
                                 BTREE_CMP_VALUE_FUNC pCompareValues);
 
 /**
- * @brief Frees a B-tree and all its nodes.
- * @param pTree Pointer to the B-tree.
- * @param pFreeKey Optional function to free each key (can be NULL).
+ * @brief Frees a B-tree and all its nodes, or releases a snapshot.
+ * All snapshots of a tree must be released before the tree is freed.
+ * @param pTree Pointer to the B-tree or snapshot.
+ * @param pFreeKey Optional function to free each key (can be NULL). Ignored
+ *        when releasing a snapshot, since the keys belong to the source tree.
  */
 extern void cfl_btree_free(CFL_BTREEP pTree, BTREE_FREE_KEY_FUNC pFreeKey);
 
+/**
+ * @brief Takes an immutable snapshot of the B-tree in O(1).
+ *
+ * The snapshot shares the nodes of the tree. Later insertions and deletions
+ * in the tree copy the nodes they modify (and the path from the root to them)
+ * instead of changing shared nodes, so the snapshot keeps seeing the keys the
+ * tree had when it was taken. Nodes no longer reachable from the tree are
+ * freed when the last snapshot referencing them is released.
+ *
+ * The snapshot is a read-only CFL_BTREEP: the search, position and iterator
+ * functions work on it, while add, delete and bulk loads fail. It can be read
+ * and released by another thread while the tree keeps being modified, but
+ * taking the snapshot must not run concurrently with modifications of the
+ * tree. Keys deleted from the tree may still be referenced by snapshots and
+ * must not be freed while those snapshots are alive.
+ *
+ * @param pTree Pointer to the B-tree (or to another snapshot of it).
+ * @return Snapshot to be released with cfl_btree_free, or NULL if allocation
+ *         fails.
+ */
+extern CFL_BTREEP cfl_btree_snapshot(CFL_BTREEP pTree);
+
 /**
  * @brief Adds a key to the B-tree.
  * @param pTree Pointer to the B-tree.
  * @param pKey Pointer to the key to add.
- * @return CFL_TRUE if added, CFL_FALSE if key already exists.
+ * @return CFL_TRUE if added, CFL_FALSE if key already exists or the tree is a
+ *         snapshot.
  */
 extern CFL_BOOL cfl_btree_add(CFL_BTREEP pTree, void *pKey);
 
+/**
+ * @brief Builds the B-tree bottom-up from sorted keys in O(n).
+ * @param pTree Pointer to an empty B-tree.
+ * @param pKeys Keys in strictly ascending order.
+ * @param lCount Number of keys.
+ * @param fillFactor Fraction (0 to 1] of each node to fill; the remaining
+ *        room absorbs later insertions without splits.
+ * @return CFL_TRUE if loaded, CFL_FALSE if the tree is not empty or is a
+ *         snapshot, or the keys are not sorted or have duplicates.
+ */
+extern CFL_BOOL cfl_btree_bulkLoad(CFL_BTREEP pTree, void **pKeys,
+                                   CFL_INT32 lCount, CFL_DOUBLE fillFactor);
+
+/**
+ * @brief Sorts the keys in place and builds the B-tree with them.
+ * @param pTree Pointer to an empty B-tree.
+ * @param pKeys Keys in any order; the array is left sorted.
+ * @param lCount Number of keys.
+ * @param fillFactor Fraction (0 to 1] of each node to fill.
+ * @return CFL_TRUE if loaded, CFL_FALSE if the tree is not empty or is a
+ *         snapshot, or the keys have duplicates.
+ */
+extern CFL_BOOL cfl_btree_sortAndLoad(CFL_BTREEP pTree, void **pKeys,
+                                      CFL_INT32 lCount, CFL_DOUBLE fillFactor);
+
 /**
  * @brief Deletes a key from the B-tree.
  * @param pTree Pointer to the B-tree.
  * @param pKey Pointer to the key to delete.
- * @return Pointer to the deleted key, or NULL if not found.
+ * @return Pointer to the deleted key, or NULL if not found or the tree is a
+ *         snapshot.
  */
 extern void *cfl_btree_delete(CFL_BTREEP pTree, void *pKey);
 
@@ -102,13 +157,39 @@ extern void *cfl_btree_delete(CFL_BTREEP pTree, void *pKey);
 extern void *cfl_btree_search(CFL_BTREEP pTree, void *pKey);
 
 /**
- * @brief Searches for a key by position.
+ * @brief Searches for several keys at once.
+ * The lookups are interleaved and the nodes of the next level are prefetched,
+ * overlapping the cache misses of independent searches on large trees.
+ * @param pTree Pointer to the B-tree.
+ * @param pKeys Array of keys to search for.
+ * @param pResults Array receiving the found key for each key, or NULL if not found.
+ * @param lCount Number of keys.
+ */
+extern void cfl_btree_searchBatch(CFL_BTREEP pTree, void **pKeys, void **pResults, CFL_INT32 lCount);
+
+/**
+ * @brief Searches for a key by position in O(log n).
  * @param pTree Pointer to the B-tree.
  * @param lPosition Position (1-indexed).
  * @return Pointer to the key at that position, or NULL if not found.
  */
 extern void *cfl_btree_searchPosition(CFL_BTREEP pTree, CFL_INT32 lPosition);
 
+/**
+ * @brief Returns the position of a key in O(log n).
+ * @param pTree Pointer to the B-tree.
+ * @param pKey Pointer to the key to search for.
+ * @return Position of the key (1-indexed), or 0 if not found.
+ */
+extern CFL_INT32 cfl_btree_rank(CFL_BTREEP pTree, void *pKey);
+
+/**
+ * @brief Returns the number of keys in the B-tree.
+ * @param pTree Pointer to the B-tree.
+ * @return Number of keys.
+ */
+extern CFL_INT32 cfl_btree_count(CFL_BTREEP pTree);
+
 /**
  * @brief Searches for a key using partial matching.
  * @param pTree Pointer to the B-tree.
@@ -174,6 +255,38 @@ extern CFL_ITERATORP cfl_btree_iterator(CFL_BTREEP pTree);
  */
 extern CFL_ITERATORP cfl_btree_iteratorLast(CFL_BTREEP pTree);
 
+/**
+ * @brief Creates an iterator positioned at a key position.
+ * @param pTree Pointer to the B-tree.
+ * @param lPosition Position (1-indexed) of the key returned by the first call
+ *        to cfl_iterator_next.
+ * @return Iterator, or NULL if the position is out of range.
+ */
+extern CFL_ITERATORP cfl_btree_iteratorAt(CFL_BTREEP pTree,
+                                          CFL_INT32 lPosition);
+
+/**
+ * @brief Initializes an iterator starting from the first element in
+ * caller-provided storage. The path to the cursor is kept inside the iterator,
+ * so no memory is allocated while iterating. Release it with
+ * cfl_iterator_dispose.
+ * @param it Iterator storage, the iterator of a CFL_ITERATOR_BUFFER.
+ * @param pTree Pointer to the B-tree.
+ * @return The initialized iterator.
+ */
+extern CFL_ITERATORP cfl_btree_iteratorInit(CFL_ITERATORP it,
+                                            CFL_BTREEP pTree);
+
+/**
+ * @brief Initializes an iterator starting from the last element in
+ * caller-provided storage, like cfl_btree_iteratorInit.
+ * @param it Iterator storage, the iterator of a CFL_ITERATOR_BUFFER.
+ * @param pTree Pointer to the B-tree.
+ * @return The initialized iterator.
+ */
+extern CFL_ITERATORP cfl_btree_iteratorLastInit(CFL_ITERATORP it,
+                                                CFL_BTREEP pTree);
+
 /**
  * @brief Walks through all keys in the tree.
  * @param pNode Starting node for the walk.
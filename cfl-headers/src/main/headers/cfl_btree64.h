@@ -0,0 +1,150 @@
+/**
+ * @file cfl_btree64.h
+ * @brief B+tree with inline 64-bit integer keys.
+ *
+ * This module provides a B+tree specialized for CFL_INT64 keys. Unlike
+ * cfl_btree and cfl_bptree, which store key pointers and compare them through
+ * a callback, the keys are stored inline and contiguously in each node, so a
+ * node search reads a few adjacent cache lines and compares the integers
+ * directly (with AVX2 when the compiler targets it). Each key is associated
+ * with a value pointer stored in the leaves, and the next node of a descent
+ * is prefetched while the current one is searched.
+ */
+
+#ifndef _CFL_BTREE64_H_
+
+#define _CFL_BTREE64_H_
+
+#include "cfl_btree.h"
+#include "cfl_iterator.h"
+#include "cfl_types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** @brief Keys per node used when 0 is passed to cfl_btree64_new */
+#define CFL_BTREE64_DEFAULT_KEYS 32
+
+struct _CFL_BTREE64;
+typedef struct _CFL_BTREE64 CFL_BTREE64;
+typedef CFL_BTREE64 *CFL_BTREE64P;
+
+struct _CFL_BTREE64_NODE;
+typedef struct _CFL_BTREE64_NODE CFL_BTREE64_NODE;
+typedef CFL_BTREE64_NODE *CFL_BTREE64_NODEP;
+
+/**
+ * @brief B+tree node structure.
+ *
+ * The keys array has room for lKeys + 1 keys and is followed by the pointer
+ * area: the values of a leaf or the lKeys + 2 children of an internal node.
+ */
+struct _CFL_BTREE64_NODE {
+  CFL_INT32 lNumKeys;          /**< Number of keys in this node */
+  CFL_BOOL bIsLeafNode;        /**< Whether this node is a leaf */
+  CFL_BTREE64_NODEP pPrevLeaf; /**< Previous leaf in key order (leaves only) */
+  CFL_BTREE64_NODEP pNextLeaf; /**< Next leaf in key order (leaves only) */
+  CFL_INT64 keys[];            /**< Inline keys followed by the pointers */
+};
+
+/**
+ * @brief B+tree structure.
+ */
+struct _CFL_BTREE64 {
+  CFL_BTREE64_NODEP pRoot;      /**< Root node of the tree */
+  CFL_BTREE64_NODEP pFirstLeaf; /**< Leaf with the smallest keys */
+  CFL_BTREE64_NODEP pLastLeaf;  /**< Leaf with the greatest keys */
+  CFL_INT32 lKeys;              /**< Maximum keys per node */
+  CFL_INT32 lCount;             /**< Number of keys in the tree */
+};
+
+/**
+ * @brief Creates a new B+tree with inline keys.
+ * @param lKeys Maximum number of keys per node (at least 3), or 0 to use
+ *        CFL_BTREE64_DEFAULT_KEYS.
+ * @return Pointer to the new B+tree, or NULL if allocation fails.
+ */
+extern CFL_BTREE64P cfl_btree64_new(CFL_INT32 lKeys);
+
+/**
+ * @brief Frees a B+tree and all its nodes.
+ * @param pTree Pointer to the B+tree.
+ * @param pFreeValue Optional function to free each value (can be NULL).
+ */
+extern void cfl_btree64_free(CFL_BTREE64P pTree, BTREE_FREE_KEY_FUNC pFreeValue);
+
+/**
+ * @brief Adds a key and its value to the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @param key Key to add.
+ * @param pValue Value associated with the key.
+ * @return CFL_TRUE if added, CFL_FALSE if key already exists or memory cannot
+ *         be allocated, in which case the tree is unchanged.
+ */
+extern CFL_BOOL cfl_btree64_add(CFL_BTREE64P pTree, CFL_INT64 key,
+                                void *pValue);
+
+/**
+ * @brief Deletes a key from the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @param key Key to delete.
+ * @return Value of the deleted key, or NULL if not found.
+ */
+extern void *cfl_btree64_delete(CFL_BTREE64P pTree, CFL_INT64 key);
+
+/**
+ * @brief Searches for a key.
+ * @param pTree Pointer to the B+tree.
+ * @param key Key to search for.
+ * @return Value associated with the key, or NULL if not found.
+ */
+extern void *cfl_btree64_search(CFL_BTREE64P pTree, CFL_INT64 key);
+
+/**
+ * @brief Checks if the B+tree contains a key.
+ * @param pTree Pointer to the B+tree.
+ * @param key Key to search for.
+ * @return CFL_TRUE if found, CFL_FALSE otherwise.
+ */
+extern CFL_BOOL cfl_btree64_contains(CFL_BTREE64P pTree, CFL_INT64 key);
+
+/**
+ * @brief Returns the number of keys in the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @return Number of keys.
+ */
+extern CFL_INT32 cfl_btree64_count(CFL_BTREE64P pTree);
+
+/**
+ * @brief Creates an iterator over the values in key order.
+ * @param pTree Pointer to the B+tree.
+ * @return Iterator positioned before the first key.
+ */
+extern CFL_ITERATORP cfl_btree64_iterator(CFL_BTREE64P pTree);
+
+/**
+ * @brief Creates an iterator over the values whose keys are in the range
+ *        [fromKey, toKey].
+ * @param pTree Pointer to the B+tree.
+ * @param fromKey Lower bound (inclusive).
+ * @param toKey Upper bound (inclusive).
+ * @return Iterator limited to the keys in the range.
+ */
+extern CFL_ITERATORP cfl_btree64_iteratorRange(CFL_BTREE64P pTree,
+                                               CFL_INT64 fromKey,
+                                               CFL_INT64 toKey);
+
+/**
+ * @brief Returns the key of the last value returned by an iterator.
+ * @param it Iterator created by cfl_btree64_iterator or
+ *        cfl_btree64_iteratorRange.
+ * @return Key of the current value, or 0 if no value was returned yet.
+ */
+extern CFL_INT64 cfl_btree64_iteratorKey(CFL_ITERATORP it);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,143 @@
+/**
+ * @file cfl_btree_file.h
+ * @brief Persistent B-tree file that is searched in place through a
+ * read-only memory mapping.
+ *
+ * cfl_btree_file_write serializes the keys of an in-memory CFL_BTREE into a
+ * file of fixed size pages, where child references are page numbers instead
+ * of pointers. cfl_btree_file_open maps the file read-only and searches it
+ * directly, so an index can be reopened at startup without being rebuilt.
+ *
+ * Keys are stored as flat byte copies (the number of bytes is given by a
+ * BTREE_KEY_SIZE_FUNC), aligned to 8 bytes inside the pages. The search
+ * functions pass pointers into the mapping to the comparison function, so the
+ * same BTREE_CMP_VALUE_FUNC used by the in-memory tree works as long as it
+ * only reads the key bytes (for example NUL terminated strings or integers).
+ * The keys returned by searches and iterators point into the mapping and are
+ * valid until the file is closed.
+ *
+ * The file stores integers in the byte order of the machine that wrote it,
+ * and cfl_btree_file_open rejects files written with another byte order.
+ *
+ * cfl_btree_file_open checks the header and every page, so that the searches
+ * of a truncated or corrupt file stay inside the mapping. The key bytes
+ * themselves are not checked: a comparison function that reads a key up to a
+ * terminator relies on the file being written by cfl_btree_file_write, and
+ * the file must not be modified while it is open.
+ */
+
+#ifndef _CFL_BTREE_FILE_H_
+
+#define _CFL_BTREE_FILE_H_
+
+#include "cfl_btree.h"
+#include "cfl_iterator.h"
+#include "cfl_types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** @brief Page size used when 0 is passed to cfl_btree_file_write */
+#define CFL_BTREE_FILE_DEFAULT_PAGE_SIZE 4096
+
+/** @brief Returns the number of bytes of a key to be stored in the file */
+typedef CFL_UINT32 (*BTREE_KEY_SIZE_FUNC)(void *pKey);
+
+struct _CFL_BTREE_FILE;
+typedef struct _CFL_BTREE_FILE CFL_BTREE_FILE;
+typedef CFL_BTREE_FILE *CFL_BTREE_FILEP;
+
+/**
+ * @brief Writes the keys of a B-tree to a B-tree file.
+ * @param pTree Pointer to the B-tree.
+ * @param filePath Path of the file to create or replace.
+ * @param pageSize Page size in bytes (a multiple of 8, at least 256), or 0 to
+ *        use CFL_BTREE_FILE_DEFAULT_PAGE_SIZE.
+ * @param pKeySize Function returning the number of bytes of each key.
+ * @return CFL_TRUE if the file was written, CFL_FALSE if the page size is
+ *         invalid, a key does not fit in a page or the file cannot be written.
+ */
+extern CFL_BOOL cfl_btree_file_write(CFL_BTREEP pTree, const char *filePath,
+                                     CFL_UINT32 pageSize,
+                                     BTREE_KEY_SIZE_FUNC pKeySize);
+
+/**
+ * @brief Opens a B-tree file mapping it read-only into memory.
+ * @param filePath Path of the file.
+ * @param pCompareValues Function to compare keys, called with the searched key
+ *        and a pointer to the key bytes stored in the file.
+ * @return Pointer to the opened file, or NULL if the file cannot be mapped or
+ *         is not a valid B-tree file, including a page whose keys or
+ *         references fall outside the page or the file.
+ */
+extern CFL_BTREE_FILEP cfl_btree_file_open(const char *filePath,
+                                           BTREE_CMP_VALUE_FUNC pCompareValues);
+
+/**
+ * @brief Unmaps and closes a B-tree file.
+ * @param pFile Pointer to the B-tree file.
+ */
+extern void cfl_btree_file_close(CFL_BTREE_FILEP pFile);
+
+/**
+ * @brief Returns the number of keys in the B-tree file.
+ * @param pFile Pointer to the B-tree file.
+ * @return Number of keys.
+ */
+extern CFL_INT32 cfl_btree_file_count(CFL_BTREE_FILEP pFile);
+
+/**
+ * @brief Searches for an exact key match.
+ * @param pFile Pointer to the B-tree file.
+ * @param pKey Pointer to the key to search for.
+ * @return Pointer to the key bytes in the file, or NULL if not found.
+ */
+extern void *cfl_btree_file_search(CFL_BTREE_FILEP pFile, void *pKey);
+
+/**
+ * @brief Searches for the first key partially matching the given key.
+ * @param pFile Pointer to the B-tree file.
+ * @param pKey Pointer to the key (prefix) to search for.
+ * @return Pointer to the key bytes in the file, or NULL if not found.
+ */
+extern void *cfl_btree_file_searchLike(CFL_BTREE_FILEP pFile, void *pKey);
+
+/**
+ * @brief Creates an iterator starting from the first key.
+ * @param pFile Pointer to the B-tree file.
+ * @return Iterator for traversing the keys in order.
+ */
+extern CFL_ITERATORP cfl_btree_file_iterator(CFL_BTREE_FILEP pFile);
+
+/**
+ * @brief Creates an iterator positioned after the last key.
+ * @param pFile Pointer to the B-tree file.
+ * @return Iterator for traversing the keys in reverse order.
+ */
+extern CFL_ITERATORP cfl_btree_file_iteratorLast(CFL_BTREE_FILEP pFile);
+
+/**
+ * @brief Creates an iterator starting at a specific key.
+ * @param pFile Pointer to the B-tree file.
+ * @param pKey Key to start from.
+ * @return Iterator whose next key is pKey, or NULL if key not found.
+ */
+extern CFL_ITERATORP cfl_btree_file_iteratorSearch(CFL_BTREE_FILEP pFile,
+                                                   void *pKey);
+
+/**
+ * @brief Creates an iterator over the keys partially matching the given key.
+ * @param pFile Pointer to the B-tree file.
+ * @param pKey Key pattern (prefix) to match.
+ * @return Iterator positioned at the first match and limited to the matching
+ *         keys, or NULL if no match found.
+ */
+extern CFL_ITERATORP cfl_btree_file_iteratorSearchLike(CFL_BTREE_FILEP pFile,
+                                                       void *pKey);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
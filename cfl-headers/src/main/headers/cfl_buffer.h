@@ -227,6 +227,199 @@ extern double cfl_buffer_getDouble(CFL_BUFFERP buffer);
 /** @brief Peeks a double. */
 extern double cfl_buffer_peekDouble(CFL_BUFFERP buffer);
 
+/*
+ * Explicit byte order: the functions above use the byte order of the host,
+ * the ones below always write and read big endian (BE, network order) or
+ * little endian (LE) values.
+ */
+
+/** @brief Writes a 16-bit integer in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt16BE(CFL_BUFFERP buffer, CFL_INT16 value);
+/** @brief Reads a 16-bit integer in big endian byte order. */
+extern CFL_INT16 cfl_buffer_getInt16BE(CFL_BUFFERP buffer);
+/** @brief Writes a 32-bit integer in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt32BE(CFL_BUFFERP buffer, CFL_INT32 value);
+/** @brief Reads a 32-bit integer in big endian byte order. */
+extern CFL_INT32 cfl_buffer_getInt32BE(CFL_BUFFERP buffer);
+/** @brief Writes a 64-bit integer in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt64BE(CFL_BUFFERP buffer, CFL_INT64 value);
+/** @brief Reads a 64-bit integer in big endian byte order. */
+extern CFL_INT64 cfl_buffer_getInt64BE(CFL_BUFFERP buffer);
+/** @brief Writes an unsigned 16-bit integer in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putUInt16BE(CFL_BUFFERP buffer, CFL_UINT16 value);
+/** @brief Reads an unsigned 16-bit integer in big endian byte order. */
+extern CFL_UINT16 cfl_buffer_getUInt16BE(CFL_BUFFERP buffer);
+/** @brief Writes an unsigned 32-bit integer in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putUInt32BE(CFL_BUFFERP buffer, CFL_UINT32 value);
+/** @brief Reads an unsigned 32-bit integer in big endian byte order. */
+extern CFL_UINT32 cfl_buffer_getUInt32BE(CFL_BUFFERP buffer);
+/** @brief Writes an unsigned 64-bit integer in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putUInt64BE(CFL_BUFFERP buffer, CFL_UINT64 value);
+/** @brief Reads an unsigned 64-bit integer in big endian byte order. */
+extern CFL_UINT64 cfl_buffer_getUInt64BE(CFL_BUFFERP buffer);
+/** @brief Writes a float in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putFloatBE(CFL_BUFFERP buffer, float value);
+/** @brief Reads a float in big endian byte order. */
+extern float cfl_buffer_getFloatBE(CFL_BUFFERP buffer);
+/** @brief Writes a double in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putDoubleBE(CFL_BUFFERP buffer, double value);
+/** @brief Reads a double in big endian byte order. */
+extern double cfl_buffer_getDoubleBE(CFL_BUFFERP buffer);
+
+/** @brief Writes a 16-bit integer in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt16LE(CFL_BUFFERP buffer, CFL_INT16 value);
+/** @brief Reads a 16-bit integer in little endian byte order. */
+extern CFL_INT16 cfl_buffer_getInt16LE(CFL_BUFFERP buffer);
+/** @brief Writes a 32-bit integer in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt32LE(CFL_BUFFERP buffer, CFL_INT32 value);
+/** @brief Reads a 32-bit integer in little endian byte order. */
+extern CFL_INT32 cfl_buffer_getInt32LE(CFL_BUFFERP buffer);
+/** @brief Writes a 64-bit integer in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt64LE(CFL_BUFFERP buffer, CFL_INT64 value);
+/** @brief Reads a 64-bit integer in little endian byte order. */
+extern CFL_INT64 cfl_buffer_getInt64LE(CFL_BUFFERP buffer);
+/** @brief Writes an unsigned 16-bit integer in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putUInt16LE(CFL_BUFFERP buffer, CFL_UINT16 value);
+/** @brief Reads an unsigned 16-bit integer in little endian byte order. */
+extern CFL_UINT16 cfl_buffer_getUInt16LE(CFL_BUFFERP buffer);
+/** @brief Writes an unsigned 32-bit integer in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putUInt32LE(CFL_BUFFERP buffer, CFL_UINT32 value);
+/** @brief Reads an unsigned 32-bit integer in little endian byte order. */
+extern CFL_UINT32 cfl_buffer_getUInt32LE(CFL_BUFFERP buffer);
+/** @brief Writes an unsigned 64-bit integer in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putUInt64LE(CFL_BUFFERP buffer, CFL_UINT64 value);
+/** @brief Reads an unsigned 64-bit integer in little endian byte order. */
+extern CFL_UINT64 cfl_buffer_getUInt64LE(CFL_BUFFERP buffer);
+/** @brief Writes a float in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putFloatLE(CFL_BUFFERP buffer, float value);
+/** @brief Reads a float in little endian byte order. */
+extern float cfl_buffer_getFloatLE(CFL_BUFFERP buffer);
+/** @brief Writes a double in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putDoubleLE(CFL_BUFFERP buffer, double value);
+/** @brief Reads a double in little endian byte order. */
+extern double cfl_buffer_getDoubleLE(CFL_BUFFERP buffer);
+
+/*
+ * Arrays: the values are written with a single capacity check and copied in
+ * bulk, with the bytes of each value reversed when the byte order differs
+ * from the host. Unsigned arrays can be passed as the signed type of the same
+ * size. The get functions read up to count values and return the number read;
+ * when the data ends first, the position is moved to the end.
+ */
+
+/** @brief Writes an array of 16-bit integers. */
+extern CFL_BOOL cfl_buffer_putInt16Array(CFL_BUFFERP buffer, const CFL_INT16 *values, CFL_UINT32 count);
+/** @brief Reads an array of 16-bit integers, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt16Array(CFL_BUFFERP buffer, CFL_INT16 *values, CFL_UINT32 count);
+/** @brief Writes an array of 32-bit integers. */
+extern CFL_BOOL cfl_buffer_putInt32Array(CFL_BUFFERP buffer, const CFL_INT32 *values, CFL_UINT32 count);
+/** @brief Reads an array of 32-bit integers, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt32Array(CFL_BUFFERP buffer, CFL_INT32 *values, CFL_UINT32 count);
+/** @brief Writes an array of 64-bit integers. */
+extern CFL_BOOL cfl_buffer_putInt64Array(CFL_BUFFERP buffer, const CFL_INT64 *values, CFL_UINT32 count);
+/** @brief Reads an array of 64-bit integers, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt64Array(CFL_BUFFERP buffer, CFL_INT64 *values, CFL_UINT32 count);
+/** @brief Writes an array of floats. */
+extern CFL_BOOL cfl_buffer_putFloatArray(CFL_BUFFERP buffer, const float *values, CFL_UINT32 count);
+/** @brief Reads an array of floats, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getFloatArray(CFL_BUFFERP buffer, float *values, CFL_UINT32 count);
+/** @brief Writes an array of doubles. */
+extern CFL_BOOL cfl_buffer_putDoubleArray(CFL_BUFFERP buffer, const double *values, CFL_UINT32 count);
+/** @brief Reads an array of doubles, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getDoubleArray(CFL_BUFFERP buffer, double *values, CFL_UINT32 count);
+
+/** @brief Writes an array of 16-bit integers in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt16ArrayBE(CFL_BUFFERP buffer, const CFL_INT16 *values, CFL_UINT32 count);
+/** @brief Reads an array of 16-bit integers in big endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt16ArrayBE(CFL_BUFFERP buffer, CFL_INT16 *values, CFL_UINT32 count);
+/** @brief Writes an array of 32-bit integers in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt32ArrayBE(CFL_BUFFERP buffer, const CFL_INT32 *values, CFL_UINT32 count);
+/** @brief Reads an array of 32-bit integers in big endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt32ArrayBE(CFL_BUFFERP buffer, CFL_INT32 *values, CFL_UINT32 count);
+/** @brief Writes an array of 64-bit integers in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt64ArrayBE(CFL_BUFFERP buffer, const CFL_INT64 *values, CFL_UINT32 count);
+/** @brief Reads an array of 64-bit integers in big endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt64ArrayBE(CFL_BUFFERP buffer, CFL_INT64 *values, CFL_UINT32 count);
+/** @brief Writes an array of floats in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putFloatArrayBE(CFL_BUFFERP buffer, const float *values, CFL_UINT32 count);
+/** @brief Reads an array of floats in big endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getFloatArrayBE(CFL_BUFFERP buffer, float *values, CFL_UINT32 count);
+/** @brief Writes an array of doubles in big endian byte order. */
+extern CFL_BOOL cfl_buffer_putDoubleArrayBE(CFL_BUFFERP buffer, const double *values, CFL_UINT32 count);
+/** @brief Reads an array of doubles in big endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getDoubleArrayBE(CFL_BUFFERP buffer, double *values, CFL_UINT32 count);
+
+/** @brief Writes an array of 16-bit integers in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt16ArrayLE(CFL_BUFFERP buffer, const CFL_INT16 *values, CFL_UINT32 count);
+/** @brief Reads an array of 16-bit integers in little endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt16ArrayLE(CFL_BUFFERP buffer, CFL_INT16 *values, CFL_UINT32 count);
+/** @brief Writes an array of 32-bit integers in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt32ArrayLE(CFL_BUFFERP buffer, const CFL_INT32 *values, CFL_UINT32 count);
+/** @brief Reads an array of 32-bit integers in little endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt32ArrayLE(CFL_BUFFERP buffer, CFL_INT32 *values, CFL_UINT32 count);
+/** @brief Writes an array of 64-bit integers in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putInt64ArrayLE(CFL_BUFFERP buffer, const CFL_INT64 *values, CFL_UINT32 count);
+/** @brief Reads an array of 64-bit integers in little endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getInt64ArrayLE(CFL_BUFFERP buffer, CFL_INT64 *values, CFL_UINT32 count);
+/** @brief Writes an array of floats in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putFloatArrayLE(CFL_BUFFERP buffer, const float *values, CFL_UINT32 count);
+/** @brief Reads an array of floats in little endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getFloatArrayLE(CFL_BUFFERP buffer, float *values, CFL_UINT32 count);
+/** @brief Writes an array of doubles in little endian byte order. */
+extern CFL_BOOL cfl_buffer_putDoubleArrayLE(CFL_BUFFERP buffer, const double *values, CFL_UINT32 count);
+/** @brief Reads an array of doubles in little endian byte order, returning the number of values read. */
+extern CFL_UINT32 cfl_buffer_getDoubleArrayLE(CFL_BUFFERP buffer, double *values, CFL_UINT32 count);
+
+/*
+ * Variable length integers: 7 bits per byte, lowest bits first, the high bit
+ * of each byte set when more bytes follow. Values below 128 take one byte.
+ * Signed values are zigzag encoded, so small negative values are short too.
+ * Reading a truncated or too long value returns 0 and moves the position to
+ * the end of the data.
+ */
+
+/** @brief Writes an unsigned 32-bit integer in 1 to 5 bytes. */
+extern CFL_BOOL cfl_buffer_putVarUInt32(CFL_BUFFERP buffer, CFL_UINT32 value);
+/** @brief Reads an unsigned 32-bit integer written by cfl_buffer_putVarUInt32. */
+extern CFL_UINT32 cfl_buffer_getVarUInt32(CFL_BUFFERP buffer);
+
+/** @brief Writes an unsigned 64-bit integer in 1 to 10 bytes. */
+extern CFL_BOOL cfl_buffer_putVarUInt64(CFL_BUFFERP buffer, CFL_UINT64 value);
+/** @brief Reads an unsigned 64-bit integer written by cfl_buffer_putVarUInt64. */
+extern CFL_UINT64 cfl_buffer_getVarUInt64(CFL_BUFFERP buffer);
+
+/** @brief Writes a signed 32-bit integer zigzag encoded in 1 to 5 bytes. */
+extern CFL_BOOL cfl_buffer_putVarInt32(CFL_BUFFERP buffer, CFL_INT32 value);
+/** @brief Reads a signed 32-bit integer written by cfl_buffer_putVarInt32. */
+extern CFL_INT32 cfl_buffer_getVarInt32(CFL_BUFFERP buffer);
+
+/** @brief Writes a signed 64-bit integer zigzag encoded in 1 to 10 bytes. */
+extern CFL_BOOL cfl_buffer_putVarInt64(CFL_BUFFERP buffer, CFL_INT64 value);
+/** @brief Reads a signed 64-bit integer written by cfl_buffer_putVarInt64. */
+extern CFL_INT64 cfl_buffer_getVarInt64(CFL_BUFFERP buffer);
+
+/**
+ * @brief Reads consecutive values written by cfl_buffer_putVarUInt32. Runs of
+ * one-byte values are decoded 8 at a time.
+ * @param buffer Pointer to the buffer.
+ * @param values Array receiving the values.
+ * @param count Number of values to read.
+ * @return Number of values read, less than count if the data ends or a value
+ *         is invalid, in which case the position is moved to the end.
+ */
+extern CFL_UINT32 cfl_buffer_getVarUInt32Array(CFL_BUFFERP buffer, CFL_UINT32 *values, CFL_UINT32 count);
+
+/**
+ * @brief Reads consecutive values written by cfl_buffer_putVarUInt64. Runs of
+ * one-byte values are decoded 8 at a time.
+ * @param buffer Pointer to the buffer.
+ * @param values Array receiving the values.
+ * @param count Number of values to read.
+ * @return Number of values read, less than count if the data ends or a value
+ *         is invalid, in which case the position is moved to the end.
+ */
+extern CFL_UINT32 cfl_buffer_getVarUInt64Array(CFL_BUFFERP buffer, CFL_UINT64 *values, CFL_UINT32 count);
+
 /** @brief Reads a string from buffer. */
 extern CFL_STRP cfl_buffer_getString(CFL_BUFFERP buffer);
 /** @brief Gets length of next string without reading it. */
@@ -253,6 +446,17 @@ extern CFL_BOOL cfl_buffer_putCharArrayLen(CFL_BUFFERP buffer, const char *value
 /** @brief Writes a null-terminated char array. */
 extern CFL_BOOL cfl_buffer_putCharArray(CFL_BUFFERP buffer, const char *value);
 
+/** @brief Writes a string with its length as a variable length integer. */
+extern CFL_BOOL cfl_buffer_putVarString(CFL_BUFFERP buffer, CFL_STRP value);
+/** @brief Reads a string written by cfl_buffer_putVarString. */
+extern CFL_STRP cfl_buffer_getVarString(CFL_BUFFERP buffer);
+/** @brief Copies a string written by cfl_buffer_putVarString to destination. */
+extern void cfl_buffer_copyVarString(CFL_BUFFERP buffer, CFL_STRP destStr);
+/** @brief Writes a null-terminated char array with its length as a variable length integer. */
+extern CFL_BOOL cfl_buffer_putVarCharArray(CFL_BUFFERP buffer, const char *value);
+/** @brief Reads a char array written by cfl_buffer_putVarCharArray. */
+extern char *cfl_buffer_getVarCharArray(CFL_BUFFERP buffer);
+
 /** @brief Reads a date from buffer. */
 extern void cfl_buffer_getDate(CFL_BUFFERP buffer, CFL_DATEP date);
 /** @brief Writes a date to buffer. */
@@ -0,0 +1,221 @@
+/**
+ * @file cfl_buffer_chain.h
+ * @brief Chain of shared buffer segments for zero-copy message assembly.
+ *
+ * This module provides a byte sequence made of slices of reference-counted
+ * memory segments. Slicing, splitting and appending another chain only copy
+ * slice descriptors and share the segments, so payload bytes are written
+ * once and never moved. Small writes are copied into the free space of the
+ * last segment. The slices can be listed as an array of CFL_IOVEC to send
+ * the whole chain with one vectored write.
+ *
+ * Segment reference counts are atomic, so chains sharing segments can be
+ * used by different threads. A single chain is not thread-safe.
+ */
+
+#ifndef CFL_BUFFER_CHAIN_H_
+
+#define CFL_BUFFER_CHAIN_H_
+
+#include <stddef.h>
+
+#include "cfl_types.h"
+#include "cfl_buffer.h"
+
+#if !defined(CFL_OS_WINDOWS)
+#include <sys/uio.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Default size of the segments allocated to copy bytes into */
+#define CFL_BUFFER_CHAIN_SEGMENT_SIZE 4096
+
+#if defined(CFL_OS_WINDOWS)
+/** @brief Memory area for vectored I/O, with the fields of struct iovec */
+typedef struct _CFL_IOVEC {
+  void *iov_base; /**< Start of the area */
+  size_t iov_len; /**< Size of the area in bytes */
+} CFL_IOVEC;
+#else
+/** @brief Memory area for vectored I/O, usable directly with writev */
+typedef struct iovec CFL_IOVEC;
+#endif
+
+/** @brief Releases memory given to the chain by reference */
+typedef void (*CFL_BUFFER_CHAIN_FREE_FUNC)(void *data, void *context);
+
+/** @brief Part of a segment referenced by a chain, internal to the module */
+typedef struct _CFL_BUFFER_SLICE CFL_BUFFER_SLICE;
+
+/**
+ * @brief Buffer chain structure.
+ */
+typedef struct _CFL_BUFFER_CHAIN {
+  CFL_BUFFER_SLICE *slices; /**< Slices in byte order */
+  CFL_UINT32 count;         /**< Number of slices */
+  CFL_UINT32 capacity;      /**< Number of allocated slices */
+  CFL_UINT32 length;        /**< Total number of bytes */
+  CFL_BOOL allocated;       /**< Whether the structure was dynamically allocated */
+} CFL_BUFFER_CHAIN, *CFL_BUFFER_CHAINP;
+
+/**
+ * @brief Initializes an empty chain.
+ * @param chain Pointer to the chain structure to initialize.
+ */
+extern void cfl_buffer_chain_init(CFL_BUFFER_CHAINP chain);
+
+/**
+ * @brief Creates a new empty chain.
+ * @return Pointer to the new chain, or NULL if allocation fails.
+ */
+extern CFL_BUFFER_CHAINP cfl_buffer_chain_new(void);
+
+/**
+ * @brief Releases the segments of a chain and frees it.
+ * @param chain Pointer to the chain.
+ */
+extern void cfl_buffer_chain_free(CFL_BUFFER_CHAINP chain);
+
+/**
+ * @brief Releases all segments, leaving the chain empty.
+ * @param chain Pointer to the chain.
+ */
+extern void cfl_buffer_chain_clear(CFL_BUFFER_CHAINP chain);
+
+/**
+ * @brief Returns the number of bytes in the chain.
+ * @param chain Pointer to the chain.
+ * @return Length in bytes.
+ */
+extern CFL_UINT32 cfl_buffer_chain_length(const CFL_BUFFER_CHAINP chain);
+
+/**
+ * @brief Returns the number of slices, which is the number of CFL_IOVEC
+ * needed by cfl_buffer_chain_toIovec.
+ * @param chain Pointer to the chain.
+ * @return Number of slices.
+ */
+extern CFL_UINT32 cfl_buffer_chain_sliceCount(const CFL_BUFFER_CHAINP chain);
+
+/**
+ * @brief Copies bytes to the end of the chain, using the free space of the
+ * last segment before allocating a new one.
+ * @param chain Pointer to the chain.
+ * @param data Bytes to copy.
+ * @param size Number of bytes.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated, in
+ *         which case the chain is unchanged.
+ */
+extern CFL_BOOL cfl_buffer_chain_append(CFL_BUFFER_CHAINP chain, const void *data, CFL_UINT32 size);
+
+/**
+ * @brief Copies bytes to the beginning of the chain, for example a header
+ * whose content depends on the payload already in the chain.
+ * @param chain Pointer to the chain.
+ * @param data Bytes to copy.
+ * @param size Number of bytes.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_buffer_chain_prepend(CFL_BUFFER_CHAINP chain, const void *data, CFL_UINT32 size);
+
+/**
+ * @brief Appends memory owned by the caller without copying it. The memory
+ * must stay unchanged until freeFunc is called, when no chain references it
+ * anymore.
+ * @param chain Pointer to the chain.
+ * @param data Start of the memory.
+ * @param size Number of bytes.
+ * @param freeFunc Function called to release the memory, or NULL if none.
+ * @param context Pointer passed to freeFunc.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated, in
+ *         which case freeFunc is not called.
+ */
+extern CFL_BOOL cfl_buffer_chain_appendRef(CFL_BUFFER_CHAINP chain, void *data, CFL_UINT32 size,
+                                           CFL_BUFFER_CHAIN_FREE_FUNC freeFunc, void *context);
+
+/**
+ * @brief Appends the bytes of a buffer from its position to its length by
+ * taking over its memory, without copying. The buffer is left empty and can
+ * be reused.
+ * @param chain Pointer to the chain.
+ * @param buffer Pointer to the buffer.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated, in
+ *         which case the buffer is unchanged.
+ */
+extern CFL_BOOL cfl_buffer_chain_appendBuffer(CFL_BUFFER_CHAINP chain, CFL_BUFFERP buffer);
+
+/**
+ * @brief Appends the bytes of another chain by sharing its segments.
+ * @param chain Pointer to the chain.
+ * @param other Pointer to the chain to append, which may be chain itself.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated or the
+ *         length would overflow, in which case the chain is unchanged.
+ */
+extern CFL_BOOL cfl_buffer_chain_appendChain(CFL_BUFFER_CHAINP chain, const CFL_BUFFER_CHAINP other);
+
+/**
+ * @brief Creates a chain with a range of bytes of another chain, sharing its
+ * segments.
+ * @param chain Pointer to the chain.
+ * @param offset Start of the range.
+ * @param size Number of bytes, limited to the end of the chain.
+ * @return Pointer to the new chain, or NULL if the offset is beyond the end
+ *         or memory cannot be allocated.
+ */
+extern CFL_BUFFER_CHAINP cfl_buffer_chain_slice(const CFL_BUFFER_CHAINP chain, CFL_UINT32 offset, CFL_UINT32 size);
+
+/**
+ * @brief Splits a chain in two at an offset without copying bytes.
+ * @param chain Pointer to the chain, which keeps the bytes before offset.
+ * @param offset Position where the chain is split.
+ * @return Pointer to a new chain with the bytes from offset to the end, or
+ *         NULL if the offset is beyond the end or memory cannot be allocated,
+ *         in which case the chain is unchanged.
+ */
+extern CFL_BUFFER_CHAINP cfl_buffer_chain_split(CFL_BUFFER_CHAINP chain, CFL_UINT32 offset);
+
+/**
+ * @brief Removes bytes from the beginning of the chain, for example after a
+ * partial write.
+ * @param chain Pointer to the chain.
+ * @param size Number of bytes, limited to the length of the chain.
+ */
+extern void cfl_buffer_chain_skip(CFL_BUFFER_CHAINP chain, CFL_UINT32 size);
+
+/**
+ * @brief Copies bytes of the chain to memory.
+ * @param chain Pointer to the chain.
+ * @param offset Position of the first byte to copy.
+ * @param dest Destination of the bytes.
+ * @param size Maximum number of bytes to copy.
+ * @return Number of bytes copied.
+ */
+extern CFL_UINT32 cfl_buffer_chain_copy(const CFL_BUFFER_CHAINP chain, CFL_UINT32 offset, void *dest,
+                                        CFL_UINT32 size);
+
+/**
+ * @brief Writes all bytes of the chain to a buffer at its position.
+ * @param chain Pointer to the chain.
+ * @param buffer Pointer to the buffer.
+ * @return CFL_TRUE on success, CFL_FALSE if the buffer cannot grow.
+ */
+extern CFL_BOOL cfl_buffer_chain_toBuffer(const CFL_BUFFER_CHAINP chain, CFL_BUFFERP buffer);
+
+/**
+ * @brief Fills an array with the memory areas of the chain, in order. The
+ * areas are valid until the chain is modified.
+ * @param chain Pointer to the chain.
+ * @param iov Array receiving up to maxCount areas.
+ * @param maxCount Maximum number of areas to store.
+ * @return Number of areas stored.
+ */
+extern CFL_UINT32 cfl_buffer_chain_toIovec(const CFL_BUFFER_CHAINP chain, CFL_IOVEC *iov, CFL_UINT32 maxCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
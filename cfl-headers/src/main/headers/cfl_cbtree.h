@@ -0,0 +1,122 @@
+/**
+ * @file cfl_cbtree.h
+ * @brief Concurrent B+tree with optimistic lock coupling.
+ *
+ * This module provides a thread safe B+tree with inline CFL_INT64 keys and
+ * value pointers. Every node carries a version lock: readers never write to
+ * shared memory, they read the version before and after visiting a node and
+ * restart the operation if a writer changed it in between. Writers traverse
+ * the tree in the same optimistic way and lock exclusively only the leaf they
+ * modify, plus its parent while splitting a full node. Lookups therefore run
+ * in parallel with each other and with insertions in other parts of the tree.
+ *
+ * Deletes remove the key from its leaf but never merge underfull nodes, so
+ * that no node is released while a reader may still be visiting it. The
+ * memory of the nodes is returned by cfl_cbtree_free.
+ */
+
+#ifndef _CFL_CBTREE_H_
+
+#define _CFL_CBTREE_H_
+
+#include "cfl_btree.h"
+#include "cfl_types.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/** @brief Keys per node used when 0 is passed to cfl_cbtree_new */
+#define CFL_CBTREE_DEFAULT_KEYS 32
+
+struct _CFL_CBTREE;
+typedef struct _CFL_CBTREE CFL_CBTREE;
+typedef CFL_CBTREE *CFL_CBTREEP;
+
+struct _CFL_CBTREE_NODE;
+typedef struct _CFL_CBTREE_NODE CFL_CBTREE_NODE;
+typedef CFL_CBTREE_NODE *CFL_CBTREE_NODEP;
+
+/**
+ * @brief Concurrent B+tree node structure.
+ *
+ * The keys array has room for lKeys keys and is followed by the pointer area:
+ * the values of a leaf or the lKeys + 1 children of an internal node.
+ */
+struct _CFL_CBTREE_NODE {
+  CFL_INT32 version;    /**< Version lock, odd while locked by a writer */
+  CFL_INT32 lNumKeys;   /**< Number of keys in this node */
+  CFL_BOOL bIsLeafNode; /**< Whether this node is a leaf */
+  CFL_INT64 keys[];     /**< Inline keys followed by the pointers */
+};
+
+/**
+ * @brief Concurrent B+tree structure.
+ */
+struct _CFL_CBTREE {
+  CFL_CBTREE_NODEP pRoot; /**< Root node of the tree */
+  CFL_INT32 lKeys;        /**< Maximum keys per node */
+  CFL_INT32 lCount;       /**< Number of keys in the tree */
+};
+
+/**
+ * @brief Creates a new concurrent B+tree.
+ * @param lKeys Maximum number of keys per node (at least 3), or 0 to use
+ *        CFL_CBTREE_DEFAULT_KEYS.
+ * @return Pointer to the new B+tree, or NULL if allocation fails.
+ */
+extern CFL_CBTREEP cfl_cbtree_new(CFL_INT32 lKeys);
+
+/**
+ * @brief Frees a B+tree and all its nodes.
+ * @param pTree Pointer to the B+tree.
+ * @param pFreeValue Optional function to free each value (can be NULL).
+ * @note Must not be called while other threads are using the tree.
+ */
+extern void cfl_cbtree_free(CFL_CBTREEP pTree, BTREE_FREE_KEY_FUNC pFreeValue);
+
+/**
+ * @brief Adds a key and its value to the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @param key Key to add.
+ * @param pValue Value associated with the key.
+ * @return CFL_TRUE if added, CFL_FALSE if key already exists.
+ */
+extern CFL_BOOL cfl_cbtree_add(CFL_CBTREEP pTree, CFL_INT64 key, void *pValue);
+
+/**
+ * @brief Deletes a key from the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @param key Key to delete.
+ * @return Value of the deleted key, or NULL if not found.
+ */
+extern void *cfl_cbtree_delete(CFL_CBTREEP pTree, CFL_INT64 key);
+
+/**
+ * @brief Searches for a key.
+ * @param pTree Pointer to the B+tree.
+ * @param key Key to search for.
+ * @return Value associated with the key, or NULL if not found.
+ */
+extern void *cfl_cbtree_search(CFL_CBTREEP pTree, CFL_INT64 key);
+
+/**
+ * @brief Checks if the B+tree contains a key.
+ * @param pTree Pointer to the B+tree.
+ * @param key Key to search for.
+ * @return CFL_TRUE if found, CFL_FALSE otherwise.
+ */
+extern CFL_BOOL cfl_cbtree_contains(CFL_CBTREEP pTree, CFL_INT64 key);
+
+/**
+ * @brief Returns the number of keys in the B+tree.
+ * @param pTree Pointer to the B+tree.
+ * @return Number of keys.
+ */
+extern CFL_INT32 cfl_cbtree_count(CFL_CBTREEP pTree);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
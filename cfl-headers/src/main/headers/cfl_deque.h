@@ -0,0 +1,155 @@
+/**
+ * @file cfl_deque.h
+ * @brief Double-ended queue stored in a ring buffer.
+ *
+ * This module provides a deque of pointers kept in a single contiguous
+ * buffer whose capacity is a power of two. Items can be added and removed at
+ * both ends in constant time and accessed by index. The buffer doubles when
+ * full, so no memory is allocated per item.
+ */
+
+#ifndef CFL_DEQUE_H_
+
+#define CFL_DEQUE_H_
+
+#include "cfl_iterator.h"
+#include "cfl_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Deque structure.
+ */
+typedef struct _CFL_DEQUE {
+  void **items;        /**< Ring buffer of item pointers */
+  CFL_UINT32 capacity; /**< Size of the ring buffer, 0 or a power of two */
+  CFL_UINT32 head;     /**< Position of the first item in the ring buffer */
+  CFL_UINT32 length;   /**< Current number of items in the deque */
+  CFL_BOOL allocated;  /**< Whether the structure was dynamically allocated */
+} CFL_DEQUE, *CFL_DEQUEP;
+
+/**
+ * @brief Initializes a deque structure.
+ * @param deque Pointer to the deque structure to initialize.
+ * @param capacity Initial capacity, rounded up to a power of two.
+ * @return CFL_TRUE on success, CFL_FALSE if the buffer cannot be allocated.
+ */
+extern CFL_BOOL cfl_deque_init(CFL_DEQUEP deque, CFL_UINT32 capacity);
+
+/**
+ * @brief Creates a new deque.
+ * @param capacity Initial capacity, rounded up to a power of two.
+ * @return Pointer to the new deque, or NULL if allocation fails.
+ */
+extern CFL_DEQUEP cfl_deque_new(CFL_UINT32 capacity);
+
+/**
+ * @brief Frees the memory used by a deque.
+ * @param deque Pointer to the deque.
+ * @note This does not free the items stored in the deque.
+ */
+extern void cfl_deque_free(CFL_DEQUEP deque);
+
+/**
+ * @brief Adds an item to the end of the deque.
+ * @param deque Pointer to the deque.
+ * @param item Pointer to the item to add.
+ * @return CFL_TRUE on success, CFL_FALSE if the buffer cannot grow.
+ */
+extern CFL_BOOL cfl_deque_addLast(CFL_DEQUEP deque, void *item);
+
+/**
+ * @brief Adds an item to the beginning of the deque.
+ * @param deque Pointer to the deque.
+ * @param item Pointer to the item to add.
+ * @return CFL_TRUE on success, CFL_FALSE if the buffer cannot grow.
+ */
+extern CFL_BOOL cfl_deque_addFirst(CFL_DEQUEP deque, void *item);
+
+/**
+ * @brief Removes and returns the first item.
+ * @param deque Pointer to the deque.
+ * @return Pointer to the removed item, or NULL if the deque is empty.
+ */
+extern void *cfl_deque_removeFirst(CFL_DEQUEP deque);
+
+/**
+ * @brief Removes and returns the last item.
+ * @param deque Pointer to the deque.
+ * @return Pointer to the removed item, or NULL if the deque is empty.
+ */
+extern void *cfl_deque_removeLast(CFL_DEQUEP deque);
+
+/**
+ * @brief Gets the first item without removing it.
+ * @param deque Pointer to the deque.
+ * @return Pointer to the first item, or NULL if the deque is empty.
+ */
+extern void *cfl_deque_getFirst(const CFL_DEQUEP deque);
+
+/**
+ * @brief Gets the last item without removing it.
+ * @param deque Pointer to the deque.
+ * @return Pointer to the last item, or NULL if the deque is empty.
+ */
+extern void *cfl_deque_getLast(const CFL_DEQUEP deque);
+
+/**
+ * @brief Gets the item at the specified index, counted from the first item.
+ * @param deque Pointer to the deque.
+ * @param ulIndex Index of the item.
+ * @return Pointer to the item, or NULL if the index is out of bounds.
+ */
+extern void *cfl_deque_get(const CFL_DEQUEP deque, CFL_UINT32 ulIndex);
+
+/**
+ * @brief Sets the item at the specified index.
+ * @param deque Pointer to the deque.
+ * @param ulIndex Index of the item, ignored if out of bounds.
+ * @param item Pointer to the item to set.
+ */
+extern void cfl_deque_set(CFL_DEQUEP deque, CFL_UINT32 ulIndex, void *item);
+
+/**
+ * @brief Removes and returns the item at the specified index, moving the
+ * items of the shorter side.
+ * @param deque Pointer to the deque.
+ * @param ulIndex Index of the item.
+ * @return Pointer to the removed item, or NULL if the index is out of bounds.
+ */
+extern void *cfl_deque_remove(CFL_DEQUEP deque, CFL_UINT32 ulIndex);
+
+/**
+ * @brief Removes all items, keeping the buffer.
+ * @param deque Pointer to the deque.
+ */
+extern void cfl_deque_clear(CFL_DEQUEP deque);
+
+/**
+ * @brief Returns the number of items in the deque.
+ * @param deque Pointer to the deque.
+ * @return Number of items.
+ */
+extern CFL_UINT32 cfl_deque_length(const CFL_DEQUEP deque);
+
+/**
+ * @brief Checks if the deque is empty.
+ * @param deque Pointer to the deque.
+ * @return CFL_TRUE if the deque has no items.
+ */
+extern CFL_BOOL cfl_deque_isEmpty(const CFL_DEQUEP deque);
+
+/**
+ * @brief Creates an iterator over the items, from the first to the last.
+ * @param deque Pointer to the deque.
+ * @return Iterator for the deque.
+ */
+extern CFL_ITERATORP cfl_deque_iterator(CFL_DEQUEP deque);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
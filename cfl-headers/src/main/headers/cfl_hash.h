@@ -93,6 +93,20 @@ extern int cfl_hash_insert(CFL_HASHP h, void *k, void *v);
  */
 extern void *cfl_hash_search(CFL_HASHP h, void *k);
 
+/**
+ * @brief Searches for the values of several keys at once.
+ *
+ * Equivalent to calling cfl_hash_search for each key, but the lookups are
+ * interleaved and the buckets are prefetched, so the memory latency of a
+ * search overlaps with the others. Faster for tables larger than the cache.
+ *
+ * @param h The hash table to search.
+ * @param keys Array of keys to search for (does not claim ownership).
+ * @param values Array receiving the value of each key, or NULL if not found.
+ * @param count Number of keys.
+ */
+extern void cfl_hash_searchBatch(CFL_HASHP h, void **keys, void **values, CFL_UINT32 count);
+
 /**
  * @brief Removes an entry from the hash table.
  *
@@ -153,6 +167,15 @@ CFL_UINT32 cfl_hash_murmur3(const void *key, CFL_UINT32 len);
  */
 CFL_ITERATORP cfl_hash_iterator(CFL_HASHP h);
 
+/**
+ * @brief Initializes an iterator for the hash table in caller-provided
+ * storage, without allocating memory. Release it with cfl_iterator_dispose.
+ * @param it Iterator storage, usually the iterator of a CFL_ITERATOR_BUFFER.
+ * @param h The hash table to iterate over.
+ * @return The initialized iterator.
+ */
+CFL_ITERATORP cfl_hash_iteratorInit(CFL_ITERATORP it, CFL_HASHP h);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,219 @@
+/**
+ * @file cfl_ilist.h
+ * @brief Intrusive doubly linked list.
+ *
+ * This module provides a doubly linked list whose links are a CFL_ILIST_NODE
+ * embedded in the user structures, so adding an element allocates nothing
+ * and an element is removed or moved in constant time without searching for
+ * it. CFL_ILIST_ENTRY gets back the structure that contains a node.
+ *
+ * The list is circular around a sentinel node stored in CFL_ILIST, so a list
+ * must not be copied by value once initialized. A node belongs to at most one
+ * list at a time; nodes not in a list have NULL links.
+ */
+
+#ifndef CFL_ILIST_H_
+
+#define CFL_ILIST_H_
+
+#include <stddef.h>
+
+#include "cfl_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Returns a pointer to the structure containing a list node.
+ * @param node Pointer to the CFL_ILIST_NODE.
+ * @param type Type of the structure containing the node.
+ * @param member Name of the node member in the structure.
+ */
+#define CFL_ILIST_ENTRY(node, type, member) ((type *) ((char *) (node) - offsetof(type, member)))
+
+/**
+ * @brief Loops over the nodes of a list, from the first to the last. The
+ * current node must not be removed inside the loop.
+ * @param list Pointer to the list.
+ * @param node CFL_ILIST_NODEP variable receiving each node.
+ */
+#define CFL_ILIST_FOR_EACH(list, node) \
+   for ((node) = (list)->head.next; (node) != &(list)->head; (node) = (node)->next)
+
+/**
+ * @brief Loops over the nodes of a list, from the first to the last, allowing
+ * the current node to be removed inside the loop.
+ * @param list Pointer to the list.
+ * @param node CFL_ILIST_NODEP variable receiving each node.
+ * @param nextNode CFL_ILIST_NODEP variable used to keep the next node.
+ */
+#define CFL_ILIST_FOR_EACH_SAFE(list, node, nextNode) \
+   for ((node) = (list)->head.next, (nextNode) = (node)->next; (node) != &(list)->head; \
+        (node) = (nextNode), (nextNode) = (node)->next)
+
+/**
+ * @brief List links, embedded in the structures stored in the list.
+ */
+typedef struct _CFL_ILIST_NODE {
+  struct _CFL_ILIST_NODE *next;     /**< Next node, or the list sentinel */
+  struct _CFL_ILIST_NODE *previous; /**< Previous node, or the list sentinel */
+} CFL_ILIST_NODE, *CFL_ILIST_NODEP;
+
+/**
+ * @brief Intrusive list structure.
+ */
+typedef struct _CFL_ILIST {
+  CFL_ILIST_NODE head; /**< Sentinel node linking the last and first nodes */
+  CFL_UINT32 length;   /**< Number of nodes in the list */
+} CFL_ILIST, *CFL_ILISTP;
+
+/**
+ * @brief Initializes an empty list.
+ * @param list Pointer to the list.
+ */
+extern void cfl_ilist_init(CFL_ILISTP list);
+
+/**
+ * @brief Initializes a node as not linked to any list.
+ * @param node Pointer to the node.
+ */
+extern void cfl_ilist_nodeInit(CFL_ILIST_NODEP node);
+
+/**
+ * @brief Checks if a node is in a list.
+ * @param node Pointer to the node.
+ * @return CFL_TRUE if the node is linked.
+ */
+extern CFL_BOOL cfl_ilist_isLinked(const CFL_ILIST_NODEP node);
+
+/**
+ * @brief Adds a node to the beginning of the list.
+ * @param list Pointer to the list.
+ * @param node Pointer to a node not in any list.
+ */
+extern void cfl_ilist_addFirst(CFL_ILISTP list, CFL_ILIST_NODEP node);
+
+/**
+ * @brief Adds a node to the end of the list.
+ * @param list Pointer to the list.
+ * @param node Pointer to a node not in any list.
+ */
+extern void cfl_ilist_addLast(CFL_ILISTP list, CFL_ILIST_NODEP node);
+
+/**
+ * @brief Inserts a node before another node of the list.
+ * @param list Pointer to the list.
+ * @param position Pointer to a node of the list.
+ * @param node Pointer to a node not in any list.
+ */
+extern void cfl_ilist_insertBefore(CFL_ILISTP list, CFL_ILIST_NODEP position, CFL_ILIST_NODEP node);
+
+/**
+ * @brief Inserts a node after another node of the list.
+ * @param list Pointer to the list.
+ * @param position Pointer to a node of the list.
+ * @param node Pointer to a node not in any list.
+ */
+extern void cfl_ilist_insertAfter(CFL_ILISTP list, CFL_ILIST_NODEP position, CFL_ILIST_NODEP node);
+
+/**
+ * @brief Removes a node from the list. The node links are set to NULL.
+ * @param list Pointer to the list containing the node.
+ * @param node Pointer to the node.
+ */
+extern void cfl_ilist_remove(CFL_ILISTP list, CFL_ILIST_NODEP node);
+
+/**
+ * @brief Removes and returns the first node.
+ * @param list Pointer to the list.
+ * @return Pointer to the removed node, or NULL if the list is empty.
+ */
+extern CFL_ILIST_NODEP cfl_ilist_removeFirst(CFL_ILISTP list);
+
+/**
+ * @brief Removes and returns the last node.
+ * @param list Pointer to the list.
+ * @return Pointer to the removed node, or NULL if the list is empty.
+ */
+extern CFL_ILIST_NODEP cfl_ilist_removeLast(CFL_ILISTP list);
+
+/**
+ * @brief Moves a node of the list to its beginning.
+ * @param list Pointer to the list containing the node.
+ * @param node Pointer to the node.
+ */
+extern void cfl_ilist_moveToFirst(CFL_ILISTP list, CFL_ILIST_NODEP node);
+
+/**
+ * @brief Moves a node of the list to its end.
+ * @param list Pointer to the list containing the node.
+ * @param node Pointer to the node.
+ */
+extern void cfl_ilist_moveToLast(CFL_ILISTP list, CFL_ILIST_NODEP node);
+
+/**
+ * @brief Moves all nodes of another list to the beginning of the list, in
+ * constant time. The other list is left empty.
+ * @param list Pointer to the list.
+ * @param other Pointer to the list whose nodes are moved.
+ */
+extern void cfl_ilist_spliceFirst(CFL_ILISTP list, CFL_ILISTP other);
+
+/**
+ * @brief Moves all nodes of another list to the end of the list, in constant
+ * time. The other list is left empty.
+ * @param list Pointer to the list.
+ * @param other Pointer to the list whose nodes are moved.
+ */
+extern void cfl_ilist_spliceLast(CFL_ILISTP list, CFL_ILISTP other);
+
+/**
+ * @brief Returns the first node.
+ * @param list Pointer to the list.
+ * @return Pointer to the first node, or NULL if the list is empty.
+ */
+extern CFL_ILIST_NODEP cfl_ilist_first(const CFL_ILISTP list);
+
+/**
+ * @brief Returns the last node.
+ * @param list Pointer to the list.
+ * @return Pointer to the last node, or NULL if the list is empty.
+ */
+extern CFL_ILIST_NODEP cfl_ilist_last(const CFL_ILISTP list);
+
+/**
+ * @brief Returns the node after another node of the list.
+ * @param list Pointer to the list containing the node.
+ * @param node Pointer to the node.
+ * @return Pointer to the next node, or NULL if node is the last one.
+ */
+extern CFL_ILIST_NODEP cfl_ilist_next(const CFL_ILISTP list, const CFL_ILIST_NODEP node);
+
+/**
+ * @brief Returns the node before another node of the list.
+ * @param list Pointer to the list containing the node.
+ * @param node Pointer to the node.
+ * @return Pointer to the previous node, or NULL if node is the first one.
+ */
+extern CFL_ILIST_NODEP cfl_ilist_previous(const CFL_ILISTP list, const CFL_ILIST_NODEP node);
+
+/**
+ * @brief Returns the number of nodes in the list.
+ * @param list Pointer to the list.
+ * @return Number of nodes.
+ */
+extern CFL_UINT32 cfl_ilist_length(const CFL_ILISTP list);
+
+/**
+ * @brief Checks if the list is empty.
+ * @param list Pointer to the list.
+ * @return CFL_TRUE if the list has no nodes.
+ */
+extern CFL_BOOL cfl_ilist_isEmpty(const CFL_ILISTP list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,6 +29,15 @@ typedef CFL_ITERATOR_CLASS *CFL_ITERATOR_CLASSP;
 
 typedef void (*CFL_ITERATOR_FUNC)(void *);
 
+/** @brief Predicate used by cfl_iterator_filter, returns CFL_TRUE to keep a value */
+typedef CFL_BOOL (*CFL_ITERATOR_FILTER_FUNC)(void *value, void *context);
+
+/** @brief Transformation used by cfl_iterator_map */
+typedef void *(*CFL_ITERATOR_MAP_FUNC)(void *value, void *context);
+
+/** @brief Comparison used by cfl_iterator_merge, negative if value1 comes first */
+typedef int (*CFL_ITERATOR_COMPARE_FUNC)(void *value1, void *value2, void *context);
+
 /**
  * @brief Virtual function table for iterators.
  */
@@ -45,6 +54,9 @@ struct _CFL_ITERATOR_CLASS {
   void (*last)(CFL_ITERATORP it);      /**< Move to last element */
   void (*add)(CFL_ITERATORP it,
               void *value); /**< Add element at current position */
+  void (*dispose)(CFL_ITERATORP it); /**< Release resources without freeing the iterator */
+  CFL_UINT32 (*next_batch)(CFL_ITERATORP it, void **out,
+                           CFL_UINT32 n); /**< Move over up to n elements */
 };
 
 /**
@@ -54,6 +66,24 @@ struct _CFL_ITERATOR {
   CFL_ITERATOR_CLASS *itClass; /**< Pointer to implementation functions */
 };
 
+/**
+ * @brief Maximum size of the implementation data of an iterator initialized
+ * in a CFL_ITERATOR_BUFFER.
+ */
+#define CFL_ITERATOR_MAX_DATA_SIZE (72 * sizeof(void *))
+
+/**
+ * @brief Storage for an iterator provided by the caller, usually on the stack,
+ * and passed to the *_iteratorInit functions.
+ */
+typedef struct _CFL_ITERATOR_BUFFER {
+  CFL_ITERATOR iterator; /**< Iterator header */
+  union {
+    void *align;                              /**< Forces pointer alignment */
+    CFL_UINT8 bytes[CFL_ITERATOR_MAX_DATA_SIZE]; /**< Implementation data */
+  } data;
+} CFL_ITERATOR_BUFFER;
+
 /**
  * @brief Creates a new iterator (base constructor).
  * @param dataSize Size of the iterator implementation structure.
@@ -74,6 +104,13 @@ extern void *cfl_iterator_data(CFL_ITERATORP it);
  */
 extern void cfl_iterator_free(CFL_ITERATORP it);
 
+/**
+ * @brief Releases the resources of an iterator initialized by a *_iteratorInit
+ * function, without freeing the iterator memory.
+ * @param it The iterator to dispose.
+ */
+extern void cfl_iterator_dispose(CFL_ITERATORP it);
+
 /**
  * @brief Checks if there is a previous element.
  * @param it The iterator.
@@ -95,6 +132,17 @@ extern CFL_BOOL cfl_iterator_hasNext(CFL_ITERATORP it);
  */
 extern void *cfl_iterator_next(CFL_ITERATORP it);
 
+/**
+ * @brief Advances the iterator over up to n elements, storing them in out.
+ * Iterators without a native implementation fall back to calling next.
+ * @param it The iterator.
+ * @param out Array receiving at least n element pointers.
+ * @param n Maximum number of elements to return.
+ * @return Number of elements stored, less than n only at the end.
+ */
+extern CFL_UINT32 cfl_iterator_nextBatch(CFL_ITERATORP it, void **out,
+                                         CFL_UINT32 n);
+
 /**
  * @brief Returns the current element without moving the iterator.
  * @param it The iterator.
@@ -134,6 +182,81 @@ extern void cfl_iterator_last(CFL_ITERATORP it);
  */
 extern void cfl_iterator_add(CFL_ITERATORP it, void *value);
 
+/**
+ * @brief Creates an iterator over the values of a source iterator accepted by
+ * a predicate. Values are read from the source only as they are requested.
+ *
+ * Like the other adapters below, the new iterator moves only forward, takes
+ * ownership of its source iterators and frees them with cfl_iterator_free when
+ * freed itself, so the sources must not be initialized in a
+ * CFL_ITERATOR_BUFFER. If a source is NULL or memory cannot be allocated, the
+ * sources are freed and NULL is returned, so adapters can be nested directly.
+ * @param source Source iterator.
+ * @param filter Predicate called for each source value.
+ * @param context Pointer passed to the predicate.
+ * @return The new iterator, or NULL on failure.
+ */
+extern CFL_ITERATORP cfl_iterator_filter(CFL_ITERATORP source,
+                                         CFL_ITERATOR_FILTER_FUNC filter,
+                                         void *context);
+
+/**
+ * @brief Creates an iterator returning each value of a source iterator
+ * transformed by a function.
+ * @param source Source iterator.
+ * @param map Function called for each source value.
+ * @param context Pointer passed to the function.
+ * @return The new iterator, or NULL on failure.
+ */
+extern CFL_ITERATORP cfl_iterator_map(CFL_ITERATORP source,
+                                      CFL_ITERATOR_MAP_FUNC map,
+                                      void *context);
+
+/**
+ * @brief Creates an iterator returning at most the first count values of a
+ * source iterator. The source is not read past the last value returned.
+ * @param source Source iterator.
+ * @param count Maximum number of values.
+ * @return The new iterator, or NULL on failure.
+ */
+extern CFL_ITERATORP cfl_iterator_limit(CFL_ITERATORP source,
+                                        CFL_UINT32 count);
+
+/**
+ * @brief Creates an iterator that skips the first count values of a source
+ * iterator and returns the remaining ones.
+ * @param source Source iterator.
+ * @param count Number of values to skip.
+ * @return The new iterator, or NULL on failure.
+ */
+extern CFL_ITERATORP cfl_iterator_skip(CFL_ITERATORP source,
+                                       CFL_UINT32 count);
+
+/**
+ * @brief Creates an iterator returning all values of a first iterator and
+ * then all values of a second one.
+ * @param first First source iterator.
+ * @param second Second source iterator.
+ * @return The new iterator, or NULL on failure.
+ */
+extern CFL_ITERATORP cfl_iterator_concat(CFL_ITERATORP first,
+                                         CFL_ITERATORP second);
+
+/**
+ * @brief Creates an iterator merging two iterators sorted by the same order
+ * into a single sorted sequence. Equal values from the first iterator come
+ * before those from the second.
+ * @param first First sorted source iterator.
+ * @param second Second sorted source iterator.
+ * @param compare Comparison function.
+ * @param context Pointer passed to the comparison function.
+ * @return The new iterator, or NULL on failure.
+ */
+extern CFL_ITERATORP cfl_iterator_merge(CFL_ITERATORP first,
+                                        CFL_ITERATORP second,
+                                        CFL_ITERATOR_COMPARE_FUNC compare,
+                                        void *context);
+
 #if defined(__cplusplus)
 }
 #endif
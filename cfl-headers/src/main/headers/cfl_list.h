@@ -10,12 +10,17 @@
 
 #define CFL_LIST_H_
 
+#include "cfl_iterator.h"
+#include "cfl_sort.h"
 #include "cfl_types.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** @brief Returns the integer key of a list item, used by cfl_list_sortByKey */
+typedef CFL_UINT64 (*LIST_KEY_FUNC)(void *item);
+
 /**
  * @brief Dynamic list structure for storing pointers.
  */
@@ -115,6 +120,77 @@ extern CFL_UINT32 cfl_list_length(const CFL_LISTP list);
  */
 extern void cfl_list_setLength(CFL_LISTP list, CFL_UINT32 newLen);
 
+/**
+ * @brief Makes room for at least capacity items, so that adding up to that
+ * many items does not reallocate.
+ * @param list Pointer to the list.
+ * @param capacity Minimum capacity (number of items).
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_list_reserve(CFL_LISTP list, CFL_UINT32 capacity);
+
+/**
+ * @brief Reduces the capacity to the current length, releasing the unused
+ * memory.
+ * @param list Pointer to the list.
+ */
+extern void cfl_list_shrinkToFit(CFL_LISTP list);
+
+/**
+ * @brief Adds count items to the end of the list with a single copy.
+ * @param list Pointer to the list.
+ * @param items Array of count item pointers to add.
+ * @param count Number of items to add.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_list_appendN(CFL_LISTP list, void **items,
+                                 CFL_UINT32 count);
+
+/**
+ * @brief Adds all items of another list to the end of the list.
+ * @param list Pointer to the list.
+ * @param other Pointer to the list with the items to add.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_list_addAll(CFL_LISTP list, const CFL_LISTP other);
+
+/**
+ * @brief Inserts count items at the specified index, moving the following
+ * items only once.
+ * @param list Pointer to the list.
+ * @param ulIndex Index at which to insert, up to the list length.
+ * @param items Array of count item pointers to insert.
+ * @param count Number of items to insert.
+ * @return CFL_TRUE on success, CFL_FALSE if the index is out of bounds or
+ *         memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_list_insertRange(CFL_LISTP list, CFL_UINT32 ulIndex,
+                                     void **items, CFL_UINT32 count);
+
+/**
+ * @brief Deletes count items starting at the specified index, moving the
+ * following items only once.
+ * @param list Pointer to the list.
+ * @param ulIndex Index of the first item to delete.
+ * @param count Number of items to delete, limited to the end of the list.
+ * @note This does not free the deleted items.
+ */
+extern void cfl_list_deleteRange(CFL_LISTP list, CFL_UINT32 ulIndex,
+                                 CFL_UINT32 count);
+
+/**
+ * @brief Sets the length of the list, optionally without clearing the new
+ * slots.
+ * @param list Pointer to the list.
+ * @param newLen New length for the list.
+ * @param bZeroFill If CFL_TRUE, new slots are set to NULL as in
+ *        cfl_list_setLength. If CFL_FALSE they are left uninitialized and
+ *        must be set before being read.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_list_resize(CFL_LISTP list, CFL_UINT32 newLen,
+                                CFL_BOOL bZeroFill);
+
 /**
  * @brief Creates a shallow copy of a list.
  * @param other Pointer to the list to clone.
@@ -137,6 +213,48 @@ extern void *cfl_list_remove(CFL_LISTP list, CFL_UINT32 ulIndex);
  */
 extern void *cfl_list_removeLast(CFL_LISTP list);
 
+/**
+ * @brief Sorts the items with pattern-defeating quicksort. Not stable.
+ * @param list Pointer to the list.
+ * @param cmp Comparison function receiving pointers to two list slots, that
+ *        is, two (void **) as with qsort.
+ */
+extern void cfl_list_sort(CFL_LISTP list, CFL_SORT_CMP_FUNC cmp);
+
+/**
+ * @brief Sorts the items with merge sort, keeping the order of equal items.
+ * @param list Pointer to the list.
+ * @param cmp Comparison function receiving pointers to two list slots.
+ * @return CFL_TRUE if sorted, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_list_sortStable(CFL_LISTP list, CFL_SORT_CMP_FUNC cmp);
+
+/**
+ * @brief Sorts the items by an unsigned integer key with a stable radix sort.
+ * The key of each item is read once. To sort by a signed key, return it with
+ * its sign bit flipped.
+ * @param list Pointer to the list.
+ * @param keyFunc Function returning the key of an item.
+ * @return CFL_TRUE if sorted, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_list_sortByKey(CFL_LISTP list, LIST_KEY_FUNC keyFunc);
+
+/**
+ * @brief Creates an iterator over the items, from the first to the last.
+ * @param list Pointer to the list.
+ * @return Iterator for the list.
+ */
+extern CFL_ITERATORP cfl_list_iterator(CFL_LISTP list);
+
+/**
+ * @brief Initializes an iterator for the list in caller-provided storage,
+ * without allocating memory. Release it with cfl_iterator_dispose.
+ * @param it Iterator storage, usually the iterator of a CFL_ITERATOR_BUFFER.
+ * @param list Pointer to the list.
+ * @return The initialized iterator.
+ */
+extern CFL_ITERATORP cfl_list_iteratorInit(CFL_ITERATORP it, CFL_LISTP list);
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,6 +4,10 @@
  *
  * This module provides a map (dictionary) data structure that stores key-value
  * pairs with O(n) lookup complexity. Suitable for small collections.
+ *
+ * A map created in sorted mode (cfl_map_newSorted / cfl_map_initSorted) keeps
+ * its entries ordered by the key comparison function, so lookups are done by
+ * binary search in O(log n) and entries can be visited by key ranges.
  */
 
 #ifndef CFL_MAP_H_
@@ -32,6 +36,7 @@ typedef struct _CFL_MAP {
   CFL_UINT32 valueSize;             /**< Size of each value in bytes */
   MAP_COMP_FUNC keyCompFunc;        /**< Key comparison function */
   MAP_KEY_VALUE_FUNC freeEntryFunc; /**< Entry cleanup function */
+  CFL_BOOL sorted;                  /**< Whether entries are kept sorted */
   CFL_BOOL allocated;               /**< Whether structure was allocated */
 } CFL_MAP, *CFL_MAPP;
 
@@ -59,6 +64,30 @@ extern CFL_MAPP cfl_map_new(CFL_UINT32 keySize, CFL_UINT32 valueSize,
                             MAP_COMP_FUNC keyCompFunc,
                             MAP_KEY_VALUE_FUNC freeEntryFunc);
 
+/**
+ * @brief Initializes a map that keeps its entries sorted by key.
+ * @param map Pointer to the map to initialize.
+ * @param keySize Size of each key in bytes.
+ * @param valueSize Size of each value in bytes.
+ * @param keyCompFunc Function to compare keys. Must define a total order.
+ * @param freeEntryFunc Function to free entries (can be NULL).
+ */
+extern void cfl_map_initSorted(CFL_MAPP map, CFL_UINT32 keySize,
+                               CFL_UINT32 valueSize, MAP_COMP_FUNC keyCompFunc,
+                               MAP_KEY_VALUE_FUNC freeEntryFunc);
+
+/**
+ * @brief Creates a new map that keeps its entries sorted by key.
+ * @param keySize Size of each key in bytes.
+ * @param valueSize Size of each value in bytes.
+ * @param keyCompFunc Function to compare keys. Must define a total order.
+ * @param freeEntryFunc Function to free entries (can be NULL).
+ * @return Pointer to the new map, or NULL if allocation fails.
+ */
+extern CFL_MAPP cfl_map_newSorted(CFL_UINT32 keySize, CFL_UINT32 valueSize,
+                                  MAP_COMP_FUNC keyCompFunc,
+                                  MAP_KEY_VALUE_FUNC freeEntryFunc);
+
 /**
  * @brief Frees the memory used by a map.
  * @param map Pointer to the map to free.
@@ -131,6 +160,48 @@ extern void cfl_map_setKeyIndex(CFL_MAPP map, CFL_UINT32 index,
  */
 extern void cfl_map_copy(CFL_MAPP toMap, CFL_MAPP fromMap);
 
+/**
+ * @brief Adds many key-value pairs at once.
+ * @param map Pointer to the map.
+ * @param keys Contiguous array of count keys.
+ * @param values Contiguous array of count values.
+ * @param count Number of pairs.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated, in
+ *         which case the map is unchanged.
+ * @note In sorted mode the input does not need to be ordered: the pairs are
+ *       appended and the whole map is sorted once. When a key repeats, the
+ *       value that comes last wins, as with successive calls to cfl_map_set.
+ */
+extern CFL_BOOL cfl_map_setAll(CFL_MAPP map, const void *keys, const void *values,
+                               CFL_UINT32 count);
+
+/**
+ * @brief Finds the first entry whose key is not less than the given key.
+ * @param map Pointer to a sorted map.
+ * @param key Pointer to the key.
+ * @return Index of the entry, or the map length if there is none.
+ */
+extern CFL_UINT32 cfl_map_lowerBound(CFL_MAPP map, const void *key);
+
+/**
+ * @brief Finds the first entry whose key is greater than the given key.
+ * @param map Pointer to a sorted map.
+ * @param key Pointer to the key.
+ * @return Index of the entry, or the map length if there is none.
+ */
+extern CFL_UINT32 cfl_map_upperBound(CFL_MAPP map, const void *key);
+
+/**
+ * @brief Creates an iterator over the values of the entries whose keys are in
+ * the range [fromKey, toKey].
+ * @param map Pointer to a sorted map.
+ * @param fromKey Lower key of the range, or NULL to start at the first entry.
+ * @param toKey Upper key of the range, or NULL to end at the last entry.
+ * @return Iterator returning pointers to values, in key order.
+ */
+extern CFL_ITERATORP cfl_map_iteratorRange(CFL_MAPP map, const void *fromKey,
+                                           const void *toKey);
+
 /**
  * @brief Returns the number of entries in the map.
  * @param map Pointer to the map.
@@ -5,6 +5,12 @@
  * This module provides a specialized map implementation where both keys and
  * values are strings. It keeps copies of the strings, making it easier to
  * manage memory for simple string dictionaries.
+ *
+ * A map created in packed mode (cfl_mapstr_newPacked / cfl_mapstr_initPacked)
+ * appends all keys and values into a single byte arena owned by the map
+ * instead of allocating two buffers per entry. Strings returned by a packed
+ * map must be treated as read-only and are valid until the next change to the
+ * map.
  */
 
 #ifndef CFL_MAP_STR_H_
@@ -25,17 +31,25 @@ extern "C" {
  * @brief Entry structure for String Map.
  */
 typedef struct _CFL_MAPSTR_ENTRY {
-  CFL_STR key;        /**< Key string */
-  CFL_STR value;      /**< Value string */
-  CFL_BOOL allocated; /**< Allocation flag */
+  CFL_STR key;                 /**< Key string */
+  CFL_STR value;               /**< Value string */
+  struct _CFL_MAPSTR *packed;  /**< Packed map owning the arena of the strings, NULL otherwise */
+  CFL_UINT32 keyOffset;        /**< Key offset in the arena (packed mode) */
+  CFL_UINT32 valueOffset;      /**< Value offset in the arena (packed mode) */
+  CFL_BOOL allocated;          /**< Allocation flag */
 } CFL_MAPSTR_ENTRY, *CFL_MAPSTR_ENTRYP;
 
 /**
  * @brief String Map structure.
  */
 typedef struct _CFL_MAPSTR {
-  CFL_ARRAY entries;  /**< Array of CFL_MAPSTR_ENTRY */
-  CFL_BOOL allocated; /**< Allocation flag */
+  CFL_ARRAY entries;        /**< Array of CFL_MAPSTR_ENTRY */
+  char *arena;              /**< Key/value storage (packed mode) */
+  CFL_UINT32 arenaLength;   /**< Bytes used in the arena */
+  CFL_UINT32 arenaCapacity; /**< Bytes allocated for the arena */
+  CFL_UINT32 arenaWaste;    /**< Bytes no longer referenced by any entry */
+  CFL_BOOL packed;          /**< Packed mode flag */
+  CFL_BOOL allocated;       /**< Allocation flag */
 } CFL_MAPSTR, *CFL_MAPSTRP;
 
 /**
@@ -93,6 +107,36 @@ extern void cfl_mapstr_init(CFL_MAPSTRP map);
  */
 extern CFL_MAPSTRP cfl_mapstr_new(void);
 
+/**
+ * @brief Initializes a String Map in packed mode.
+ * @param map The map to initialize.
+ * @param arenaCapacity Initial size in bytes of the key/value arena.
+ */
+extern void cfl_mapstr_initPacked(CFL_MAPSTRP map, CFL_UINT32 arenaCapacity);
+
+/**
+ * @brief Creates a new String Map in packed mode.
+ * @param arenaCapacity Initial size in bytes of the key/value arena.
+ * @return Pointer to the new map.
+ */
+extern CFL_MAPSTRP cfl_mapstr_newPacked(CFL_UINT32 arenaCapacity);
+
+/**
+ * @brief Checks if the map stores its strings in a packed arena.
+ * @param map The map.
+ * @return CFL_TRUE if the map is in packed mode.
+ */
+extern CFL_BOOL cfl_mapstr_isPacked(CFL_MAPSTRP map);
+
+/**
+ * @brief Discards arena space left behind by deleted or replaced entries.
+ * @param map The map.
+ * @note Does nothing if the map is not in packed mode. It is called
+ *       automatically by cfl_mapstr_del when the unused space grows beyond
+ *       half of the arena.
+ */
+extern void cfl_mapstr_compact(CFL_MAPSTRP map);
+
 /**
  * @brief Frees a String Map and all its contents.
  * @param map The map to free.
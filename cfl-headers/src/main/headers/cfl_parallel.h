@@ -0,0 +1,233 @@
+/**
+ * @file cfl_parallel.h
+ * @brief Data parallel loops, reductions and sorting over a worker pool.
+ *
+ * This module splits a range of indexes, a cfl_array or a cfl_list into chunks
+ * and runs them on a pool of cfl_thread workers. The calling thread works on
+ * the chunks too, and every function returns only when all chunks are done.
+ * A pool runs one job at a time: when it is busy, for example when a chunk
+ * function calls back into the same pool, the job runs on the calling thread
+ * alone instead of waiting.
+ *
+ * Every function receiving a pool accepts NULL to use the shared pool, which
+ * is created on first use with one thread per processor.
+ */
+
+#ifndef CFL_PARALLEL_H_
+
+#define CFL_PARALLEL_H_
+
+#include "cfl_types.h"
+#include "cfl_array.h"
+#include "cfl_list.h"
+#include "cfl_lock.h"
+#include "cfl_sort.h"
+#include "cfl_thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Function run for each chunk of a parallel loop.
+ * @param start First index of the chunk.
+ * @param end Index after the last one of the chunk.
+ * @param context Context given to the parallel function.
+ */
+typedef void (*CFL_PARALLEL_RANGE_FUNC)(CFL_UINT32 start, CFL_UINT32 end, void *context);
+
+/**
+ * @brief Function run for each item of a cfl_array or cfl_list.
+ * @param item Pointer to the array item, or the list item itself.
+ * @param context Context given to the parallel function.
+ */
+typedef void (*CFL_PARALLEL_ITEM_FUNC)(void *item, void *context);
+
+/**
+ * @brief Function accumulating a chunk of indexes into a partial result.
+ * @param start First index of the chunk.
+ * @param end Index after the last one of the chunk.
+ * @param partial Partial result of the chunk, starting as a copy of the initial result.
+ * @param context Context given to the parallel function.
+ */
+typedef void (*CFL_PARALLEL_REDUCE_FUNC)(CFL_UINT32 start, CFL_UINT32 end, void *partial, void *context);
+
+/**
+ * @brief Function accumulating one item of a cfl_array or cfl_list into a partial result.
+ * @param partial Partial result of the chunk, starting as a copy of the initial result.
+ * @param item Pointer to the array item, or the list item itself.
+ * @param context Context given to the parallel function.
+ */
+typedef void (*CFL_PARALLEL_ACCUM_FUNC)(void *partial, void *item, void *context);
+
+/**
+ * @brief Function combining a partial result into the final result.
+ * @param result Final result.
+ * @param partial Partial result of a chunk.
+ * @param context Context given to the parallel function.
+ */
+typedef void (*CFL_PARALLEL_COMBINE_FUNC)(void *result, const void *partial, void *context);
+
+/**
+ * @brief Worker pool.
+ */
+typedef struct _CFL_PARALLEL {
+   CFL_LOCK                   lock;        /**< Protects the job and the worker state */
+   CFL_LOCK                   runLock;     /**< Held by the thread running a job */
+   CFL_CONDITION_VARIABLE     jobReady;    /**< Signaled when a job is published or the pool stops */
+   CFL_CONDITION_VARIABLE     jobDone;     /**< Signaled when the last worker leaves a job */
+   struct _CFL_PARALLEL_JOB  *job;         /**< Job being run, or NULL */
+   CFL_THREADP               *workers;     /**< Worker threads */
+   CFL_UINT32                 workerCount; /**< Number of worker threads */
+   CFL_UINT32                 generation;  /**< Incremented for each job published */
+   CFL_BOOL                   stop;        /**< Set when the pool is freed */
+} CFL_PARALLEL, *CFL_PARALLELP;
+
+/**
+ * @brief Returns the number of processors available to the process.
+ * @return Number of processors, at least 1.
+ */
+extern CFL_UINT32 cfl_parallel_cpuCount(void);
+
+/**
+ * @brief Creates a worker pool.
+ * @param threads Number of threads working on a job, including the calling
+ *        thread, or 0 for one thread per processor. A pool of 1 thread runs
+ *        every job on the calling thread.
+ * @return Pointer to the new pool, or NULL if allocation fails.
+ */
+extern CFL_PARALLELP cfl_parallel_new(CFL_UINT32 threads);
+
+/**
+ * @brief Stops the workers and frees the pool. It must not be running a job.
+ * @param pool Pointer to the pool.
+ */
+extern void cfl_parallel_free(CFL_PARALLELP pool);
+
+/**
+ * @brief Returns the shared pool, creating it on first use.
+ * @return Pointer to the shared pool, or NULL if it cannot be created.
+ */
+extern CFL_PARALLELP cfl_parallel_shared(void);
+
+/**
+ * @brief Frees the shared pool, if created. It must not be in use.
+ */
+extern void cfl_parallel_freeShared(void);
+
+/**
+ * @brief Returns the number of threads working on a job, including the calling thread.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @return Number of threads.
+ */
+extern CFL_UINT32 cfl_parallel_threads(CFL_PARALLELP pool);
+
+/**
+ * @brief Calls func for chunks covering the indexes 0 to count - 1, in parallel.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param count Number of indexes.
+ * @param func Function called for each chunk.
+ * @param context Context passed to func.
+ */
+extern void cfl_parallel_for(CFL_PARALLELP pool, CFL_UINT32 count, CFL_PARALLEL_RANGE_FUNC func, void *context);
+
+/**
+ * @brief Calls func for each item of an array, in parallel.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param array Pointer to the array.
+ * @param func Function called with a pointer to each item.
+ * @param context Context passed to func.
+ */
+extern void cfl_parallel_forArray(CFL_PARALLELP pool, CFL_ARRAYP array, CFL_PARALLEL_ITEM_FUNC func, void *context);
+
+/**
+ * @brief Calls func for each item of a list, in parallel.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param list Pointer to the list.
+ * @param func Function called with each item.
+ * @param context Context passed to func.
+ */
+extern void cfl_parallel_forList(CFL_PARALLELP pool, CFL_LISTP list, CFL_PARALLEL_ITEM_FUNC func, void *context);
+
+/**
+ * @brief Reduces the indexes 0 to count - 1 in parallel. Each chunk is
+ * accumulated into its own copy of the initial result, and the partial
+ * results are then combined into result in chunk order on the calling thread,
+ * so the initial result must be the identity of the combine function (such as
+ * 0 for a sum).
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param count Number of indexes.
+ * @param result Initial result on entry, final result on return.
+ * @param resultSize Size of the result in bytes.
+ * @param reduceFunc Function accumulating a chunk into a partial result.
+ * @param combineFunc Function combining a partial result into result.
+ * @param context Context passed to the functions.
+ */
+extern void cfl_parallel_reduce(CFL_PARALLELP pool, CFL_UINT32 count, void *result, CFL_UINT32 resultSize,
+                                CFL_PARALLEL_REDUCE_FUNC reduceFunc, CFL_PARALLEL_COMBINE_FUNC combineFunc,
+                                void *context);
+
+/**
+ * @brief Reduces the items of an array in parallel, as cfl_parallel_reduce.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param array Pointer to the array.
+ * @param result Initial result on entry, final result on return.
+ * @param resultSize Size of the result in bytes.
+ * @param accumFunc Function accumulating a pointer to an item into a partial result.
+ * @param combineFunc Function combining a partial result into result.
+ * @param context Context passed to the functions.
+ */
+extern void cfl_parallel_reduceArray(CFL_PARALLELP pool, CFL_ARRAYP array, void *result, CFL_UINT32 resultSize,
+                                     CFL_PARALLEL_ACCUM_FUNC accumFunc, CFL_PARALLEL_COMBINE_FUNC combineFunc,
+                                     void *context);
+
+/**
+ * @brief Reduces the items of a list in parallel, as cfl_parallel_reduce.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param list Pointer to the list.
+ * @param result Initial result on entry, final result on return.
+ * @param resultSize Size of the result in bytes.
+ * @param accumFunc Function accumulating an item into a partial result.
+ * @param combineFunc Function combining a partial result into result.
+ * @param context Context passed to the functions.
+ */
+extern void cfl_parallel_reduceList(CFL_PARALLELP pool, CFL_LISTP list, void *result, CFL_UINT32 resultSize,
+                                    CFL_PARALLEL_ACCUM_FUNC accumFunc, CFL_PARALLEL_COMBINE_FUNC combineFunc,
+                                    void *context);
+
+/**
+ * @brief Sorts the items in parallel. Runs of the items are sorted by cfl_sort
+ * on the pool threads and then merged pairwise, each merge being split into
+ * independent pieces so that all threads work until the last merge. Not
+ * stable. Uses an auxiliary buffer the size of the items and falls back to
+ * cfl_sort when it cannot be allocated.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param base Pointer to the first item.
+ * @param count Number of items.
+ * @param itemSize Size of each item in bytes.
+ * @param cmp Comparison function.
+ */
+extern void cfl_parallel_sort(CFL_PARALLELP pool, void *base, CFL_UINT32 count, CFL_UINT32 itemSize,
+                              CFL_SORT_CMP_FUNC cmp);
+
+/**
+ * @brief Sorts the items of an array in parallel with cfl_parallel_sort.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param array Pointer to the array.
+ * @param cmp Comparison function, receiving pointers to the items.
+ */
+extern void cfl_parallel_sortArray(CFL_PARALLELP pool, CFL_ARRAYP array, CFL_SORT_CMP_FUNC cmp);
+
+/**
+ * @brief Sorts the items of a list in parallel with cfl_parallel_sort.
+ * @param pool Pointer to the pool, or NULL for the shared pool.
+ * @param list Pointer to the list.
+ * @param cmp Comparison function, receiving pointers to the item pointers.
+ */
+extern void cfl_parallel_sortList(CFL_PARALLELP pool, CFL_LISTP list, CFL_SORT_CMP_FUNC cmp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,196 @@
+/**
+ * @file cfl_roaring.h
+ * @brief Compressed bitmap of 32-bit values.
+ *
+ * This module provides a Roaring-style compressed bitmap. Values are split in
+ * chunks of 65536 by their high 16 bits, and each chunk present in the set is
+ * stored in the smallest of three containers: a sorted array of up to 4096
+ * values, a bitmap of 65536 bits, or a list of runs of consecutive values.
+ * Sparse and clustered sets use a small fraction of the memory of a flat
+ * bitmap, while union and intersection work chunk by chunk on the
+ * containers.
+ */
+
+#ifndef CFL_ROARING_H_
+
+#define CFL_ROARING_H_
+
+#include "cfl_types.h"
+#include "cfl_buffer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Called by cfl_roaring_forEach for each value, returns CFL_FALSE to stop */
+typedef CFL_BOOL (*CFL_ROARING_FUNC)(CFL_UINT32 value, void *context);
+
+/** @brief Container of the values of one chunk, internal to the module */
+typedef struct _CFL_ROARING_CONTAINER CFL_ROARING_CONTAINER;
+
+/**
+ * @brief Compressed bitmap structure.
+ */
+typedef struct _CFL_ROARING {
+  CFL_ROARING_CONTAINER *containers; /**< Non-empty containers ordered by chunk */
+  CFL_UINT32 count;                  /**< Number of containers */
+  CFL_UINT32 capacity;               /**< Number of allocated containers */
+  CFL_BOOL allocated;                /**< Whether the structure was dynamically allocated */
+} CFL_ROARING, *CFL_ROARINGP;
+
+/**
+ * @brief Initializes an empty compressed bitmap.
+ * @param roaring Pointer to the structure to initialize.
+ */
+extern void cfl_roaring_init(CFL_ROARINGP roaring);
+
+/**
+ * @brief Creates a new empty compressed bitmap.
+ * @return Pointer to the new bitmap, or NULL if allocation fails.
+ */
+extern CFL_ROARINGP cfl_roaring_new(void);
+
+/**
+ * @brief Frees the memory used by a compressed bitmap.
+ * @param roaring Pointer to the bitmap.
+ */
+extern void cfl_roaring_free(CFL_ROARINGP roaring);
+
+/**
+ * @brief Creates a copy of a compressed bitmap.
+ * @param roaring Pointer to the bitmap to clone.
+ * @return Pointer to the new bitmap, or NULL if allocation fails.
+ */
+extern CFL_ROARINGP cfl_roaring_clone(const CFL_ROARINGP roaring);
+
+/**
+ * @brief Removes all values.
+ * @param roaring Pointer to the bitmap.
+ */
+extern void cfl_roaring_clear(CFL_ROARINGP roaring);
+
+/**
+ * @brief Adds a value.
+ * @param roaring Pointer to the bitmap.
+ * @param value Value to add.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_roaring_add(CFL_ROARINGP roaring, CFL_UINT32 value);
+
+/**
+ * @brief Adds all values of a range, stored as runs where possible.
+ * @param roaring Pointer to the bitmap.
+ * @param from First value of the range.
+ * @param to Last value of the range, inclusive.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_roaring_addRange(CFL_ROARINGP roaring, CFL_UINT32 from, CFL_UINT32 to);
+
+/**
+ * @brief Removes a value.
+ * @param roaring Pointer to the bitmap.
+ * @param value Value to remove.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated to
+ *         split a run.
+ */
+extern CFL_BOOL cfl_roaring_remove(CFL_ROARINGP roaring, CFL_UINT32 value);
+
+/**
+ * @brief Checks if a value is in the bitmap.
+ * @param roaring Pointer to the bitmap.
+ * @param value Value to look for.
+ * @return CFL_TRUE if the value is present.
+ */
+extern CFL_BOOL cfl_roaring_contains(const CFL_ROARINGP roaring, CFL_UINT32 value);
+
+/**
+ * @brief Returns the number of values in the bitmap.
+ * @param roaring Pointer to the bitmap.
+ * @return Number of values.
+ */
+extern CFL_UINT64 cfl_roaring_cardinality(const CFL_ROARINGP roaring);
+
+/**
+ * @brief Checks if the bitmap has no values.
+ * @param roaring Pointer to the bitmap.
+ * @return CFL_TRUE if the bitmap is empty.
+ */
+extern CFL_BOOL cfl_roaring_isEmpty(const CFL_ROARINGP roaring);
+
+/**
+ * @brief Adds the values of another bitmap.
+ * @param roaring Pointer to the bitmap to modify.
+ * @param other Pointer to the other bitmap.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated, in
+ *         which case the bitmap is unchanged.
+ */
+extern CFL_BOOL cfl_roaring_or(CFL_ROARINGP roaring, const CFL_ROARINGP other);
+
+/**
+ * @brief Keeps only the values also present in another bitmap.
+ * @param roaring Pointer to the bitmap to modify.
+ * @param other Pointer to the other bitmap.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated, in
+ *         which case the bitmap is unchanged.
+ */
+extern CFL_BOOL cfl_roaring_and(CFL_ROARINGP roaring, const CFL_ROARINGP other);
+
+/**
+ * @brief Converts each container to the smallest representation, turning
+ * long sequences of consecutive values into runs.
+ * @param roaring Pointer to the bitmap.
+ * @return CFL_TRUE on success, CFL_FALSE if memory cannot be allocated.
+ */
+extern CFL_BOOL cfl_roaring_optimize(CFL_ROARINGP roaring);
+
+/**
+ * @brief Calls a function for each value, in increasing order.
+ * @param roaring Pointer to the bitmap.
+ * @param func Function called with each value.
+ * @param context Pointer passed to the function.
+ * @return CFL_TRUE if all values were visited, CFL_FALSE if stopped by func.
+ */
+extern CFL_BOOL cfl_roaring_forEach(const CFL_ROARINGP roaring, CFL_ROARING_FUNC func, void *context);
+
+/**
+ * @brief Stores the values in increasing order.
+ * @param roaring Pointer to the bitmap.
+ * @param out Array receiving up to maxCount values.
+ * @param maxCount Maximum number of values to store.
+ * @return Number of values stored.
+ */
+extern CFL_UINT32 cfl_roaring_toArray(const CFL_ROARINGP roaring, CFL_UINT32 *out, CFL_UINT32 maxCount);
+
+/**
+ * @brief Checks if two bitmaps have the same values.
+ * @param roaring1 Pointer to the first bitmap.
+ * @param roaring2 Pointer to the second bitmap.
+ * @return CFL_TRUE if the bitmaps are equal.
+ */
+extern CFL_BOOL cfl_roaring_equals(const CFL_ROARINGP roaring1, const CFL_ROARINGP roaring2);
+
+/**
+ * @brief Writes the bitmap to a buffer at its current position. The
+ * containers are written as they are, so call cfl_roaring_optimize first for
+ * the most compact output. Numbers use the byte order of the buffer
+ * functions.
+ * @param roaring Pointer to the bitmap.
+ * @param buffer Pointer to the buffer.
+ * @return CFL_TRUE on success, CFL_FALSE if the buffer cannot grow.
+ */
+extern CFL_BOOL cfl_roaring_serialize(const CFL_ROARINGP roaring, CFL_BUFFERP buffer);
+
+/**
+ * @brief Reads a bitmap written by cfl_roaring_serialize from the current
+ * position of a buffer.
+ * @param buffer Pointer to the buffer.
+ * @return Pointer to the new bitmap, or NULL if the data is truncated or
+ *         invalid or memory cannot be allocated.
+ */
+extern CFL_ROARINGP cfl_roaring_deserialize(CFL_BUFFERP buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
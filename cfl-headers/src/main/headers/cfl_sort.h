@@ -0,0 +1,84 @@
+/**
+ * @file cfl_sort.h
+ * @brief Sorting of contiguous arrays of fixed-size items.
+ *
+ * This module provides the sort routines used by cfl_list and cfl_array:
+ * an unstable pattern-defeating quicksort (introsort with a heapsort fallback
+ * that also detects sorted, reversed and equal runs), a stable merge sort and
+ * an LSD radix sort for items ordered by an integer or fixed width key.
+ * Item moves are specialized for 4 and 8 byte items, such as pointers and
+ * integers, instead of going through a generic byte swap.
+ */
+
+#ifndef CFL_SORT_H_
+
+#define CFL_SORT_H_
+
+#include "cfl_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Comparison function, receiving pointers to the two items compared
+ * (the same contract as qsort).
+ * @return Negative, zero or positive if the first item is respectively less
+ *         than, equal to or greater than the second.
+ */
+typedef int (*CFL_SORT_CMP_FUNC)(const void *pItem1, const void *pItem2);
+
+/**
+ * @brief Types of the keys sorted by cfl_sort_radix.
+ */
+typedef enum {
+  CFL_SORT_KEY_UNSIGNED = 0, /**< Unsigned integer of 1, 2, 4 or 8 bytes in the machine byte order */
+  CFL_SORT_KEY_SIGNED = 1,   /**< Two's complement integer of 1, 2, 4 or 8 bytes in the machine byte order */
+  CFL_SORT_KEY_BYTES = 2     /**< Fixed width byte string, ordered as memcmp */
+} CFL_SORT_KEY_TYPE;
+
+/**
+ * @brief Sorts the items with pattern-defeating quicksort. Not stable.
+ * @param base Pointer to the first item.
+ * @param count Number of items.
+ * @param itemSize Size of each item in bytes.
+ * @param cmp Comparison function.
+ */
+extern void cfl_sort(void *base, CFL_UINT32 count, CFL_UINT32 itemSize,
+                     CFL_SORT_CMP_FUNC cmp);
+
+/**
+ * @brief Sorts the items with merge sort, keeping the order of equal items.
+ * @param base Pointer to the first item.
+ * @param count Number of items.
+ * @param itemSize Size of each item in bytes.
+ * @param cmp Comparison function.
+ * @return CFL_TRUE if sorted, CFL_FALSE if the auxiliary buffer (half the
+ *         size of the items) cannot be allocated.
+ */
+extern CFL_BOOL cfl_sort_stable(void *base, CFL_UINT32 count,
+                                CFL_UINT32 itemSize, CFL_SORT_CMP_FUNC cmp);
+
+/**
+ * @brief Sorts the items by a key stored inside each item with an LSD radix
+ * sort, in O(n) time per key byte and without calling a comparison function.
+ * The sort is stable. Passes over key bytes equal in all items are skipped.
+ * @param base Pointer to the first item.
+ * @param count Number of items.
+ * @param itemSize Size of each item in bytes.
+ * @param keyOffset Offset of the key inside each item.
+ * @param keySize Size of the key in bytes.
+ * @param keyType How the key bytes are ordered.
+ * @return CFL_TRUE if sorted, CFL_FALSE if the key does not fit in the item,
+ *         an integer key size is not 1, 2, 4 or 8, or the auxiliary buffer
+ *         (the size of the items) cannot be allocated.
+ */
+extern CFL_BOOL cfl_sort_radix(void *base, CFL_UINT32 count,
+                               CFL_UINT32 itemSize, CFL_UINT32 keyOffset,
+                               CFL_UINT32 keySize, CFL_SORT_KEY_TYPE keyType);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
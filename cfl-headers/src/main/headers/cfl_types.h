@@ -24,6 +24,10 @@
 #include "cfl_os.h"
 #include "cfl_ints.h"
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   #include <xmmintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -70,6 +74,15 @@ typedef unsigned char CFL_BOOL;
    #define CFL_INLINE
 #endif
 
+/* Hints the processor to bring the cache line of an address into the cache. Never faults, even on invalid addresses. */
+#if defined(__GNUC__) || defined(__clang__)
+   #define CFL_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   #define CFL_PREFETCH(p) _mm_prefetch((const char *) (p), _MM_HINT_T0)
+#else
+   #define CFL_PREFETCH(p) ((void) (p))
+#endif
+
 #define CFL_NO_ERROR_TYPE 0
 #define CFL_NO_ERROR_CODE 0
 
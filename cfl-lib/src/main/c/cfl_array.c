@@ -36,6 +36,7 @@ static void iteratorFirst(CFL_ITERATORP it);
 static CFL_BOOL iteratorHasPrevious(CFL_ITERATORP it);
 static void * iteratorPrevious(CFL_ITERATORP it);
 static void iteratorLast(CFL_ITERATORP it);
+static CFL_UINT32 iteratorNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
 
 static const CFL_ITERATOR_CLASS s_arrayIteratorClass = {
    iteratorHasNext,
@@ -47,7 +48,9 @@ static const CFL_ITERATOR_CLASS s_arrayIteratorClass = {
    iteratorHasPrevious,
    iteratorPrevious,
    iteratorLast,
-   NULL
+   NULL,
+   NULL,
+   iteratorNextBatch
 };
 
 void cfl_array_init(CFL_ARRAYP array, CFL_UINT32 ulCapacity, CFL_UINT32 ulItemSize) {
@@ -204,6 +207,159 @@ void cfl_array_setLength(CFL_ARRAYP array, CFL_UINT32 newLen) {
    }
 }
 
+static CFL_BOOL array_setCapacity(CFL_ARRAYP array, CFL_UINT32 ulCapacity) {
+   CFL_UINT8 *items;
+   if (array->items != NULL) {
+      items = (CFL_UINT8 *) CFL_MEM_REALLOC(array->items, (size_t) ulCapacity * array->ulItemSize);
+   } else {
+      items = (CFL_UINT8 *) CFL_MEM_ALLOC((size_t) ulCapacity * array->ulItemSize);
+   }
+   if (items == NULL) {
+      return CFL_FALSE;
+   }
+   array->items = items;
+   array->ulCapacity = ulCapacity;
+   return CFL_TRUE;
+}
+
+static CFL_BOOL array_grow(CFL_ARRAYP array, CFL_UINT32 ulCount) {
+   CFL_UINT32 ulNeeded = array->ulLength + ulCount;
+   CFL_UINT32 ulCapacity;
+   if (ulNeeded < array->ulLength) {
+      return CFL_FALSE;
+   }
+   if (ulNeeded <= array->ulCapacity && array->items != NULL) {
+      return CFL_TRUE;
+   }
+   ulCapacity = ( array->ulCapacity >> 1 ) + 1 + array->ulLength;
+   if (ulCapacity < ulNeeded) {
+      ulCapacity = ulNeeded;
+   }
+   return array_setCapacity(array, ulCapacity);
+}
+
+CFL_BOOL cfl_array_reserve(CFL_ARRAYP array, CFL_UINT32 ulCapacity) {
+   if (ulCapacity <= array->ulCapacity && (array->items != NULL || ulCapacity == 0)) {
+      return CFL_TRUE;
+   }
+   return array_setCapacity(array, ulCapacity);
+}
+
+void cfl_array_shrinkToFit(CFL_ARRAYP array) {
+   if (array->ulLength == 0) {
+      if (array->items != NULL) {
+         CFL_MEM_FREE(array->items);
+         array->items = NULL;
+      }
+      array->ulCapacity = 0;
+   } else if (array->ulLength < array->ulCapacity) {
+      array_setCapacity(array, array->ulLength);
+   }
+}
+
+// Returns the offset of items if it points into the array, which growing the array may move, or -1 otherwise
+static CFL_INT64 array_offsetOf(const CFL_ARRAYP array, const void *items) {
+   const CFL_UINT8 *pItems = (const CFL_UINT8 *) items;
+   if (array->items != NULL && pItems >= array->items &&
+       pItems < array->items + (size_t) array->ulLength * array->ulItemSize) {
+      return (CFL_INT64) (pItems - array->items);
+   }
+   return -1;
+}
+
+void *cfl_array_appendN(CFL_ARRAYP array, const void *items, CFL_UINT32 ulCount) {
+   CFL_INT64 srcOffset = array_offsetOf(array, items);
+   CFL_UINT8 *dest;
+   if (! array_grow(array, ulCount)) {
+      return NULL;
+   }
+   if (srcOffset >= 0) {
+      items = &array->items[srcOffset];
+   }
+   dest = &array->items[(size_t) array->ulLength * array->ulItemSize];
+   if (items != NULL) {
+      memcpy(dest, items, (size_t) ulCount * array->ulItemSize);
+   }
+   array->ulLength += ulCount;
+   return (void *) dest;
+}
+
+CFL_BOOL cfl_array_addAll(CFL_ARRAYP array, const CFL_ARRAYP other) {
+   if (other->ulItemSize != array->ulItemSize) {
+      return CFL_FALSE;
+   }
+   if (other->ulLength == 0) {
+      return CFL_TRUE;
+   }
+   return cfl_array_appendN(array, other->items, other->ulLength) != NULL;
+}
+
+void *cfl_array_insertRange(CFL_ARRAYP array, CFL_UINT32 ulIndex, const void *items, CFL_UINT32 ulCount) {
+   CFL_INT64 srcOffset = array_offsetOf(array, items);
+   size_t destOffset = (size_t) ulIndex * array->ulItemSize;
+   size_t size = (size_t) ulCount * array->ulItemSize;
+   CFL_UINT8 *dest;
+   if (ulIndex > array->ulLength || ! array_grow(array, ulCount)) {
+      return NULL;
+   }
+   dest = &array->items[destOffset];
+   if (ulIndex < array->ulLength) {
+      memmove(dest + size, dest, (size_t) (array->ulLength - ulIndex) * array->ulItemSize);
+   }
+   if (srcOffset >= 0) {
+      // Items from the array at or after the insertion point were moved up by size bytes
+      size_t before = (size_t) srcOffset < destOffset ? destOffset - (size_t) srcOffset : 0;
+      if (before > size) {
+         before = size;
+      }
+      memcpy(dest, &array->items[srcOffset], before);
+      memcpy(dest + before, &array->items[(size_t) srcOffset + before + size], size - before);
+   } else if (items != NULL) {
+      memcpy(dest, items, size);
+   }
+   array->ulLength += ulCount;
+   return (void *) dest;
+}
+
+void cfl_array_deleteRange(CFL_ARRAYP array, CFL_UINT32 ulIndex, CFL_UINT32 ulCount) {
+   if (ulIndex >= array->ulLength) {
+      return;
+   }
+   if (ulCount > array->ulLength - ulIndex) {
+      ulCount = array->ulLength - ulIndex;
+   }
+   memmove(&array->items[(size_t) ulIndex * array->ulItemSize],
+           &array->items[(size_t) (ulIndex + ulCount) * array->ulItemSize],
+           (size_t) (array->ulLength - ulIndex - ulCount) * array->ulItemSize);
+   array->ulLength -= ulCount;
+}
+
+CFL_BOOL cfl_array_resize(CFL_ARRAYP array, CFL_UINT32 newLen, CFL_BOOL bZeroFill) {
+   if (newLen > array->ulLength) {
+      if (! array_grow(array, newLen - array->ulLength)) {
+         return CFL_FALSE;
+      }
+      if (bZeroFill) {
+         memset(&array->items[(size_t) array->ulLength * array->ulItemSize], 0,
+                (size_t) (newLen - array->ulLength) * array->ulItemSize);
+      }
+   }
+   array->ulLength = newLen;
+   return CFL_TRUE;
+}
+
+void cfl_array_sort(CFL_ARRAYP array, CFL_SORT_CMP_FUNC cmp) {
+   cfl_sort(array->items, array->ulLength, array->ulItemSize, cmp);
+}
+
+CFL_BOOL cfl_array_sortStable(CFL_ARRAYP array, CFL_SORT_CMP_FUNC cmp) {
+   return cfl_sort_stable(array->items, array->ulLength, array->ulItemSize, cmp);
+}
+
+CFL_BOOL cfl_array_sortByKey(CFL_ARRAYP array, CFL_UINT32 keyOffset, CFL_UINT32 keySize, CFL_SORT_KEY_TYPE keyType) {
+   return cfl_sort_radix(array->items, array->ulLength, array->ulItemSize, keyOffset, keySize, keyType);
+}
+
 CFL_ARRAYP cfl_array_clone(const CFL_ARRAYP other) {
    CFL_ARRAYP clone = cfl_array_newLen(other->ulLength, other->ulItemSize);
    if (clone != NULL) {
@@ -269,6 +425,29 @@ static void iteratorLast(CFL_ITERATORP it) {
    data->index = cfl_array_length(data->array);
 }
 
+static CFL_UINT32 iteratorNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   ARRAY_ITERATORP data = (ARRAY_ITERATORP) cfl_iterator_data(it);
+   CFL_ARRAYP array = data->array;
+   CFL_UINT8 *item;
+   CFL_UINT32 count;
+   CFL_UINT32 i;
+
+   if (data->index >= array->ulLength) {
+      return 0;
+   }
+   count = array->ulLength - data->index;
+   if (count > n) {
+      count = n;
+   }
+   item = (CFL_UINT8 *) array->items + (size_t) data->index * array->ulItemSize;
+   for (i = 0; i < count; i++) {
+      out[i] = item;
+      item += array->ulItemSize;
+   }
+   data->index += count;
+   return count;
+}
+
 CFL_ITERATORP cfl_array_iterator(CFL_ARRAYP array) {
    CFL_ITERATORP it = cfl_iterator_new(sizeof(ARRAY_ITERATOR));
    ARRAY_ITERATORP data = (ARRAY_ITERATORP) cfl_iterator_data(it);
@@ -277,3 +456,11 @@ CFL_ITERATORP cfl_array_iterator(CFL_ARRAYP array) {
    data->index = 0;
    return it;
 }
+
+CFL_ITERATORP cfl_array_iteratorInit(CFL_ITERATORP it, CFL_ARRAYP array) {
+   ARRAY_ITERATORP data = (ARRAY_ITERATORP) cfl_iterator_data(it);
+   it->itClass = (CFL_ITERATOR_CLASS *) &s_arrayIteratorClass;
+   data->array = array;
+   data->index = 0;
+   return it;
+}
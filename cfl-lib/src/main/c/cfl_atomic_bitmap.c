@@ -0,0 +1,195 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cfl_atomic_bitmap.h"
+#include "cfl_atomic.h"
+#include "cfl_mem.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#if defined(CFL_OS_WINDOWS) && !defined(CFL_ARCH_64)
+#define WORD_SHIFT         5
+#define WORD_UNSIGNED      CFL_UINT32
+#define ATOMIC_GET(w)      cfl_atomic_getInt32(w)
+#define ATOMIC_OR(w, v)    cfl_atomic_orInt32(w, v)
+#define ATOMIC_AND(w, v)   cfl_atomic_andInt32(w, v)
+#else
+#define WORD_SHIFT         6
+#define WORD_UNSIGNED      CFL_UINT64
+#define ATOMIC_GET(w)      cfl_atomic_getInt64(w)
+#define ATOMIC_OR(w, v)    cfl_atomic_orInt64(w, v)
+#define ATOMIC_AND(w, v)   cfl_atomic_andInt64(w, v)
+#endif
+
+#define WORD_BITS          (1 << WORD_SHIFT)
+#define WORD_INDEX(pos)    ((pos) >> WORD_SHIFT)
+#define BIT_MASK(pos)      (((WORD_UNSIGNED) 1) << ((pos) & (WORD_BITS - 1)))
+#define ALL_BITS           (~((WORD_UNSIGNED) 0))
+
+static CFL_INLINE CFL_UINT32 popCount(WORD_UNSIGNED word) {
+#if defined(__GNUC__) || defined(__clang__)
+   return (CFL_UINT32) __builtin_popcountll(word);
+#else
+   CFL_UINT64 bits = word;
+   bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+   bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+   bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+   return (CFL_UINT32) ((bits * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* Position of the lowest set bit. The word must not be zero. */
+static CFL_INLINE CFL_UINT32 trailingZeros(WORD_UNSIGNED word) {
+#if defined(__GNUC__) || defined(__clang__)
+   return (CFL_UINT32) __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   unsigned long index;
+   _BitScanForward64(&index, word);
+   return (CFL_UINT32) index;
+#else
+   CFL_UINT32 count = 0;
+   while ((word & 1) == 0) {
+      word >>= 1;
+      ++count;
+   }
+   return count;
+#endif
+}
+
+/* Bits of a word that are inside the bitmap */
+static CFL_INLINE WORD_UNSIGNED validBits(const CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 index) {
+   if (index == bitmap->wordCount - 1 && (bitmap->numBits & (WORD_BITS - 1)) != 0) {
+      return BIT_MASK(bitmap->numBits) - 1;
+   }
+   return ALL_BITS;
+}
+
+CFL_BOOL cfl_atomic_bitmap_init(CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 numBits) {
+   bitmap->numBits = numBits;
+   bitmap->wordCount = (CFL_UINT32) (((CFL_UINT64) numBits + WORD_BITS - 1) >> WORD_SHIFT);
+   bitmap->allocated = CFL_FALSE;
+   if (bitmap->wordCount > 0) {
+      bitmap->words = (CFL_ATOMIC_BITMAP_WORD *) CFL_MEM_CALLOC(bitmap->wordCount, sizeof(CFL_ATOMIC_BITMAP_WORD));
+      if (bitmap->words == NULL) {
+         bitmap->numBits = 0;
+         bitmap->wordCount = 0;
+         return CFL_FALSE;
+      }
+   } else {
+      bitmap->words = NULL;
+   }
+   return CFL_TRUE;
+}
+
+CFL_ATOMIC_BITMAPP cfl_atomic_bitmap_new(CFL_UINT32 numBits) {
+   CFL_ATOMIC_BITMAPP bitmap = (CFL_ATOMIC_BITMAPP) CFL_MEM_ALLOC(sizeof(CFL_ATOMIC_BITMAP));
+   if (bitmap == NULL) {
+      return NULL;
+   }
+   if (!cfl_atomic_bitmap_init(bitmap, numBits)) {
+      CFL_MEM_FREE(bitmap);
+      return NULL;
+   }
+   bitmap->allocated = CFL_TRUE;
+   return bitmap;
+}
+
+void cfl_atomic_bitmap_free(CFL_ATOMIC_BITMAPP bitmap) {
+   if (bitmap != NULL) {
+      if (bitmap->words != NULL) {
+         CFL_MEM_FREE(bitmap->words);
+         bitmap->words = NULL;
+      }
+      if (bitmap->allocated) {
+         CFL_MEM_FREE(bitmap);
+      }
+   }
+}
+
+CFL_UINT32 cfl_atomic_bitmap_size(const CFL_ATOMIC_BITMAPP bitmap) {
+   return bitmap->numBits;
+}
+
+CFL_INT64 cfl_atomic_bitmap_tryAcquireFirstClear(CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 *hint) {
+   CFL_UINT32 start;
+   CFL_UINT32 index;
+   CFL_UINT32 n;
+
+   if (bitmap->wordCount == 0) {
+      return -1;
+   }
+   start = hint != NULL && *hint < bitmap->numBits ? WORD_INDEX(*hint) : 0;
+   index = start;
+   for (n = 0; n < bitmap->wordCount; n++) {
+      WORD_UNSIGNED valid = validBits(bitmap, index);
+      WORD_UNSIGNED word = (WORD_UNSIGNED) ATOMIC_GET(&bitmap->words[index]);
+      while ((word & valid) != valid) {
+         WORD_UNSIGNED mask = BIT_MASK(trailingZeros(~word & valid));
+         /* The previous value tells whether this thread set the bit */
+         word = (WORD_UNSIGNED) ATOMIC_OR(&bitmap->words[index], (CFL_ATOMIC_BITMAP_WORD) mask);
+         if ((word & mask) == 0) {
+            CFL_UINT32 pos = (index << WORD_SHIFT) + trailingZeros(mask);
+            if (hint != NULL) {
+               *hint = pos;
+            }
+            return (CFL_INT64) pos;
+         }
+      }
+      if (++index == bitmap->wordCount) {
+         index = 0;
+      }
+   }
+   return -1;
+}
+
+CFL_BOOL cfl_atomic_bitmap_tryAcquire(CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 pos) {
+   WORD_UNSIGNED previous;
+   if (pos >= bitmap->numBits) {
+      return CFL_FALSE;
+   }
+   previous = (WORD_UNSIGNED) ATOMIC_OR(&bitmap->words[WORD_INDEX(pos)], (CFL_ATOMIC_BITMAP_WORD) BIT_MASK(pos));
+   return (previous & BIT_MASK(pos)) == 0 ? CFL_TRUE : CFL_FALSE;
+}
+
+CFL_BOOL cfl_atomic_bitmap_release(CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 pos) {
+   WORD_UNSIGNED previous;
+   if (pos >= bitmap->numBits) {
+      return CFL_FALSE;
+   }
+   previous = (WORD_UNSIGNED) ATOMIC_AND(&bitmap->words[WORD_INDEX(pos)], (CFL_ATOMIC_BITMAP_WORD) ~BIT_MASK(pos));
+   return (previous & BIT_MASK(pos)) != 0 ? CFL_TRUE : CFL_FALSE;
+}
+
+CFL_BOOL cfl_atomic_bitmap_get(const CFL_ATOMIC_BITMAPP bitmap, CFL_UINT32 pos) {
+   if (pos >= bitmap->numBits) {
+      return CFL_FALSE;
+   }
+   return ((WORD_UNSIGNED) ATOMIC_GET(&bitmap->words[WORD_INDEX(pos)]) & BIT_MASK(pos)) != 0 ? CFL_TRUE : CFL_FALSE;
+}
+
+CFL_UINT32 cfl_atomic_bitmap_count(const CFL_ATOMIC_BITMAPP bitmap) {
+   CFL_UINT32 count = 0;
+   CFL_UINT32 i;
+   for (i = 0; i < bitmap->wordCount; i++) {
+      count += popCount((WORD_UNSIGNED) ATOMIC_GET(&bitmap->words[i]));
+   }
+   return count;
+}
@@ -0,0 +1,374 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "cfl_bitset.h"
+#include "cfl_mem.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#define WORD_INDEX(pos)   ((pos) >> 6)
+#define BIT_MASK(pos)     (((CFL_UINT64) 1) << ((pos) & 63))
+#define WORD_COUNT(bits)  ((CFL_UINT32) (((bits) + 63) >> 6))
+
+static CFL_INLINE CFL_UINT32 popCount(CFL_UINT64 word) {
+#if defined(__GNUC__) || defined(__clang__)
+   return (CFL_UINT32) __builtin_popcountll(word);
+#else
+   word = word - ((word >> 1) & 0x5555555555555555ULL);
+   word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+   word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+   return (CFL_UINT32) ((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* Position of the lowest set bit. The word must not be zero. */
+static CFL_INLINE CFL_UINT32 trailingZeros(CFL_UINT64 word) {
+#if defined(__GNUC__) || defined(__clang__)
+   return (CFL_UINT32) __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   unsigned long index;
+   _BitScanForward64(&index, word);
+   return (CFL_UINT32) index;
+#else
+   CFL_UINT32 count = 0;
+   while ((word & 1) == 0) {
+      word >>= 1;
+      ++count;
+   }
+   return count;
+#endif
+}
+
+/* Clears the bits of the last word that are beyond the size of the set */
+static void clearTail(CFL_BITSETP bitset) {
+   if ((bitset->numBits & 63) != 0) {
+      bitset->words[bitset->wordCount - 1] &= BIT_MASK(bitset->numBits) - 1;
+   }
+}
+
+CFL_BOOL cfl_bitset_init(CFL_BITSETP bitset, CFL_UINT64 numBits) {
+   bitset->words = NULL;
+   bitset->numBits = 0;
+   bitset->wordCount = 0;
+   bitset->allocated = CFL_FALSE;
+   if (numBits > CFL_BITSET_MAX_BITS) {
+      return CFL_FALSE;
+   }
+   if (numBits > 0) {
+      bitset->words = (CFL_UINT64 *) CFL_MEM_CALLOC(WORD_COUNT(numBits), sizeof(CFL_UINT64));
+      if (bitset->words == NULL) {
+         return CFL_FALSE;
+      }
+   }
+   bitset->numBits = numBits;
+   bitset->wordCount = WORD_COUNT(numBits);
+   return CFL_TRUE;
+}
+
+CFL_BITSETP cfl_bitset_new(CFL_UINT64 numBits) {
+   CFL_BITSETP bitset = (CFL_BITSETP) CFL_MEM_ALLOC(sizeof(CFL_BITSET));
+   if (bitset == NULL) {
+      return NULL;
+   }
+   if (! cfl_bitset_init(bitset, numBits)) {
+      CFL_MEM_FREE(bitset);
+      return NULL;
+   }
+   bitset->allocated = CFL_TRUE;
+   return bitset;
+}
+
+void cfl_bitset_free(CFL_BITSETP bitset) {
+   if (bitset != NULL) {
+      if (bitset->words != NULL) {
+         CFL_MEM_FREE(bitset->words);
+         bitset->words = NULL;
+      }
+      if (bitset->allocated) {
+         CFL_MEM_FREE(bitset);
+      }
+   }
+}
+
+CFL_BITSETP cfl_bitset_clone(const CFL_BITSETP bitset) {
+   CFL_BITSETP clone = cfl_bitset_new(bitset->numBits);
+   if (clone != NULL && bitset->wordCount > 0) {
+      memcpy(clone->words, bitset->words, (size_t) bitset->wordCount * sizeof(CFL_UINT64));
+   }
+   return clone;
+}
+
+CFL_BOOL cfl_bitset_resize(CFL_BITSETP bitset, CFL_UINT64 numBits) {
+   CFL_UINT32 wordCount = WORD_COUNT(numBits);
+
+   if (numBits > CFL_BITSET_MAX_BITS) {
+      return CFL_FALSE;
+   }
+   if (wordCount == 0) {
+      if (bitset->words != NULL) {
+         CFL_MEM_FREE(bitset->words);
+         bitset->words = NULL;
+      }
+   } else if (wordCount != bitset->wordCount) {
+      CFL_UINT64 *words = (CFL_UINT64 *) CFL_MEM_REALLOC(bitset->words, (size_t) wordCount * sizeof(CFL_UINT64));
+      if (words == NULL) {
+         return CFL_FALSE;
+      }
+      if (wordCount > bitset->wordCount) {
+         memset(&words[bitset->wordCount], 0, (size_t) (wordCount - bitset->wordCount) * sizeof(CFL_UINT64));
+      }
+      bitset->words = words;
+   }
+   bitset->numBits = numBits;
+   bitset->wordCount = wordCount;
+   if (wordCount > 0) {
+      clearTail(bitset);
+   }
+   return CFL_TRUE;
+}
+
+CFL_UINT64 cfl_bitset_size(const CFL_BITSETP bitset) {
+   return bitset->numBits;
+}
+
+void cfl_bitset_set(CFL_BITSETP bitset, CFL_UINT32 pos) {
+   if (pos < bitset->numBits) {
+      bitset->words[WORD_INDEX(pos)] |= BIT_MASK(pos);
+   }
+}
+
+void cfl_bitset_reset(CFL_BITSETP bitset, CFL_UINT32 pos) {
+   if (pos < bitset->numBits) {
+      bitset->words[WORD_INDEX(pos)] &= ~BIT_MASK(pos);
+   }
+}
+
+CFL_BOOL cfl_bitset_get(const CFL_BITSETP bitset, CFL_UINT32 pos) {
+   if (pos < bitset->numBits) {
+      return (bitset->words[WORD_INDEX(pos)] & BIT_MASK(pos)) != 0 ? CFL_TRUE : CFL_FALSE;
+   }
+   return CFL_FALSE;
+}
+
+void cfl_bitset_clear(CFL_BITSETP bitset) {
+   if (bitset->wordCount > 0) {
+      memset(bitset->words, 0, (size_t) bitset->wordCount * sizeof(CFL_UINT64));
+   }
+}
+
+void cfl_bitset_fill(CFL_BITSETP bitset) {
+   if (bitset->wordCount > 0) {
+      memset(bitset->words, 0xFF, (size_t) bitset->wordCount * sizeof(CFL_UINT64));
+      clearTail(bitset);
+   }
+}
+
+CFL_UINT64 cfl_bitset_count(const CFL_BITSETP bitset) {
+   const CFL_UINT64 *words = bitset->words;
+   CFL_UINT64 count = 0;
+   CFL_UINT32 i;
+
+   for (i = 0; i < bitset->wordCount; i++) {
+      count += popCount(words[i]);
+   }
+   return count;
+}
+
+CFL_INT64 cfl_bitset_nextSet(const CFL_BITSETP bitset, CFL_UINT32 from) {
+   CFL_UINT32 index;
+   CFL_UINT64 word;
+
+   if (from >= bitset->numBits) {
+      return -1;
+   }
+   index = WORD_INDEX(from);
+   word = bitset->words[index] & ~(BIT_MASK(from) - 1);
+   while (word == 0) {
+      if (++index >= bitset->wordCount) {
+         return -1;
+      }
+      word = bitset->words[index];
+   }
+   return ((CFL_INT64) index << 6) + trailingZeros(word);
+}
+
+CFL_INT64 cfl_bitset_nextClear(const CFL_BITSETP bitset, CFL_UINT32 from) {
+   CFL_UINT32 index;
+   CFL_UINT64 word;
+   CFL_INT64 pos;
+
+   if (from >= bitset->numBits) {
+      return -1;
+   }
+   index = WORD_INDEX(from);
+   word = ~bitset->words[index] & ~(BIT_MASK(from) - 1);
+   while (word == 0) {
+      if (++index >= bitset->wordCount) {
+         return -1;
+      }
+      word = ~bitset->words[index];
+   }
+   pos = ((CFL_INT64) index << 6) + trailingZeros(word);
+   /* The clear bits beyond the size of the set are not part of it */
+   return (CFL_UINT64) pos < bitset->numBits ? pos : -1;
+}
+
+CFL_BOOL cfl_bitset_forEach(const CFL_BITSETP bitset, CFL_BITSET_FUNC func, void *context) {
+   CFL_UINT32 i;
+
+   for (i = 0; i < bitset->wordCount; i++) {
+      CFL_UINT64 word = bitset->words[i];
+      while (word != 0) {
+         if (! func((i << 6) + trailingZeros(word), context)) {
+            return CFL_FALSE;
+         }
+         /* Clears the lowest set bit */
+         word &= word - 1;
+      }
+   }
+   return CFL_TRUE;
+}
+
+CFL_UINT32 cfl_bitset_toArray(const CFL_BITSETP bitset, CFL_UINT32 from, CFL_UINT32 *out, CFL_UINT32 maxCount) {
+   CFL_UINT32 count = 0;
+   CFL_UINT32 index;
+   CFL_UINT64 word;
+
+   if (from >= bitset->numBits || maxCount == 0) {
+      return 0;
+   }
+   index = WORD_INDEX(from);
+   word = bitset->words[index] & ~(BIT_MASK(from) - 1);
+   for (;;) {
+      while (word != 0) {
+         out[count++] = (index << 6) + trailingZeros(word);
+         if (count == maxCount) {
+            return count;
+         }
+         word &= word - 1;
+      }
+      if (++index >= bitset->wordCount) {
+         return count;
+      }
+      word = bitset->words[index];
+   }
+}
+
+/*
+ * The binary operations combine the words of both sets in place. With AVX2 four words are combined per instruction;
+ * otherwise the plain loop is left to the compiler, which vectorizes it with the instructions of the target.
+ */
+#if defined(__AVX2__)
+   #define VECTOR_LOOP(words, otherWords, count, i, vectorOp) \
+      for (; i + 4 <= count; i += 4) { \
+         __m256i v1 = _mm256_loadu_si256((const __m256i *) &words[i]); \
+         __m256i v2 = _mm256_loadu_si256((const __m256i *) &otherWords[i]); \
+         _mm256_storeu_si256((__m256i *) &words[i], vectorOp(v1, v2)); \
+      }
+   #define ANDNOT_VECTOR(v1, v2) _mm256_andnot_si256(v2, v1)
+#else
+   #define VECTOR_LOOP(words, otherWords, count, i, vectorOp)
+#endif
+
+void cfl_bitset_and(CFL_BITSETP bitset, const CFL_BITSETP other) {
+   CFL_UINT64 *words = bitset->words;
+   const CFL_UINT64 *otherWords = other->words;
+   CFL_UINT32 count = bitset->wordCount < other->wordCount ? bitset->wordCount : other->wordCount;
+   CFL_UINT32 i = 0;
+
+   VECTOR_LOOP(words, otherWords, count, i, _mm256_and_si256)
+   for (; i < count; i++) {
+      words[i] &= otherWords[i];
+   }
+   if (bitset->wordCount > count) {
+      memset(&words[count], 0, (size_t) (bitset->wordCount - count) * sizeof(CFL_UINT64));
+   }
+}
+
+void cfl_bitset_or(CFL_BITSETP bitset, const CFL_BITSETP other) {
+   CFL_UINT64 *words = bitset->words;
+   const CFL_UINT64 *otherWords = other->words;
+   CFL_UINT32 count = bitset->wordCount < other->wordCount ? bitset->wordCount : other->wordCount;
+   CFL_UINT32 i = 0;
+
+   VECTOR_LOOP(words, otherWords, count, i, _mm256_or_si256)
+   for (; i < count; i++) {
+      words[i] |= otherWords[i];
+   }
+   if (count > 0) {
+      clearTail(bitset);
+   }
+}
+
+void cfl_bitset_xor(CFL_BITSETP bitset, const CFL_BITSETP other) {
+   CFL_UINT64 *words = bitset->words;
+   const CFL_UINT64 *otherWords = other->words;
+   CFL_UINT32 count = bitset->wordCount < other->wordCount ? bitset->wordCount : other->wordCount;
+   CFL_UINT32 i = 0;
+
+   VECTOR_LOOP(words, otherWords, count, i, _mm256_xor_si256)
+   for (; i < count; i++) {
+      words[i] ^= otherWords[i];
+   }
+   if (count > 0) {
+      clearTail(bitset);
+   }
+}
+
+void cfl_bitset_andNot(CFL_BITSETP bitset, const CFL_BITSETP other) {
+   CFL_UINT64 *words = bitset->words;
+   const CFL_UINT64 *otherWords = other->words;
+   CFL_UINT32 count = bitset->wordCount < other->wordCount ? bitset->wordCount : other->wordCount;
+   CFL_UINT32 i = 0;
+
+   VECTOR_LOOP(words, otherWords, count, i, ANDNOT_VECTOR)
+   for (; i < count; i++) {
+      words[i] &= ~otherWords[i];
+   }
+}
+
+CFL_UINT64 cfl_bitset_andCount(const CFL_BITSETP bitset1, const CFL_BITSETP bitset2) {
+   const CFL_UINT64 *words1 = bitset1->words;
+   const CFL_UINT64 *words2 = bitset2->words;
+   CFL_UINT32 count = bitset1->wordCount < bitset2->wordCount ? bitset1->wordCount : bitset2->wordCount;
+   CFL_UINT64 bits = 0;
+   CFL_UINT32 i;
+
+   for (i = 0; i < count; i++) {
+      bits += popCount(words1[i] & words2[i]);
+   }
+   return bits;
+}
+
+CFL_BOOL cfl_bitset_equals(const CFL_BITSETP bitset1, const CFL_BITSETP bitset2) {
+   if (bitset1->numBits != bitset2->numBits) {
+      return CFL_FALSE;
+   }
+   if (bitset1->wordCount == 0) {
+      return CFL_TRUE;
+   }
+   return memcmp(bitset1->words, bitset2->words, (size_t) bitset1->wordCount * sizeof(CFL_UINT64)) == 0
+             ? CFL_TRUE : CFL_FALSE;
+}
@@ -0,0 +1,723 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfl_bptree.h"
+#include "cfl_iterator.h"
+#include "cfl_mem.h"
+
+/* Nodes have room for one extra key (and child) so that an insertion can overflow the node before it is split. */
+#define NODE_KEY(n, i)          ((n)->pPointers[i])
+#define NODE_CHILD(n, i)        ((CFL_BPTREE_NODEP) (n)->pPointers[(n)->pTree->lKeys + 1 + (i)])
+#define NODE_SET_KEY(n, i, p)   ((n)->pPointers[i] = (void *) (p))
+#define NODE_SET_CHILD(n, i, p) ((n)->pPointers[(n)->pTree->lKeys + 1 + (i)] = (void *) (p))
+
+#define MIN_KEYS(t)             ((t)->lKeys / 2)
+
+typedef struct _BPTreeIterator {
+   CFL_ITERATOR     iterator;
+   CFL_BPTREEP      pTree;
+   CFL_BPTREE_NODEP pLeaf;
+   CFL_INT32        lKey;
+   void            *pValue;
+   void            *pLowKey;
+   void            *pHighKey;
+   CFL_BOOL         bExact;
+} BPTreeIterator;
+
+static CFL_BOOL cfl_bptree_iterator_hasNext(CFL_ITERATORP pIt);
+static void *cfl_bptree_iterator_next(CFL_ITERATORP pIt);
+static void *cfl_bptree_iterator_value(CFL_ITERATORP pIt);
+static void cfl_bptree_iterator_first(CFL_ITERATORP pIt);
+static void cfl_bptree_iterator_last(CFL_ITERATORP pIt);
+static CFL_BOOL cfl_bptree_iterator_hasPrevious(CFL_ITERATORP pIt);
+static void *cfl_bptree_iterator_previous(CFL_ITERATORP pIt);
+
+static CFL_ITERATOR_CLASS cfl_bptree_iterator_class = {
+   cfl_bptree_iterator_hasNext,
+   cfl_bptree_iterator_next,
+   cfl_bptree_iterator_value,
+   NULL,
+   NULL,
+   cfl_bptree_iterator_first,
+   cfl_bptree_iterator_hasPrevious,
+   cfl_bptree_iterator_previous,
+   cfl_bptree_iterator_last,
+   NULL,
+   NULL,
+   NULL,
+};
+
+static CFL_BPTREE_NODEP cfl_bptree_node_new(CFL_BPTREEP pTree, CFL_BOOL bIsLeafNode) {
+   size_t pointersSize = sizeof(void *) * ((pTree->lKeys * 2) + 3);
+   CFL_BPTREE_NODEP pNode = (CFL_BPTREE_NODEP) CFL_MEM_ALLOC(sizeof(CFL_BPTREE_NODE) + pointersSize);
+   if (pNode == NULL) {
+      return NULL;
+   }
+   pNode->pTree = pTree;
+   pNode->lNumKeys = 0;
+   pNode->bIsLeafNode = bIsLeafNode;
+   pNode->pPrevLeaf = NULL;
+   pNode->pNextLeaf = NULL;
+   memset(pNode->pPointers, 0, pointersSize);
+   return pNode;
+}
+
+static void cfl_bptree_node_free(CFL_BPTREE_NODEP pNode) {
+   CFL_MEM_FREE(pNode);
+}
+
+static CFL_INT16 cfl_bptree_compareValues(CFL_BPTREEP pTree, void *pValue1, void *pValue2, CFL_BOOL bExact) {
+   CFL_INT16 iValue = -1;
+
+   if (pTree->pCompareValues != NULL) {
+      iValue = pTree->pCompareValues(pValue1, pValue2, bExact);
+   }
+   return iValue;
+}
+
+// Index of the first key of the node that is not less than pKey.
+
+static CFL_INT32 cfl_bptree_node_lowerBound(CFL_BPTREE_NODEP pNode, void *pKey, CFL_BOOL bExact) {
+   CFL_INT32 lFirst = 0;
+   CFL_INT32 lLast = pNode->lNumKeys;
+   while (lFirst < lLast) {
+      CFL_INT32 lMiddle = lFirst + ((lLast - lFirst) / 2);
+      if (cfl_bptree_compareValues(pNode->pTree, pKey, NODE_KEY(pNode, lMiddle), bExact) > 0) {
+         lFirst = lMiddle + 1;
+      } else {
+         lLast = lMiddle;
+      }
+   }
+   return lFirst;
+}
+
+// Index of the first key of the node that is greater than pKey.
+
+static CFL_INT32 cfl_bptree_node_upperBound(CFL_BPTREE_NODEP pNode, void *pKey, CFL_BOOL bExact) {
+   CFL_INT32 lFirst = 0;
+   CFL_INT32 lLast = pNode->lNumKeys;
+   while (lFirst < lLast) {
+      CFL_INT32 lMiddle = lFirst + ((lLast - lFirst) / 2);
+      if (cfl_bptree_compareValues(pNode->pTree, pKey, NODE_KEY(pNode, lMiddle), bExact) >= 0) {
+         lFirst = lMiddle + 1;
+      } else {
+         lLast = lMiddle;
+      }
+   }
+   return lFirst;
+}
+
+// Descend to the leaf that must contain pKey. A separator key is the smallest key of its right subtree.
+
+static CFL_BPTREE_NODEP cfl_bptree_findLeaf(CFL_BPTREEP pTree, void *pKey) {
+   CFL_BPTREE_NODEP pNode = pTree->pRoot;
+   while (!pNode->bIsLeafNode) {
+      pNode = NODE_CHILD(pNode, cfl_bptree_node_upperBound(pNode, pKey, CFL_TRUE));
+   }
+   return pNode;
+}
+
+// Position (leaf and key index) of the first key not less than (bUpper == FALSE) or greater than (bUpper == TRUE) pKey.
+// The index may be equal to the number of keys of the leaf when the position is at the end of the tree.
+
+static CFL_BPTREE_NODEP cfl_bptree_seek(CFL_BPTREEP pTree, void *pKey, CFL_BOOL bExact, CFL_BOOL bUpper, CFL_INT32 *plKey) {
+   CFL_BPTREE_NODEP pNode = pTree->pRoot;
+   CFL_INT32 i;
+   while (!pNode->bIsLeafNode) {
+      i = bUpper ? cfl_bptree_node_upperBound(pNode, pKey, bExact) : cfl_bptree_node_lowerBound(pNode, pKey, bExact);
+      pNode = NODE_CHILD(pNode, i);
+   }
+   i = bUpper ? cfl_bptree_node_upperBound(pNode, pKey, bExact) : cfl_bptree_node_lowerBound(pNode, pKey, bExact);
+   if (i >= pNode->lNumKeys && pNode->pNextLeaf != NULL) {
+      pNode = pNode->pNextLeaf;
+      i = 0;
+   }
+   *plKey = i;
+   return pNode;
+}
+
+CFL_BPTREEP cfl_bptree_new(CFL_INT32 lKeys, BTREE_CMP_VALUE_FUNC pCompareValues) {
+   CFL_BPTREEP pTree = (CFL_BPTREEP) CFL_MEM_ALLOC(sizeof(CFL_BPTREE));
+   if (pTree == NULL) {
+      return NULL;
+   }
+   pTree->lKeys = lKeys < 2 ? 2 : lKeys;
+   pTree->pCompareValues = pCompareValues;
+   pTree->lCount = 0;
+   pTree->pRoot = cfl_bptree_node_new(pTree, CFL_TRUE);
+   if (pTree->pRoot == NULL) {
+      CFL_MEM_FREE(pTree);
+      return NULL;
+   }
+   pTree->pFirstLeaf = pTree->pRoot;
+   pTree->pLastLeaf = pTree->pRoot;
+   return pTree;
+}
+
+static void cfl_bptree_freeNodes(CFL_BPTREE_NODEP pNode) {
+   if (!pNode->bIsLeafNode) {
+      CFL_INT32 i;
+      for (i = 0; i <= pNode->lNumKeys; i++) {
+         cfl_bptree_freeNodes(NODE_CHILD(pNode, i));
+      }
+   }
+   cfl_bptree_node_free(pNode);
+}
+
+void cfl_bptree_free(CFL_BPTREEP pTree, BTREE_FREE_KEY_FUNC pFreeKey) {
+   if (pTree == NULL) {
+      return;
+   }
+   if (pFreeKey != NULL) {
+      CFL_BPTREE_NODEP pLeaf;
+      for (pLeaf = pTree->pFirstLeaf; pLeaf != NULL; pLeaf = pLeaf->pNextLeaf) {
+         CFL_INT32 i;
+         for (i = 0; i < pLeaf->lNumKeys; i++) {
+            pFreeKey(NODE_KEY(pLeaf, i));
+         }
+      }
+   }
+   cfl_bptree_freeNodes(pTree->pRoot);
+   CFL_MEM_FREE(pTree);
+}
+
+// Allocate, before the tree is changed, the nodes that the insertion of the key may need: one for each full node at the
+// bottom of the path to its leaf, which would be split, and a new root if the whole path is full. The spare nodes are
+// chained by pNextLeaf.
+
+static CFL_BOOL cfl_bptree_reserveSplits(CFL_BPTREEP pTree, void *pKey, CFL_BPTREE_NODEP *ppSpare) {
+   CFL_BPTREE_NODEP pNode = pTree->pRoot;
+   CFL_INT32 lDepth = 0;
+   CFL_INT32 lSplits = 0;
+
+   *ppSpare = NULL;
+   for (;;) {
+      ++lDepth;
+      lSplits = pNode->lNumKeys >= pTree->lKeys ? lSplits + 1 : 0;
+      if (pNode->bIsLeafNode) {
+         break;
+      }
+      pNode = NODE_CHILD(pNode, cfl_bptree_node_upperBound(pNode, pKey, CFL_TRUE));
+   }
+   if (lSplits == lDepth) {
+      ++lSplits;
+   }
+   while (lSplits-- > 0) {
+      pNode = cfl_bptree_node_new(pTree, CFL_FALSE);
+      if (pNode == NULL) {
+         return CFL_FALSE;
+      }
+      pNode->pNextLeaf = *ppSpare;
+      *ppSpare = pNode;
+   }
+   return CFL_TRUE;
+}
+
+static CFL_BPTREE_NODEP cfl_bptree_takeSpare(CFL_BPTREE_NODEP *ppSpare, CFL_BOOL bIsLeafNode) {
+   CFL_BPTREE_NODEP pNode = *ppSpare;
+   *ppSpare = pNode->pNextLeaf;
+   pNode->pNextLeaf = NULL;
+   pNode->bIsLeafNode = bIsLeafNode;
+   return pNode;
+}
+
+static void cfl_bptree_freeSpares(CFL_BPTREE_NODEP pSpare) {
+   while (pSpare != NULL) {
+      CFL_BPTREE_NODEP pNext = pSpare->pNextLeaf;
+      cfl_bptree_node_free(pSpare);
+      pSpare = pNext;
+   }
+}
+
+// Split an overflowed leaf. The new right leaf is linked into the leaf chain and its first key is copied up as separator.
+
+static CFL_BPTREE_NODEP cfl_bptree_splitLeaf(CFL_BPTREE_NODEP pNode, void **ppSeparator, CFL_BPTREE_NODEP *ppSpare) {
+   CFL_BPTREEP pTree = pNode->pTree;
+   CFL_BPTREE_NODEP pNewNode = cfl_bptree_takeSpare(ppSpare, CFL_TRUE);
+   CFL_INT32 lLeftKeys = (pTree->lKeys + 1) / 2;
+   CFL_INT32 j;
+
+   pNewNode->lNumKeys = pNode->lNumKeys - lLeftKeys;
+   for (j = 0; j < pNewNode->lNumKeys; j++) {
+      NODE_SET_KEY(pNewNode, j, NODE_KEY(pNode, lLeftKeys + j));
+      NODE_SET_KEY(pNode, lLeftKeys + j, NULL);
+   }
+   pNode->lNumKeys = lLeftKeys;
+
+   pNewNode->pPrevLeaf = pNode;
+   pNewNode->pNextLeaf = pNode->pNextLeaf;
+   if (pNode->pNextLeaf != NULL) {
+      pNode->pNextLeaf->pPrevLeaf = pNewNode;
+   } else {
+      pTree->pLastLeaf = pNewNode;
+   }
+   pNode->pNextLeaf = pNewNode;
+
+   *ppSeparator = NODE_KEY(pNewNode, 0);
+   return pNewNode;
+}
+
+// Split an overflowed internal node. The median key moves up to the parent.
+
+static CFL_BPTREE_NODEP cfl_bptree_splitInternal(CFL_BPTREE_NODEP pNode, void **ppSeparator, CFL_BPTREE_NODEP *ppSpare) {
+   CFL_BPTREEP pTree = pNode->pTree;
+   CFL_BPTREE_NODEP pNewNode = cfl_bptree_takeSpare(ppSpare, CFL_FALSE);
+   CFL_INT32 lLeftKeys = (pTree->lKeys + 1) / 2;
+   CFL_INT32 j;
+
+   *ppSeparator = NODE_KEY(pNode, lLeftKeys);
+   NODE_SET_KEY(pNode, lLeftKeys, NULL);
+   pNewNode->lNumKeys = pNode->lNumKeys - lLeftKeys - 1;
+   for (j = 0; j < pNewNode->lNumKeys; j++) {
+      NODE_SET_KEY(pNewNode, j, NODE_KEY(pNode, lLeftKeys + 1 + j));
+      NODE_SET_KEY(pNode, lLeftKeys + 1 + j, NULL);
+   }
+   for (j = 0; j <= pNewNode->lNumKeys; j++) {
+      NODE_SET_CHILD(pNewNode, j, NODE_CHILD(pNode, lLeftKeys + 1 + j));
+      NODE_SET_CHILD(pNode, lLeftKeys + 1 + j, NULL);
+   }
+   pNode->lNumKeys = lLeftKeys;
+   return pNewNode;
+}
+
+// Insert the key in the subtree. When the node overflows it is split with a spare node and the new right node and its
+// separator are returned.
+
+static CFL_BOOL cfl_bptree_insertIntoNode(CFL_BPTREE_NODEP pNode, void *pKey, void **ppSeparator, CFL_BPTREE_NODEP *ppNewNode,
+                                          CFL_BPTREE_NODEP *ppSpare) {
+   CFL_INT32 i;
+   CFL_INT32 j;
+
+   *ppNewNode = NULL;
+   if (pNode->bIsLeafNode) {
+      i = cfl_bptree_node_lowerBound(pNode, pKey, CFL_TRUE);
+      if (i < pNode->lNumKeys && cfl_bptree_compareValues(pNode->pTree, pKey, NODE_KEY(pNode, i), CFL_TRUE) == 0) {
+         return CFL_FALSE;
+      }
+      for (j = pNode->lNumKeys; j > i; j--) {
+         NODE_SET_KEY(pNode, j, NODE_KEY(pNode, j - 1));
+      }
+      NODE_SET_KEY(pNode, i, pKey);
+      ++(pNode->lNumKeys);
+      if (pNode->lNumKeys > pNode->pTree->lKeys) {
+         *ppNewNode = cfl_bptree_splitLeaf(pNode, ppSeparator, ppSpare);
+      }
+   } else {
+      void *pChildSeparator;
+      CFL_BPTREE_NODEP pNewChild;
+      i = cfl_bptree_node_upperBound(pNode, pKey, CFL_TRUE);
+      if (!cfl_bptree_insertIntoNode(NODE_CHILD(pNode, i), pKey, &pChildSeparator, &pNewChild, ppSpare)) {
+         return CFL_FALSE;
+      }
+      if (pNewChild != NULL) {
+         for (j = pNode->lNumKeys; j > i; j--) {
+            NODE_SET_KEY(pNode, j, NODE_KEY(pNode, j - 1));
+            NODE_SET_CHILD(pNode, j + 1, NODE_CHILD(pNode, j));
+         }
+         NODE_SET_KEY(pNode, i, pChildSeparator);
+         NODE_SET_CHILD(pNode, i + 1, pNewChild);
+         ++(pNode->lNumKeys);
+         if (pNode->lNumKeys > pNode->pTree->lKeys) {
+            *ppNewNode = cfl_bptree_splitInternal(pNode, ppSeparator, ppSpare);
+         }
+      }
+   }
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_bptree_add(CFL_BPTREEP pTree, void *pKey) {
+   void *pSeparator;
+   CFL_BPTREE_NODEP pNewNode;
+   CFL_BPTREE_NODEP pSpare;
+
+   if (!cfl_bptree_reserveSplits(pTree, pKey, &pSpare)) {
+      cfl_bptree_freeSpares(pSpare);
+      return CFL_FALSE;
+   }
+   if (!cfl_bptree_insertIntoNode(pTree->pRoot, pKey, &pSeparator, &pNewNode, &pSpare)) {
+      cfl_bptree_freeSpares(pSpare);
+      return CFL_FALSE;
+   }
+   if (pNewNode != NULL) {
+      CFL_BPTREE_NODEP pNewRoot = cfl_bptree_takeSpare(&pSpare, CFL_FALSE);
+      NODE_SET_KEY(pNewRoot, 0, pSeparator);
+      NODE_SET_CHILD(pNewRoot, 0, pTree->pRoot);
+      NODE_SET_CHILD(pNewRoot, 1, pNewNode);
+      pNewRoot->lNumKeys = 1;
+      pTree->pRoot = pNewRoot;
+   }
+   cfl_bptree_freeSpares(pSpare);
+   ++(pTree->lCount);
+   return CFL_TRUE;
+}
+
+// Remove the key at lIndex and the child at lIndex + 1 from an internal node.
+
+static void cfl_bptree_node_removeSeparator(CFL_BPTREE_NODEP pNode, CFL_INT32 lIndex) {
+   CFL_INT32 j;
+   for (j = lIndex; j < pNode->lNumKeys - 1; j++) {
+      NODE_SET_KEY(pNode, j, NODE_KEY(pNode, j + 1));
+      NODE_SET_CHILD(pNode, j + 1, NODE_CHILD(pNode, j + 2));
+   }
+   NODE_SET_KEY(pNode, pNode->lNumKeys - 1, NULL);
+   NODE_SET_CHILD(pNode, pNode->lNumKeys, NULL);
+   --(pNode->lNumKeys);
+}
+
+// Move all keys (and children) of pRight into pLeft, pRight being the child lIndex + 1 of pParent. pRight is freed.
+
+static void cfl_bptree_mergeNodes(CFL_BPTREE_NODEP pParent, CFL_INT32 lIndex, CFL_BPTREE_NODEP pLeft, CFL_BPTREE_NODEP pRight) {
+   CFL_INT32 j;
+   if (pLeft->bIsLeafNode) {
+      for (j = 0; j < pRight->lNumKeys; j++) {
+         NODE_SET_KEY(pLeft, pLeft->lNumKeys + j, NODE_KEY(pRight, j));
+      }
+      pLeft->lNumKeys += pRight->lNumKeys;
+      pLeft->pNextLeaf = pRight->pNextLeaf;
+      if (pRight->pNextLeaf != NULL) {
+         pRight->pNextLeaf->pPrevLeaf = pLeft;
+      } else {
+         pLeft->pTree->pLastLeaf = pLeft;
+      }
+   } else {
+      // The separator comes down between the keys of both nodes
+      NODE_SET_KEY(pLeft, pLeft->lNumKeys, NODE_KEY(pParent, lIndex));
+      for (j = 0; j < pRight->lNumKeys; j++) {
+         NODE_SET_KEY(pLeft, pLeft->lNumKeys + 1 + j, NODE_KEY(pRight, j));
+      }
+      for (j = 0; j <= pRight->lNumKeys; j++) {
+         NODE_SET_CHILD(pLeft, pLeft->lNumKeys + 1 + j, NODE_CHILD(pRight, j));
+      }
+      pLeft->lNumKeys += pRight->lNumKeys + 1;
+   }
+   cfl_bptree_node_removeSeparator(pParent, lIndex);
+   cfl_bptree_node_free(pRight);
+}
+
+// Restore the minimum number of keys of the i-th child of pNode borrowing from a sibling or merging with it.
+
+static void cfl_bptree_rebalanceChild(CFL_BPTREE_NODEP pNode, CFL_INT32 i) {
+   CFL_BPTREE_NODEP pChild = NODE_CHILD(pNode, i);
+   CFL_BPTREE_NODEP pLeft = i > 0 ? NODE_CHILD(pNode, i - 1) : NULL;
+   CFL_BPTREE_NODEP pRight = i < pNode->lNumKeys ? NODE_CHILD(pNode, i + 1) : NULL;
+   CFL_INT32 lMinKeys = MIN_KEYS(pNode->pTree);
+   CFL_INT32 j;
+
+   if (pLeft != NULL && pLeft->lNumKeys > lMinKeys) {
+      if (!pChild->bIsLeafNode) {
+         NODE_SET_CHILD(pChild, pChild->lNumKeys + 1, NODE_CHILD(pChild, pChild->lNumKeys));
+      }
+      for (j = pChild->lNumKeys; j > 0; j--) {
+         NODE_SET_KEY(pChild, j, NODE_KEY(pChild, j - 1));
+         if (!pChild->bIsLeafNode) {
+            NODE_SET_CHILD(pChild, j, NODE_CHILD(pChild, j - 1));
+         }
+      }
+      if (pChild->bIsLeafNode) {
+         NODE_SET_KEY(pChild, 0, NODE_KEY(pLeft, pLeft->lNumKeys - 1));
+         NODE_SET_KEY(pNode, i - 1, NODE_KEY(pChild, 0));
+      } else {
+         NODE_SET_KEY(pChild, 0, NODE_KEY(pNode, i - 1));
+         NODE_SET_CHILD(pChild, 0, NODE_CHILD(pLeft, pLeft->lNumKeys));
+         NODE_SET_KEY(pNode, i - 1, NODE_KEY(pLeft, pLeft->lNumKeys - 1));
+         NODE_SET_CHILD(pLeft, pLeft->lNumKeys, NULL);
+      }
+      NODE_SET_KEY(pLeft, pLeft->lNumKeys - 1, NULL);
+      --(pLeft->lNumKeys);
+      ++(pChild->lNumKeys);
+   } else if (pRight != NULL && pRight->lNumKeys > lMinKeys) {
+      if (pChild->bIsLeafNode) {
+         NODE_SET_KEY(pChild, pChild->lNumKeys, NODE_KEY(pRight, 0));
+      } else {
+         NODE_SET_KEY(pChild, pChild->lNumKeys, NODE_KEY(pNode, i));
+         NODE_SET_CHILD(pChild, pChild->lNumKeys + 1, NODE_CHILD(pRight, 0));
+         NODE_SET_KEY(pNode, i, NODE_KEY(pRight, 0));
+      }
+      ++(pChild->lNumKeys);
+      for (j = 0; j < pRight->lNumKeys - 1; j++) {
+         NODE_SET_KEY(pRight, j, NODE_KEY(pRight, j + 1));
+         if (!pRight->bIsLeafNode) {
+            NODE_SET_CHILD(pRight, j, NODE_CHILD(pRight, j + 1));
+         }
+      }
+      if (!pRight->bIsLeafNode) {
+         NODE_SET_CHILD(pRight, j, NODE_CHILD(pRight, j + 1));
+         NODE_SET_CHILD(pRight, j + 1, NULL);
+      }
+      NODE_SET_KEY(pRight, j, NULL);
+      --(pRight->lNumKeys);
+      if (pChild->bIsLeafNode) {
+         NODE_SET_KEY(pNode, i, NODE_KEY(pRight, 0));
+      }
+   } else if (pLeft != NULL) {
+      cfl_bptree_mergeNodes(pNode, i - 1, pLeft, pChild);
+   } else if (pRight != NULL) {
+      cfl_bptree_mergeNodes(pNode, i, pChild, pRight);
+   }
+}
+
+static void *cfl_bptree_deleteFromNode(CFL_BPTREE_NODEP pNode, void *pKey) {
+   CFL_INT32 i;
+   if (pNode->bIsLeafNode) {
+      void *pDeletedKey;
+      i = cfl_bptree_node_lowerBound(pNode, pKey, CFL_TRUE);
+      if (i >= pNode->lNumKeys || cfl_bptree_compareValues(pNode->pTree, pKey, NODE_KEY(pNode, i), CFL_TRUE) != 0) {
+         return NULL;
+      }
+      pDeletedKey = NODE_KEY(pNode, i);
+      for (; i < pNode->lNumKeys - 1; i++) {
+         NODE_SET_KEY(pNode, i, NODE_KEY(pNode, i + 1));
+      }
+      NODE_SET_KEY(pNode, i, NULL);
+      --(pNode->lNumKeys);
+      return pDeletedKey;
+   } else {
+      void *pDeletedKey;
+      i = cfl_bptree_node_upperBound(pNode, pKey, CFL_TRUE);
+      pDeletedKey = cfl_bptree_deleteFromNode(NODE_CHILD(pNode, i), pKey);
+      if (pDeletedKey != NULL && NODE_CHILD(pNode, i)->lNumKeys < MIN_KEYS(pNode->pTree)) {
+         cfl_bptree_rebalanceChild(pNode, i);
+      }
+      return pDeletedKey;
+   }
+}
+
+// A deleted key may still be referenced as separator by an internal node in its search path. Replace it by the smallest
+// key of the right subtree, so that the caller can release the deleted key.
+
+static void cfl_bptree_replaceSeparator(CFL_BPTREEP pTree, void *pDeletedKey) {
+   CFL_BPTREE_NODEP pNode = pTree->pRoot;
+   while (!pNode->bIsLeafNode) {
+      CFL_INT32 i = cfl_bptree_node_upperBound(pNode, pDeletedKey, CFL_TRUE);
+      if (i > 0 && NODE_KEY(pNode, i - 1) == pDeletedKey) {
+         CFL_BPTREE_NODEP pMinNode = NODE_CHILD(pNode, i);
+         while (!pMinNode->bIsLeafNode) {
+            pMinNode = NODE_CHILD(pMinNode, 0);
+         }
+         NODE_SET_KEY(pNode, i - 1, NODE_KEY(pMinNode, 0));
+      }
+      pNode = NODE_CHILD(pNode, i);
+   }
+}
+
+void *cfl_bptree_delete(CFL_BPTREEP pTree, void *pKey) {
+   void *pDeletedKey = cfl_bptree_deleteFromNode(pTree->pRoot, pKey);
+   if (pDeletedKey != NULL) {
+      CFL_BPTREE_NODEP pRoot = pTree->pRoot;
+      if (!pRoot->bIsLeafNode && pRoot->lNumKeys == 0) {
+         pTree->pRoot = NODE_CHILD(pRoot, 0);
+         cfl_bptree_node_free(pRoot);
+      }
+      cfl_bptree_replaceSeparator(pTree, pDeletedKey);
+      --(pTree->lCount);
+   }
+   return pDeletedKey;
+}
+
+void *cfl_bptree_search(CFL_BPTREEP pTree, void *pKey) {
+   CFL_BPTREE_NODEP pLeaf = cfl_bptree_findLeaf(pTree, pKey);
+   CFL_INT32 i = cfl_bptree_node_lowerBound(pLeaf, pKey, CFL_TRUE);
+   if (i < pLeaf->lNumKeys && cfl_bptree_compareValues(pTree, pKey, NODE_KEY(pLeaf, i), CFL_TRUE) == 0) {
+      return NODE_KEY(pLeaf, i);
+   }
+   return NULL;
+}
+
+void *cfl_bptree_searchLike(CFL_BPTREEP pTree, void *pKey) {
+   CFL_INT32 i;
+   CFL_BPTREE_NODEP pLeaf = cfl_bptree_seek(pTree, pKey, CFL_FALSE, CFL_FALSE, &i);
+   if (i < pLeaf->lNumKeys && cfl_bptree_compareValues(pTree, pKey, NODE_KEY(pLeaf, i), CFL_FALSE) == 0) {
+      return NODE_KEY(pLeaf, i);
+   }
+   return NULL;
+}
+
+CFL_INT32 cfl_bptree_count(CFL_BPTREEP pTree) {
+   return pTree->lCount;
+}
+
+static BPTreeIterator *cfl_bptree_iteratorCreate(CFL_BPTREEP pTree, void *pLowKey, void *pHighKey, CFL_BOOL bExact) {
+   BPTreeIterator *pIt = (BPTreeIterator *) CFL_MEM_ALLOC(sizeof(BPTreeIterator));
+   if (pIt == NULL) {
+      return NULL;
+   }
+   pIt->iterator.itClass = &cfl_bptree_iterator_class;
+   pIt->pTree = pTree;
+   pIt->pLeaf = pTree->pFirstLeaf;
+   pIt->lKey = 0;
+   pIt->pValue = NULL;
+   pIt->pLowKey = pLowKey;
+   pIt->pHighKey = pHighKey;
+   pIt->bExact = bExact;
+   return pIt;
+}
+
+CFL_ITERATORP cfl_bptree_iterator(CFL_BPTREEP pTree) {
+   BPTreeIterator *pIt = cfl_bptree_iteratorCreate(pTree, NULL, NULL, CFL_TRUE);
+   return pIt != NULL ? &pIt->iterator : NULL;
+}
+
+CFL_ITERATORP cfl_bptree_iteratorLast(CFL_BPTREEP pTree) {
+   BPTreeIterator *pIt = cfl_bptree_iteratorCreate(pTree, NULL, NULL, CFL_TRUE);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   cfl_bptree_iterator_last(&pIt->iterator);
+   return &pIt->iterator;
+}
+
+CFL_ITERATORP cfl_bptree_iteratorSearch(CFL_BPTREEP pTree, void *pKey) {
+   BPTreeIterator *pIt;
+   CFL_INT32 i;
+   CFL_BPTREE_NODEP pLeaf = cfl_bptree_seek(pTree, pKey, CFL_TRUE, CFL_FALSE, &i);
+   if (i >= pLeaf->lNumKeys || cfl_bptree_compareValues(pTree, pKey, NODE_KEY(pLeaf, i), CFL_TRUE) != 0) {
+      return NULL;
+   }
+   pIt = cfl_bptree_iteratorCreate(pTree, NULL, NULL, CFL_TRUE);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   pIt->pLeaf = pLeaf;
+   pIt->lKey = i;
+   return &pIt->iterator;
+}
+
+CFL_ITERATORP cfl_bptree_iteratorSearchLike(CFL_BPTREEP pTree, void *pKey) {
+   BPTreeIterator *pIt;
+   if (cfl_bptree_searchLike(pTree, pKey) == NULL) {
+      return NULL;
+   }
+   pIt = cfl_bptree_iteratorCreate(pTree, pKey, pKey, CFL_FALSE);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   cfl_bptree_iterator_first(&pIt->iterator);
+   return &pIt->iterator;
+}
+
+CFL_ITERATORP cfl_bptree_iteratorSearchLastLike(CFL_BPTREEP pTree, void *pKey) {
+   BPTreeIterator *pIt;
+   if (cfl_bptree_searchLike(pTree, pKey) == NULL) {
+      return NULL;
+   }
+   pIt = cfl_bptree_iteratorCreate(pTree, pKey, pKey, CFL_FALSE);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   cfl_bptree_iterator_last(&pIt->iterator);
+   return &pIt->iterator;
+}
+
+CFL_ITERATORP cfl_bptree_iteratorRange(CFL_BPTREEP pTree, void *pFromKey, void *pToKey) {
+   BPTreeIterator *pIt = cfl_bptree_iteratorCreate(pTree, pFromKey, pToKey, CFL_TRUE);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   cfl_bptree_iterator_first(&pIt->iterator);
+   return &pIt->iterator;
+}
+
+// The iterator is a cursor between two keys: pLeaf/lKey is the position of the key returned by the next call to next().
+
+static void *cfl_bptree_iterator_peekNext(BPTreeIterator *pIt) {
+   while (pIt->lKey >= pIt->pLeaf->lNumKeys) {
+      if (pIt->pLeaf->pNextLeaf == NULL) {
+         return NULL;
+      }
+      pIt->pLeaf = pIt->pLeaf->pNextLeaf;
+      pIt->lKey = 0;
+   }
+   if (pIt->pHighKey != NULL
+       && cfl_bptree_compareValues(pIt->pTree, pIt->pHighKey, NODE_KEY(pIt->pLeaf, pIt->lKey), pIt->bExact) < 0) {
+      return NULL;
+   }
+   return NODE_KEY(pIt->pLeaf, pIt->lKey);
+}
+
+static void *cfl_bptree_iterator_peekPrevious(BPTreeIterator *pIt) {
+   while (pIt->lKey <= 0) {
+      if (pIt->pLeaf->pPrevLeaf == NULL) {
+         return NULL;
+      }
+      pIt->pLeaf = pIt->pLeaf->pPrevLeaf;
+      pIt->lKey = pIt->pLeaf->lNumKeys;
+   }
+   if (pIt->pLowKey != NULL
+       && cfl_bptree_compareValues(pIt->pTree, pIt->pLowKey, NODE_KEY(pIt->pLeaf, pIt->lKey - 1), pIt->bExact) > 0) {
+      return NULL;
+   }
+   return NODE_KEY(pIt->pLeaf, pIt->lKey - 1);
+}
+
+static CFL_BOOL cfl_bptree_iterator_hasNext(CFL_ITERATORP iterator) {
+   return cfl_bptree_iterator_peekNext((BPTreeIterator *) iterator) != NULL;
+}
+
+static void *cfl_bptree_iterator_next(CFL_ITERATORP iterator) {
+   BPTreeIterator *pIt = (BPTreeIterator *) iterator;
+   void *pKey = cfl_bptree_iterator_peekNext(pIt);
+   if (pKey != NULL) {
+      ++(pIt->lKey);
+      pIt->pValue = pKey;
+   }
+   return pKey;
+}
+
+static CFL_BOOL cfl_bptree_iterator_hasPrevious(CFL_ITERATORP iterator) {
+   return cfl_bptree_iterator_peekPrevious((BPTreeIterator *) iterator) != NULL;
+}
+
+static void *cfl_bptree_iterator_previous(CFL_ITERATORP iterator) {
+   BPTreeIterator *pIt = (BPTreeIterator *) iterator;
+   void *pKey = cfl_bptree_iterator_peekPrevious(pIt);
+   if (pKey != NULL) {
+      --(pIt->lKey);
+      pIt->pValue = pKey;
+   }
+   return pKey;
+}
+
+static void *cfl_bptree_iterator_value(CFL_ITERATORP iterator) {
+   return ((BPTreeIterator *) iterator)->pValue;
+}
+
+static void cfl_bptree_iterator_first(CFL_ITERATORP iterator) {
+   BPTreeIterator *pIt = (BPTreeIterator *) iterator;
+   if (pIt->pLowKey != NULL) {
+      pIt->pLeaf = cfl_bptree_seek(pIt->pTree, pIt->pLowKey, pIt->bExact, CFL_FALSE, &pIt->lKey);
+   } else {
+      pIt->pLeaf = pIt->pTree->pFirstLeaf;
+      pIt->lKey = 0;
+   }
+   pIt->pValue = NULL;
+}
+
+static void cfl_bptree_iterator_last(CFL_ITERATORP iterator) {
+   BPTreeIterator *pIt = (BPTreeIterator *) iterator;
+   if (pIt->pHighKey != NULL) {
+      pIt->pLeaf = cfl_bptree_seek(pIt->pTree, pIt->pHighKey, pIt->bExact, CFL_TRUE, &pIt->lKey);
+   } else {
+      pIt->pLeaf = pIt->pTree->pLastLeaf;
+      pIt->lKey = pIt->pLeaf->lNumKeys;
+   }
+   pIt->pValue = NULL;
+}
@@ -20,15 +20,20 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "cfl_atomic.h"
 #include "cfl_btree.h"
 #include "cfl_iterator.h"
 #include "cfl_mem.h"
 
+#define BTREE_MIN_KEYS(t) (((t)->lKeys - 1) / 2)
+
 typedef struct _BTreeIterator {
    CFL_ITERATOR    iterator;
    CFL_INT32       lKey;
    CFL_BTREE_NODEP pNode;
+   void           *pValue;
    struct _BTreeIterator *pPreviousIt;
+   CFL_BTREEP      pTree; // Tree or snapshot iterated, whose root first and last return to
 } BTreeIterator;
 
 static CFL_BOOL cfl_btree_iterator_hasNext(CFL_ITERATORP pIt);
@@ -39,6 +44,7 @@ static void cfl_btree_iterator_first(CFL_ITERATORP pIt);
 static void cfl_btree_iterator_last(CFL_ITERATORP pIt);
 static CFL_BOOL cfl_btree_iterator_hasPrevious(CFL_ITERATORP pIt);
 static void *cfl_btree_iterator_previous(CFL_ITERATORP pIt);
+static CFL_UINT32 cfl_btree_iterator_nextBatch(CFL_ITERATORP pIt, void **out, CFL_UINT32 n);
 
 static CFL_ITERATOR_CLASS cfl_btree_iterator_class = {
    cfl_btree_iterator_hasNext,
@@ -51,6 +57,52 @@ static CFL_ITERATOR_CLASS cfl_btree_iterator_class = {
    cfl_btree_iterator_previous,
    cfl_btree_iterator_last,
    NULL,
+   NULL,
+   cfl_btree_iterator_nextBatch,
+};
+
+/*
+ * Iterator initialized in storage provided by the caller. The path from the root to the cursor is kept in a fixed
+ * array instead of a chain of allocated nodes. Every node has at least 3 keys of capacity, so an internal node has at
+ * least 2 children and a tree of up to 2^31 keys is never deeper than BTREE_ITERATOR_MAX_DEPTH levels.
+ */
+#define BTREE_ITERATOR_MAX_DEPTH 32
+
+typedef struct _BTreeStackLevel {
+   CFL_BTREE_NODEP pNode;
+   CFL_INT32       lKey;
+} BTreeStackLevel;
+
+typedef struct _BTreeStackIterator {
+   CFL_ITERATOR    iterator;
+   void           *pValue;
+   CFL_BTREEP      pTree; // Tree or snapshot iterated, whose root first and last return to
+   CFL_INT32       lDepth;
+   BTreeStackLevel levels[BTREE_ITERATOR_MAX_DEPTH];
+} BTreeStackIterator;
+
+static CFL_BOOL cfl_btree_stackIterator_hasNext(CFL_ITERATORP pIt);
+static void *cfl_btree_stackIterator_next(CFL_ITERATORP pIt);
+static void *cfl_btree_stackIterator_value(CFL_ITERATORP pIt);
+static void cfl_btree_stackIterator_first(CFL_ITERATORP pIt);
+static void cfl_btree_stackIterator_last(CFL_ITERATORP pIt);
+static CFL_BOOL cfl_btree_stackIterator_hasPrevious(CFL_ITERATORP pIt);
+static void *cfl_btree_stackIterator_previous(CFL_ITERATORP pIt);
+static CFL_UINT32 cfl_btree_stackIterator_nextBatch(CFL_ITERATORP pIt, void **out, CFL_UINT32 n);
+
+static CFL_ITERATOR_CLASS cfl_btree_stackIterator_class = {
+   cfl_btree_stackIterator_hasNext,
+   cfl_btree_stackIterator_next,
+   cfl_btree_stackIterator_value,
+   NULL,
+   NULL,
+   cfl_btree_stackIterator_first,
+   cfl_btree_stackIterator_hasPrevious,
+   cfl_btree_stackIterator_previous,
+   cfl_btree_stackIterator_last,
+   NULL,
+   NULL,
+   cfl_btree_stackIterator_nextBatch,
 };
 
 static CFL_BTREE_NODEP cfl_btree_node_new(CFL_BTREEP pTree) {
@@ -64,7 +116,9 @@ static CFL_BTREE_NODEP cfl_btree_node_new(CFL_BTREEP pTree) {
    }
    pNode->pTree = pTree;
    pNode->lNumKeys = 0;
+   pNode->lCount = 0;
    pNode->bIsLeafNode = CFL_TRUE;
+   pNode->lRefCount = 1;
    memset(pNode->pPointers, 0, sizeof(void *) * (pTree->lKeys * 4));
 
    return pNode;
@@ -74,32 +128,60 @@ static void cfl_btree_node_free(CFL_BTREE_NODEP pNode) {
    CFL_MEM_FREE(pNode);
 }
 
-static CFL_INT16 cfl_btree_compareValues(CFL_BTREEP pTree, void * pValue1, void * pValue2, CFL_BOOL bExact) {
-   CFL_INT16 iValue = -1;
+// Drop a reference to the node. The last reference frees the node, its keys if pFreeKey is given, and drops the
+// references of the node to its children.
 
-   if (pTree->pCompareValues != NULL) {
-      iValue = pTree->pCompareValues(pValue1, pValue2, bExact);
+static void cfl_btree_node_release(CFL_BTREE_NODEP pNode, BTREE_FREE_KEY_FUNC pFreeKey) {
+   CFL_INT32 i;
+   if (cfl_atomic_subInt32(&pNode->lRefCount, 1) != 1) {
+      return;
    }
-   return iValue;
+   if (!pNode->bIsLeafNode) {
+      for (i = 0; i <= pNode->lNumKeys; i++) {
+         cfl_btree_node_release(GET_CHILD(pNode, i), pFreeKey);
+      }
+   }
+   if (pFreeKey != NULL) {
+      for (i = 0; i < pNode->lNumKeys; i++) {
+         pFreeKey(GET_KEY(pNode, i));
+      }
+   }
+   cfl_btree_node_free(pNode);
 }
 
-static CFL_INT32 cfl_btree_node_search(CFL_BTREE_NODEP pNode, void * pKey, CFL_BOOL bExact) {
-   CFL_INT32 lLeftIndex = 0;
-   CFL_INT32 lRightIndex = pNode->lNumKeys - 1;
+// Return the node itself if it can be modified in place, or a copy of it if the node is shared with a snapshot.
+// The copy takes a reference to each child and the caller must replace the node by the copy in its parent, which
+// must already be writable. Nodes are made writable from the root down, so a node whose count is 1 is referenced
+// only by the path the writer is on. Without snapshots no node is shared and the counter of the node is not read.
 
-   while (lLeftIndex <= lRightIndex) {
-      CFL_INT32 lMiddleIndex = lLeftIndex + ((lRightIndex - lLeftIndex) / 2);
-      CFL_INT16 iCmp = cfl_btree_compareValues(pNode->pTree, GET_KEY(pNode, lMiddleIndex), pKey, bExact);
-      if (iCmp < 0) {
-         lLeftIndex = lMiddleIndex + 1;
-      } else if (iCmp > 0) {
-         lRightIndex = lMiddleIndex - 1;
-      } else {
-         return lMiddleIndex;
+static CFL_BTREE_NODEP cfl_btree_node_writable(CFL_BTREE_NODEP pNode) {
+   CFL_BTREE_NODEP pCopy;
+   CFL_INT32 i;
+
+   if (cfl_atomic_getInt32(&pNode->pTree->lSnapshots) == 0 || cfl_atomic_getInt32(&pNode->lRefCount) == 1) {
+      return pNode;
+   }
+   pCopy = cfl_btree_node_new(pNode->pTree);
+   pCopy->lNumKeys = pNode->lNumKeys;
+   pCopy->lCount = pNode->lCount;
+   pCopy->bIsLeafNode = pNode->bIsLeafNode;
+   memcpy(pCopy->pPointers, pNode->pPointers, sizeof(void *) * (pNode->lNumKeys * 2 + 1));
+   if (!pCopy->bIsLeafNode) {
+      for (i = 0; i <= pCopy->lNumKeys; i++) {
+         cfl_atomic_addInt32(&GET_CHILD(pCopy, i)->lRefCount, 1);
       }
    }
+   cfl_btree_node_release(pNode, NULL);
+   return pCopy;
+}
+
+static CFL_INT16 cfl_btree_compareValues(CFL_BTREEP pTree, void * pValue1, void * pValue2, CFL_BOOL bExact) {
+   CFL_INT16 iValue = -1;
 
-   return -1;
+   if (pTree->pCompareValues != NULL) {
+      iValue = pTree->pCompareValues(pValue1, pValue2, bExact);
+   }
+   return iValue;
 }
 
 static CFL_INT32 cfl_btree_node_keyAscPosition(CFL_BTREE_NODEP pNode, void * pKey) {
@@ -148,119 +230,74 @@ static CFL_INT32 cfl_btree_node_keyDescPosition(CFL_BTREE_NODEP pNode, void * pK
    return 0;
 }
 
-// Remove an element from a node and also the left (0) or right (+1) child.
-
-static void * cfl_btree_node_remove(CFL_BTREE_NODEP pNode, CFL_INT32 lIndex, CFL_INT32 lLeftOrRightChild) {
-   if (lIndex >= 0) {
-      CFL_INT32 i;
-      void * pKeyDeleted;
-
-      pKeyDeleted = GET_KEY(pNode, lIndex);
-
-      for (i = lIndex; i < pNode->lNumKeys - 1; i++) {
-         void * src = GET_KEY(pNode, i + 1);
-         SET_KEY(pNode, i, src);
-         if (!pNode->bIsLeafNode) {
-            if (i >= lIndex + lLeftOrRightChild) {
-               SET_CHILD(pNode, i, GET_CHILD(pNode, i + 1));
-            }
-         }
-      }
-      // i is now pNode->lNumKeys - 1
-      SET_KEY(pNode, i, NULL);
-      if (!pNode->bIsLeafNode) {
-         if (i >= lIndex + lLeftOrRightChild) {
-            SET_CHILD(pNode, i, GET_CHILD(pNode, i + 1));
-         }
-         cfl_btree_node_free(GET_CHILD(pNode, i + 1));
-         SET_CHILD(pNode, i + 1, NULL);
-      }
-      --pNode->lNumKeys;
-      return pKeyDeleted;
-   }
-   return NULL;
-}
-
-static void cfl_btree_node_shiftRightByOne(CFL_BTREE_NODEP pNode) {
-   CFL_INT32 i;
+static void cfl_btree_node_updateCount(CFL_BTREE_NODEP pNode) {
+   CFL_INT32 lCount = pNode->lNumKeys;
    if (!pNode->bIsLeafNode) {
-      SET_CHILD(pNode, pNode->lNumKeys + 1, GET_CHILD(pNode, pNode->lNumKeys));
-   }
-   for (i = pNode->lNumKeys - 1; i >= 0; i--) {
-      SET_KEY(pNode, i + 1, GET_KEY(pNode, i));
-      if (!pNode->bIsLeafNode) {
-         SET_CHILD(pNode, i + 1, GET_CHILD(pNode, i));
+      CFL_INT32 i;
+      for (i = 0; i <= pNode->lNumKeys; i++) {
+         lCount += GET_CHILD(pNode, i)->lCount;
       }
    }
-}
-
-static CFL_INT32 cfl_btree_node_subtreeRootNodeIndex(CFL_BTREE_NODEP pNode, void * pKey) {
-   CFL_INT32 i = cfl_btree_node_keyAscPosition(pNode, pKey);
-   if (cfl_btree_compareValues(pNode->pTree, pKey, GET_KEY(pNode, i), CFL_TRUE) < 0) {
-      return i;
-   }
-   return pNode->lNumKeys;
+   pNode->lCount = lCount;
 }
 
 CFL_BTREEP cfl_btree_new(CFL_INT32 lKeys, BTREE_CMP_VALUE_FUNC pCompareValues) {
    CFL_BTREEP pTree;
    pTree = (CFL_BTREEP) CFL_MEM_ALLOC(sizeof(CFL_BTREE));
-   pTree->lKeys = lKeys;
+   pTree->lKeys = lKeys < 3 ? 3 : lKeys;
    pTree->pCompareValues = pCompareValues;
+   pTree->pSource = NULL;
+   pTree->lSnapshots = 0;
    pTree->pRoot = cfl_btree_node_new(pTree);
    return pTree;
 }
 
-static void cfl_btree_freeNodes(CFL_BTREE_NODEP pNode, BTREE_FREE_KEY_FUNC pFreeKey) {
-   if (!pNode->bIsLeafNode) {
-      CFL_INT32 i;
-      if (pFreeKey != NULL) {
-         for (i = 0; i < pNode->lNumKeys; i++) {
-            pFreeKey(GET_KEY(pNode, i));
-            cfl_btree_freeNodes(GET_CHILD(pNode, i), pFreeKey);
-         }
-         cfl_btree_freeNodes(GET_CHILD(pNode, i), pFreeKey);
-      } else {
-         for (i = 0; i <= pNode->lNumKeys; i++) {
-            cfl_btree_freeNodes(GET_CHILD(pNode, i), pFreeKey);
-         }
-      }
+void cfl_btree_free(CFL_BTREEP pTree, BTREE_FREE_KEY_FUNC pFreeKey) {
+   if (pTree->pSource != NULL) {
+      cfl_btree_node_release(pTree->pRoot, NULL);
+      cfl_atomic_subInt32(&pTree->pSource->lSnapshots, 1);
+   } else {
+      cfl_btree_node_release(pTree->pRoot, pFreeKey);
    }
-   cfl_btree_node_free(pNode);
+   CFL_MEM_FREE(pTree);
 }
 
-void cfl_btree_free(CFL_BTREEP pTree, BTREE_FREE_KEY_FUNC pFreeKey) {
-   cfl_btree_freeNodes(pTree->pRoot, pFreeKey);
-   CFL_MEM_FREE(pTree);
+CFL_BTREEP cfl_btree_snapshot(CFL_BTREEP pTree) {
+   CFL_BTREEP pSnapshot = (CFL_BTREEP) CFL_MEM_ALLOC(sizeof(CFL_BTREE));
+   if (pSnapshot == NULL) {
+      return NULL;
+   }
+   pSnapshot->lKeys = pTree->lKeys;
+   pSnapshot->pCompareValues = pTree->pCompareValues;
+   pSnapshot->pSource = pTree->pSource != NULL ? pTree->pSource : pTree;
+   pSnapshot->lSnapshots = 0;
+   pSnapshot->pRoot = pTree->pRoot;
+   cfl_atomic_addInt32(&pSnapshot->pSource->lSnapshots, 1);
+   cfl_atomic_addInt32(&pSnapshot->pRoot->lRefCount, 1);
+   return pSnapshot;
 }
 
-// Split the node, node, of a B-Tree into two nodes that both contain T-1 elements and move node's median key up to the pParentNode.
-// This method will only be called if node is full; node is the i-th child of pParentNode.
+// Split the full node, node, of a B-Tree into two nodes and move node's median key up to the pParentNode.
+// This method will only be called if node is full; node is the i-th child of pParentNode and both are writable.
 
 static void cfl_btree_splitChildNode(CFL_BTREE_NODEP pParentNode, CFL_INT32 i, CFL_BTREE_NODEP pNode) {
    CFL_BTREEP pTree = pNode->pTree;
    CFL_BTREE_NODEP pNewNode = cfl_btree_node_new(pTree);
-   CFL_INT32 lMiddle = (pTree->lKeys + 1) / 2;
+   CFL_INT32 lMiddle = pNode->lNumKeys / 2;
    CFL_INT32 j;
    pNewNode->bIsLeafNode = pNode->bIsLeafNode;
-   pNewNode->lNumKeys = lMiddle - 1;
-   for (j = 0; j < pNewNode->lNumKeys; j++) { // Copy the last T-1 elements of pNode into pNewNode.
-      SET_KEY(pNewNode, j, GET_KEY(pNode, j + lMiddle));
-      SET_KEY(pNode, j + lMiddle, NULL);
+   pNewNode->lNumKeys = pNode->lNumKeys - lMiddle - 1;
+   for (j = 0; j < pNewNode->lNumKeys; j++) { // Copy the keys after the median into pNewNode.
+      SET_KEY(pNewNode, j, GET_KEY(pNode, j + lMiddle + 1));
+      SET_KEY(pNode, j + lMiddle + 1, NULL);
    }
    if (!pNewNode->bIsLeafNode) {
-      for (j = 0; j < lMiddle; j++) { // Copy the last T pointers of pNode into pNewNode.
-         SET_CHILD(pNewNode, j, GET_CHILD(pNode, j + lMiddle));
-      }
-      for (j = lMiddle; j <= pNode->lNumKeys; j++) {
-         cfl_btree_node_free(GET_CHILD(pNode, j));
-         SET_CHILD(pNode, j, NULL);
+      for (j = 0; j <= pNewNode->lNumKeys; j++) { // Move the children after the median into pNewNode.
+         SET_CHILD(pNewNode, j, GET_CHILD(pNode, j + lMiddle + 1));
+         SET_CHILD(pNode, j + lMiddle + 1, NULL);
       }
    }
-   //   for (j = lMiddle; j < pNode->lNumKeys; j++) {
-   //      SET_KEY(pNode, j, NULL);
-   //   }
-   pNode->lNumKeys = lMiddle - 1;
+   pNode->lNumKeys = lMiddle;
 
    // Insert a (child) pointer to node pNewNode into the pParentNode, moving other keys and pointers as necessary.
    for (j = pParentNode->lNumKeys; j >= i + 1; j--) {
@@ -270,9 +307,13 @@ static void cfl_btree_splitChildNode(CFL_BTREE_NODEP pParentNode, CFL_INT32 i, C
    for (j = pParentNode->lNumKeys - 1; j >= i; j--) {
       SET_KEY(pParentNode, j + 1, GET_KEY(pParentNode, j));
    }
-   SET_KEY(pParentNode, i, GET_KEY(pNode, lMiddle - 1));
-   SET_KEY(pNode, lMiddle - 1, NULL);
+   SET_KEY(pParentNode, i, GET_KEY(pNode, lMiddle));
+   SET_KEY(pNode, lMiddle, NULL);
    ++(pParentNode->lNumKeys);
+
+   // The parent keeps the same number of keys in its subtree
+   cfl_btree_node_updateCount(pNode);
+   cfl_btree_node_updateCount(pNewNode);
 }
 
 // Insert an element into a B-Tree. (The element will ultimately be inserted into a leaf pNode).
@@ -280,6 +321,7 @@ static void cfl_btree_splitChildNode(CFL_BTREE_NODEP pParentNode, CFL_INT32 i, C
 static void cfl_btree_insertIntoNonFullNode(CFL_BTREE_NODEP pNode, void * pKey) {
    CFL_BTREEP pTree = pNode->pTree;
    CFL_INT32 i = pNode->lNumKeys - 1;
+   ++(pNode->lCount);
    if (pNode->bIsLeafNode) {
       // Since node is not a full node insert the new element into its proper place within node.
       while (i >= 0 && cfl_btree_compareValues(pTree, pKey, GET_KEY(pNode, i), CFL_TRUE) < 0) {
@@ -296,6 +338,7 @@ static void cfl_btree_insertIntoNonFullNode(CFL_BTREE_NODEP pNode, void * pKey)
          --i;
       }
       ++i;
+      SET_CHILD(pNode, i, cfl_btree_node_writable(GET_CHILD(pNode, i)));
       if (GET_CHILD(pNode, i)->lNumKeys == pTree->lKeys) {
          cfl_btree_splitChildNode(pNode, i, GET_CHILD(pNode, i));
          if (cfl_btree_compareValues(pTree, pKey, GET_KEY(pNode, i), CFL_TRUE) > 0) {
@@ -315,7 +358,7 @@ static CFL_BOOL cfl_btree_existsKey(CFL_BTREE_NODEP pNode, void * pKey) {
       i = cfl_btree_node_keyAscPosition(pNode, pKey);
       if (cfl_btree_compareValues(pNode->pTree, pKey, GET_KEY(pNode, i), CFL_TRUE) == 0) {
          return CFL_TRUE;
-      } else {
+      } else if (cfl_btree_compareValues(pNode->pTree, pKey, GET_KEY(pNode, i), CFL_TRUE) > 0) {
          ++i;
       }
       if (pNode->bIsLeafNode) {
@@ -328,14 +371,20 @@ static CFL_BOOL cfl_btree_existsKey(CFL_BTREE_NODEP pNode, void * pKey) {
 }
 
 CFL_BOOL cfl_btree_add(CFL_BTREEP pTree, void * pKey) {
-   CFL_BTREE_NODEP pRootNode = pTree->pRoot;
+   CFL_BTREE_NODEP pRootNode;
+   if (pTree->pSource != NULL) {
+      return CFL_FALSE;
+   }
    if (! cfl_btree_existsKey(pTree->pRoot, pKey)) {
+      pRootNode = cfl_btree_node_writable(pTree->pRoot);
+      pTree->pRoot = pRootNode;
       if (pRootNode->lNumKeys == pTree->lKeys) {
          CFL_BTREE_NODEP pNewRootNode = cfl_btree_node_new(pTree);
          pTree->pRoot = pNewRootNode;
          pNewRootNode->bIsLeafNode = CFL_FALSE;
          SET_CHILD(pNewRootNode, 0, pRootNode);
          cfl_btree_splitChildNode(pNewRootNode, 0, pRootNode); // Split pRootNode and move its median (middle) key up into pNewRootNode.
+         cfl_btree_node_updateCount(pNewRootNode);
          cfl_btree_insertIntoNonFullNode(pNewRootNode, pKey); // Insert the key into the B-Tree with root pNewRootNode.
       } else {
          cfl_btree_insertIntoNonFullNode(pRootNode, pKey); // Insert the key into the B-Tree with root pRootNode.
@@ -345,185 +394,342 @@ CFL_BOOL cfl_btree_add(CFL_BTREEP pTree, void * pKey) {
    return CFL_FALSE;
 }
 
-// Merge two nodes and keep the median key (element) empty.
+// Number of keys of a subtree with the given height whose nodes have lKeysPerNode keys each.
 
-static CFL_INT32 cfl_btree_mergeNodes(CFL_BTREE_NODEP pDstNode, CFL_BTREE_NODEP pSrcNode) {
-   CFL_INT32 lMedianKeyIndex;
-   if (cfl_btree_compareValues(pSrcNode->pTree, GET_KEY(pSrcNode, 0), GET_KEY(pDstNode, pDstNode->lNumKeys - 1), CFL_TRUE) < 0) {
-      CFL_INT32 i;
-      // Shift all elements of pDstNode right by pSrcNode.mNumKeys + 1 to make place for the pSrcNode and the median key.
-      if (!pDstNode->bIsLeafNode) {
-         SET_CHILD(pDstNode, pSrcNode->lNumKeys + pDstNode->lNumKeys + 1, GET_CHILD(pDstNode, pDstNode->lNumKeys));
-      }
-      for (i = pDstNode->lNumKeys; i > 0; i--) {
-         SET_KEY(pDstNode, pSrcNode->lNumKeys + i, GET_KEY(pDstNode, i - 1));
-         if (!pDstNode->bIsLeafNode) {
-            SET_CHILD(pDstNode, pSrcNode->lNumKeys + i, GET_CHILD(pDstNode, i - 1));
-         }
-      }
+static CFL_INT64 cfl_btree_subtreeCapacity(CFL_INT32 lKeysPerNode, CFL_INT32 lHeight) {
+   CFL_INT64 llCapacity = lKeysPerNode;
+   while (lHeight-- > 0 && llCapacity < 0x7FFFFFFF) {
+      llCapacity = (llCapacity + 1) * (lKeysPerNode + 1) - 1;
+   }
+   return llCapacity;
+}
 
-      // Clear the median key (element).
-      lMedianKeyIndex = pSrcNode->lNumKeys;
-      SET_KEY(pDstNode, lMedianKeyIndex, NULL);
+// Build a subtree of height lHeight with the sorted keys, spreading them evenly among the children.
 
-      // Copy the pSrcNode's elements into pDstNode.
-      for (i = 0; i < pSrcNode->lNumKeys; i++) {
-         SET_KEY(pDstNode, i, GET_KEY(pSrcNode, i));
-         if (!pSrcNode->bIsLeafNode) {
-            SET_CHILD(pDstNode, i, GET_CHILD(pSrcNode, i));
-         }
-      }
-      if (!pSrcNode->bIsLeafNode) {
-         SET_CHILD(pDstNode, i, GET_CHILD(pSrcNode, i));
+static CFL_BTREE_NODEP cfl_btree_buildNode(CFL_BTREEP pTree, void **pKeys, CFL_INT32 lCount, CFL_INT32 lHeight, CFL_INT32 lKeysPerNode, CFL_BOOL bRoot) {
+   CFL_BTREE_NODEP pNode = cfl_btree_node_new(pTree);
+   CFL_INT32 i;
+
+   pNode->lCount = lCount;
+   if (lHeight == 0) {
+      for (i = 0; i < lCount; i++) {
+         SET_KEY(pNode, i, pKeys[i]);
       }
+      pNode->lNumKeys = lCount;
    } else {
-      CFL_INT32 lOffset;
-      CFL_INT32 i;
-
-      // Clear the median key (element).
-      lMedianKeyIndex = pDstNode->lNumKeys;
-      SET_KEY(pDstNode, lMedianKeyIndex, NULL);
-
-      // Copy the pSrcNode's elements into pDstNode.
-      lOffset = lMedianKeyIndex + 1;
-      for (i = 0; i < pSrcNode->lNumKeys; i++) {
-         SET_KEY(pDstNode, lOffset + i, GET_KEY(pSrcNode, i));
-         if (!pSrcNode->bIsLeafNode) {
-            SET_CHILD(pDstNode, lOffset + i, GET_CHILD(pSrcNode, i));
-         }
+      CFL_INT64 llChildCapacity = cfl_btree_subtreeCapacity(lKeysPerNode, lHeight - 1);
+      CFL_INT64 llChildMinimum = cfl_btree_subtreeCapacity(BTREE_MIN_KEYS(pTree), lHeight - 1);
+      CFL_INT32 lChildren = (CFL_INT32) ((lCount + 1 + llChildCapacity) / (llChildCapacity + 1));
+      CFL_INT32 lMinChildren = bRoot ? 2 : BTREE_MIN_KEYS(pTree) + 1;
+      CFL_INT32 lChildKeys;
+      CFL_INT32 lExtraKeys;
+      CFL_INT32 lOffset = 0;
+
+      if (lChildren > pTree->lKeys + 1) {
+         lChildren = pTree->lKeys + 1;
+      }
+      if (lChildren < lMinChildren) {
+         lChildren = lMinChildren;
       }
-      if (!pSrcNode->bIsLeafNode) {
-         SET_CHILD(pDstNode, lOffset + i, GET_CHILD(pSrcNode, i));
+      // Never leave the children with less keys than a B-tree node requires
+      while (lChildren > lMinChildren && (lCount - lChildren + 1) / lChildren < llChildMinimum) {
+         --lChildren;
+      }
+      lChildKeys = (lCount - lChildren + 1) / lChildren;
+      lExtraKeys = (lCount - lChildren + 1) % lChildren;
+      pNode->bIsLeafNode = CFL_FALSE;
+      pNode->lNumKeys = lChildren - 1;
+      for (i = 0; i < lChildren; i++) {
+         CFL_INT32 lSize = lChildKeys + (i < lExtraKeys ? 1 : 0);
+         SET_CHILD(pNode, i, cfl_btree_buildNode(pTree, &pKeys[lOffset], lSize, lHeight - 1, lKeysPerNode, CFL_FALSE));
+         lOffset += lSize;
+         if (i < lChildren - 1) {
+            SET_KEY(pNode, i, pKeys[lOffset++]);
+         }
       }
    }
-   pDstNode->lNumKeys += pSrcNode->lNumKeys;
-   return lMedianKeyIndex;
+   return pNode;
 }
 
-// Move the key from srcNode at index into dstNode at medianKeyIndex. Note that the element at index is already empty.
+CFL_BOOL cfl_btree_bulkLoad(CFL_BTREEP pTree, void **pKeys, CFL_INT32 lCount, CFL_DOUBLE fillFactor) {
+   CFL_INT32 lKeysPerNode;
+   CFL_INT32 lHeight = 0;
+   CFL_INT32 i;
+
+   if (pTree->pSource != NULL || pTree->pRoot->lNumKeys > 0 || lCount < 0) {
+      return CFL_FALSE;
+   }
+   for (i = 1; i < lCount; i++) {
+      if (cfl_btree_compareValues(pTree, pKeys[i - 1], pKeys[i], CFL_TRUE) >= 0) {
+         return CFL_FALSE;
+      }
+   }
+   if (lCount == 0) {
+      return CFL_TRUE;
+   }
+   if (fillFactor <= 0 || fillFactor > 1) {
+      fillFactor = 1;
+   }
+   lKeysPerNode = (CFL_INT32) (pTree->lKeys * fillFactor + 0.5);
+   if (lKeysPerNode < BTREE_MIN_KEYS(pTree) + 1) {
+      lKeysPerNode = BTREE_MIN_KEYS(pTree) + 1;
+   }
+   if (lKeysPerNode > pTree->lKeys) {
+      lKeysPerNode = pTree->lKeys;
+   }
+   while (cfl_btree_subtreeCapacity(lKeysPerNode, lHeight) < lCount) {
+      ++lHeight;
+   }
+   // With a low fill factor the keys may not be enough to give each child of the root its minimum number of keys
+   while (lHeight > 0 && lCount < 2 * cfl_btree_subtreeCapacity(BTREE_MIN_KEYS(pTree), lHeight - 1) + 1) {
+      --lHeight;
+   }
+   cfl_btree_node_release(pTree->pRoot, NULL);
+   pTree->pRoot = cfl_btree_buildNode(pTree, pKeys, lCount, lHeight, lKeysPerNode, CFL_TRUE);
+   return CFL_TRUE;
+}
 
-static void cfl_btree_moveKey(CFL_BTREE_NODEP pSrcNode, CFL_INT32 lSrcKeyIndex, CFL_INT32 lChildIndex, CFL_BTREE_NODEP pDstNode, CFL_INT32 lMedianKeyIndex) {
-   SET_KEY(pDstNode, lMedianKeyIndex, GET_KEY(pSrcNode, lSrcKeyIndex));
-   ++(pDstNode->lNumKeys);
+// Stable merge sort of the keys with the comparison function of the tree.
 
-   cfl_btree_node_remove(pSrcNode, lSrcKeyIndex, lChildIndex);
+static void cfl_btree_sortKeys(CFL_BTREEP pTree, void **pKeys, void **pAux, CFL_INT32 lCount) {
+   CFL_INT32 lMiddle;
+   CFL_INT32 i;
+   CFL_INT32 j;
+   CFL_INT32 k;
 
-   if (pSrcNode == pDstNode->pTree->pRoot && pSrcNode->lNumKeys == 0) {
-      pDstNode->pTree->pRoot = pDstNode;
+   if (lCount < 2) {
+      return;
+   }
+   lMiddle = lCount / 2;
+   cfl_btree_sortKeys(pTree, pKeys, pAux, lMiddle);
+   cfl_btree_sortKeys(pTree, &pKeys[lMiddle], pAux, lCount - lMiddle);
+   if (cfl_btree_compareValues(pTree, pKeys[lMiddle - 1], pKeys[lMiddle], CFL_TRUE) <= 0) {
+      return;
+   }
+   memcpy(pAux, pKeys, lMiddle * sizeof(void *));
+   i = 0;
+   j = lMiddle;
+   k = 0;
+   while (i < lMiddle && j < lCount) {
+      if (cfl_btree_compareValues(pTree, pKeys[j], pAux[i], CFL_TRUE) < 0) {
+         pKeys[k++] = pKeys[j++];
+      } else {
+         pKeys[k++] = pAux[i++];
+      }
+   }
+   while (i < lMiddle) {
+      pKeys[k++] = pAux[i++];
    }
 }
 
-static void * cfl_btree_deleteFromNode(CFL_BTREE_NODEP pNode, void * pKey) {
-   // 1. If the key is in node and node is a leaf node, then delete the key from node.
-   void * pDeletedKey = NULL;
-   if (pNode->bIsLeafNode) {
-      CFL_INT32 i;
-      if ((i = cfl_btree_node_search(pNode, pKey, CFL_TRUE)) != -1) { // key is i-th key of node if node contains key.
-         pDeletedKey = cfl_btree_node_remove(pNode, i, LEFT_CHILD_NODE);
+CFL_BOOL cfl_btree_sortAndLoad(CFL_BTREEP pTree, void **pKeys, CFL_INT32 lCount, CFL_DOUBLE fillFactor) {
+   void **pAux;
+
+   if (pTree->pSource != NULL || pTree->pRoot->lNumKeys > 0 || lCount < 0) {
+      return CFL_FALSE;
+   }
+   if (lCount > 1) {
+      pAux = (void **) CFL_MEM_ALLOC(((lCount / 2) + 1) * sizeof(void *));
+      if (pAux == NULL) {
+         return CFL_FALSE;
       }
-   } else {
-      CFL_INT32 i;
-      CFL_INT32 lMiddle = (pNode->pTree->lKeys + 1) / 2;
-      // 2. If node is an internal node and it contains the key... (key is i-th key of node if node contains key)
-      if ((i = cfl_btree_node_search(pNode, pKey, CFL_TRUE)) != -1) {
-         CFL_BTREE_NODEP pLeftChildNode = GET_CHILD(pNode, i);
-         CFL_BTREE_NODEP pRightChildNode = GET_CHILD(pNode, i + 1);
-         // 2a. If the predecessor child node has at least T keys...
-         if (pLeftChildNode->lNumKeys >= lMiddle) {
-            CFL_BTREE_NODEP pPredecessorNode = pLeftChildNode;
-            CFL_BTREE_NODEP pErasureNode = pPredecessorNode; // Make sure not to delete a key from a node with only T - 1 elements.
-            while (!pPredecessorNode->bIsLeafNode) { // Therefore only descend to the previous node (erasureNode) of the predecessor node and delete the key using 3.
-               pErasureNode = pPredecessorNode;
-               pPredecessorNode = GET_CHILD(pPredecessorNode, pNode->lNumKeys - 1);
-            }
-            SET_KEY(pNode, i, GET_KEY(pPredecessorNode, pPredecessorNode->lNumKeys - 1));
-            pDeletedKey = cfl_btree_deleteFromNode(pErasureNode, GET_KEY(pNode, i));
-
-            // 2b. If the successor child node has at least T keys...
-         } else if (pRightChildNode->lNumKeys >= lMiddle) {
-            CFL_BTREE_NODEP pSuccessorNode = pRightChildNode;
-            CFL_BTREE_NODEP pErasureNode = pSuccessorNode; // Make sure not to delete a key from a node with only T - 1 elements.
-            while (!pSuccessorNode->bIsLeafNode) { // Therefore only descend to the previous node (erasureNode) of the predecessor node and delete the key using 3.
-               pErasureNode = pSuccessorNode;
-               pSuccessorNode = GET_CHILD(pSuccessorNode, 0);
-            }
-            SET_KEY(pNode, i, GET_KEY(pSuccessorNode, 0));
-            pDeletedKey = cfl_btree_deleteFromNode(pErasureNode, GET_KEY(pNode, i));
+      cfl_btree_sortKeys(pTree, pKeys, pAux, lCount);
+      CFL_MEM_FREE(pAux);
+   }
+   return cfl_btree_bulkLoad(pTree, pKeys, lCount, fillFactor);
+}
 
-            // 2c. If both the predecessor and the successor child node have only T - 1 keys...
-            // If both of the two child nodes to the left and right of the deleted element have the minimum number of elements,
-            // namely T - 1, they can then be joined into a single node with 2 * T - 2 elements.
-         } else {
-            CFL_INT32 lMedianKeyIndex = cfl_btree_mergeNodes(pLeftChildNode, pRightChildNode);
-            cfl_btree_node_free(pRightChildNode);
-            cfl_btree_moveKey(pNode, i, RIGHT_CHILD_NODE, pLeftChildNode, lMedianKeyIndex); // Delete i's right child pointer from node.
-            pDeletedKey = cfl_btree_deleteFromNode(pLeftChildNode, pKey);
-         }
+// Merge the (i + 1)-th child of pNode into the i-th child. The i-th key of pNode comes down as the median key.
+// The right child is made writable too, so that its references to the children move to the left child.
 
-         // 3. If the key is not present in node, descent to the root of the appropriate subtree that must contain key...
-         // The method is structured to guarantee that whenever delete is called recursively on node "node", the number of keys
-         // in node is at least the minimum degree T. Note that this condition requires one more key than the minimum required
-         // by usual B-tree conditions. This strengthened condition allows us to delete a key from the tree in one downward pass
-         // without having to "back up".
-      } else {
-         CFL_BTREE_NODEP pChildNode;
-         i = cfl_btree_node_subtreeRootNodeIndex(pNode, pKey);
-         pChildNode = GET_CHILD(pNode, i); // childNode is i-th child of node.
-         if (pChildNode->lNumKeys == lMiddle - 1) {
-            CFL_BTREE_NODEP pLeftChildSibling = (i - 1 >= 0) ? GET_CHILD(pNode, i - 1) : NULL;
-            CFL_BTREE_NODEP pRightChildSibling = (i + 1 <= pNode->lNumKeys) ? GET_CHILD(pNode, i + 1) : NULL;
-            // 3a. The left sibling has >= T keys...
-            if (pLeftChildSibling != NULL && pLeftChildSibling->lNumKeys >= lMiddle) {
-               // Move a key from the subtree's root node down into childNode along with the appropriate child pointer.
-               // Therefore, first shift all elements and children of childNode right by 1.
-               cfl_btree_node_shiftRightByOne(pChildNode);
-               SET_KEY(pChildNode, 0, GET_KEY(pNode, i - 1)); // i - 1 is the key index in node that is smaller than childNode's smallest key.
-               if (!pChildNode->bIsLeafNode) {
-                  SET_CHILD(pChildNode, 0, GET_CHILD(pLeftChildSibling, pLeftChildSibling->lNumKeys));
-               }
-               ++(pChildNode->lNumKeys);
+static void cfl_btree_mergeChildren(CFL_BTREE_NODEP pNode, CFL_INT32 i) {
+   CFL_BTREE_NODEP pLeftNode = cfl_btree_node_writable(GET_CHILD(pNode, i));
+   CFL_BTREE_NODEP pRightNode = cfl_btree_node_writable(GET_CHILD(pNode, i + 1));
+   CFL_INT32 lOffset = pLeftNode->lNumKeys + 1;
+   CFL_INT32 j;
 
-               // Move a key from the left sibling into the subtree's root node.
-               SET_KEY(pNode, i - 1, GET_KEY(pLeftChildSibling, pLeftChildSibling->lNumKeys - 1));
+   SET_CHILD(pNode, i, pLeftNode);
+   SET_KEY(pLeftNode, pLeftNode->lNumKeys, GET_KEY(pNode, i));
+   for (j = 0; j < pRightNode->lNumKeys; j++) {
+      SET_KEY(pLeftNode, lOffset + j, GET_KEY(pRightNode, j));
+   }
+   if (!pLeftNode->bIsLeafNode) {
+      for (j = 0; j <= pRightNode->lNumKeys; j++) {
+         SET_CHILD(pLeftNode, lOffset + j, GET_CHILD(pRightNode, j));
+      }
+   }
+   pLeftNode->lNumKeys += pRightNode->lNumKeys + 1;
+   pLeftNode->lCount += pRightNode->lCount + 1;
 
-               // Remove the key from the left sibling along with its right child node.
-               cfl_btree_node_remove(pLeftChildSibling, pLeftChildSibling->lNumKeys - 1, RIGHT_CHILD_NODE);
+   // Remove the median key and the right child from pNode.
+   for (j = i; j < pNode->lNumKeys - 1; j++) {
+      SET_KEY(pNode, j, GET_KEY(pNode, j + 1));
+      SET_CHILD(pNode, j + 1, GET_CHILD(pNode, j + 2));
+   }
+   SET_KEY(pNode, pNode->lNumKeys - 1, NULL);
+   SET_CHILD(pNode, pNode->lNumKeys, NULL);
+   --(pNode->lNumKeys);
+   cfl_btree_node_free(pRightNode);
+}
 
-               // 3b. The right sibling has >= T keys...
-            } else if (pRightChildSibling != NULL && pRightChildSibling->lNumKeys >= lMiddle) {
-               // Move a key from the subtree's root node down into childNode along with the appropriate child pointer.
-               SET_KEY(pChildNode, pChildNode->lNumKeys, GET_KEY(pNode, i)); // i is the key index in node that is bigger than childNode's biggest key.
-               if (!pChildNode->bIsLeafNode) {
-                  SET_CHILD(pChildNode, pChildNode->lNumKeys + 1, GET_CHILD(pRightChildSibling, 0));
-               }
-               ++(pChildNode->lNumKeys);
+// Restore the minimum number of keys of the i-th child of pNode, moving a key through pNode from a sibling
+// that can spare one or merging the child with a sibling. pNode and its i-th child must be writable.
 
-               // Move a key from the right sibling into the subtree's root node.
-               SET_KEY(pNode, i, GET_KEY(pRightChildSibling, 0));
-               // Remove the key from the right sibling along with its left child node.
-               cfl_btree_node_remove(pRightChildSibling, 0, LEFT_CHILD_NODE);
+static void cfl_btree_fixChildNode(CFL_BTREE_NODEP pNode, CFL_INT32 i) {
+   CFL_BTREE_NODEP pChildNode = GET_CHILD(pNode, i);
+   CFL_BTREE_NODEP pLeftChildSibling = i > 0 ? GET_CHILD(pNode, i - 1) : NULL;
+   CFL_BTREE_NODEP pRightChildSibling = i < pNode->lNumKeys ? GET_CHILD(pNode, i + 1) : NULL;
+   CFL_INT32 lMinKeys = BTREE_MIN_KEYS(pNode->pTree);
+   CFL_INT32 j;
 
-               // 3c. Both of childNode's siblings have only T - 1 keys each...
-            } else {
-               if (pLeftChildSibling != NULL) {
-                  CFL_INT32 lMedianKeyIndex = cfl_btree_mergeNodes(pChildNode, pLeftChildSibling);
-                  cfl_btree_node_free(pLeftChildSibling);
-                  cfl_btree_moveKey(pNode, i - 1, LEFT_CHILD_NODE, pChildNode, lMedianKeyIndex); // i - 1 is the median key index in node when merging with the left sibling.
-               } else if (pRightChildSibling != NULL) {
-                  CFL_INT32 lMedianKeyIndex = cfl_btree_mergeNodes(pChildNode, pRightChildSibling);
-                  cfl_btree_node_free(pRightChildSibling);
-                  cfl_btree_moveKey(pNode, i, RIGHT_CHILD_NODE, pChildNode, lMedianKeyIndex); // i is the median key index in node when merging with the right sibling.
-               }
-            }
+   // The left sibling has more than the minimum number of keys...
+   if (pLeftChildSibling != NULL && pLeftChildSibling->lNumKeys > lMinKeys) {
+      pLeftChildSibling = cfl_btree_node_writable(pLeftChildSibling);
+      SET_CHILD(pNode, i - 1, pLeftChildSibling);
+      // Shift all elements and children of childNode right by 1.
+      if (!pChildNode->bIsLeafNode) {
+         SET_CHILD(pChildNode, pChildNode->lNumKeys + 1, GET_CHILD(pChildNode, pChildNode->lNumKeys));
+      }
+      for (j = pChildNode->lNumKeys; j > 0; j--) {
+         SET_KEY(pChildNode, j, GET_KEY(pChildNode, j - 1));
+         if (!pChildNode->bIsLeafNode) {
+            SET_CHILD(pChildNode, j, GET_CHILD(pChildNode, j - 1));
          }
-         pDeletedKey = cfl_btree_deleteFromNode(pChildNode, pKey);
+      }
+      // Move a key from the subtree's root node down into childNode along with the last child of the left sibling.
+      SET_KEY(pChildNode, 0, GET_KEY(pNode, i - 1));
+      if (!pChildNode->bIsLeafNode) {
+         SET_CHILD(pChildNode, 0, GET_CHILD(pLeftChildSibling, pLeftChildSibling->lNumKeys));
+         SET_CHILD(pLeftChildSibling, pLeftChildSibling->lNumKeys, NULL);
+      }
+      ++(pChildNode->lNumKeys);
+      // Move the last key from the left sibling into the subtree's root node.
+      SET_KEY(pNode, i - 1, GET_KEY(pLeftChildSibling, pLeftChildSibling->lNumKeys - 1));
+      SET_KEY(pLeftChildSibling, pLeftChildSibling->lNumKeys - 1, NULL);
+      --(pLeftChildSibling->lNumKeys);
+      cfl_btree_node_updateCount(pLeftChildSibling);
+      cfl_btree_node_updateCount(pChildNode);
+
+   // The right sibling has more than the minimum number of keys...
+   } else if (pRightChildSibling != NULL && pRightChildSibling->lNumKeys > lMinKeys) {
+      pRightChildSibling = cfl_btree_node_writable(pRightChildSibling);
+      SET_CHILD(pNode, i + 1, pRightChildSibling);
+      // Move a key from the subtree's root node down into childNode along with the first child of the right sibling.
+      SET_KEY(pChildNode, pChildNode->lNumKeys, GET_KEY(pNode, i));
+      if (!pChildNode->bIsLeafNode) {
+         SET_CHILD(pChildNode, pChildNode->lNumKeys + 1, GET_CHILD(pRightChildSibling, 0));
+      }
+      ++(pChildNode->lNumKeys);
+      // Move the first key from the right sibling into the subtree's root node.
+      SET_KEY(pNode, i, GET_KEY(pRightChildSibling, 0));
+      for (j = 0; j < pRightChildSibling->lNumKeys - 1; j++) {
+         SET_KEY(pRightChildSibling, j, GET_KEY(pRightChildSibling, j + 1));
+         if (!pRightChildSibling->bIsLeafNode) {
+            SET_CHILD(pRightChildSibling, j, GET_CHILD(pRightChildSibling, j + 1));
+         }
+      }
+      if (!pRightChildSibling->bIsLeafNode) {
+         SET_CHILD(pRightChildSibling, j, GET_CHILD(pRightChildSibling, j + 1));
+         SET_CHILD(pRightChildSibling, j + 1, NULL);
+      }
+      SET_KEY(pRightChildSibling, j, NULL);
+      --(pRightChildSibling->lNumKeys);
+      cfl_btree_node_updateCount(pRightChildSibling);
+      cfl_btree_node_updateCount(pChildNode);
+
+   // Both siblings have only the minimum number of keys...
+   } else if (pLeftChildSibling != NULL) {
+      cfl_btree_mergeChildren(pNode, i - 1);
+   } else if (pRightChildSibling != NULL) {
+      cfl_btree_mergeChildren(pNode, i);
+   }
+}
+
+// Remove the greatest key of the subtree.
+
+static void * cfl_btree_deleteMax(CFL_BTREE_NODEP pNode) {
+   void * pDeletedKey;
+   --(pNode->lCount);
+   if (pNode->bIsLeafNode) {
+      pDeletedKey = GET_KEY(pNode, pNode->lNumKeys - 1);
+      SET_KEY(pNode, pNode->lNumKeys - 1, NULL);
+      --(pNode->lNumKeys);
+   } else {
+      CFL_INT32 i = pNode->lNumKeys;
+      SET_CHILD(pNode, i, cfl_btree_node_writable(GET_CHILD(pNode, i)));
+      pDeletedKey = cfl_btree_deleteMax(GET_CHILD(pNode, i));
+      if (GET_CHILD(pNode, i)->lNumKeys < BTREE_MIN_KEYS(pNode->pTree)) {
+         cfl_btree_fixChildNode(pNode, i);
       }
    }
    return pDeletedKey;
 }
 
+static void * cfl_btree_deleteFromNode(CFL_BTREE_NODEP pNode, void * pKey) {
+   void * pDeletedKey;
+   CFL_INT32 i;
+   CFL_INT16 iCmp;
+
+   if (pNode->lNumKeys == 0) {
+      return NULL;
+   }
+   i = cfl_btree_node_keyAscPosition(pNode, pKey);
+   iCmp = cfl_btree_compareValues(pNode->pTree, pKey, GET_KEY(pNode, i), CFL_TRUE);
+   if (pNode->bIsLeafNode) {
+      // 1. If the key is in node and node is a leaf node, then delete the key from node.
+      if (iCmp != 0) {
+         return NULL;
+      }
+      pDeletedKey = GET_KEY(pNode, i);
+      for (; i < pNode->lNumKeys - 1; i++) {
+         SET_KEY(pNode, i, GET_KEY(pNode, i + 1));
+      }
+      SET_KEY(pNode, i, NULL);
+      --(pNode->lNumKeys);
+      --(pNode->lCount);
+      return pDeletedKey;
+   }
+   if (iCmp == 0) {
+      // 2. If node is an internal node and it contains the key, replace it by its predecessor, removed from the left child.
+      pDeletedKey = GET_KEY(pNode, i);
+      SET_CHILD(pNode, i, cfl_btree_node_writable(GET_CHILD(pNode, i)));
+      SET_KEY(pNode, i, cfl_btree_deleteMax(GET_CHILD(pNode, i)));
+   } else {
+      // 3. If the key is not present in node, descent to the root of the appropriate subtree that must contain key.
+      if (iCmp > 0) {
+         ++i;
+      }
+      SET_CHILD(pNode, i, cfl_btree_node_writable(GET_CHILD(pNode, i)));
+      pDeletedKey = cfl_btree_deleteFromNode(GET_CHILD(pNode, i), pKey);
+      if (pDeletedKey == NULL) {
+         return NULL;
+      }
+   }
+   --(pNode->lCount);
+   if (GET_CHILD(pNode, i)->lNumKeys < BTREE_MIN_KEYS(pNode->pTree)) {
+      cfl_btree_fixChildNode(pNode, i);
+   }
+   return pDeletedKey;
+}
+
 void * cfl_btree_delete(CFL_BTREEP pTree, void * pKey) {
-   return cfl_btree_deleteFromNode(pTree->pRoot, pKey);
+   void * pDeletedKey;
+   CFL_BTREE_NODEP pRootNode;
+   if (pTree->pSource != NULL) {
+      return NULL;
+   }
+   // With snapshots the path to the key is copied on the way down, so avoid copying it for a missing key
+   if (cfl_atomic_getInt32(&pTree->lSnapshots) > 0 && !cfl_btree_existsKey(pTree->pRoot, pKey)) {
+      return NULL;
+   }
+   pTree->pRoot = cfl_btree_node_writable(pTree->pRoot);
+   pDeletedKey = cfl_btree_deleteFromNode(pTree->pRoot, pKey);
+   pRootNode = pTree->pRoot;
+   if (!pRootNode->bIsLeafNode && pRootNode->lNumKeys == 0) {
+      pTree->pRoot = GET_CHILD(pRootNode, 0);
+      cfl_btree_node_free(pRootNode);
+   }
+   return pDeletedKey;
 }
 
 // Iterative search method.
@@ -556,36 +762,114 @@ void * cfl_btree_search(CFL_BTREEP pTree, void * pKey) {
    return cfl_btree_searchFromNode(pTree->pRoot, pKey);
 }
 
-// search node by position
+// Batched search: the lookups of a group descend the tree in lockstep, one level per pass, and the next node of each
+// lookup is prefetched while the other lookups of the group are compared.
+
+#define BTREE_BATCH_SIZE 8
 
-static void * cfl_btree_searchPositionFromNode(CFL_BTREE_NODEP pNode, CFL_INT32 *lCount) {
+void cfl_btree_searchBatch(CFL_BTREEP pTree, void ** pKeys, void ** pResults, CFL_INT32 lCount) {
+   CFL_BTREE_NODEP pNodes[BTREE_BATCH_SIZE];
+   CFL_INT32 lStart;
+   CFL_INT32 lGroupSize;
+   CFL_INT32 lActive;
    CFL_INT32 i;
-   if (pNode->bIsLeafNode) {
-      if (*lCount <= pNode->lNumKeys) {
-         i = *lCount - 1;
-         *lCount = 0;
-         return GET_KEY(pNode, i);
-      } else {
-         *lCount -= pNode->lNumKeys;
+   CFL_INT32 j;
+   CFL_INT16 iCmp;
+
+   for (lStart = 0; lStart < lCount; lStart += lGroupSize) {
+      lGroupSize = lCount - lStart < BTREE_BATCH_SIZE ? lCount - lStart : BTREE_BATCH_SIZE;
+      for (j = 0; j < lGroupSize; j++) {
+         pNodes[j] = pTree->pRoot;
+         pResults[lStart + j] = NULL;
       }
-   } else {
-      for (i = 0; i < pNode->lNumKeys; i++) {
-         void * pFoundKey = cfl_btree_searchPositionFromNode(GET_CHILD(pNode, i), lCount);
-         if (pFoundKey != NULL) {
-            return pFoundKey;
-         } else {
-            *lCount -= 1;
-            if (*lCount == 0) {
-               return GET_KEY(pNode, i);
+      lActive = lGroupSize;
+      while (lActive > 0) {
+         for (j = 0; j < lGroupSize; j++) {
+            CFL_BTREE_NODEP pNode = pNodes[j];
+            if (pNode == NULL) {
+               continue;
+            }
+            if (pNode->lNumKeys == 0) {
+               pNodes[j] = NULL;
+               --lActive;
+               continue;
+            }
+            i = cfl_btree_node_keyAscPosition(pNode, pKeys[lStart + j]);
+            iCmp = cfl_btree_compareValues(pTree, pKeys[lStart + j], GET_KEY(pNode, i), CFL_TRUE);
+            if (iCmp == 0) {
+               pResults[lStart + j] = GET_KEY(pNode, i);
+               pNodes[j] = NULL;
+               --lActive;
+            } else if (pNode->bIsLeafNode) {
+               pNodes[j] = NULL;
+               --lActive;
+            } else {
+               if (iCmp > 0) {
+                  ++i;
+               }
+               pNode = GET_CHILD(pNode, i);
+               // the node header and the middle of its pointers, where the binary search starts
+               CFL_PREFETCH(pNode);
+               CFL_PREFETCH(&pNode->pPointers[pTree->lKeys]);
+               pNodes[j] = pNode;
             }
          }
       }
    }
-   return NULL;
 }
 
+// search node by position using the number of keys of each subtree
+
 void * cfl_btree_searchPosition(CFL_BTREEP pTree, CFL_INT32 lPosition) {
-   return cfl_btree_searchPositionFromNode(pTree->pRoot, &lPosition);
+   CFL_BTREE_NODEP pNode = pTree->pRoot;
+   if (lPosition < 1 || lPosition > pNode->lCount) {
+      return NULL;
+   }
+   while (!pNode->bIsLeafNode) {
+      CFL_INT32 i = 0;
+      CFL_BTREE_NODEP pChildNode = GET_CHILD(pNode, 0);
+      while (lPosition > pChildNode->lCount + 1) {
+         lPosition -= pChildNode->lCount + 1;
+         pChildNode = GET_CHILD(pNode, ++i);
+      }
+      if (lPosition == pChildNode->lCount + 1) {
+         return GET_KEY(pNode, i);
+      }
+      pNode = pChildNode;
+   }
+   return GET_KEY(pNode, lPosition - 1);
+}
+
+CFL_INT32 cfl_btree_rank(CFL_BTREEP pTree, void * pKey) {
+   CFL_BTREE_NODEP pNode = pTree->pRoot;
+   CFL_INT32 lRank = 0;
+   while (pNode->lNumKeys > 0) {
+      CFL_INT32 i = cfl_btree_node_keyAscPosition(pNode, pKey);
+      CFL_INT32 j;
+      CFL_INT16 iCmp = cfl_btree_compareValues(pNode->pTree, pKey, GET_KEY(pNode, i), CFL_TRUE);
+      if (iCmp > 0) {
+         ++i;
+      }
+      // Keys before the i-th key and their subtrees are smaller than pKey
+      lRank += i;
+      if (!pNode->bIsLeafNode) {
+         for (j = 0; j < i; j++) {
+            lRank += GET_CHILD(pNode, j)->lCount;
+         }
+      }
+      if (iCmp == 0) {
+         return lRank + (pNode->bIsLeafNode ? 0 : GET_CHILD(pNode, i)->lCount) + 1;
+      }
+      if (pNode->bIsLeafNode) {
+         break;
+      }
+      pNode = GET_CHILD(pNode, i);
+   }
+   return 0;
+}
+
+CFL_INT32 cfl_btree_count(CFL_BTREEP pTree) {
+   return pTree->pRoot->lCount;
 }
 
 // Iterative search method.
@@ -620,25 +904,38 @@ static BTreeIterator *cfl_btree_iteratorCreate(CFL_BTREE_NODEP pNode, CFL_INT32
    pIt->iterator.itClass = &cfl_btree_iterator_class;
    pIt->pNode = pNode;
    pIt->lKey = lKey;
+   pIt->pValue = NULL;
    pIt->pPreviousIt = pPreviousIt;
+   pIt->pTree = pPreviousIt != NULL ? pPreviousIt->pTree : pNode->pTree;
    return pIt;
 }
 
+// Nodes of a snapshot belong to the source tree, so the iterator keeps the tree it was created on.
+
+static CFL_ITERATORP cfl_btree_iteratorOf(BTreeIterator *pIt, CFL_BTREEP pTree) {
+   if (pIt == NULL) {
+      return NULL;
+   }
+   pIt->pTree = pTree;
+   return &pIt->iterator;
+}
+
 static CFL_ITERATORP cfl_btree_iteratorSearchFromNode(CFL_BTREE_NODEP pNode, void * pKey) {
    BTreeIterator *pParentIt = NULL;
-   while (pNode != NULL) {
+   while (pNode != NULL && pNode->lNumKeys > 0) {
       CFL_INT32 i = cfl_btree_node_keyAscPosition(pNode, pKey);
-      if (cfl_btree_compareValues(pNode->pTree, pKey, GET_KEY(pNode, i), CFL_TRUE) == 0) {
+      CFL_INT16 iCmp = cfl_btree_compareValues(pNode->pTree, pKey, GET_KEY(pNode, i), CFL_TRUE);
+      if (iCmp == 0) {
          BTreeIterator *pIt = cfl_btree_iteratorCreate(pNode, i, pParentIt);
          return &pIt->iterator;
-      } else {
+      } else if (iCmp > 0) {
          ++i;
       }
       if (pNode->bIsLeafNode) {
          pNode = NULL;
       } else {
+         pParentIt = cfl_btree_iteratorCreate(pNode, i, pParentIt);
          pNode = GET_CHILD(pNode, i);
-         pParentIt = cfl_btree_iteratorCreate(pNode, i, NULL);
       }
    }
    if (pParentIt != NULL) {
@@ -648,7 +945,7 @@ static CFL_ITERATORP cfl_btree_iteratorSearchFromNode(CFL_BTREE_NODEP pNode, voi
 }
 
 CFL_ITERATORP cfl_btree_iteratorSearch(CFL_BTREEP pTree, void * pKey) {
-   return cfl_btree_iteratorSearchFromNode(pTree->pRoot, pKey);
+   return cfl_btree_iteratorOf((BTreeIterator *) cfl_btree_iteratorSearchFromNode(pTree->pRoot, pKey), pTree);
 }
 
 static BTreeIterator *cfl_btree_iteratorSearchLikeFromNode(CFL_BTREE_NODEP pNode, void * pKey, BTreeIterator *pParentIt) {
@@ -676,11 +973,7 @@ static BTreeIterator *cfl_btree_iteratorSearchLikeFromNode(CFL_BTREE_NODEP pNode
 }
 
 CFL_ITERATORP cfl_btree_iteratorSearchLike(CFL_BTREEP pTree, void * pKey) {
-   BTreeIterator *pIterator = cfl_btree_iteratorSearchLikeFromNode(pTree->pRoot, pKey, NULL);
-   if (pIterator != NULL) {
-      return &pIterator->iterator;
-   }
-   return NULL;
+   return cfl_btree_iteratorOf(cfl_btree_iteratorSearchLikeFromNode(pTree->pRoot, pKey, NULL), pTree);
 }
 
 static BTreeIterator *cfl_btree_iteratorSoftSearchLikeFromNode(CFL_BTREE_NODEP pNode, void * pKey, BTreeIterator *pParentIt) {
@@ -709,11 +1002,7 @@ static BTreeIterator *cfl_btree_iteratorSoftSearchLikeFromNode(CFL_BTREE_NODEP p
 }
 
 CFL_ITERATORP cfl_btree_iteratorSoftSearchLike(CFL_BTREEP pTree, void * pKey) {
-   BTreeIterator *pIterator = cfl_btree_iteratorSoftSearchLikeFromNode(pTree->pRoot, pKey, NULL);
-   if (pIterator != NULL) {
-      return &pIterator->iterator;
-   }
-   return NULL;
+   return cfl_btree_iteratorOf(cfl_btree_iteratorSoftSearchLikeFromNode(pTree->pRoot, pKey, NULL), pTree);
 }
 
 static BTreeIterator *cfl_btree_iteratorSearchLastLikeFromNode(CFL_BTREE_NODEP pNode, void * pKey, BTreeIterator *pParentIt) {
@@ -741,11 +1030,7 @@ static BTreeIterator *cfl_btree_iteratorSearchLastLikeFromNode(CFL_BTREE_NODEP p
 }
 
 CFL_ITERATORP cfl_btree_iteratorSearchLastLike(CFL_BTREEP pTree, void * pKey) {
-   BTreeIterator *pIterator = cfl_btree_iteratorSearchLastLikeFromNode(pTree->pRoot, pKey, NULL);
-   if (pIterator != NULL) {
-      return &pIterator->iterator;
-   }
-   return NULL;
+   return cfl_btree_iteratorOf(cfl_btree_iteratorSearchLastLikeFromNode(pTree->pRoot, pKey, NULL), pTree);
 }
 
 static BTreeIterator *cfl_btree_iteratorSoftSearchLastLikeFromNode(CFL_BTREE_NODEP pNode, void * pKey, BTreeIterator *pParentIt) {
@@ -773,11 +1058,7 @@ static BTreeIterator *cfl_btree_iteratorSoftSearchLastLikeFromNode(CFL_BTREE_NOD
 }
 
 CFL_ITERATORP cfl_btree_iteratorSoftSearchLastLike(CFL_BTREEP pTree, void * pKey) {
-   BTreeIterator *pIterator = cfl_btree_iteratorSoftSearchLastLikeFromNode(pTree->pRoot, pKey, NULL);
-   if (pIterator != NULL) {
-      return &pIterator->iterator;
-   }
-   return NULL;
+   return cfl_btree_iteratorOf(cfl_btree_iteratorSoftSearchLastLikeFromNode(pTree->pRoot, pKey, NULL), pTree);
 }
 
 CFL_ITERATORP cfl_btree_iterator(CFL_BTREEP pTree) {
@@ -789,19 +1070,49 @@ CFL_ITERATORP cfl_btree_iterator(CFL_BTREEP pTree) {
       pNode = GET_CHILD(pNode, 0);
    }
    pIt = cfl_btree_iteratorCreate(pNode, 0, pIt);
-   return &pIt->iterator;
+   return cfl_btree_iteratorOf(pIt, pTree);
 }
 
 CFL_ITERATORP cfl_btree_iteratorLast(CFL_BTREEP pTree) {
    BTreeIterator *pIt = NULL;
    CFL_BTREE_NODEP pNode = pTree->pRoot;
-   /* Busca o no mais a direita da arvore, que deve ser o de menor chave... */
+   /* Busca o no mais a direita da arvore, que deve ser o de maior chave... */
    while (!pNode->bIsLeafNode) {
-      pIt = cfl_btree_iteratorCreate(pNode, pNode->lNumKeys - 1, pIt);
+      pIt = cfl_btree_iteratorCreate(pNode, pNode->lNumKeys, pIt);
       pNode = GET_CHILD(pNode, pNode->lNumKeys);
    }
-   pIt = cfl_btree_iteratorCreate(pNode, pNode->lNumKeys - 1, pIt);
-   return &pIt->iterator;
+   pIt = cfl_btree_iteratorCreate(pNode, pNode->lNumKeys, pIt);
+   return cfl_btree_iteratorOf(pIt, pTree);
+}
+
+CFL_ITERATORP cfl_btree_iteratorAt(CFL_BTREEP pTree, CFL_INT32 lPosition) {
+   BTreeIterator *pIt = NULL;
+   CFL_BTREE_NODEP pNode = pTree->pRoot;
+   if (lPosition < 1 || lPosition > pNode->lCount) {
+      return NULL;
+   }
+   while (!pNode->bIsLeafNode) {
+      CFL_INT32 i = 0;
+      CFL_BTREE_NODEP pChildNode = GET_CHILD(pNode, 0);
+      while (lPosition > pChildNode->lCount + 1) {
+         lPosition -= pChildNode->lCount + 1;
+         pChildNode = GET_CHILD(pNode, ++i);
+      }
+      pIt = cfl_btree_iteratorCreate(pNode, i, pIt);
+      if (lPosition == pChildNode->lCount + 1) {
+         /* A chave esta no noh interno: posiciona apos a ultima chave da subarvore a esquerda */
+         pNode = pChildNode;
+         while (!pNode->bIsLeafNode) {
+            pIt = cfl_btree_iteratorCreate(pNode, pNode->lNumKeys, pIt);
+            pNode = GET_CHILD(pNode, pNode->lNumKeys);
+         }
+         pIt = cfl_btree_iteratorCreate(pNode, pNode->lNumKeys, pIt);
+         return cfl_btree_iteratorOf(pIt, pTree);
+      }
+      pNode = pChildNode;
+   }
+   pIt = cfl_btree_iteratorCreate(pNode, lPosition - 1, pIt);
+   return cfl_btree_iteratorOf(pIt, pTree);
 }
 
 static void cfl_btree_iterator_free(CFL_ITERATORP iterator) {
@@ -816,7 +1127,7 @@ static void cfl_btree_iterator_free(CFL_ITERATORP iterator) {
 static void cfl_btree_iterator_first(CFL_ITERATORP iterator) {
    BTreeIterator *pIt = (BTreeIterator *) iterator;
    BTreeIterator *pPreviousIt;
-   CFL_BTREE_NODEP pNode = pIt->pNode->pTree->pRoot;
+   CFL_BTREE_NODEP pNode = pIt->pTree->pRoot;
 
    pPreviousIt = pIt->pPreviousIt;
    while (pPreviousIt != NULL) {
@@ -832,13 +1143,14 @@ static void cfl_btree_iterator_first(CFL_ITERATORP iterator) {
    }
    pIt->pNode = pNode;
    pIt->lKey = 0;
+   pIt->pValue = NULL;
    pIt->pPreviousIt = pPreviousIt;
 }
 
 static void cfl_btree_iterator_last(CFL_ITERATORP iterator) {
    BTreeIterator *pIt = (BTreeIterator *) iterator;
    BTreeIterator *pPreviousIt;
-   CFL_BTREE_NODEP pNode = pIt->pNode->pTree->pRoot;
+   CFL_BTREE_NODEP pNode = pIt->pTree->pRoot;
 
    pPreviousIt = pIt->pPreviousIt;
    while (pPreviousIt != NULL) {
@@ -849,22 +1161,65 @@ static void cfl_btree_iterator_last(CFL_ITERATORP iterator) {
    pPreviousIt = NULL;
    /* Busca o no mais a esquerda da arvore, que deve ser o de menor chave... */
    while (!pNode->bIsLeafNode) {
-      pPreviousIt = cfl_btree_iteratorCreate(pNode, pNode->lNumKeys - 1, pPreviousIt);
+      pPreviousIt = cfl_btree_iteratorCreate(pNode, pNode->lNumKeys, pPreviousIt);
       pNode = GET_CHILD(pNode, pNode->lNumKeys);
    }
    pIt->pNode = pNode;
-   pIt->lKey = pNode->lNumKeys - 1;
+   pIt->lKey = pNode->lNumKeys;
+   pIt->pValue = NULL;
    pIt->pPreviousIt = pPreviousIt;
 }
 
+/*
+ * O iterator eh uma pilha de nos: o topo eh o cursor e cada no anterior guarda o indice do filho em que o cursor esta.
+ * No topo, lKey eh a posicao da proxima chave a ser retornada.
+ */
+
+// Descend from the top node of the iterator into its lKey-th child, down to the leftmost or rightmost leaf.
+
+static void cfl_btree_iterator_descend(BTreeIterator *pIt, CFL_BOOL bLeftmost) {
+   while (!pIt->pNode->bIsLeafNode) {
+      CFL_BTREE_NODEP pChildNode = GET_CHILD(pIt->pNode, pIt->lKey);
+      BTreeIterator *pParentIt = (BTreeIterator *) CFL_MEM_ALLOC(sizeof(BTreeIterator));
+      memcpy(pParentIt, pIt, sizeof(BTreeIterator));
+      pIt->pNode = pChildNode;
+      pIt->lKey = bLeftmost ? 0 : pChildNode->lNumKeys;
+      pIt->pPreviousIt = pParentIt;
+   }
+}
+
+// A search may leave the cursor on a key of an internal node. Move it to the end of the leaf that precedes that key.
+
+static void cfl_btree_iterator_toLeaf(BTreeIterator *pIt) {
+   if (!pIt->pNode->bIsLeafNode) {
+      cfl_btree_iterator_descend(pIt, CFL_FALSE);
+   }
+}
+
+// Move the cursor up to the parent pParentIt, releasing the nodes in between.
+
+static void cfl_btree_iterator_ascend(BTreeIterator *pIt, BTreeIterator *pParentIt) {
+   BTreeIterator *pAuxIt = pIt->pPreviousIt;
+   while (pAuxIt != pParentIt) {
+      BTreeIterator *pNextIt = pAuxIt->pPreviousIt;
+      CFL_MEM_FREE(pAuxIt);
+      pAuxIt = pNextIt;
+   }
+   pIt->pNode = pParentIt->pNode;
+   pIt->lKey = pParentIt->lKey;
+   pIt->pPreviousIt = pParentIt->pPreviousIt;
+   CFL_MEM_FREE(pParentIt);
+}
+
 static CFL_BOOL cfl_btree_iterator_hasNext(CFL_ITERATORP iterator) {
    BTreeIterator *pIt = (BTreeIterator *) iterator;
 
-   while (pIt != NULL) {
+   if (pIt->lKey < pIt->pNode->lNumKeys) {
+      return CFL_TRUE;
+   }
+   for (pIt = pIt->pPreviousIt; pIt != NULL; pIt = pIt->pPreviousIt) {
       if (pIt->lKey < pIt->pNode->lNumKeys) {
          return CFL_TRUE;
-      } else {
-         pIt = pIt->pPreviousIt;
       }
    }
    return CFL_FALSE;
@@ -873,81 +1228,235 @@ static CFL_BOOL cfl_btree_iterator_hasNext(CFL_ITERATORP iterator) {
 static CFL_BOOL cfl_btree_iterator_hasPrevious(CFL_ITERATORP iterator) {
    BTreeIterator *pIt = (BTreeIterator *) iterator;
 
+   cfl_btree_iterator_toLeaf(pIt);
    while (pIt != NULL) {
       if (pIt->lKey > 0) {
          return CFL_TRUE;
-      } else {
-         pIt = pIt->pPreviousIt;
       }
+      pIt = pIt->pPreviousIt;
    }
    return CFL_FALSE;
 }
 
 static void * cfl_btree_iterator_next(CFL_ITERATORP iterator) {
    BTreeIterator *pIt = (BTreeIterator *) iterator;
-   CFL_BOOL bGoingback = CFL_FALSE;
+   BTreeIterator *pParentIt;
+
+   cfl_btree_iterator_toLeaf(pIt);
+   if (pIt->lKey < pIt->pNode->lNumKeys) {
+      pIt->pValue = GET_KEY(pIt->pNode, (pIt->lKey)++);
+      return pIt->pValue;
+   }
+   /* Sobe ate o primeiro no que ainda tem chave apos o filho corrente */
+   for (pParentIt = pIt->pPreviousIt; pParentIt != NULL; pParentIt = pParentIt->pPreviousIt) {
+      if (pParentIt->lKey < pParentIt->pNode->lNumKeys) {
+         cfl_btree_iterator_ascend(pIt, pParentIt);
+         pIt->pValue = GET_KEY(pIt->pNode, pIt->lKey);
+         ++(pIt->lKey);
+         cfl_btree_iterator_descend(pIt, CFL_TRUE);
+         return pIt->pValue;
+      }
+   }
+   return NULL;
+}
+
+// Copy the keys left in the current leaf at once and go through cfl_btree_iterator_next only to cross to the next leaf.
+
+static CFL_UINT32 cfl_btree_iterator_nextBatch(CFL_ITERATORP iterator, void **out, CFL_UINT32 n) {
+   BTreeIterator *pIt = (BTreeIterator *) iterator;
+   CFL_UINT32 count = 0;
 
-   while (CFL_TRUE) {
+   while (count < n) {
+      cfl_btree_iterator_toLeaf(pIt);
       if (pIt->lKey < pIt->pNode->lNumKeys) {
-         if (pIt->pNode->bIsLeafNode || bGoingback) {
-            return GET_KEY(pIt->pNode, (pIt->lKey)++);
-         } else {
-            CFL_BTREE_NODEP pChildNode = GET_CHILD(pIt->pNode, pIt->lKey);
-            BTreeIterator *pParentIt = (BTreeIterator *) CFL_MEM_ALLOC(sizeof(BTreeIterator));
-            memcpy(pParentIt, pIt, sizeof (BTreeIterator));
-            pIt->pNode = pChildNode;
-            pIt->lKey = 0;
-            pIt->pPreviousIt = pParentIt;
-            continue;
+         CFL_UINT32 ulKeys = (CFL_UINT32) (pIt->pNode->lNumKeys - pIt->lKey);
+         if (ulKeys > n - count) {
+            ulKeys = n - count;
+         }
+         while (ulKeys-- > 0) {
+            out[count++] = GET_KEY(pIt->pNode, (pIt->lKey)++);
          }
-      } else if (pIt->pPreviousIt != NULL) {
-         BTreeIterator *pAuxIt = pIt->pPreviousIt;
-         pIt->pNode = pAuxIt->pNode;
-         pIt->lKey = pAuxIt->lKey;
-         pIt->pPreviousIt = pAuxIt->pPreviousIt;
-         CFL_MEM_FREE(pAuxIt);
-         bGoingback = CFL_TRUE;
-         continue;
+         pIt->pValue = out[count - 1];
+      } else if (cfl_btree_iterator_hasNext(iterator)) {
+         out[count++] = cfl_btree_iterator_next(iterator);
+      } else {
+         break;
       }
-      return NULL;
    }
+   return count;
 }
 
 static void * cfl_btree_iterator_value(CFL_ITERATORP iterator) {
    BTreeIterator *pIt = (BTreeIterator *) iterator;
-   if (pIt != NULL && pIt->pNode != NULL && pIt->lKey >= 0) {
-      return GET_KEY(pIt->pNode, pIt->lKey);
+   if (pIt != NULL) {
+      return pIt->pValue;
    }
    return NULL;
 }
 
 static void * cfl_btree_iterator_previous(CFL_ITERATORP iterator) {
    BTreeIterator *pIt = (BTreeIterator *) iterator;
-   CFL_BOOL bGoingback = CFL_FALSE;
+   BTreeIterator *pParentIt;
 
-   while (CFL_TRUE) {
-      if (pIt->lKey > 0) {
-         if (pIt->pNode->bIsLeafNode || bGoingback) {
-            return GET_KEY(pIt->pNode, --(pIt->lKey));
-         } else {
-            CFL_BTREE_NODEP pChildNode = GET_CHILD(pIt->pNode, pIt->lKey);
-            BTreeIterator *pParentIt = (BTreeIterator *) CFL_MEM_ALLOC(sizeof(BTreeIterator));
-            memcpy(pParentIt, pIt, sizeof(BTreeIterator));
-            pIt->pNode = pChildNode;
-            pIt->lKey = pChildNode->lNumKeys;
-            pIt->pPreviousIt = pParentIt;
-            continue;
+   cfl_btree_iterator_toLeaf(pIt);
+   if (pIt->lKey > 0) {
+      pIt->pValue = GET_KEY(pIt->pNode, --(pIt->lKey));
+      return pIt->pValue;
+   }
+   /* Sobe ate o primeiro no que ainda tem chave antes do filho corrente */
+   for (pParentIt = pIt->pPreviousIt; pParentIt != NULL; pParentIt = pParentIt->pPreviousIt) {
+      if (pParentIt->lKey > 0) {
+         cfl_btree_iterator_ascend(pIt, pParentIt);
+         pIt->pValue = GET_KEY(pIt->pNode, --(pIt->lKey));
+         cfl_btree_iterator_descend(pIt, CFL_FALSE);
+         return pIt->pValue;
+      }
+   }
+   return NULL;
+}
+
+// Descend from the top level of the stack iterator into its lKey-th child, down to the leftmost or rightmost leaf.
+
+static void cfl_btree_stackIterator_descend(BTreeStackIterator *pIt, CFL_BOOL bLeftmost) {
+   BTreeStackLevel *pLevel = &pIt->levels[pIt->lDepth - 1];
+   while (!pLevel->pNode->bIsLeafNode) {
+      CFL_BTREE_NODEP pChildNode = GET_CHILD(pLevel->pNode, pLevel->lKey);
+      ++pLevel;
+      ++(pIt->lDepth);
+      pLevel->pNode = pChildNode;
+      pLevel->lKey = bLeftmost ? 0 : pChildNode->lNumKeys;
+   }
+}
+
+static void cfl_btree_stackIterator_first(CFL_ITERATORP iterator) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) iterator;
+   pIt->levels[0].pNode = pIt->pTree->pRoot;
+   pIt->levels[0].lKey = 0;
+   pIt->lDepth = 1;
+   pIt->pValue = NULL;
+   cfl_btree_stackIterator_descend(pIt, CFL_TRUE);
+}
+
+static void cfl_btree_stackIterator_last(CFL_ITERATORP iterator) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) iterator;
+   CFL_BTREE_NODEP pRoot = pIt->pTree->pRoot;
+   pIt->levels[0].pNode = pRoot;
+   pIt->levels[0].lKey = pRoot->lNumKeys;
+   pIt->lDepth = 1;
+   pIt->pValue = NULL;
+   cfl_btree_stackIterator_descend(pIt, CFL_FALSE);
+}
+
+static CFL_BOOL cfl_btree_stackIterator_hasNext(CFL_ITERATORP iterator) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) iterator;
+   CFL_INT32 i;
+
+   for (i = pIt->lDepth - 1; i >= 0; i--) {
+      if (pIt->levels[i].lKey < pIt->levels[i].pNode->lNumKeys) {
+         return CFL_TRUE;
+      }
+   }
+   return CFL_FALSE;
+}
+
+static CFL_BOOL cfl_btree_stackIterator_hasPrevious(CFL_ITERATORP iterator) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) iterator;
+   CFL_INT32 i;
+
+   for (i = pIt->lDepth - 1; i >= 0; i--) {
+      if (pIt->levels[i].lKey > 0) {
+         return CFL_TRUE;
+      }
+   }
+   return CFL_FALSE;
+}
+
+static void * cfl_btree_stackIterator_next(CFL_ITERATORP iterator) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) iterator;
+   BTreeStackLevel *pLevel = &pIt->levels[pIt->lDepth - 1];
+   CFL_INT32 i;
+
+   if (pLevel->lKey < pLevel->pNode->lNumKeys) {
+      pIt->pValue = GET_KEY(pLevel->pNode, (pLevel->lKey)++);
+      return pIt->pValue;
+   }
+   /* Sobe ate o primeiro no que ainda tem chave apos o filho corrente */
+   for (i = pIt->lDepth - 2; i >= 0; i--) {
+      pLevel = &pIt->levels[i];
+      if (pLevel->lKey < pLevel->pNode->lNumKeys) {
+         pIt->lDepth = i + 1;
+         pIt->pValue = GET_KEY(pLevel->pNode, (pLevel->lKey)++);
+         cfl_btree_stackIterator_descend(pIt, CFL_TRUE);
+         return pIt->pValue;
+      }
+   }
+   return NULL;
+}
+
+static void * cfl_btree_stackIterator_previous(CFL_ITERATORP iterator) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) iterator;
+   BTreeStackLevel *pLevel = &pIt->levels[pIt->lDepth - 1];
+   CFL_INT32 i;
+
+   if (pLevel->lKey > 0) {
+      pIt->pValue = GET_KEY(pLevel->pNode, --(pLevel->lKey));
+      return pIt->pValue;
+   }
+   /* Sobe ate o primeiro no que ainda tem chave antes do filho corrente */
+   for (i = pIt->lDepth - 2; i >= 0; i--) {
+      pLevel = &pIt->levels[i];
+      if (pLevel->lKey > 0) {
+         pIt->lDepth = i + 1;
+         pIt->pValue = GET_KEY(pLevel->pNode, --(pLevel->lKey));
+         cfl_btree_stackIterator_descend(pIt, CFL_FALSE);
+         return pIt->pValue;
+      }
+   }
+   return NULL;
+}
+
+static CFL_UINT32 cfl_btree_stackIterator_nextBatch(CFL_ITERATORP iterator, void **out, CFL_UINT32 n) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) iterator;
+   CFL_UINT32 count = 0;
+
+   while (count < n) {
+      BTreeStackLevel *pLevel = &pIt->levels[pIt->lDepth - 1];
+      if (pLevel->lKey < pLevel->pNode->lNumKeys) {
+         CFL_UINT32 ulKeys = (CFL_UINT32) (pLevel->pNode->lNumKeys - pLevel->lKey);
+         if (ulKeys > n - count) {
+            ulKeys = n - count;
+         }
+         while (ulKeys-- > 0) {
+            out[count++] = GET_KEY(pLevel->pNode, (pLevel->lKey)++);
          }
-      } else if (pIt->pPreviousIt != NULL) {
-         BTreeIterator *pAuxIt = pIt->pPreviousIt;
-         pIt->pNode = pAuxIt->pNode;
-         pIt->lKey = pAuxIt->lKey;
-         pIt->pPreviousIt = pAuxIt->pPreviousIt;
-         CFL_MEM_FREE(pAuxIt);
-         bGoingback = CFL_TRUE;
-         continue;
+         pIt->pValue = out[count - 1];
+      } else if (cfl_btree_stackIterator_hasNext(iterator)) {
+         out[count++] = cfl_btree_stackIterator_next(iterator);
+      } else {
+         break;
       }
    }
+   return count;
+}
+
+static void * cfl_btree_stackIterator_value(CFL_ITERATORP iterator) {
+   return ((BTreeStackIterator *) iterator)->pValue;
+}
+
+CFL_ITERATORP cfl_btree_iteratorInit(CFL_ITERATORP it, CFL_BTREEP pTree) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) it;
+   pIt->iterator.itClass = &cfl_btree_stackIterator_class;
+   pIt->pTree = pTree;
+   cfl_btree_stackIterator_first(it);
+   return it;
+}
+
+CFL_ITERATORP cfl_btree_iteratorLastInit(CFL_ITERATORP it, CFL_BTREEP pTree) {
+   BTreeStackIterator *pIt = (BTreeStackIterator *) it;
+   pIt->iterator.itClass = &cfl_btree_stackIterator_class;
+   pIt->pTree = pTree;
+   cfl_btree_stackIterator_last(it);
+   return it;
 }
 
 CFL_BOOL cfl_btree_walk(CFL_BTREE_NODEP pNode, BTREE_WALK_CALLBACK callback) {
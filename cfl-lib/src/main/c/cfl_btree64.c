@@ -0,0 +1,643 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfl_btree64.h"
+#include "cfl_iterator.h"
+#include "cfl_mem.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* The keys array has room for one extra key so that an insertion can overflow the node before it is split. The
+ * pointers (values of a leaf or children of an internal node) follow the keys, reached by a byte offset so that they
+ * are never accessed through a CFL_INT64. */
+#define NODE_POINTERS(t, n)        ((void **) ((char *) (n)->keys + sizeof(CFL_INT64) * ((t)->lKeys + 1)))
+#define NODE_VALUE(t, n, i)        (NODE_POINTERS(t, n)[i])
+#define NODE_CHILD(t, n, i)        ((CFL_BTREE64_NODEP) NODE_POINTERS(t, n)[i])
+#define NODE_SET_VALUE(t, n, i, p) (NODE_POINTERS(t, n)[i] = (void *) (p))
+#define NODE_SET_CHILD(t, n, i, p) (NODE_POINTERS(t, n)[i] = (void *) (p))
+
+#define MIN_KEYS(t)                ((t)->lKeys / 2)
+
+/* Below this number of keys a linear scan of the contiguous keys is faster than keep halving the range */
+#define LINEAR_SEARCH_KEYS         16
+
+typedef struct _BTree64Iterator {
+   CFL_ITERATOR      iterator;
+   CFL_BTREE64P      pTree;
+   CFL_BTREE64_NODEP pLeaf;
+   CFL_INT32         lKey;
+   CFL_INT64         key;
+   void             *pValue;
+   CFL_INT64         lowKey;
+   CFL_INT64         highKey;
+   CFL_BOOL          bRange;
+} BTree64Iterator;
+
+static CFL_BOOL cfl_btree64_iterator_hasNext(CFL_ITERATORP pIt);
+static void *cfl_btree64_iterator_next(CFL_ITERATORP pIt);
+static void *cfl_btree64_iterator_value(CFL_ITERATORP pIt);
+static void cfl_btree64_iterator_first(CFL_ITERATORP pIt);
+static void cfl_btree64_iterator_last(CFL_ITERATORP pIt);
+static CFL_BOOL cfl_btree64_iterator_hasPrevious(CFL_ITERATORP pIt);
+static void *cfl_btree64_iterator_previous(CFL_ITERATORP pIt);
+
+static CFL_ITERATOR_CLASS cfl_btree64_iterator_class = {
+   cfl_btree64_iterator_hasNext,
+   cfl_btree64_iterator_next,
+   cfl_btree64_iterator_value,
+   NULL,
+   NULL,
+   cfl_btree64_iterator_first,
+   cfl_btree64_iterator_hasPrevious,
+   cfl_btree64_iterator_previous,
+   cfl_btree64_iterator_last,
+   NULL,
+   NULL,
+   NULL,
+};
+
+static CFL_BTREE64_NODEP cfl_btree64_node_new(CFL_BTREE64P pTree, CFL_BOOL bIsLeafNode) {
+   size_t nodeSize = sizeof(CFL_BTREE64_NODE) + (sizeof(CFL_INT64) * (pTree->lKeys + 1)) + (sizeof(void *) * (pTree->lKeys + 2));
+   CFL_BTREE64_NODEP pNode = (CFL_BTREE64_NODEP) CFL_MEM_ALLOC(nodeSize);
+   if (pNode == NULL) {
+      return NULL;
+   }
+   memset(pNode, 0, nodeSize);
+   pNode->bIsLeafNode = bIsLeafNode;
+   return pNode;
+}
+
+static void cfl_btree64_node_free(CFL_BTREE64_NODEP pNode) {
+   CFL_MEM_FREE(pNode);
+}
+
+// Number of keys less than (or less than or equal to, if bOrEqual) key. The range is halved while it is large and the
+// remaining keys are counted without branches, four at a time with AVX2.
+
+static CFL_INT32 cfl_btree64_countLess(const CFL_INT64 *keys, CFL_INT32 lNumKeys, CFL_INT64 key, CFL_BOOL bOrEqual) {
+   CFL_INT32 lFirst = 0;
+   CFL_INT32 lLast = lNumKeys;
+   CFL_INT32 lCount;
+   CFL_INT32 i;
+
+   while (lLast - lFirst > LINEAR_SEARCH_KEYS) {
+      CFL_INT32 lMiddle = lFirst + ((lLast - lFirst) / 2);
+      if (keys[lMiddle] < key || (bOrEqual && keys[lMiddle] == key)) {
+         lFirst = lMiddle + 1;
+      } else {
+         lLast = lMiddle;
+      }
+   }
+   lCount = lFirst;
+   i = lFirst;
+#if defined(__AVX2__)
+   {
+      __m256i vKey = _mm256_set1_epi64x(key);
+      for (; i + 4 <= lLast; i += 4) {
+         __m256i vKeys = _mm256_loadu_si256((const __m256i *) &keys[i]);
+         // keys[i] <= key is !(keys[i] > key)
+         __m256i vMask = bOrEqual ? _mm256_cmpgt_epi64(vKeys, vKey) : _mm256_cmpgt_epi64(vKey, vKeys);
+         CFL_INT32 lBits = (CFL_INT32) _mm_popcnt_u32((unsigned int) _mm256_movemask_pd(_mm256_castsi256_pd(vMask)));
+         lCount += bOrEqual ? 4 - lBits : lBits;
+      }
+   }
+#endif
+   if (bOrEqual) {
+      for (; i < lLast; i++) {
+         lCount += keys[i] <= key;
+      }
+   } else {
+      for (; i < lLast; i++) {
+         lCount += keys[i] < key;
+      }
+   }
+   return lCount;
+}
+
+#define NODE_LOWER_BOUND(n, k) cfl_btree64_countLess((n)->keys, (n)->lNumKeys, k, CFL_FALSE)
+#define NODE_UPPER_BOUND(n, k) cfl_btree64_countLess((n)->keys, (n)->lNumKeys, k, CFL_TRUE)
+
+// Child of an internal node to descend into. The first lines of the child (header and the middle of its keys, where
+// the search starts) are requested while the caller is still working with the parent.
+
+static CFL_BTREE64_NODEP cfl_btree64_childFor(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pNode, CFL_INT64 key, CFL_INT32 *pIndex) {
+   CFL_INT32 i = NODE_UPPER_BOUND(pNode, key);
+   CFL_BTREE64_NODEP pChild = NODE_CHILD(pTree, pNode, i);
+   CFL_PREFETCH(pChild);
+   CFL_PREFETCH(&pChild->keys[pTree->lKeys / 2]);
+   if (pIndex != NULL) {
+      *pIndex = i;
+   }
+   return pChild;
+}
+
+// Descend to the leaf that must contain key. A separator key is the smallest key of its right subtree.
+
+static CFL_BTREE64_NODEP cfl_btree64_findLeaf(CFL_BTREE64P pTree, CFL_INT64 key) {
+   CFL_BTREE64_NODEP pNode = pTree->pRoot;
+   while (!pNode->bIsLeafNode) {
+      pNode = cfl_btree64_childFor(pTree, pNode, key, NULL);
+   }
+   return pNode;
+}
+
+CFL_BTREE64P cfl_btree64_new(CFL_INT32 lKeys) {
+   CFL_BTREE64P pTree = (CFL_BTREE64P) CFL_MEM_ALLOC(sizeof(CFL_BTREE64));
+   if (pTree == NULL) {
+      return NULL;
+   }
+   if (lKeys <= 0) {
+      lKeys = CFL_BTREE64_DEFAULT_KEYS;
+   }
+   pTree->lKeys = lKeys < 3 ? 3 : lKeys;
+   pTree->lCount = 0;
+   pTree->pRoot = cfl_btree64_node_new(pTree, CFL_TRUE);
+   if (pTree->pRoot == NULL) {
+      CFL_MEM_FREE(pTree);
+      return NULL;
+   }
+   pTree->pFirstLeaf = pTree->pRoot;
+   pTree->pLastLeaf = pTree->pRoot;
+   return pTree;
+}
+
+static void cfl_btree64_freeNodes(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pNode) {
+   if (!pNode->bIsLeafNode) {
+      CFL_INT32 i;
+      for (i = 0; i <= pNode->lNumKeys; i++) {
+         cfl_btree64_freeNodes(pTree, NODE_CHILD(pTree, pNode, i));
+      }
+   }
+   cfl_btree64_node_free(pNode);
+}
+
+void cfl_btree64_free(CFL_BTREE64P pTree, BTREE_FREE_KEY_FUNC pFreeValue) {
+   if (pTree == NULL) {
+      return;
+   }
+   if (pFreeValue != NULL) {
+      CFL_BTREE64_NODEP pLeaf;
+      for (pLeaf = pTree->pFirstLeaf; pLeaf != NULL; pLeaf = pLeaf->pNextLeaf) {
+         CFL_INT32 i;
+         for (i = 0; i < pLeaf->lNumKeys; i++) {
+            pFreeValue(NODE_VALUE(pTree, pLeaf, i));
+         }
+      }
+   }
+   cfl_btree64_freeNodes(pTree, pTree->pRoot);
+   CFL_MEM_FREE(pTree);
+}
+
+// Allocate, before the tree is changed, the nodes that the insertion of the key may need: one for each full node at the
+// bottom of the path to its leaf, which would be split, and a new root if the whole path is full. The spare nodes are
+// chained by pNextLeaf.
+
+static CFL_BOOL cfl_btree64_reserveSplits(CFL_BTREE64P pTree, CFL_INT64 key, CFL_BTREE64_NODEP *ppSpare) {
+   CFL_BTREE64_NODEP pNode = pTree->pRoot;
+   CFL_INT32 lDepth = 0;
+   CFL_INT32 lSplits = 0;
+
+   *ppSpare = NULL;
+   for (;;) {
+      ++lDepth;
+      lSplits = pNode->lNumKeys >= pTree->lKeys ? lSplits + 1 : 0;
+      if (pNode->bIsLeafNode) {
+         break;
+      }
+      pNode = NODE_CHILD(pTree, pNode, NODE_UPPER_BOUND(pNode, key));
+   }
+   if (lSplits == lDepth) {
+      ++lSplits;
+   }
+   while (lSplits-- > 0) {
+      pNode = cfl_btree64_node_new(pTree, CFL_FALSE);
+      if (pNode == NULL) {
+         return CFL_FALSE;
+      }
+      pNode->pNextLeaf = *ppSpare;
+      *ppSpare = pNode;
+   }
+   return CFL_TRUE;
+}
+
+static CFL_BTREE64_NODEP cfl_btree64_takeSpare(CFL_BTREE64_NODEP *ppSpare, CFL_BOOL bIsLeafNode) {
+   CFL_BTREE64_NODEP pNode = *ppSpare;
+   *ppSpare = pNode->pNextLeaf;
+   pNode->pNextLeaf = NULL;
+   pNode->bIsLeafNode = bIsLeafNode;
+   return pNode;
+}
+
+static void cfl_btree64_freeSpares(CFL_BTREE64_NODEP pSpare) {
+   while (pSpare != NULL) {
+      CFL_BTREE64_NODEP pNext = pSpare->pNextLeaf;
+      cfl_btree64_node_free(pSpare);
+      pSpare = pNext;
+   }
+}
+
+// Split an overflowed leaf. The new right leaf is linked into the leaf chain and its first key is copied up as separator.
+
+static CFL_BTREE64_NODEP cfl_btree64_splitLeaf(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pNode, CFL_INT64 *pSeparator,
+                                               CFL_BTREE64_NODEP *ppSpare) {
+   CFL_BTREE64_NODEP pNewNode = cfl_btree64_takeSpare(ppSpare, CFL_TRUE);
+   CFL_INT32 lLeftKeys = (pTree->lKeys + 1) / 2;
+
+   pNewNode->lNumKeys = pNode->lNumKeys - lLeftKeys;
+   memcpy(pNewNode->keys, &pNode->keys[lLeftKeys], sizeof(CFL_INT64) * pNewNode->lNumKeys);
+   memcpy(NODE_POINTERS(pTree, pNewNode), &NODE_POINTERS(pTree, pNode)[lLeftKeys], sizeof(void *) * pNewNode->lNumKeys);
+   pNode->lNumKeys = lLeftKeys;
+
+   pNewNode->pPrevLeaf = pNode;
+   pNewNode->pNextLeaf = pNode->pNextLeaf;
+   if (pNode->pNextLeaf != NULL) {
+      pNode->pNextLeaf->pPrevLeaf = pNewNode;
+   } else {
+      pTree->pLastLeaf = pNewNode;
+   }
+   pNode->pNextLeaf = pNewNode;
+
+   *pSeparator = pNewNode->keys[0];
+   return pNewNode;
+}
+
+// Split an overflowed internal node. The median key moves up to the parent.
+
+static CFL_BTREE64_NODEP cfl_btree64_splitInternal(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pNode, CFL_INT64 *pSeparator,
+                                                   CFL_BTREE64_NODEP *ppSpare) {
+   CFL_BTREE64_NODEP pNewNode = cfl_btree64_takeSpare(ppSpare, CFL_FALSE);
+   CFL_INT32 lLeftKeys = (pTree->lKeys + 1) / 2;
+
+   *pSeparator = pNode->keys[lLeftKeys];
+   pNewNode->lNumKeys = pNode->lNumKeys - lLeftKeys - 1;
+   memcpy(pNewNode->keys, &pNode->keys[lLeftKeys + 1], sizeof(CFL_INT64) * pNewNode->lNumKeys);
+   memcpy(NODE_POINTERS(pTree, pNewNode), &NODE_POINTERS(pTree, pNode)[lLeftKeys + 1],
+          sizeof(void *) * (pNewNode->lNumKeys + 1));
+   pNode->lNumKeys = lLeftKeys;
+   return pNewNode;
+}
+
+// Insert the key in the subtree. When the node overflows it is split with a spare node and the new right node and its
+// separator are returned.
+
+static CFL_BOOL cfl_btree64_insertIntoNode(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pNode, CFL_INT64 key, void *pValue,
+                                           CFL_INT64 *pSeparator, CFL_BTREE64_NODEP *ppNewNode, CFL_BTREE64_NODEP *ppSpare) {
+   void **pPointers = NODE_POINTERS(pTree, pNode);
+   CFL_INT32 i;
+
+   *ppNewNode = NULL;
+   if (pNode->bIsLeafNode) {
+      i = NODE_LOWER_BOUND(pNode, key);
+      if (i < pNode->lNumKeys && pNode->keys[i] == key) {
+         return CFL_FALSE;
+      }
+      memmove(&pNode->keys[i + 1], &pNode->keys[i], sizeof(CFL_INT64) * (pNode->lNumKeys - i));
+      memmove(&pPointers[i + 1], &pPointers[i], sizeof(void *) * (pNode->lNumKeys - i));
+      pNode->keys[i] = key;
+      pPointers[i] = pValue;
+      ++(pNode->lNumKeys);
+      if (pNode->lNumKeys > pTree->lKeys) {
+         *ppNewNode = cfl_btree64_splitLeaf(pTree, pNode, pSeparator, ppSpare);
+      }
+   } else {
+      CFL_INT64 childSeparator;
+      CFL_BTREE64_NODEP pNewChild;
+      CFL_BTREE64_NODEP pChild = cfl_btree64_childFor(pTree, pNode, key, &i);
+      if (!cfl_btree64_insertIntoNode(pTree, pChild, key, pValue, &childSeparator, &pNewChild, ppSpare)) {
+         return CFL_FALSE;
+      }
+      if (pNewChild != NULL) {
+         memmove(&pNode->keys[i + 1], &pNode->keys[i], sizeof(CFL_INT64) * (pNode->lNumKeys - i));
+         memmove(&pPointers[i + 2], &pPointers[i + 1], sizeof(void *) * (pNode->lNumKeys - i));
+         pNode->keys[i] = childSeparator;
+         pPointers[i + 1] = pNewChild;
+         ++(pNode->lNumKeys);
+         if (pNode->lNumKeys > pTree->lKeys) {
+            *ppNewNode = cfl_btree64_splitInternal(pTree, pNode, pSeparator, ppSpare);
+         }
+      }
+   }
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_btree64_add(CFL_BTREE64P pTree, CFL_INT64 key, void *pValue) {
+   CFL_INT64 separator;
+   CFL_BTREE64_NODEP pNewNode;
+   CFL_BTREE64_NODEP pSpare;
+
+   if (!cfl_btree64_reserveSplits(pTree, key, &pSpare)) {
+      cfl_btree64_freeSpares(pSpare);
+      return CFL_FALSE;
+   }
+   if (!cfl_btree64_insertIntoNode(pTree, pTree->pRoot, key, pValue, &separator, &pNewNode, &pSpare)) {
+      cfl_btree64_freeSpares(pSpare);
+      return CFL_FALSE;
+   }
+   if (pNewNode != NULL) {
+      CFL_BTREE64_NODEP pNewRoot = cfl_btree64_takeSpare(&pSpare, CFL_FALSE);
+      pNewRoot->keys[0] = separator;
+      NODE_SET_CHILD(pTree, pNewRoot, 0, pTree->pRoot);
+      NODE_SET_CHILD(pTree, pNewRoot, 1, pNewNode);
+      pNewRoot->lNumKeys = 1;
+      pTree->pRoot = pNewRoot;
+   }
+   cfl_btree64_freeSpares(pSpare);
+   ++(pTree->lCount);
+   return CFL_TRUE;
+}
+
+// Remove the key at lIndex and the child at lIndex + 1 from an internal node.
+
+static void cfl_btree64_node_removeSeparator(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pNode, CFL_INT32 lIndex) {
+   void **pPointers = NODE_POINTERS(pTree, pNode);
+   memmove(&pNode->keys[lIndex], &pNode->keys[lIndex + 1], sizeof(CFL_INT64) * (pNode->lNumKeys - lIndex - 1));
+   memmove(&pPointers[lIndex + 1], &pPointers[lIndex + 2], sizeof(void *) * (pNode->lNumKeys - lIndex - 1));
+   --(pNode->lNumKeys);
+}
+
+// Move all keys (and children) of pRight into pLeft, pRight being the child lIndex + 1 of pParent. pRight is freed.
+
+static void cfl_btree64_mergeNodes(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pParent, CFL_INT32 lIndex,
+                                   CFL_BTREE64_NODEP pLeft, CFL_BTREE64_NODEP pRight) {
+   void **pLeftPointers = NODE_POINTERS(pTree, pLeft);
+   if (pLeft->bIsLeafNode) {
+      memcpy(&pLeft->keys[pLeft->lNumKeys], pRight->keys, sizeof(CFL_INT64) * pRight->lNumKeys);
+      memcpy(&pLeftPointers[pLeft->lNumKeys], NODE_POINTERS(pTree, pRight), sizeof(void *) * pRight->lNumKeys);
+      pLeft->lNumKeys += pRight->lNumKeys;
+      pLeft->pNextLeaf = pRight->pNextLeaf;
+      if (pRight->pNextLeaf != NULL) {
+         pRight->pNextLeaf->pPrevLeaf = pLeft;
+      } else {
+         pTree->pLastLeaf = pLeft;
+      }
+   } else {
+      // The separator comes down between the keys of both nodes
+      pLeft->keys[pLeft->lNumKeys] = pParent->keys[lIndex];
+      memcpy(&pLeft->keys[pLeft->lNumKeys + 1], pRight->keys, sizeof(CFL_INT64) * pRight->lNumKeys);
+      memcpy(&pLeftPointers[pLeft->lNumKeys + 1], NODE_POINTERS(pTree, pRight), sizeof(void *) * (pRight->lNumKeys + 1));
+      pLeft->lNumKeys += pRight->lNumKeys + 1;
+   }
+   cfl_btree64_node_removeSeparator(pTree, pParent, lIndex);
+   cfl_btree64_node_free(pRight);
+}
+
+// Restore the minimum number of keys of the i-th child of pNode borrowing from a sibling or merging with it.
+
+static void cfl_btree64_rebalanceChild(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pNode, CFL_INT32 i) {
+   CFL_BTREE64_NODEP pChild = NODE_CHILD(pTree, pNode, i);
+   CFL_BTREE64_NODEP pLeft = i > 0 ? NODE_CHILD(pTree, pNode, i - 1) : NULL;
+   CFL_BTREE64_NODEP pRight = i < pNode->lNumKeys ? NODE_CHILD(pTree, pNode, i + 1) : NULL;
+   void **pChildPointers = NODE_POINTERS(pTree, pChild);
+
+   if (pLeft != NULL && pLeft->lNumKeys > MIN_KEYS(pTree)) {
+      void **pLeftPointers = NODE_POINTERS(pTree, pLeft);
+      CFL_INT32 lPointers = pChild->bIsLeafNode ? pChild->lNumKeys : pChild->lNumKeys + 1;
+      memmove(&pChild->keys[1], pChild->keys, sizeof(CFL_INT64) * pChild->lNumKeys);
+      memmove(&pChildPointers[1], pChildPointers, sizeof(void *) * lPointers);
+      if (pChild->bIsLeafNode) {
+         pChild->keys[0] = pLeft->keys[pLeft->lNumKeys - 1];
+         pChildPointers[0] = pLeftPointers[pLeft->lNumKeys - 1];
+         pNode->keys[i - 1] = pChild->keys[0];
+      } else {
+         pChild->keys[0] = pNode->keys[i - 1];
+         pChildPointers[0] = pLeftPointers[pLeft->lNumKeys];
+         pNode->keys[i - 1] = pLeft->keys[pLeft->lNumKeys - 1];
+      }
+      --(pLeft->lNumKeys);
+      ++(pChild->lNumKeys);
+   } else if (pRight != NULL && pRight->lNumKeys > MIN_KEYS(pTree)) {
+      void **pRightPointers = NODE_POINTERS(pTree, pRight);
+      CFL_INT32 lPointers;
+      if (pChild->bIsLeafNode) {
+         pChild->keys[pChild->lNumKeys] = pRight->keys[0];
+         pChildPointers[pChild->lNumKeys] = pRightPointers[0];
+         lPointers = pRight->lNumKeys - 1;
+      } else {
+         pChild->keys[pChild->lNumKeys] = pNode->keys[i];
+         pChildPointers[pChild->lNumKeys + 1] = pRightPointers[0];
+         pNode->keys[i] = pRight->keys[0];
+         lPointers = pRight->lNumKeys;
+      }
+      ++(pChild->lNumKeys);
+      memmove(pRight->keys, &pRight->keys[1], sizeof(CFL_INT64) * (pRight->lNumKeys - 1));
+      memmove(pRightPointers, &pRightPointers[1], sizeof(void *) * lPointers);
+      --(pRight->lNumKeys);
+      if (pChild->bIsLeafNode) {
+         pNode->keys[i] = pRight->keys[0];
+      }
+   } else if (pLeft != NULL) {
+      cfl_btree64_mergeNodes(pTree, pNode, i - 1, pLeft, pChild);
+   } else if (pRight != NULL) {
+      cfl_btree64_mergeNodes(pTree, pNode, i, pChild, pRight);
+   }
+}
+
+static CFL_BOOL cfl_btree64_deleteFromNode(CFL_BTREE64P pTree, CFL_BTREE64_NODEP pNode, CFL_INT64 key, void **ppValue) {
+   CFL_INT32 i;
+   if (pNode->bIsLeafNode) {
+      void **pPointers = NODE_POINTERS(pTree, pNode);
+      i = NODE_LOWER_BOUND(pNode, key);
+      if (i >= pNode->lNumKeys || pNode->keys[i] != key) {
+         return CFL_FALSE;
+      }
+      *ppValue = pPointers[i];
+      memmove(&pNode->keys[i], &pNode->keys[i + 1], sizeof(CFL_INT64) * (pNode->lNumKeys - i - 1));
+      memmove(&pPointers[i], &pPointers[i + 1], sizeof(void *) * (pNode->lNumKeys - i - 1));
+      --(pNode->lNumKeys);
+      return CFL_TRUE;
+   } else {
+      CFL_BTREE64_NODEP pChild = cfl_btree64_childFor(pTree, pNode, key, &i);
+      if (!cfl_btree64_deleteFromNode(pTree, pChild, key, ppValue)) {
+         return CFL_FALSE;
+      }
+      if (pChild->lNumKeys < MIN_KEYS(pTree)) {
+         cfl_btree64_rebalanceChild(pTree, pNode, i);
+      }
+      return CFL_TRUE;
+   }
+}
+
+void *cfl_btree64_delete(CFL_BTREE64P pTree, CFL_INT64 key) {
+   void *pValue = NULL;
+   if (cfl_btree64_deleteFromNode(pTree, pTree->pRoot, key, &pValue)) {
+      CFL_BTREE64_NODEP pRoot = pTree->pRoot;
+      if (!pRoot->bIsLeafNode && pRoot->lNumKeys == 0) {
+         pTree->pRoot = NODE_CHILD(pTree, pRoot, 0);
+         cfl_btree64_node_free(pRoot);
+      }
+      --(pTree->lCount);
+   }
+   return pValue;
+}
+
+void *cfl_btree64_search(CFL_BTREE64P pTree, CFL_INT64 key) {
+   CFL_BTREE64_NODEP pLeaf = cfl_btree64_findLeaf(pTree, key);
+   CFL_INT32 i = NODE_LOWER_BOUND(pLeaf, key);
+   if (i < pLeaf->lNumKeys && pLeaf->keys[i] == key) {
+      return NODE_VALUE(pTree, pLeaf, i);
+   }
+   return NULL;
+}
+
+CFL_BOOL cfl_btree64_contains(CFL_BTREE64P pTree, CFL_INT64 key) {
+   CFL_BTREE64_NODEP pLeaf = cfl_btree64_findLeaf(pTree, key);
+   CFL_INT32 i = NODE_LOWER_BOUND(pLeaf, key);
+   return i < pLeaf->lNumKeys && pLeaf->keys[i] == key;
+}
+
+CFL_INT32 cfl_btree64_count(CFL_BTREE64P pTree) {
+   return pTree->lCount;
+}
+
+static BTree64Iterator *cfl_btree64_iteratorCreate(CFL_BTREE64P pTree) {
+   BTree64Iterator *pIt = (BTree64Iterator *) CFL_MEM_ALLOC(sizeof(BTree64Iterator));
+   if (pIt == NULL) {
+      return NULL;
+   }
+   pIt->iterator.itClass = &cfl_btree64_iterator_class;
+   pIt->pTree = pTree;
+   pIt->pLeaf = pTree->pFirstLeaf;
+   pIt->lKey = 0;
+   pIt->key = 0;
+   pIt->pValue = NULL;
+   pIt->lowKey = 0;
+   pIt->highKey = 0;
+   pIt->bRange = CFL_FALSE;
+   return pIt;
+}
+
+CFL_ITERATORP cfl_btree64_iterator(CFL_BTREE64P pTree) {
+   BTree64Iterator *pIt = cfl_btree64_iteratorCreate(pTree);
+   return pIt != NULL ? &pIt->iterator : NULL;
+}
+
+CFL_ITERATORP cfl_btree64_iteratorRange(CFL_BTREE64P pTree, CFL_INT64 fromKey, CFL_INT64 toKey) {
+   BTree64Iterator *pIt = cfl_btree64_iteratorCreate(pTree);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   pIt->lowKey = fromKey;
+   pIt->highKey = toKey;
+   pIt->bRange = CFL_TRUE;
+   cfl_btree64_iterator_first(&pIt->iterator);
+   return &pIt->iterator;
+}
+
+CFL_INT64 cfl_btree64_iteratorKey(CFL_ITERATORP it) {
+   return ((BTree64Iterator *) it)->key;
+}
+
+// The iterator is a cursor between two keys: pLeaf/lKey is the position of the key returned by the next call to next().
+// Values may be NULL, so the peek functions report the availability of a key separately.
+
+static CFL_BOOL cfl_btree64_iterator_peekNext(BTree64Iterator *pIt) {
+   while (pIt->lKey >= pIt->pLeaf->lNumKeys) {
+      if (pIt->pLeaf->pNextLeaf == NULL) {
+         return CFL_FALSE;
+      }
+      pIt->pLeaf = pIt->pLeaf->pNextLeaf;
+      pIt->lKey = 0;
+      if (pIt->pLeaf->pNextLeaf != NULL) {
+         CFL_PREFETCH(pIt->pLeaf->pNextLeaf);
+      }
+   }
+   return !pIt->bRange || pIt->pLeaf->keys[pIt->lKey] <= pIt->highKey;
+}
+
+static CFL_BOOL cfl_btree64_iterator_peekPrevious(BTree64Iterator *pIt) {
+   while (pIt->lKey <= 0) {
+      if (pIt->pLeaf->pPrevLeaf == NULL) {
+         return CFL_FALSE;
+      }
+      pIt->pLeaf = pIt->pLeaf->pPrevLeaf;
+      pIt->lKey = pIt->pLeaf->lNumKeys;
+   }
+   return !pIt->bRange || pIt->pLeaf->keys[pIt->lKey - 1] >= pIt->lowKey;
+}
+
+static CFL_BOOL cfl_btree64_iterator_hasNext(CFL_ITERATORP iterator) {
+   return cfl_btree64_iterator_peekNext((BTree64Iterator *) iterator);
+}
+
+static void *cfl_btree64_iterator_next(CFL_ITERATORP iterator) {
+   BTree64Iterator *pIt = (BTree64Iterator *) iterator;
+   if (!cfl_btree64_iterator_peekNext(pIt)) {
+      return NULL;
+   }
+   pIt->key = pIt->pLeaf->keys[pIt->lKey];
+   pIt->pValue = NODE_VALUE(pIt->pTree, pIt->pLeaf, pIt->lKey);
+   ++(pIt->lKey);
+   return pIt->pValue;
+}
+
+static CFL_BOOL cfl_btree64_iterator_hasPrevious(CFL_ITERATORP iterator) {
+   return cfl_btree64_iterator_peekPrevious((BTree64Iterator *) iterator);
+}
+
+static void *cfl_btree64_iterator_previous(CFL_ITERATORP iterator) {
+   BTree64Iterator *pIt = (BTree64Iterator *) iterator;
+   if (!cfl_btree64_iterator_peekPrevious(pIt)) {
+      return NULL;
+   }
+   --(pIt->lKey);
+   pIt->key = pIt->pLeaf->keys[pIt->lKey];
+   pIt->pValue = NODE_VALUE(pIt->pTree, pIt->pLeaf, pIt->lKey);
+   return pIt->pValue;
+}
+
+static void *cfl_btree64_iterator_value(CFL_ITERATORP iterator) {
+   return ((BTree64Iterator *) iterator)->pValue;
+}
+
+// Position of the first key not less than (bUpper == FALSE) or greater than (bUpper == TRUE) key.
+
+static void cfl_btree64_iterator_seek(BTree64Iterator *pIt, CFL_INT64 key, CFL_BOOL bUpper) {
+   CFL_BTREE64_NODEP pLeaf = cfl_btree64_findLeaf(pIt->pTree, key);
+   pIt->pLeaf = pLeaf;
+   pIt->lKey = cfl_btree64_countLess(pLeaf->keys, pLeaf->lNumKeys, key, bUpper);
+}
+
+static void cfl_btree64_iterator_first(CFL_ITERATORP iterator) {
+   BTree64Iterator *pIt = (BTree64Iterator *) iterator;
+   if (pIt->bRange) {
+      cfl_btree64_iterator_seek(pIt, pIt->lowKey, CFL_FALSE);
+   } else {
+      pIt->pLeaf = pIt->pTree->pFirstLeaf;
+      pIt->lKey = 0;
+   }
+   pIt->key = 0;
+   pIt->pValue = NULL;
+}
+
+static void cfl_btree64_iterator_last(CFL_ITERATORP iterator) {
+   BTree64Iterator *pIt = (BTree64Iterator *) iterator;
+   if (pIt->bRange) {
+      cfl_btree64_iterator_seek(pIt, pIt->highKey, CFL_TRUE);
+   } else {
+      pIt->pLeaf = pIt->pTree->pLastLeaf;
+      pIt->lKey = pIt->pLeaf->lNumKeys;
+   }
+   pIt->key = 0;
+   pIt->pValue = NULL;
+}
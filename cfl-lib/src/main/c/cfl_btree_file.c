@@ -0,0 +1,738 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfl_btree_file.h"
+#include "cfl_iterator.h"
+#include "cfl_mem.h"
+#include "cfl_os.h"
+
+#if defined(CFL_OS_WINDOWS)
+   #include <windows.h>
+#else
+   #include <fcntl.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+   #include <unistd.h>
+#endif
+
+/*
+ * File layout: page 0 holds the FILE_HEADER and the following pages are tree nodes. A node page starts with a
+ * PAGE_HEADER followed by an array of 32-bit slots. The key bytes are stored at the end of the page, growing
+ * backwards, each one aligned to 8 bytes.
+ *  - Leaf:     slot[i] is the page offset of the key i. Leaves are linked by prevLeaf/nextLeaf.
+ *  - Internal: slot[0] is the page of the child 0, slot[1 + 2i] the offset of the separator key i and slot[2 + 2i] the
+ *              page of the child i + 1. A separator is the smallest key of its right subtree.
+ * Page number 0 is used as "no page" in the leaf links.
+ */
+
+#define FILE_MAGIC        "CFLBTRF1"
+#define FILE_BYTE_ORDER   0x01020304
+#define MIN_PAGE_SIZE     256
+
+#define ALIGN_KEY(s)      (((s) + 7) & ~((CFL_UINT32) 7))
+
+typedef struct _FILE_HEADER {
+   char       magic[8];
+   CFL_UINT32 byteOrder;
+   CFL_UINT32 pageSize;
+   CFL_UINT32 pageCount;
+   CFL_UINT32 rootPage;
+   CFL_UINT32 firstLeafPage;
+   CFL_UINT32 lastLeafPage;
+   CFL_UINT32 keyCount;
+   CFL_UINT32 reserved;
+} FILE_HEADER;
+
+typedef struct _PAGE_HEADER {
+   CFL_UINT32 numKeys;
+   CFL_UINT32 isLeaf;
+   CFL_UINT32 prevLeaf;
+   CFL_UINT32 nextLeaf;
+} PAGE_HEADER;
+
+#define PAGE_AT(f, n)          ((CFL_UINT8 *) (f)->pData + ((size_t) (n) * (f)->pageSize))
+#define PAGE_HDR(p)            ((PAGE_HEADER *) (p))
+#define PAGE_SLOTS(p)          ((CFL_UINT32 *) ((CFL_UINT8 *) (p) + sizeof(PAGE_HEADER)))
+#define LEAF_KEY(p, i)         ((void *) ((CFL_UINT8 *) (p) + PAGE_SLOTS(p)[i]))
+#define INTERNAL_KEY(p, i)     ((void *) ((CFL_UINT8 *) (p) + PAGE_SLOTS(p)[1 + (2 * (i))]))
+#define INTERNAL_CHILD(p, i)   (PAGE_SLOTS(p)[2 * (i)])
+
+struct _CFL_BTREE_FILE {
+   CFL_UINT8           *pData;
+   size_t               size;
+   CFL_UINT32           pageSize;
+   CFL_UINT32           pageCount;
+   CFL_UINT32           rootPage;
+   CFL_UINT32           firstLeafPage;
+   CFL_UINT32           lastLeafPage;
+   CFL_UINT32           keyCount;
+   BTREE_CMP_VALUE_FUNC pCompareValues;
+};
+
+typedef struct _BTreeFileIterator {
+   CFL_ITERATOR    iterator;
+   CFL_BTREE_FILEP pFile;
+   CFL_UINT32      leafPage;
+   CFL_INT32       lKey;
+   void           *pValue;
+   void           *pLowKey;
+   void           *pHighKey;
+   CFL_BOOL        bExact;
+} BTreeFileIterator;
+
+/* First key and page of each node of the level being written, used to build the level above */
+typedef struct _LEVEL_ENTRY {
+   void      *pFirstKey;
+   CFL_UINT32 firstKeySize;
+   CFL_UINT32 page;
+} LEVEL_ENTRY;
+
+typedef struct _PAGE_WRITER {
+   FILE        *pStream;
+   CFL_UINT8   *pPage;
+   CFL_UINT32   pageSize;
+   CFL_UINT32   nextPage;
+   CFL_UINT32   slotsEnd;
+   CFL_UINT32   keysStart;
+   LEVEL_ENTRY *pEntries;
+   CFL_UINT32   lEntries;
+   CFL_UINT32   lCapacity;
+} PAGE_WRITER;
+
+static CFL_BOOL cfl_btree_file_iterator_hasNext(CFL_ITERATORP pIt);
+static void *cfl_btree_file_iterator_next(CFL_ITERATORP pIt);
+static void *cfl_btree_file_iterator_value(CFL_ITERATORP pIt);
+static void cfl_btree_file_iterator_first(CFL_ITERATORP pIt);
+static void cfl_btree_file_iterator_last(CFL_ITERATORP pIt);
+static CFL_BOOL cfl_btree_file_iterator_hasPrevious(CFL_ITERATORP pIt);
+static void *cfl_btree_file_iterator_previous(CFL_ITERATORP pIt);
+
+static CFL_ITERATOR_CLASS cfl_btree_file_iterator_class = {
+   cfl_btree_file_iterator_hasNext,
+   cfl_btree_file_iterator_next,
+   cfl_btree_file_iterator_value,
+   NULL,
+   NULL,
+   cfl_btree_file_iterator_first,
+   cfl_btree_file_iterator_hasPrevious,
+   cfl_btree_file_iterator_previous,
+   cfl_btree_file_iterator_last,
+   NULL,
+   NULL,
+   NULL,
+};
+
+static void cfl_btree_file_resetPage(PAGE_WRITER *pWriter, CFL_BOOL bLeaf) {
+   memset(pWriter->pPage, 0, pWriter->pageSize);
+   PAGE_HDR(pWriter->pPage)->isLeaf = bLeaf ? 1 : 0;
+   pWriter->slotsEnd = sizeof(PAGE_HEADER);
+   pWriter->keysStart = pWriter->pageSize;
+}
+
+static CFL_BOOL cfl_btree_file_addEntry(PAGE_WRITER *pWriter, void *pFirstKey, CFL_UINT32 firstKeySize, CFL_UINT32 page) {
+   if (pWriter->lEntries >= pWriter->lCapacity) {
+      CFL_UINT32 lNewCapacity = pWriter->lCapacity == 0 ? 64 : pWriter->lCapacity * 2;
+      LEVEL_ENTRY *pEntries = (LEVEL_ENTRY *) CFL_MEM_REALLOC(pWriter->pEntries, sizeof(LEVEL_ENTRY) * lNewCapacity);
+      if (pEntries == NULL) {
+         return CFL_FALSE;
+      }
+      pWriter->pEntries = pEntries;
+      pWriter->lCapacity = lNewCapacity;
+   }
+   pWriter->pEntries[pWriter->lEntries].pFirstKey = pFirstKey;
+   pWriter->pEntries[pWriter->lEntries].firstKeySize = firstKeySize;
+   pWriter->pEntries[pWriter->lEntries].page = page;
+   ++(pWriter->lEntries);
+   return CFL_TRUE;
+}
+
+// Copy the key bytes to the end of the free area of the page and return their offset, or 0 if the key and
+// lSlots new slots do not fit.
+
+static CFL_UINT32 cfl_btree_file_putKey(PAGE_WRITER *pWriter, void *pKey, CFL_UINT32 keySize, CFL_UINT32 lSlots) {
+   CFL_UINT32 alignedSize = ALIGN_KEY(keySize);
+   if (alignedSize < keySize || pWriter->slotsEnd + (lSlots * sizeof(CFL_UINT32)) + alignedSize > pWriter->keysStart) {
+      return 0;
+   }
+   pWriter->keysStart -= alignedSize;
+   memcpy(pWriter->pPage + pWriter->keysStart, pKey, keySize);
+   return pWriter->keysStart;
+}
+
+static void cfl_btree_file_putSlot(PAGE_WRITER *pWriter, CFL_UINT32 value) {
+   *(CFL_UINT32 *) (pWriter->pPage + pWriter->slotsEnd) = value;
+   pWriter->slotsEnd += sizeof(CFL_UINT32);
+}
+
+static CFL_BOOL cfl_btree_file_flushPage(PAGE_WRITER *pWriter) {
+   if (fwrite(pWriter->pPage, pWriter->pageSize, 1, pWriter->pStream) != 1) {
+      return CFL_FALSE;
+   }
+   ++(pWriter->nextPage);
+   return CFL_TRUE;
+}
+
+// Leaves are written in key order to consecutive pages, so the next leaf of a page is always the following page.
+
+static CFL_BOOL cfl_btree_file_writeLeaves(PAGE_WRITER *pWriter, CFL_BTREEP pTree, BTREE_KEY_SIZE_FUNC pKeySize,
+                                           CFL_UINT32 *pKeyCount) {
+   CFL_ITERATORP it = cfl_btree_iterator(pTree);
+   CFL_BOOL bSuccess = CFL_TRUE;
+   PAGE_HEADER *pHeader = PAGE_HDR(pWriter->pPage);
+
+   if (it == NULL) {
+      return CFL_FALSE;
+   }
+   *pKeyCount = 0;
+   cfl_btree_file_resetPage(pWriter, CFL_TRUE);
+   while (bSuccess && cfl_iterator_hasNext(it)) {
+      void *pKey = cfl_iterator_next(it);
+      CFL_UINT32 keySize = pKeySize(pKey);
+      CFL_UINT32 offset = cfl_btree_file_putKey(pWriter, pKey, keySize, 1);
+      if (offset == 0) {
+         if (pHeader->numKeys == 0) {
+            // the key does not fit in an empty page
+            bSuccess = CFL_FALSE;
+            break;
+         }
+         pHeader->nextLeaf = pWriter->nextPage + 1;
+         if (!cfl_btree_file_flushPage(pWriter)) {
+            bSuccess = CFL_FALSE;
+            break;
+         }
+         cfl_btree_file_resetPage(pWriter, CFL_TRUE);
+         pHeader->prevLeaf = pWriter->nextPage - 1;
+         offset = cfl_btree_file_putKey(pWriter, pKey, keySize, 1);
+         if (offset == 0) {
+            bSuccess = CFL_FALSE;
+            break;
+         }
+      }
+      if (pHeader->numKeys == 0 && !cfl_btree_file_addEntry(pWriter, pKey, keySize, pWriter->nextPage)) {
+         bSuccess = CFL_FALSE;
+         break;
+      }
+      cfl_btree_file_putSlot(pWriter, offset);
+      ++(pHeader->numKeys);
+      ++(*pKeyCount);
+   }
+   cfl_iterator_free(it);
+   if (bSuccess && pWriter->lEntries == 0) {
+      // empty tree: a single empty leaf
+      bSuccess = cfl_btree_file_addEntry(pWriter, NULL, 0, pWriter->nextPage);
+   }
+   return bSuccess && cfl_btree_file_flushPage(pWriter);
+}
+
+// Write the internal nodes over the entries of the level below and replace them by the entries of the new level.
+
+static CFL_BOOL cfl_btree_file_writeLevel(PAGE_WRITER *pWriter) {
+   LEVEL_ENTRY *pChildren = pWriter->pEntries;
+   CFL_UINT32 lChildren = pWriter->lEntries;
+   PAGE_HEADER *pHeader = PAGE_HDR(pWriter->pPage);
+   CFL_BOOL bSuccess = CFL_TRUE;
+   CFL_UINT32 i;
+
+   pWriter->pEntries = NULL;
+   pWriter->lEntries = 0;
+   pWriter->lCapacity = 0;
+   for (i = 0; bSuccess && i < lChildren; i++) {
+      LEVEL_ENTRY *pChild = &pChildren[i];
+      if (i > 0) {
+         CFL_UINT32 offset = cfl_btree_file_putKey(pWriter, pChild->pFirstKey, pChild->firstKeySize, 2);
+         if (offset != 0) {
+            cfl_btree_file_putSlot(pWriter, offset);
+            cfl_btree_file_putSlot(pWriter, pChild->page);
+            ++(pHeader->numKeys);
+            continue;
+         }
+         if (pHeader->numKeys == 0) {
+            // not even one separator fits in the page
+            bSuccess = CFL_FALSE;
+            break;
+         }
+         if (!cfl_btree_file_flushPage(pWriter)) {
+            bSuccess = CFL_FALSE;
+            break;
+         }
+      }
+      cfl_btree_file_resetPage(pWriter, CFL_FALSE);
+      cfl_btree_file_putSlot(pWriter, pChild->page);
+      bSuccess = cfl_btree_file_addEntry(pWriter, pChild->pFirstKey, pChild->firstKeySize, pWriter->nextPage);
+   }
+   CFL_MEM_FREE(pChildren);
+   return bSuccess && cfl_btree_file_flushPage(pWriter);
+}
+
+CFL_BOOL cfl_btree_file_write(CFL_BTREEP pTree, const char *filePath, CFL_UINT32 pageSize, BTREE_KEY_SIZE_FUNC pKeySize) {
+   PAGE_WRITER writer;
+   FILE_HEADER header;
+   CFL_UINT32 keyCount = 0;
+   CFL_UINT32 lastLeafPage;
+   CFL_BOOL bSuccess;
+
+   if (pageSize == 0) {
+      pageSize = CFL_BTREE_FILE_DEFAULT_PAGE_SIZE;
+   }
+   if (pageSize < MIN_PAGE_SIZE || (pageSize % 8) != 0 || pKeySize == NULL) {
+      return CFL_FALSE;
+   }
+   memset(&writer, 0, sizeof(writer));
+   writer.pageSize = pageSize;
+   writer.nextPage = 0;
+   writer.pPage = (CFL_UINT8 *) CFL_MEM_ALLOC(pageSize);
+   if (writer.pPage == NULL) {
+      return CFL_FALSE;
+   }
+   writer.pStream = fopen(filePath, "wb");
+   if (writer.pStream == NULL) {
+      CFL_MEM_FREE(writer.pPage);
+      return CFL_FALSE;
+   }
+
+   // the header page is rewritten at the end, when the root is known
+   memset(writer.pPage, 0, pageSize);
+   bSuccess = cfl_btree_file_flushPage(&writer) && cfl_btree_file_writeLeaves(&writer, pTree, pKeySize, &keyCount);
+   lastLeafPage = writer.nextPage - 1;
+   while (bSuccess && writer.lEntries > 1) {
+      bSuccess = cfl_btree_file_writeLevel(&writer);
+   }
+
+   if (bSuccess) {
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, FILE_MAGIC, sizeof(header.magic));
+      header.byteOrder = FILE_BYTE_ORDER;
+      header.pageSize = pageSize;
+      header.pageCount = writer.nextPage;
+      header.rootPage = writer.pEntries[0].page;
+      header.firstLeafPage = 1;
+      header.lastLeafPage = lastLeafPage;
+      header.keyCount = keyCount;
+      memset(writer.pPage, 0, pageSize);
+      memcpy(writer.pPage, &header, sizeof(header));
+      bSuccess = fseek(writer.pStream, 0, SEEK_SET) == 0 && fwrite(writer.pPage, pageSize, 1, writer.pStream) == 1;
+   }
+   if (fclose(writer.pStream) != 0) {
+      bSuccess = CFL_FALSE;
+   }
+   if (!bSuccess) {
+      remove(filePath);
+   }
+   if (writer.pEntries != NULL) {
+      CFL_MEM_FREE(writer.pEntries);
+   }
+   CFL_MEM_FREE(writer.pPage);
+   return bSuccess;
+}
+
+static CFL_UINT8 *cfl_btree_file_map(const char *filePath, size_t *pSize) {
+#if defined(CFL_OS_WINDOWS)
+   HANDLE hFile;
+   HANDLE hMapping;
+   LARGE_INTEGER fileSize;
+   CFL_UINT8 *pData = NULL;
+
+   hFile = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (hFile == INVALID_HANDLE_VALUE) {
+      return NULL;
+   }
+   if (GetFileSizeEx(hFile, &fileSize) && fileSize.QuadPart > 0 && (CFL_UINT64) fileSize.QuadPart <= (size_t) -1) {
+      hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (hMapping != NULL) {
+         // the view keeps the mapping alive after the handles are closed
+         pData = (CFL_UINT8 *) MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+         CloseHandle(hMapping);
+      }
+      *pSize = (size_t) fileSize.QuadPart;
+   }
+   CloseHandle(hFile);
+   return pData;
+#else
+   struct stat fileStat;
+   void *pData = MAP_FAILED;
+   int fd = open(filePath, O_RDONLY);
+
+   if (fd < 0) {
+      return NULL;
+   }
+   if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+      pData = mmap(NULL, (size_t) fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      *pSize = (size_t) fileStat.st_size;
+   }
+   close(fd);
+   return pData != MAP_FAILED ? (CFL_UINT8 *) pData : NULL;
+#endif
+}
+
+static void cfl_btree_file_unmap(CFL_UINT8 *pData, size_t size) {
+#if defined(CFL_OS_WINDOWS)
+   (void) size;
+   UnmapViewOfFile(pData);
+#else
+   munmap(pData, size);
+#endif
+}
+
+static CFL_BOOL cfl_btree_file_isLeafPage(CFL_UINT8 *pData, const FILE_HEADER *pHeader, CFL_UINT32 page) {
+   return PAGE_HDR(pData + ((size_t) page * pHeader->pageSize))->isLeaf == 1;
+}
+
+// Check that the slots of a node page stay inside the page and its references inside the file, so that a truncated or
+// corrupt file cannot make a search read outside the mapping. As they are written, children have lower page numbers
+// than their parent and leaves are linked in increasing page order, which also guarantees that every traversal ends.
+
+static CFL_BOOL cfl_btree_file_checkPage(CFL_UINT8 *pData, const FILE_HEADER *pHeader, CFL_UINT32 page) {
+   CFL_UINT8 *pPage = pData + ((size_t) page * pHeader->pageSize);
+   PAGE_HEADER *pPageHeader = PAGE_HDR(pPage);
+   CFL_UINT32 lMaxSlots = (pHeader->pageSize - (CFL_UINT32) sizeof(PAGE_HEADER)) / (CFL_UINT32) sizeof(CFL_UINT32);
+   CFL_UINT32 lSlots;
+   CFL_UINT32 keysStart;
+   CFL_UINT32 i;
+
+   if (pPageHeader->isLeaf == 1) {
+      if (pPageHeader->numKeys > lMaxSlots
+          || (pPageHeader->prevLeaf != 0
+              && (pPageHeader->prevLeaf >= page || !cfl_btree_file_isLeafPage(pData, pHeader, pPageHeader->prevLeaf)))
+          || (pPageHeader->nextLeaf != 0
+              && (pPageHeader->nextLeaf <= page || pPageHeader->nextLeaf >= pHeader->pageCount
+                  || !cfl_btree_file_isLeafPage(pData, pHeader, pPageHeader->nextLeaf)))) {
+         return CFL_FALSE;
+      }
+      lSlots = pPageHeader->numKeys;
+   } else if (pPageHeader->isLeaf == 0) {
+      if (pPageHeader->numKeys > (lMaxSlots - 1) / 2) {
+         return CFL_FALSE;
+      }
+      lSlots = (2 * pPageHeader->numKeys) + 1;
+   } else {
+      return CFL_FALSE;
+   }
+   keysStart = (CFL_UINT32) sizeof(PAGE_HEADER) + (lSlots * (CFL_UINT32) sizeof(CFL_UINT32));
+   for (i = 0; i < lSlots; i++) {
+      CFL_UINT32 slot = PAGE_SLOTS(pPage)[i];
+      if (pPageHeader->isLeaf == 0 && (i % 2) == 0) {
+         if (slot == 0 || slot >= page) {
+            return CFL_FALSE;
+         }
+      } else if (slot < keysStart || slot >= pHeader->pageSize) {
+         return CFL_FALSE;
+      }
+   }
+   return CFL_TRUE;
+}
+
+static CFL_BOOL cfl_btree_file_checkPages(CFL_UINT8 *pData, const FILE_HEADER *pHeader) {
+   CFL_UINT32 page;
+
+   if (!cfl_btree_file_isLeafPage(pData, pHeader, pHeader->firstLeafPage)
+       || !cfl_btree_file_isLeafPage(pData, pHeader, pHeader->lastLeafPage)) {
+      return CFL_FALSE;
+   }
+   for (page = 1; page < pHeader->pageCount; page++) {
+      if (!cfl_btree_file_checkPage(pData, pHeader, page)) {
+         return CFL_FALSE;
+      }
+   }
+   return CFL_TRUE;
+}
+
+CFL_BTREE_FILEP cfl_btree_file_open(const char *filePath, BTREE_CMP_VALUE_FUNC pCompareValues) {
+   CFL_BTREE_FILEP pFile;
+   FILE_HEADER header;
+   size_t size = 0;
+   CFL_UINT8 *pData = cfl_btree_file_map(filePath, &size);
+
+   if (pData == NULL) {
+      return NULL;
+   }
+   if (size < sizeof(header)) {
+      cfl_btree_file_unmap(pData, size);
+      return NULL;
+   }
+   memcpy(&header, pData, sizeof(header));
+   if (memcmp(header.magic, FILE_MAGIC, sizeof(header.magic)) != 0 || header.byteOrder != FILE_BYTE_ORDER
+       || header.pageSize < MIN_PAGE_SIZE || (header.pageSize % 8) != 0 || header.pageCount < 2
+       || (CFL_UINT64) header.pageCount * header.pageSize > size || header.rootPage == 0 || header.rootPage >= header.pageCount
+       || header.firstLeafPage == 0 || header.lastLeafPage >= header.pageCount || header.firstLeafPage > header.lastLeafPage
+       || !cfl_btree_file_checkPages(pData, &header)) {
+      cfl_btree_file_unmap(pData, size);
+      return NULL;
+   }
+   pFile = (CFL_BTREE_FILEP) CFL_MEM_ALLOC(sizeof(CFL_BTREE_FILE));
+   if (pFile == NULL) {
+      cfl_btree_file_unmap(pData, size);
+      return NULL;
+   }
+   pFile->pData = pData;
+   pFile->size = size;
+   pFile->pageSize = header.pageSize;
+   pFile->pageCount = header.pageCount;
+   pFile->rootPage = header.rootPage;
+   pFile->firstLeafPage = header.firstLeafPage;
+   pFile->lastLeafPage = header.lastLeafPage;
+   pFile->keyCount = header.keyCount;
+   pFile->pCompareValues = pCompareValues;
+   return pFile;
+}
+
+void cfl_btree_file_close(CFL_BTREE_FILEP pFile) {
+   if (pFile == NULL) {
+      return;
+   }
+   cfl_btree_file_unmap(pFile->pData, pFile->size);
+   CFL_MEM_FREE(pFile);
+}
+
+CFL_INT32 cfl_btree_file_count(CFL_BTREE_FILEP pFile) {
+   return (CFL_INT32) pFile->keyCount;
+}
+
+static CFL_INT16 cfl_btree_file_compareValues(CFL_BTREE_FILEP pFile, void *pValue1, void *pValue2, CFL_BOOL bExact) {
+   CFL_INT16 iValue = -1;
+
+   if (pFile->pCompareValues != NULL) {
+      iValue = pFile->pCompareValues(pValue1, pValue2, bExact);
+   }
+   return iValue;
+}
+
+// Index of the first key of the page that is not less than (bUpper == FALSE) or greater than (bUpper == TRUE) pKey.
+
+static CFL_INT32 cfl_btree_file_bound(CFL_BTREE_FILEP pFile, CFL_UINT8 *pPage, void *pKey, CFL_BOOL bExact, CFL_BOOL bUpper) {
+   CFL_INT32 lFirst = 0;
+   CFL_INT32 lLast = (CFL_INT32) PAGE_HDR(pPage)->numKeys;
+   CFL_BOOL bLeaf = PAGE_HDR(pPage)->isLeaf != 0;
+   while (lFirst < lLast) {
+      CFL_INT32 lMiddle = lFirst + ((lLast - lFirst) / 2);
+      void *pMiddleKey = bLeaf ? LEAF_KEY(pPage, lMiddle) : INTERNAL_KEY(pPage, lMiddle);
+      CFL_INT16 iCmp = cfl_btree_file_compareValues(pFile, pKey, pMiddleKey, bExact);
+      if (iCmp > 0 || (bUpper && iCmp == 0)) {
+         lFirst = lMiddle + 1;
+      } else {
+         lLast = lMiddle;
+      }
+   }
+   return lFirst;
+}
+
+// Position (leaf and key index) of the first key not less than (bUpper == FALSE) or greater than (bUpper == TRUE) pKey.
+// The index may be equal to the number of keys of the leaf when the position is at the end of the tree.
+
+static CFL_UINT32 cfl_btree_file_seek(CFL_BTREE_FILEP pFile, void *pKey, CFL_BOOL bExact, CFL_BOOL bUpper, CFL_INT32 *plKey) {
+   CFL_UINT32 page = pFile->rootPage;
+   CFL_UINT8 *pPage = PAGE_AT(pFile, page);
+   CFL_INT32 i;
+
+   while (PAGE_HDR(pPage)->isLeaf == 0) {
+      // lower bound searches descend left of equal separators, where the first partial match may be
+      i = cfl_btree_file_bound(pFile, pPage, pKey, bExact, bUpper || bExact);
+      page = INTERNAL_CHILD(pPage, i);
+      if (page == 0 || page >= pFile->pageCount) {
+         *plKey = 0;
+         return pFile->lastLeafPage;
+      }
+      pPage = PAGE_AT(pFile, page);
+   }
+   i = cfl_btree_file_bound(pFile, pPage, pKey, bExact, bUpper);
+   if (i >= (CFL_INT32) PAGE_HDR(pPage)->numKeys && PAGE_HDR(pPage)->nextLeaf != 0) {
+      page = PAGE_HDR(pPage)->nextLeaf;
+      i = 0;
+   }
+   *plKey = i;
+   return page;
+}
+
+static void *cfl_btree_file_keyAt(CFL_BTREE_FILEP pFile, CFL_UINT32 page, CFL_INT32 lKey) {
+   CFL_UINT8 *pPage = PAGE_AT(pFile, page);
+   return lKey < (CFL_INT32) PAGE_HDR(pPage)->numKeys ? LEAF_KEY(pPage, lKey) : NULL;
+}
+
+void *cfl_btree_file_search(CFL_BTREE_FILEP pFile, void *pKey) {
+   CFL_INT32 i;
+   CFL_UINT32 page = cfl_btree_file_seek(pFile, pKey, CFL_TRUE, CFL_FALSE, &i);
+   void *pFound = cfl_btree_file_keyAt(pFile, page, i);
+   if (pFound != NULL && cfl_btree_file_compareValues(pFile, pKey, pFound, CFL_TRUE) == 0) {
+      return pFound;
+   }
+   return NULL;
+}
+
+void *cfl_btree_file_searchLike(CFL_BTREE_FILEP pFile, void *pKey) {
+   CFL_INT32 i;
+   CFL_UINT32 page = cfl_btree_file_seek(pFile, pKey, CFL_FALSE, CFL_FALSE, &i);
+   void *pFound = cfl_btree_file_keyAt(pFile, page, i);
+   if (pFound != NULL && cfl_btree_file_compareValues(pFile, pKey, pFound, CFL_FALSE) == 0) {
+      return pFound;
+   }
+   return NULL;
+}
+
+static BTreeFileIterator *cfl_btree_file_iteratorCreate(CFL_BTREE_FILEP pFile, void *pLowKey, void *pHighKey, CFL_BOOL bExact) {
+   BTreeFileIterator *pIt = (BTreeFileIterator *) CFL_MEM_ALLOC(sizeof(BTreeFileIterator));
+   if (pIt == NULL) {
+      return NULL;
+   }
+   pIt->iterator.itClass = &cfl_btree_file_iterator_class;
+   pIt->pFile = pFile;
+   pIt->leafPage = pFile->firstLeafPage;
+   pIt->lKey = 0;
+   pIt->pValue = NULL;
+   pIt->pLowKey = pLowKey;
+   pIt->pHighKey = pHighKey;
+   pIt->bExact = bExact;
+   return pIt;
+}
+
+CFL_ITERATORP cfl_btree_file_iterator(CFL_BTREE_FILEP pFile) {
+   BTreeFileIterator *pIt = cfl_btree_file_iteratorCreate(pFile, NULL, NULL, CFL_TRUE);
+   return pIt != NULL ? &pIt->iterator : NULL;
+}
+
+CFL_ITERATORP cfl_btree_file_iteratorLast(CFL_BTREE_FILEP pFile) {
+   BTreeFileIterator *pIt = cfl_btree_file_iteratorCreate(pFile, NULL, NULL, CFL_TRUE);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   cfl_btree_file_iterator_last(&pIt->iterator);
+   return &pIt->iterator;
+}
+
+CFL_ITERATORP cfl_btree_file_iteratorSearch(CFL_BTREE_FILEP pFile, void *pKey) {
+   BTreeFileIterator *pIt;
+   CFL_INT32 i;
+   CFL_UINT32 page = cfl_btree_file_seek(pFile, pKey, CFL_TRUE, CFL_FALSE, &i);
+   void *pFound = cfl_btree_file_keyAt(pFile, page, i);
+   if (pFound == NULL || cfl_btree_file_compareValues(pFile, pKey, pFound, CFL_TRUE) != 0) {
+      return NULL;
+   }
+   pIt = cfl_btree_file_iteratorCreate(pFile, NULL, NULL, CFL_TRUE);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   pIt->leafPage = page;
+   pIt->lKey = i;
+   return &pIt->iterator;
+}
+
+CFL_ITERATORP cfl_btree_file_iteratorSearchLike(CFL_BTREE_FILEP pFile, void *pKey) {
+   BTreeFileIterator *pIt;
+   if (cfl_btree_file_searchLike(pFile, pKey) == NULL) {
+      return NULL;
+   }
+   pIt = cfl_btree_file_iteratorCreate(pFile, pKey, pKey, CFL_FALSE);
+   if (pIt == NULL) {
+      return NULL;
+   }
+   cfl_btree_file_iterator_first(&pIt->iterator);
+   return &pIt->iterator;
+}
+
+// The iterator is a cursor between two keys: leafPage/lKey is the position of the key returned by the next call to next().
+
+static void *cfl_btree_file_iterator_peekNext(BTreeFileIterator *pIt) {
+   CFL_UINT8 *pPage = PAGE_AT(pIt->pFile, pIt->leafPage);
+   while (pIt->lKey >= (CFL_INT32) PAGE_HDR(pPage)->numKeys) {
+      if (PAGE_HDR(pPage)->nextLeaf == 0) {
+         return NULL;
+      }
+      pIt->leafPage = PAGE_HDR(pPage)->nextLeaf;
+      pIt->lKey = 0;
+      pPage = PAGE_AT(pIt->pFile, pIt->leafPage);
+   }
+   if (pIt->pHighKey != NULL
+       && cfl_btree_file_compareValues(pIt->pFile, pIt->pHighKey, LEAF_KEY(pPage, pIt->lKey), pIt->bExact) < 0) {
+      return NULL;
+   }
+   return LEAF_KEY(pPage, pIt->lKey);
+}
+
+static void *cfl_btree_file_iterator_peekPrevious(BTreeFileIterator *pIt) {
+   CFL_UINT8 *pPage = PAGE_AT(pIt->pFile, pIt->leafPage);
+   while (pIt->lKey <= 0) {
+      if (PAGE_HDR(pPage)->prevLeaf == 0) {
+         return NULL;
+      }
+      pIt->leafPage = PAGE_HDR(pPage)->prevLeaf;
+      pPage = PAGE_AT(pIt->pFile, pIt->leafPage);
+      pIt->lKey = (CFL_INT32) PAGE_HDR(pPage)->numKeys;
+   }
+   if (pIt->pLowKey != NULL
+       && cfl_btree_file_compareValues(pIt->pFile, pIt->pLowKey, LEAF_KEY(pPage, pIt->lKey - 1), pIt->bExact) > 0) {
+      return NULL;
+   }
+   return LEAF_KEY(pPage, pIt->lKey - 1);
+}
+
+static CFL_BOOL cfl_btree_file_iterator_hasNext(CFL_ITERATORP iterator) {
+   return cfl_btree_file_iterator_peekNext((BTreeFileIterator *) iterator) != NULL;
+}
+
+static void *cfl_btree_file_iterator_next(CFL_ITERATORP iterator) {
+   BTreeFileIterator *pIt = (BTreeFileIterator *) iterator;
+   void *pKey = cfl_btree_file_iterator_peekNext(pIt);
+   if (pKey != NULL) {
+      ++(pIt->lKey);
+      pIt->pValue = pKey;
+   }
+   return pKey;
+}
+
+static CFL_BOOL cfl_btree_file_iterator_hasPrevious(CFL_ITERATORP iterator) {
+   return cfl_btree_file_iterator_peekPrevious((BTreeFileIterator *) iterator) != NULL;
+}
+
+static void *cfl_btree_file_iterator_previous(CFL_ITERATORP iterator) {
+   BTreeFileIterator *pIt = (BTreeFileIterator *) iterator;
+   void *pKey = cfl_btree_file_iterator_peekPrevious(pIt);
+   if (pKey != NULL) {
+      --(pIt->lKey);
+      pIt->pValue = pKey;
+   }
+   return pKey;
+}
+
+static void *cfl_btree_file_iterator_value(CFL_ITERATORP iterator) {
+   return ((BTreeFileIterator *) iterator)->pValue;
+}
+
+static void cfl_btree_file_iterator_first(CFL_ITERATORP iterator) {
+   BTreeFileIterator *pIt = (BTreeFileIterator *) iterator;
+   if (pIt->pLowKey != NULL) {
+      pIt->leafPage = cfl_btree_file_seek(pIt->pFile, pIt->pLowKey, pIt->bExact, CFL_FALSE, &pIt->lKey);
+   } else {
+      pIt->leafPage = pIt->pFile->firstLeafPage;
+      pIt->lKey = 0;
+   }
+   pIt->pValue = NULL;
+}
+
+static void cfl_btree_file_iterator_last(CFL_ITERATORP iterator) {
+   BTreeFileIterator *pIt = (BTreeFileIterator *) iterator;
+   if (pIt->pHighKey != NULL) {
+      pIt->leafPage = cfl_btree_file_seek(pIt->pFile, pIt->pHighKey, pIt->bExact, CFL_TRUE, &pIt->lKey);
+   } else {
+      pIt->leafPage = pIt->pFile->lastLeafPage;
+      pIt->lKey = (CFL_INT32) PAGE_HDR(PAGE_AT(pIt->pFile, pIt->leafPage))->numKeys;
+   }
+   pIt->pValue = NULL;
+}
@@ -27,11 +27,27 @@
 #include "cfl_str.h"
 #include "cfl_types.h"
 
+#if defined(__SSE2__) || (defined(_MSC_VER) && defined(_M_X64))
+#include <emmintrin.h>
+#define SWAP_SSE2
+#endif
+
 #define BUFFER_INI_SIZE 8192
 
+#define VARINT32_MAX_BYTES 5
+#define VARINT64_MAX_BYTES 10
+
+// Zigzag maps signed to unsigned values so that small magnitudes stay small: 0, -1, 1, -2... become 0, 1, 2, 3...
+#define ZIGZAG_ENCODE32(v) (((CFL_UINT32)(v) << 1) ^ (CFL_UINT32)((v) < 0 ? -1 : 0))
+#define ZIGZAG_DECODE32(v) ((CFL_INT32)(((v) >> 1) ^ (CFL_UINT32)(-(CFL_INT32)((v) & 1))))
+#define ZIGZAG_ENCODE64(v) (((CFL_UINT64)(v) << 1) ^ (CFL_UINT64)((v) < 0 ? -1 : 0))
+#define ZIGZAG_DECODE64(v) ((CFL_INT64)(((v) >> 1) ^ (CFL_UINT64)(-(CFL_INT64)((v) & 1))))
+
+// Values are copied with memcpy because the data is not aligned for their type
 #define PUT_BUFFER(t, b, v)                                                                                                        \
    if (ensureCapacity(b, b->length + sizeof(t))) {                                                                                 \
-      *((t *)&b->data[b->position]) = v;                                                                                           \
+      t value_ = v;                                                                                                                \
+      memcpy(&b->data[b->position], &value_, sizeof(t));                                                                           \
       b->position += sizeof(t);                                                                                                    \
       if (b->position > b->length) {                                                                                               \
          b->length = b->position;                                                                                                  \
@@ -41,7 +57,7 @@
 
 #define GET_BUFFER(v, t, b, d)                                                                                                     \
    if (b->position + sizeof(t) <= b->length) {                                                                                     \
-      v = *((t *)&b->data[b->position]);                                                                                           \
+      memcpy(&v, &b->data[b->position], sizeof(t));                                                                                \
       b->position += sizeof(t);                                                                                                    \
    } else {                                                                                                                        \
       b->position = b->length;                                                                                                     \
@@ -49,14 +65,57 @@
    }
 
 #define RETURN_BUFFER(t, b, d)                                                                                                     \
+   t value_;                                                                                                                       \
    if (b->position + sizeof(t) > b->length) {                                                                                      \
       b->position = b->length;                                                                                                     \
       return d;                                                                                                                    \
    }                                                                                                                               \
+   memcpy(&value_, &b->data[b->position], sizeof(t));                                                                              \
    b->position += sizeof(t);                                                                                                       \
-   return *((t *)&b->data[b->position - sizeof(t)])
+   return value_
 
-#define PEEK_RETURN_BUFFER(t, b, d) return b->position + sizeof(t) <= b->length ? *((t *)&b->data[b->position]) : d
+#define PEEK_RETURN_BUFFER(t, b, d)                                                                                                \
+   t value_;                                                                                                                       \
+   if (b->position + sizeof(t) > b->length) {                                                                                      \
+      return d;                                                                                                                    \
+   }                                                                                                                               \
+   memcpy(&value_, &b->data[b->position], sizeof(t));                                                                              \
+   return value_
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SWAP16(v) __builtin_bswap16(v)
+#define SWAP32(v) __builtin_bswap32(v)
+#define SWAP64(v) __builtin_bswap64(v)
+#elif defined(_MSC_VER)
+#define SWAP16(v) _byteswap_ushort(v)
+#define SWAP32(v) _byteswap_ulong(v)
+#define SWAP64(v) _byteswap_uint64(v)
+#else
+#define SWAP16(v) ((CFL_UINT16)(((v) >> 8) | ((v) << 8)))
+#define SWAP32(v) ((((v) >> 24) & 0xFF) | (((v) >> 8) & 0xFF00) | (((v) & 0xFF00) << 8) | ((v) << 24))
+#define SWAP64(v) (((CFL_UINT64)SWAP32((CFL_UINT32)(v)) << 32) | SWAP32((CFL_UINT32)((v) >> 32)))
+#endif
+
+// Conversions between host and explicit byte order, each one is its own inverse
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define BE16(v) (v)
+#define BE32(v) (v)
+#define BE64(v) (v)
+#define LE16(v) SWAP16(v)
+#define LE32(v) SWAP32(v)
+#define LE64(v) SWAP64(v)
+#define BE_SWAPS CFL_FALSE
+#define LE_SWAPS CFL_TRUE
+#else
+#define BE16(v) SWAP16(v)
+#define BE32(v) SWAP32(v)
+#define BE64(v) SWAP64(v)
+#define LE16(v) (v)
+#define LE32(v) (v)
+#define LE64(v) (v)
+#define BE_SWAPS CFL_TRUE
+#define LE_SWAPS CFL_FALSE
+#endif
 
 static CFL_BOOL ensureCapacity(CFL_BUFFERP buffer, CFL_UINT32 minCapacity) {
    if (minCapacity > buffer->capacity) {
@@ -390,6 +449,630 @@ double cfl_buffer_peekDouble(CFL_BUFFERP buffer) {
    PEEK_RETURN_BUFFER(double, buffer, 0.0);
 }
 
+CFL_BOOL cfl_buffer_putInt16BE(CFL_BUFFERP buffer, CFL_INT16 value) {
+   PUT_BUFFER(CFL_UINT16, buffer, BE16((CFL_UINT16)value));
+   return CFL_TRUE;
+}
+
+CFL_INT16 cfl_buffer_getInt16BE(CFL_BUFFERP buffer) {
+   CFL_UINT16 value;
+   GET_BUFFER(value, CFL_UINT16, buffer, 0);
+   return (CFL_INT16)BE16(value);
+}
+
+CFL_BOOL cfl_buffer_putInt32BE(CFL_BUFFERP buffer, CFL_INT32 value) {
+   PUT_BUFFER(CFL_UINT32, buffer, BE32((CFL_UINT32)value));
+   return CFL_TRUE;
+}
+
+CFL_INT32 cfl_buffer_getInt32BE(CFL_BUFFERP buffer) {
+   CFL_UINT32 value;
+   GET_BUFFER(value, CFL_UINT32, buffer, 0);
+   return (CFL_INT32)BE32(value);
+}
+
+CFL_BOOL cfl_buffer_putInt64BE(CFL_BUFFERP buffer, CFL_INT64 value) {
+   PUT_BUFFER(CFL_UINT64, buffer, BE64((CFL_UINT64)value));
+   return CFL_TRUE;
+}
+
+CFL_INT64 cfl_buffer_getInt64BE(CFL_BUFFERP buffer) {
+   CFL_UINT64 value;
+   GET_BUFFER(value, CFL_UINT64, buffer, 0);
+   return (CFL_INT64)BE64(value);
+}
+
+CFL_BOOL cfl_buffer_putUInt16BE(CFL_BUFFERP buffer, CFL_UINT16 value) {
+   PUT_BUFFER(CFL_UINT16, buffer, BE16(value));
+   return CFL_TRUE;
+}
+
+CFL_UINT16 cfl_buffer_getUInt16BE(CFL_BUFFERP buffer) {
+   CFL_UINT16 value;
+   GET_BUFFER(value, CFL_UINT16, buffer, 0);
+   return BE16(value);
+}
+
+CFL_BOOL cfl_buffer_putUInt32BE(CFL_BUFFERP buffer, CFL_UINT32 value) {
+   PUT_BUFFER(CFL_UINT32, buffer, BE32(value));
+   return CFL_TRUE;
+}
+
+CFL_UINT32 cfl_buffer_getUInt32BE(CFL_BUFFERP buffer) {
+   CFL_UINT32 value;
+   GET_BUFFER(value, CFL_UINT32, buffer, 0);
+   return BE32(value);
+}
+
+CFL_BOOL cfl_buffer_putUInt64BE(CFL_BUFFERP buffer, CFL_UINT64 value) {
+   PUT_BUFFER(CFL_UINT64, buffer, BE64(value));
+   return CFL_TRUE;
+}
+
+CFL_UINT64 cfl_buffer_getUInt64BE(CFL_BUFFERP buffer) {
+   CFL_UINT64 value;
+   GET_BUFFER(value, CFL_UINT64, buffer, 0);
+   return BE64(value);
+}
+
+CFL_BOOL cfl_buffer_putFloatBE(CFL_BUFFERP buffer, float value) {
+   CFL_UINT32 bits;
+   memcpy(&bits, &value, sizeof(bits));
+   PUT_BUFFER(CFL_UINT32, buffer, BE32(bits));
+   return CFL_TRUE;
+}
+
+float cfl_buffer_getFloatBE(CFL_BUFFERP buffer) {
+   CFL_UINT32 bits;
+   float value;
+   GET_BUFFER(bits, CFL_UINT32, buffer, 0);
+   bits = BE32(bits);
+   memcpy(&value, &bits, sizeof(value));
+   return value;
+}
+
+CFL_BOOL cfl_buffer_putDoubleBE(CFL_BUFFERP buffer, double value) {
+   CFL_UINT64 bits;
+   memcpy(&bits, &value, sizeof(bits));
+   PUT_BUFFER(CFL_UINT64, buffer, BE64(bits));
+   return CFL_TRUE;
+}
+
+double cfl_buffer_getDoubleBE(CFL_BUFFERP buffer) {
+   CFL_UINT64 bits;
+   double value;
+   GET_BUFFER(bits, CFL_UINT64, buffer, 0);
+   bits = BE64(bits);
+   memcpy(&value, &bits, sizeof(value));
+   return value;
+}
+
+CFL_BOOL cfl_buffer_putInt16LE(CFL_BUFFERP buffer, CFL_INT16 value) {
+   PUT_BUFFER(CFL_UINT16, buffer, LE16((CFL_UINT16)value));
+   return CFL_TRUE;
+}
+
+CFL_INT16 cfl_buffer_getInt16LE(CFL_BUFFERP buffer) {
+   CFL_UINT16 value;
+   GET_BUFFER(value, CFL_UINT16, buffer, 0);
+   return (CFL_INT16)LE16(value);
+}
+
+CFL_BOOL cfl_buffer_putInt32LE(CFL_BUFFERP buffer, CFL_INT32 value) {
+   PUT_BUFFER(CFL_UINT32, buffer, LE32((CFL_UINT32)value));
+   return CFL_TRUE;
+}
+
+CFL_INT32 cfl_buffer_getInt32LE(CFL_BUFFERP buffer) {
+   CFL_UINT32 value;
+   GET_BUFFER(value, CFL_UINT32, buffer, 0);
+   return (CFL_INT32)LE32(value);
+}
+
+CFL_BOOL cfl_buffer_putInt64LE(CFL_BUFFERP buffer, CFL_INT64 value) {
+   PUT_BUFFER(CFL_UINT64, buffer, LE64((CFL_UINT64)value));
+   return CFL_TRUE;
+}
+
+CFL_INT64 cfl_buffer_getInt64LE(CFL_BUFFERP buffer) {
+   CFL_UINT64 value;
+   GET_BUFFER(value, CFL_UINT64, buffer, 0);
+   return (CFL_INT64)LE64(value);
+}
+
+CFL_BOOL cfl_buffer_putUInt16LE(CFL_BUFFERP buffer, CFL_UINT16 value) {
+   PUT_BUFFER(CFL_UINT16, buffer, LE16(value));
+   return CFL_TRUE;
+}
+
+CFL_UINT16 cfl_buffer_getUInt16LE(CFL_BUFFERP buffer) {
+   CFL_UINT16 value;
+   GET_BUFFER(value, CFL_UINT16, buffer, 0);
+   return LE16(value);
+}
+
+CFL_BOOL cfl_buffer_putUInt32LE(CFL_BUFFERP buffer, CFL_UINT32 value) {
+   PUT_BUFFER(CFL_UINT32, buffer, LE32(value));
+   return CFL_TRUE;
+}
+
+CFL_UINT32 cfl_buffer_getUInt32LE(CFL_BUFFERP buffer) {
+   CFL_UINT32 value;
+   GET_BUFFER(value, CFL_UINT32, buffer, 0);
+   return LE32(value);
+}
+
+CFL_BOOL cfl_buffer_putUInt64LE(CFL_BUFFERP buffer, CFL_UINT64 value) {
+   PUT_BUFFER(CFL_UINT64, buffer, LE64(value));
+   return CFL_TRUE;
+}
+
+CFL_UINT64 cfl_buffer_getUInt64LE(CFL_BUFFERP buffer) {
+   CFL_UINT64 value;
+   GET_BUFFER(value, CFL_UINT64, buffer, 0);
+   return LE64(value);
+}
+
+CFL_BOOL cfl_buffer_putFloatLE(CFL_BUFFERP buffer, float value) {
+   CFL_UINT32 bits;
+   memcpy(&bits, &value, sizeof(bits));
+   PUT_BUFFER(CFL_UINT32, buffer, LE32(bits));
+   return CFL_TRUE;
+}
+
+float cfl_buffer_getFloatLE(CFL_BUFFERP buffer) {
+   CFL_UINT32 bits;
+   float value;
+   GET_BUFFER(bits, CFL_UINT32, buffer, 0);
+   bits = LE32(bits);
+   memcpy(&value, &bits, sizeof(value));
+   return value;
+}
+
+CFL_BOOL cfl_buffer_putDoubleLE(CFL_BUFFERP buffer, double value) {
+   CFL_UINT64 bits;
+   memcpy(&bits, &value, sizeof(bits));
+   PUT_BUFFER(CFL_UINT64, buffer, LE64(bits));
+   return CFL_TRUE;
+}
+
+double cfl_buffer_getDoubleLE(CFL_BUFFERP buffer) {
+   CFL_UINT64 bits;
+   double value;
+   GET_BUFFER(bits, CFL_UINT64, buffer, 0);
+   bits = LE64(bits);
+   memcpy(&value, &bits, sizeof(value));
+   return value;
+}
+
+#if defined(SWAP_SSE2)
+// Reverses the bytes of each 16-bit word, the 16-bit words are then reordered to complete the 32 or 64-bit swap
+static CFL_INLINE __m128i swapVector16(__m128i v) {
+   return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+#endif
+
+/*
+ * Copies count values of size bytes reversing the bytes of each one. The 16-bit loop is vectorized by the compiler;
+ * byte swaps of 32 and 64-bit values are not, so with SSE2 they are done 16 bytes at a time.
+ */
+static void copySwapped(CFL_UINT8 *dest, const CFL_UINT8 *src, CFL_UINT32 count, CFL_UINT32 size) {
+   CFL_UINT32 i = 0;
+
+   switch (size) {
+      case sizeof(CFL_UINT16):
+         for (; i < count; i++) {
+            CFL_UINT16 value;
+            memcpy(&value, src + i * sizeof(value), sizeof(value));
+            value = SWAP16(value);
+            memcpy(dest + i * sizeof(value), &value, sizeof(value));
+         }
+         break;
+      case sizeof(CFL_UINT32):
+#if defined(SWAP_SSE2)
+         for (; i + 4 <= count; i += 4) {
+            __m128i v = swapVector16(_mm_loadu_si128((const __m128i *)(src + i * sizeof(CFL_UINT32))));
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128((__m128i *)(dest + i * sizeof(CFL_UINT32)), v);
+         }
+#endif
+         for (; i < count; i++) {
+            CFL_UINT32 value;
+            memcpy(&value, src + i * sizeof(value), sizeof(value));
+            value = SWAP32(value);
+            memcpy(dest + i * sizeof(value), &value, sizeof(value));
+         }
+         break;
+      default:
+#if defined(SWAP_SSE2)
+         for (; i + 2 <= count; i += 2) {
+            __m128i v = swapVector16(_mm_loadu_si128((const __m128i *)(src + i * sizeof(CFL_UINT64))));
+            v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+            _mm_storeu_si128((__m128i *)(dest + i * sizeof(CFL_UINT64)), v);
+         }
+#endif
+         for (; i < count; i++) {
+            CFL_UINT64 value;
+            memcpy(&value, src + i * sizeof(value), sizeof(value));
+            value = SWAP64(value);
+            memcpy(dest + i * sizeof(value), &value, sizeof(value));
+         }
+         break;
+   }
+}
+
+static CFL_BOOL putArray(CFL_BUFFERP buffer, const void *values, CFL_UINT32 count, CFL_UINT32 size, CFL_BOOL swap) {
+   CFL_UINT32 len;
+
+   if (count > (CFL_UINT32_MAX - buffer->position) / size) {
+      return CFL_FALSE;
+   }
+   len = count * size;
+   if (!ensureCapacity(buffer, buffer->position + len)) {
+      return CFL_FALSE;
+   }
+   if (swap) {
+      copySwapped(&buffer->data[buffer->position], (const CFL_UINT8 *)values, count, size);
+   } else if (len > 0) {
+      memcpy(&buffer->data[buffer->position], values, len);
+   }
+   buffer->position += len;
+   if (buffer->position > buffer->length) {
+      buffer->length = buffer->position;
+   }
+   return CFL_TRUE;
+}
+
+static CFL_UINT32 getArray(CFL_BUFFERP buffer, void *values, CFL_UINT32 count, CFL_UINT32 size, CFL_BOOL swap) {
+   CFL_UINT32 available = buffer->position < buffer->length ? (buffer->length - buffer->position) / size : 0;
+   CFL_BOOL truncated = count > available;
+
+   if (truncated) {
+      count = available;
+   }
+   if (swap) {
+      copySwapped((CFL_UINT8 *)values, &buffer->data[buffer->position], count, size);
+   } else if (count > 0) {
+      memcpy(values, &buffer->data[buffer->position], count * size);
+   }
+   buffer->position = truncated ? buffer->length : buffer->position + count * size;
+   return count;
+}
+
+CFL_BOOL cfl_buffer_putInt16Array(CFL_BUFFERP buffer, const CFL_INT16 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT16), CFL_FALSE);
+}
+
+CFL_UINT32 cfl_buffer_getInt16Array(CFL_BUFFERP buffer, CFL_INT16 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT16), CFL_FALSE);
+}
+
+CFL_BOOL cfl_buffer_putInt32Array(CFL_BUFFERP buffer, const CFL_INT32 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT32), CFL_FALSE);
+}
+
+CFL_UINT32 cfl_buffer_getInt32Array(CFL_BUFFERP buffer, CFL_INT32 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT32), CFL_FALSE);
+}
+
+CFL_BOOL cfl_buffer_putInt64Array(CFL_BUFFERP buffer, const CFL_INT64 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT64), CFL_FALSE);
+}
+
+CFL_UINT32 cfl_buffer_getInt64Array(CFL_BUFFERP buffer, CFL_INT64 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT64), CFL_FALSE);
+}
+
+CFL_BOOL cfl_buffer_putFloatArray(CFL_BUFFERP buffer, const float *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(float), CFL_FALSE);
+}
+
+CFL_UINT32 cfl_buffer_getFloatArray(CFL_BUFFERP buffer, float *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(float), CFL_FALSE);
+}
+
+CFL_BOOL cfl_buffer_putDoubleArray(CFL_BUFFERP buffer, const double *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(double), CFL_FALSE);
+}
+
+CFL_UINT32 cfl_buffer_getDoubleArray(CFL_BUFFERP buffer, double *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(double), CFL_FALSE);
+}
+
+CFL_BOOL cfl_buffer_putInt16ArrayBE(CFL_BUFFERP buffer, const CFL_INT16 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT16), BE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getInt16ArrayBE(CFL_BUFFERP buffer, CFL_INT16 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT16), BE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putInt32ArrayBE(CFL_BUFFERP buffer, const CFL_INT32 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT32), BE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getInt32ArrayBE(CFL_BUFFERP buffer, CFL_INT32 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT32), BE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putInt64ArrayBE(CFL_BUFFERP buffer, const CFL_INT64 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT64), BE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getInt64ArrayBE(CFL_BUFFERP buffer, CFL_INT64 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT64), BE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putFloatArrayBE(CFL_BUFFERP buffer, const float *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(float), BE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getFloatArrayBE(CFL_BUFFERP buffer, float *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(float), BE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putDoubleArrayBE(CFL_BUFFERP buffer, const double *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(double), BE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getDoubleArrayBE(CFL_BUFFERP buffer, double *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(double), BE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putInt16ArrayLE(CFL_BUFFERP buffer, const CFL_INT16 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT16), LE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getInt16ArrayLE(CFL_BUFFERP buffer, CFL_INT16 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT16), LE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putInt32ArrayLE(CFL_BUFFERP buffer, const CFL_INT32 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT32), LE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getInt32ArrayLE(CFL_BUFFERP buffer, CFL_INT32 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT32), LE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putInt64ArrayLE(CFL_BUFFERP buffer, const CFL_INT64 *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(CFL_INT64), LE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getInt64ArrayLE(CFL_BUFFERP buffer, CFL_INT64 *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(CFL_INT64), LE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putFloatArrayLE(CFL_BUFFERP buffer, const float *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(float), LE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getFloatArrayLE(CFL_BUFFERP buffer, float *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(float), LE_SWAPS);
+}
+
+CFL_BOOL cfl_buffer_putDoubleArrayLE(CFL_BUFFERP buffer, const double *values, CFL_UINT32 count) {
+   return putArray(buffer, values, count, sizeof(double), LE_SWAPS);
+}
+
+CFL_UINT32 cfl_buffer_getDoubleArrayLE(CFL_BUFFERP buffer, double *values, CFL_UINT32 count) {
+   return getArray(buffer, values, count, sizeof(double), LE_SWAPS);
+}
+
+static CFL_BOOL putBytes(CFL_BUFFERP buffer, const void *bytes, CFL_UINT32 len) {
+   if (len > CFL_UINT32_MAX - buffer->position || !ensureCapacity(buffer, buffer->position + len)) {
+      return CFL_FALSE;
+   }
+   memcpy(&buffer->data[buffer->position], bytes, len);
+   buffer->position += len;
+   if (buffer->position > buffer->length) {
+      buffer->length = buffer->position;
+   }
+   return CFL_TRUE;
+}
+
+static CFL_UINT32 encodeVarUInt64(CFL_UINT64 value, CFL_UINT8 *bytes) {
+   CFL_UINT32 len = 0;
+   while (value >= 0x80) {
+      bytes[len++] = (CFL_UINT8)(value | 0x80);
+      value >>= 7;
+   }
+   bytes[len++] = (CFL_UINT8)value;
+   return len;
+}
+
+// Decodes a 32-bit varint when at least VARINT32_MAX_BYTES are available, without checking the end of the data
+static CFL_UINT32 decodeVarUInt32Unchecked(const CFL_UINT8 *bytes, CFL_UINT32 *value) {
+   CFL_UINT32 b;
+   CFL_UINT32 result;
+
+   b = bytes[0];
+   result = b & 0x7F;
+   if (b < 0x80) {
+      *value = result;
+      return 1;
+   }
+   b = bytes[1];
+   result |= (b & 0x7F) << 7;
+   if (b < 0x80) {
+      *value = result;
+      return 2;
+   }
+   b = bytes[2];
+   result |= (b & 0x7F) << 14;
+   if (b < 0x80) {
+      *value = result;
+      return 3;
+   }
+   b = bytes[3];
+   result |= (b & 0x7F) << 21;
+   if (b < 0x80) {
+      *value = result;
+      return 4;
+   }
+   b = bytes[4];
+   // The fifth byte holds the 4 highest bits and ends the value
+   if (b > 0x0F) {
+      return 0;
+   }
+   *value = result | (b << 28);
+   return 5;
+}
+
+// Decodes a varint of a value with the given number of bits, returning its size or 0 if it is truncated or too long
+static CFL_UINT32 decodeVarUInt(const CFL_UINT8 *bytes, CFL_UINT32 available, CFL_UINT32 bits, CFL_UINT64 *value) {
+   CFL_UINT64 result = 0;
+   CFL_UINT32 maxBytes = (bits + 6) / 7;
+   CFL_UINT32 limit = available < maxBytes ? available : maxBytes;
+   CFL_UINT32 i;
+
+   for (i = 0; i < limit; i++) {
+      CFL_UINT8 b = bytes[i];
+      if (b < 0x80) {
+         // The last byte must not carry bits beyond the value width
+         if (i == maxBytes - 1 && (b >> (bits - 7 * i)) != 0) {
+            return 0;
+         }
+         *value = result | ((CFL_UINT64)b << (7 * i));
+         return i + 1;
+      }
+      result |= (CFL_UINT64)(b & 0x7F) << (7 * i);
+   }
+   return 0;
+}
+
+static CFL_UINT32 decodeVarUInt32(const CFL_UINT8 *bytes, CFL_UINT32 available, CFL_UINT32 *value) {
+   CFL_UINT64 value64;
+   CFL_UINT32 size;
+
+   if (available >= VARINT32_MAX_BYTES) {
+      return decodeVarUInt32Unchecked(bytes, value);
+   }
+   size = decodeVarUInt(bytes, available, 32, &value64);
+   if (size > 0) {
+      *value = (CFL_UINT32)value64;
+   }
+   return size;
+}
+
+CFL_BOOL cfl_buffer_putVarUInt32(CFL_BUFFERP buffer, CFL_UINT32 value) {
+   CFL_UINT8 bytes[VARINT32_MAX_BYTES];
+
+   if (value < 0x80) {
+      bytes[0] = (CFL_UINT8)value;
+      return putBytes(buffer, bytes, 1);
+   }
+   return putBytes(buffer, bytes, encodeVarUInt64(value, bytes));
+}
+
+CFL_UINT32 cfl_buffer_getVarUInt32(CFL_BUFFERP buffer) {
+   CFL_UINT32 value;
+   CFL_UINT32 size;
+
+   if (buffer->position < buffer->length && buffer->data[buffer->position] < 0x80) {
+      return buffer->data[buffer->position++];
+   }
+   size = buffer->position < buffer->length
+              ? decodeVarUInt32(&buffer->data[buffer->position], buffer->length - buffer->position, &value)
+              : 0;
+   if (size == 0) {
+      buffer->position = buffer->length;
+      return 0;
+   }
+   buffer->position += size;
+   return value;
+}
+
+CFL_BOOL cfl_buffer_putVarUInt64(CFL_BUFFERP buffer, CFL_UINT64 value) {
+   CFL_UINT8 bytes[VARINT64_MAX_BYTES];
+
+   if (value < 0x80) {
+      bytes[0] = (CFL_UINT8)value;
+      return putBytes(buffer, bytes, 1);
+   }
+   return putBytes(buffer, bytes, encodeVarUInt64(value, bytes));
+}
+
+CFL_UINT64 cfl_buffer_getVarUInt64(CFL_BUFFERP buffer) {
+   CFL_UINT64 value;
+   CFL_UINT32 size;
+
+   if (buffer->position < buffer->length && buffer->data[buffer->position] < 0x80) {
+      return buffer->data[buffer->position++];
+   }
+   size = buffer->position < buffer->length
+              ? decodeVarUInt(&buffer->data[buffer->position], buffer->length - buffer->position, 64, &value)
+              : 0;
+   if (size == 0) {
+      buffer->position = buffer->length;
+      return 0;
+   }
+   buffer->position += size;
+   return value;
+}
+
+CFL_BOOL cfl_buffer_putVarInt32(CFL_BUFFERP buffer, CFL_INT32 value) {
+   return cfl_buffer_putVarUInt32(buffer, ZIGZAG_ENCODE32(value));
+}
+
+CFL_INT32 cfl_buffer_getVarInt32(CFL_BUFFERP buffer) {
+   CFL_UINT32 value = cfl_buffer_getVarUInt32(buffer);
+   return ZIGZAG_DECODE32(value);
+}
+
+CFL_BOOL cfl_buffer_putVarInt64(CFL_BUFFERP buffer, CFL_INT64 value) {
+   return cfl_buffer_putVarUInt64(buffer, ZIGZAG_ENCODE64(value));
+}
+
+CFL_INT64 cfl_buffer_getVarInt64(CFL_BUFFERP buffer) {
+   CFL_UINT64 value = cfl_buffer_getVarUInt64(buffer);
+   return ZIGZAG_DECODE64(value);
+}
+
+// Reads 8 one-byte values at once when none of the next 8 bytes has its continuation bit set
+#define VARINT_ARRAY_DECODE(buffer, values, count, decode)                                                                         \
+   CFL_UINT32 pos = buffer->position;                                                                                              \
+   CFL_UINT32 end = buffer->length;                                                                                                \
+   CFL_UINT32 n = 0;                                                                                                               \
+   while (n < count) {                                                                                                             \
+      CFL_UINT32 size;                                                                                                             \
+      if (count - n >= 8 && pos < end && end - pos >= 8) {                                                                         \
+         CFL_UINT64 word;                                                                                                          \
+         memcpy(&word, &buffer->data[pos], sizeof(word));                                                                          \
+         if ((word & 0x8080808080808080ULL) == 0) {                                                                                \
+            const CFL_UINT8 *bytes = &buffer->data[pos];                                                                           \
+            values[n] = bytes[0];                                                                                                  \
+            values[n + 1] = bytes[1];                                                                                              \
+            values[n + 2] = bytes[2];                                                                                              \
+            values[n + 3] = bytes[3];                                                                                              \
+            values[n + 4] = bytes[4];                                                                                              \
+            values[n + 5] = bytes[5];                                                                                              \
+            values[n + 6] = bytes[6];                                                                                              \
+            values[n + 7] = bytes[7];                                                                                              \
+            n += 8;                                                                                                                \
+            pos += 8;                                                                                                              \
+            continue;                                                                                                              \
+         }                                                                                                                         \
+      }                                                                                                                            \
+      size = pos < end ? decode : 0;                                                                                               \
+      if (size == 0) {                                                                                                             \
+         buffer->position = end;                                                                                                   \
+         return n;                                                                                                                 \
+      }                                                                                                                            \
+      pos += size;                                                                                                                 \
+      ++n;                                                                                                                         \
+   }                                                                                                                               \
+   buffer->position = pos;                                                                                                         \
+   return n
+
+CFL_UINT32 cfl_buffer_getVarUInt32Array(CFL_BUFFERP buffer, CFL_UINT32 *values, CFL_UINT32 count) {
+   VARINT_ARRAY_DECODE(buffer, values, count, decodeVarUInt32(&buffer->data[pos], end - pos, &values[n]));
+}
+
+CFL_UINT32 cfl_buffer_getVarUInt64Array(CFL_BUFFERP buffer, CFL_UINT64 *values, CFL_UINT32 count) {
+   VARINT_ARRAY_DECODE(buffer, values, count, decodeVarUInt(&buffer->data[pos], end - pos, 64, &values[n]));
+}
+
 CFL_STRP cfl_buffer_getString(CFL_BUFFERP buffer) {
    CFL_STRP str;
    CFL_UINT32 len;
@@ -597,6 +1280,57 @@ CFL_BOOL cfl_buffer_putCharArrayLen(CFL_BUFFERP buffer, const char *value, CFL_U
    return CFL_TRUE;
 }
 
+// Reads a varint length and limits it to the remaining bytes, like the 32-bit prefixed strings
+static CFL_UINT32 getVarLength(CFL_BUFFERP buffer) {
+   CFL_UINT32 len = cfl_buffer_getVarUInt32(buffer);
+   if (buffer->length - buffer->position < len) {
+      len = buffer->length - buffer->position;
+   }
+   return len;
+}
+
+CFL_BOOL cfl_buffer_putVarString(CFL_BUFFERP buffer, CFL_STRP value) {
+   CFL_UINT32 len = cfl_str_length(value);
+   return cfl_buffer_putVarUInt32(buffer, len) && putBytes(buffer, cfl_str_getPtr(value), len);
+}
+
+CFL_STRP cfl_buffer_getVarString(CFL_BUFFERP buffer) {
+   CFL_UINT32 len = getVarLength(buffer);
+   CFL_STRP str;
+
+   if (len == 0) {
+      return cfl_str_new(16);
+   }
+   str = cfl_str_newBufferLen((const char *)&buffer->data[buffer->position], len);
+   buffer->position += len;
+   return str;
+}
+
+void cfl_buffer_copyVarString(CFL_BUFFERP buffer, CFL_STRP destStr) {
+   CFL_UINT32 len = getVarLength(buffer);
+
+   cfl_str_setValueLen(destStr, (const char *)&buffer->data[buffer->position], len);
+   buffer->position += len;
+}
+
+CFL_BOOL cfl_buffer_putVarCharArray(CFL_BUFFERP buffer, const char *value) {
+   CFL_UINT32 len = (CFL_UINT32)strlen(value) * sizeof(char);
+   return cfl_buffer_putVarUInt32(buffer, len) && putBytes(buffer, value, len);
+}
+
+char *cfl_buffer_getVarCharArray(CFL_BUFFERP buffer) {
+   CFL_UINT32 len = getVarLength(buffer);
+   char *str = (char *)CFL_MEM_ALLOC((len + 1) * sizeof(char));
+
+   if (str == NULL) {
+      return NULL;
+   }
+   memcpy((void *)str, (void *)&buffer->data[buffer->position], len * sizeof(char));
+   buffer->position += len;
+   str[len] = 0;
+   return str;
+}
+
 void cfl_buffer_getDate(CFL_BUFFERP buffer, CFL_DATEP date) {
    CFL_UINT16 year;
    CFL_UINT8 month;
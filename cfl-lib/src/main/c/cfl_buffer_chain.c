@@ -0,0 +1,467 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "cfl_buffer_chain.h"
+#include "cfl_atomic.h"
+#include "cfl_mem.h"
+
+/*
+ * Memory shared by the slices of one or more chains. Segments allocated by
+ * the chain keep their bytes right after the header, segments given by
+ * reference point to the caller memory and have a free function.
+ */
+typedef struct _CFL_BUFFER_SEGMENT {
+   CFL_INT32 refCount;
+   CFL_UINT32 used;     /* Bytes written, the rest can still be appended to */
+   CFL_UINT32 capacity;
+   CFL_UINT8 *data;
+   CFL_BUFFER_CHAIN_FREE_FUNC freeFunc;
+   void *context;
+} CFL_BUFFER_SEGMENT;
+
+struct _CFL_BUFFER_SLICE {
+   CFL_BUFFER_SEGMENT *segment;
+   CFL_UINT8 *data;
+   CFL_UINT32 length;
+};
+
+static CFL_BUFFER_SEGMENT *segmentNew(CFL_UINT32 capacity) {
+   CFL_BUFFER_SEGMENT *segment = (CFL_BUFFER_SEGMENT *) CFL_MEM_ALLOC(sizeof(CFL_BUFFER_SEGMENT) + capacity);
+   if (segment == NULL) {
+      return NULL;
+   }
+   segment->refCount = 1;
+   segment->used = 0;
+   segment->capacity = capacity;
+   segment->data = (CFL_UINT8 *) (segment + 1);
+   segment->freeFunc = NULL;
+   segment->context = NULL;
+   return segment;
+}
+
+static CFL_BUFFER_SEGMENT *segmentNewRef(void *data, CFL_UINT32 size, CFL_BUFFER_CHAIN_FREE_FUNC freeFunc,
+                                         void *context) {
+   CFL_BUFFER_SEGMENT *segment = (CFL_BUFFER_SEGMENT *) CFL_MEM_ALLOC(sizeof(CFL_BUFFER_SEGMENT));
+   if (segment == NULL) {
+      return NULL;
+   }
+   segment->refCount = 1;
+   segment->used = size;
+   segment->capacity = size;
+   segment->data = (CFL_UINT8 *) data;
+   segment->freeFunc = freeFunc;
+   segment->context = context;
+   return segment;
+}
+
+static void segmentAddRef(CFL_BUFFER_SEGMENT *segment) {
+   cfl_atomic_addInt32(&segment->refCount, 1);
+}
+
+static void segmentRelease(CFL_BUFFER_SEGMENT *segment) {
+   if (cfl_atomic_subInt32(&segment->refCount, 1) == 1) {
+      if (segment->freeFunc != NULL) {
+         segment->freeFunc(segment->data, segment->context);
+      }
+      CFL_MEM_FREE(segment);
+   }
+}
+
+static void freeBufferData(void *data, void *context) {
+   CFL_UNUSED(context);
+   CFL_MEM_FREE(data);
+}
+
+static CFL_BOOL reserveSlices(CFL_BUFFER_CHAINP chain, CFL_UINT32 count) {
+   CFL_BUFFER_SLICE *slices;
+   CFL_UINT32 newCapacity;
+   if (count <= chain->capacity) {
+      return CFL_TRUE;
+   }
+   newCapacity = chain->capacity < 4 ? 4 : chain->capacity * 2;
+   if (newCapacity < count) {
+      newCapacity = count;
+   }
+   slices = (CFL_BUFFER_SLICE *) CFL_MEM_REALLOC(chain->slices, newCapacity * sizeof(CFL_BUFFER_SLICE));
+   if (slices == NULL) {
+      return CFL_FALSE;
+   }
+   chain->slices = slices;
+   chain->capacity = newCapacity;
+   return CFL_TRUE;
+}
+
+/* Inserts a slice taking over a reference to the segment. The slices must be reserved. */
+static void insertSlice(CFL_BUFFER_CHAINP chain, CFL_UINT32 index, CFL_BUFFER_SEGMENT *segment, CFL_UINT8 *data,
+                        CFL_UINT32 length) {
+   CFL_BUFFER_SLICE *slice;
+   memmove(&chain->slices[index + 1], &chain->slices[index], (chain->count - index) * sizeof(CFL_BUFFER_SLICE));
+   slice = &chain->slices[index];
+   slice->segment = segment;
+   slice->data = data;
+   slice->length = length;
+   chain->count++;
+   chain->length += length;
+}
+
+/* Bytes that can be appended in place to the last slice */
+static CFL_UINT32 tailRoom(const CFL_BUFFER_CHAINP chain) {
+   const CFL_BUFFER_SLICE *slice;
+   CFL_BUFFER_SEGMENT *segment;
+   if (chain->count == 0) {
+      return 0;
+   }
+   slice = &chain->slices[chain->count - 1];
+   segment = slice->segment;
+   /* Only the single owner can write, and only right after the written bytes */
+   if (cfl_atomic_getInt32(&segment->refCount) != 1 || slice->data + slice->length != segment->data + segment->used) {
+      return 0;
+   }
+   return segment->capacity - segment->used;
+}
+
+/* Index of the slice containing offset, and the offset inside that slice */
+static CFL_UINT32 findSlice(const CFL_BUFFER_CHAINP chain, CFL_UINT32 offset, CFL_UINT32 *sliceOffset) {
+   CFL_UINT32 index = 0;
+   while (index < chain->count && offset >= chain->slices[index].length) {
+      offset -= chain->slices[index].length;
+      ++index;
+   }
+   *sliceOffset = offset;
+   return index;
+}
+
+/* Appends references to a range of another chain. The range must be valid. */
+static CFL_BOOL appendRange(CFL_BUFFER_CHAINP chain, const CFL_BUFFER_CHAINP other, CFL_UINT32 offset,
+                            CFL_UINT32 size) {
+   CFL_UINT32 sliceOffset;
+   CFL_UINT32 index;
+   CFL_UINT32 last;
+
+   if (size == 0) {
+      return CFL_TRUE;
+   }
+   index = findSlice(other, offset, &sliceOffset);
+   last = index;
+   {
+      CFL_UINT32 covered = other->slices[index].length - sliceOffset;
+      while (covered < size) {
+         covered += other->slices[++last].length;
+      }
+   }
+   if (!reserveSlices(chain, chain->count + (last - index) + 1)) {
+      return CFL_FALSE;
+   }
+   /* other may be chain itself, so slices are read by index after reserving */
+   while (size > 0) {
+      const CFL_BUFFER_SLICE *slice = &other->slices[index++];
+      CFL_UINT32 length = slice->length - sliceOffset;
+      if (length > size) {
+         length = size;
+      }
+      segmentAddRef(slice->segment);
+      insertSlice(chain, chain->count, slice->segment, slice->data + sliceOffset, length);
+      size -= length;
+      sliceOffset = 0;
+   }
+   return CFL_TRUE;
+}
+
+void cfl_buffer_chain_init(CFL_BUFFER_CHAINP chain) {
+   chain->slices = NULL;
+   chain->count = 0;
+   chain->capacity = 0;
+   chain->length = 0;
+   chain->allocated = CFL_FALSE;
+}
+
+CFL_BUFFER_CHAINP cfl_buffer_chain_new(void) {
+   CFL_BUFFER_CHAINP chain = (CFL_BUFFER_CHAINP) CFL_MEM_ALLOC(sizeof(CFL_BUFFER_CHAIN));
+   if (chain == NULL) {
+      return NULL;
+   }
+   cfl_buffer_chain_init(chain);
+   chain->allocated = CFL_TRUE;
+   return chain;
+}
+
+void cfl_buffer_chain_free(CFL_BUFFER_CHAINP chain) {
+   if (chain != NULL) {
+      cfl_buffer_chain_clear(chain);
+      if (chain->slices != NULL) {
+         CFL_MEM_FREE(chain->slices);
+         chain->slices = NULL;
+      }
+      chain->capacity = 0;
+      if (chain->allocated) {
+         CFL_MEM_FREE(chain);
+      }
+   }
+}
+
+void cfl_buffer_chain_clear(CFL_BUFFER_CHAINP chain) {
+   CFL_UINT32 i;
+   for (i = 0; i < chain->count; i++) {
+      segmentRelease(chain->slices[i].segment);
+   }
+   chain->count = 0;
+   chain->length = 0;
+}
+
+CFL_UINT32 cfl_buffer_chain_length(const CFL_BUFFER_CHAINP chain) {
+   return chain->length;
+}
+
+CFL_UINT32 cfl_buffer_chain_sliceCount(const CFL_BUFFER_CHAINP chain) {
+   return chain->count;
+}
+
+CFL_BOOL cfl_buffer_chain_append(CFL_BUFFER_CHAINP chain, const void *data, CFL_UINT32 size) {
+   const CFL_UINT8 *bytes = (const CFL_UINT8 *) data;
+   CFL_BUFFER_SEGMENT *segment = NULL;
+   CFL_UINT32 room;
+
+   if (size == 0) {
+      return CFL_TRUE;
+   }
+   if (size > CFL_UINT32_MAX - chain->length) {
+      return CFL_FALSE;
+   }
+   room = tailRoom(chain);
+   /* Allocate everything before copying so that a failure changes nothing */
+   if (size > room) {
+      CFL_UINT32 rest = size - room;
+      segment = segmentNew(rest > CFL_BUFFER_CHAIN_SEGMENT_SIZE ? rest : CFL_BUFFER_CHAIN_SEGMENT_SIZE);
+      if (segment == NULL) {
+         return CFL_FALSE;
+      }
+      if (!reserveSlices(chain, chain->count + 1)) {
+         segmentRelease(segment);
+         return CFL_FALSE;
+      }
+   }
+   if (room > 0) {
+      CFL_BUFFER_SLICE *slice = &chain->slices[chain->count - 1];
+      CFL_UINT32 length = size < room ? size : room;
+      memcpy(slice->segment->data + slice->segment->used, bytes, length);
+      slice->segment->used += length;
+      slice->length += length;
+      chain->length += length;
+      bytes += length;
+      size -= length;
+   }
+   if (segment != NULL) {
+      memcpy(segment->data, bytes, size);
+      segment->used = size;
+      insertSlice(chain, chain->count, segment, segment->data, size);
+   }
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_buffer_chain_prepend(CFL_BUFFER_CHAINP chain, const void *data, CFL_UINT32 size) {
+   CFL_BUFFER_SEGMENT *segment;
+
+   if (size == 0) {
+      return CFL_TRUE;
+   }
+   if (size > CFL_UINT32_MAX - chain->length || !reserveSlices(chain, chain->count + 1)) {
+      return CFL_FALSE;
+   }
+   segment = segmentNew(size);
+   if (segment == NULL) {
+      return CFL_FALSE;
+   }
+   memcpy(segment->data, data, size);
+   segment->used = size;
+   insertSlice(chain, 0, segment, segment->data, size);
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_buffer_chain_appendRef(CFL_BUFFER_CHAINP chain, void *data, CFL_UINT32 size,
+                                    CFL_BUFFER_CHAIN_FREE_FUNC freeFunc, void *context) {
+   CFL_BUFFER_SEGMENT *segment;
+
+   if (size > CFL_UINT32_MAX - chain->length || !reserveSlices(chain, chain->count + 1)) {
+      return CFL_FALSE;
+   }
+   segment = segmentNewRef(data, size, freeFunc, context);
+   if (segment == NULL) {
+      return CFL_FALSE;
+   }
+   insertSlice(chain, chain->count, segment, segment->data, size);
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_buffer_chain_appendBuffer(CFL_BUFFER_CHAINP chain, CFL_BUFFERP buffer) {
+   CFL_UINT32 size = cfl_buffer_remaining(buffer);
+   CFL_BUFFER_SEGMENT *segment;
+
+   if (size == 0) {
+      // Nothing to take over, the buffer keeps its memory
+      cfl_buffer_reset(buffer);
+      return CFL_TRUE;
+   }
+   if (size > CFL_UINT32_MAX - chain->length || !reserveSlices(chain, chain->count + 1)) {
+      return CFL_FALSE;
+   }
+   segment = segmentNewRef(buffer->data, buffer->length, freeBufferData, NULL);
+   if (segment == NULL) {
+      return CFL_FALSE;
+   }
+   insertSlice(chain, chain->count, segment, buffer->data + buffer->position, size);
+   buffer->data = NULL;
+   buffer->capacity = 0;
+   buffer->length = 0;
+   buffer->position = 0;
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_buffer_chain_appendChain(CFL_BUFFER_CHAINP chain, const CFL_BUFFER_CHAINP other) {
+   if (other->length > CFL_UINT32_MAX - chain->length) {
+      return CFL_FALSE;
+   }
+   return appendRange(chain, other, 0, other->length);
+}
+
+CFL_BUFFER_CHAINP cfl_buffer_chain_slice(const CFL_BUFFER_CHAINP chain, CFL_UINT32 offset, CFL_UINT32 size) {
+   CFL_BUFFER_CHAINP slice;
+
+   if (offset > chain->length) {
+      return NULL;
+   }
+   if (size > chain->length - offset) {
+      size = chain->length - offset;
+   }
+   slice = cfl_buffer_chain_new();
+   if (slice == NULL) {
+      return NULL;
+   }
+   if (!appendRange(slice, chain, offset, size)) {
+      cfl_buffer_chain_free(slice);
+      return NULL;
+   }
+   return slice;
+}
+
+CFL_BUFFER_CHAINP cfl_buffer_chain_split(CFL_BUFFER_CHAINP chain, CFL_UINT32 offset) {
+   CFL_BUFFER_CHAINP tail;
+   CFL_UINT32 sliceOffset;
+   CFL_UINT32 index;
+   CFL_UINT32 moved;
+
+   if (offset > chain->length) {
+      return NULL;
+   }
+   tail = cfl_buffer_chain_new();
+   if (tail == NULL) {
+      return NULL;
+   }
+   index = findSlice(chain, offset, &sliceOffset);
+   moved = chain->count - index;
+   if (moved > 0 && !reserveSlices(tail, moved)) {
+      cfl_buffer_chain_free(tail);
+      return NULL;
+   }
+   /* The slices after offset move to the tail, one cut in two is shared */
+   if (moved > 0) {
+      memcpy(tail->slices, &chain->slices[index], moved * sizeof(CFL_BUFFER_SLICE));
+      tail->count = moved;
+      tail->length = chain->length - offset;
+      if (sliceOffset > 0) {
+         segmentAddRef(chain->slices[index].segment);
+         tail->slices[0].data += sliceOffset;
+         tail->slices[0].length -= sliceOffset;
+         chain->slices[index].length = sliceOffset;
+         ++index;
+      }
+   }
+   chain->count = index;
+   chain->length = offset;
+   return tail;
+}
+
+void cfl_buffer_chain_skip(CFL_BUFFER_CHAINP chain, CFL_UINT32 size) {
+   CFL_UINT32 index = 0;
+
+   if (size > chain->length) {
+      size = chain->length;
+   }
+   chain->length -= size;
+   while (size > 0 && size >= chain->slices[index].length) {
+      size -= chain->slices[index].length;
+      segmentRelease(chain->slices[index].segment);
+      ++index;
+   }
+   if (size > 0) {
+      chain->slices[index].data += size;
+      chain->slices[index].length -= size;
+   }
+   if (index > 0) {
+      memmove(chain->slices, &chain->slices[index], (chain->count - index) * sizeof(CFL_BUFFER_SLICE));
+      chain->count -= index;
+   }
+}
+
+CFL_UINT32 cfl_buffer_chain_copy(const CFL_BUFFER_CHAINP chain, CFL_UINT32 offset, void *dest, CFL_UINT32 size) {
+   CFL_UINT8 *bytes = (CFL_UINT8 *) dest;
+   CFL_UINT32 copied = 0;
+   CFL_UINT32 sliceOffset;
+   CFL_UINT32 index;
+
+   if (offset >= chain->length) {
+      return 0;
+   }
+   if (size > chain->length - offset) {
+      size = chain->length - offset;
+   }
+   index = findSlice(chain, offset, &sliceOffset);
+   while (copied < size) {
+      const CFL_BUFFER_SLICE *slice = &chain->slices[index++];
+      CFL_UINT32 length = slice->length - sliceOffset;
+      if (length > size - copied) {
+         length = size - copied;
+      }
+      memcpy(bytes + copied, slice->data + sliceOffset, length);
+      copied += length;
+      sliceOffset = 0;
+   }
+   return copied;
+}
+
+CFL_BOOL cfl_buffer_chain_toBuffer(const CFL_BUFFER_CHAINP chain, CFL_BUFFERP buffer) {
+   CFL_UINT32 i;
+   for (i = 0; i < chain->count; i++) {
+      if (!cfl_buffer_put(buffer, chain->slices[i].data, chain->slices[i].length)) {
+         return CFL_FALSE;
+      }
+   }
+   return CFL_TRUE;
+}
+
+CFL_UINT32 cfl_buffer_chain_toIovec(const CFL_BUFFER_CHAINP chain, CFL_IOVEC *iov, CFL_UINT32 maxCount) {
+   CFL_UINT32 count = chain->count < maxCount ? chain->count : maxCount;
+   CFL_UINT32 i;
+   for (i = 0; i < count; i++) {
+      iov[i].iov_base = chain->slices[i].data;
+      iov[i].iov_len = chain->slices[i].length;
+   }
+   return count;
+}
@@ -0,0 +1,429 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfl_atomic.h"
+#include "cfl_cbtree.h"
+#include "cfl_mem.h"
+#include "cfl_thread.h"
+
+/* Readers only need the loads of a node to be ordered with the loads of its version. */
+#if defined(__GNUC__) || defined(__clang__)
+   #define LOAD_VERSION(n)  __atomic_load_n(&(n)->version, __ATOMIC_ACQUIRE)
+   #define LOAD_ROOT(t)     __atomic_load_n(&(t)->pRoot, __ATOMIC_ACQUIRE)
+   #define STORE_ROOT(t, n) __atomic_store_n(&(t)->pRoot, (n), __ATOMIC_RELEASE)
+   #define READ_BARRIER()   __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+   #include <intrin.h>
+   /* x86 does not reorder loads with other loads, and volatile accesses are not reordered by the compiler. */
+   #define LOAD_VERSION(n)  (*(volatile CFL_INT32 *) &(n)->version)
+   #define LOAD_ROOT(t)     (*(CFL_CBTREE_NODEP volatile *) &(t)->pRoot)
+   #define STORE_ROOT(t, n) (*(CFL_CBTREE_NODEP volatile *) &(t)->pRoot = (n))
+   #define READ_BARRIER()   _ReadWriteBarrier()
+#else
+   #define LOAD_VERSION(n)  cfl_atomic_getInt32(&(n)->version)
+   #define LOAD_ROOT(t)     ((CFL_CBTREE_NODEP) cfl_atomic_getPointer((void **) &(t)->pRoot))
+   #define STORE_ROOT(t, n) cfl_atomic_setPointer((void **) &(t)->pRoot, (void *) (n))
+   #define READ_BARRIER()
+#endif
+
+/* The pointers are reached by a byte offset from the keys so that they are never accessed through a CFL_INT64 */
+#define NODE_POINTERS(t, n)  ((void **) ((char *) (n)->keys + sizeof(CFL_INT64) * (t)->lKeys))
+#define NODE_VALUE(t, n, i)  (NODE_POINTERS(t, n)[i])
+#define NODE_CHILD(t, n, i)  ((CFL_CBTREE_NODEP) NODE_POINTERS(t, n)[i])
+
+#define IS_LOCKED(v)         (((v) & 1) != 0)
+
+/* Result of an optimistic attempt of an operation */
+#define ATTEMPT_FAILED       -2
+#define ATTEMPT_RESTART      -1
+#define ATTEMPT_NOT_FOUND     0
+#define ATTEMPT_DONE          1
+
+/* Restarts between yields of the processor to the writer holding a lock */
+#define RESTARTS_BEFORE_YIELD 64
+
+static CFL_CBTREE_NODEP cfl_cbtree_node_new(CFL_CBTREEP pTree, CFL_BOOL bIsLeafNode) {
+   size_t nodeSize = sizeof(CFL_CBTREE_NODE) + (sizeof(CFL_INT64) * pTree->lKeys) + (sizeof(void *) * (pTree->lKeys + 1));
+   CFL_CBTREE_NODEP pNode = (CFL_CBTREE_NODEP) CFL_MEM_ALLOC(nodeSize);
+   if (pNode == NULL) {
+      return NULL;
+   }
+   memset(pNode, 0, nodeSize);
+   pNode->bIsLeafNode = bIsLeafNode;
+   return pNode;
+}
+
+// Version of an unlocked node. Returns FALSE when a writer holds the node lock.
+
+static CFL_BOOL cfl_cbtree_readLock(CFL_CBTREE_NODEP pNode, CFL_INT32 *pVersion) {
+   CFL_INT32 version = LOAD_VERSION(pNode);
+   if (IS_LOCKED(version)) {
+      return CFL_FALSE;
+   }
+   *pVersion = version;
+   return CFL_TRUE;
+}
+
+// Everything read from the node since its version was taken is consistent only if the version did not change.
+
+static CFL_BOOL cfl_cbtree_validate(CFL_CBTREE_NODEP pNode, CFL_INT32 version) {
+   READ_BARRIER();
+   return LOAD_VERSION(pNode) == version;
+}
+
+static CFL_BOOL cfl_cbtree_upgradeLock(CFL_CBTREE_NODEP pNode, CFL_INT32 version) {
+   return cfl_atomic_compareAndSetInt32(&pNode->version, version, (CFL_INT32) ((CFL_UINT32) version + 1)) == version;
+}
+
+// Releasing the lock makes the version even again, and different from every version read before the lock was taken.
+
+static void cfl_cbtree_unlock(CFL_CBTREE_NODEP pNode) {
+   cfl_atomic_addInt32(&pNode->version, 1);
+}
+
+static void cfl_cbtree_backoff(CFL_UINT32 *pRestarts) {
+   if (++(*pRestarts) % RESTARTS_BEFORE_YIELD == 0) {
+      cfl_thread_yield();
+   }
+}
+
+// Number of keys less than (or less than or equal to, if bOrEqual) key. A node read optimistically may be inconsistent,
+// so the number of keys is bounded by the node capacity; the caller discards the result if the version changed.
+
+static CFL_INT32 cfl_cbtree_countLess(CFL_CBTREEP pTree, CFL_CBTREE_NODEP pNode, CFL_INT64 key, CFL_BOOL bOrEqual) {
+   CFL_INT32 lFirst = 0;
+   CFL_INT32 lLast = pNode->lNumKeys;
+   if (lLast < 0 || lLast > pTree->lKeys) {
+      lLast = 0;
+   }
+   while (lFirst < lLast) {
+      CFL_INT32 lMiddle = lFirst + ((lLast - lFirst) / 2);
+      CFL_INT64 middleKey = pNode->keys[lMiddle];
+      if (middleKey < key || (bOrEqual && middleKey == key)) {
+         lFirst = lMiddle + 1;
+      } else {
+         lLast = lMiddle;
+      }
+   }
+   return lFirst;
+}
+
+CFL_CBTREEP cfl_cbtree_new(CFL_INT32 lKeys) {
+   CFL_CBTREEP pTree = (CFL_CBTREEP) CFL_MEM_ALLOC(sizeof(CFL_CBTREE));
+   if (pTree == NULL) {
+      return NULL;
+   }
+   if (lKeys <= 0) {
+      lKeys = CFL_CBTREE_DEFAULT_KEYS;
+   }
+   pTree->lKeys = lKeys < 3 ? 3 : lKeys;
+   pTree->lCount = 0;
+   pTree->pRoot = cfl_cbtree_node_new(pTree, CFL_TRUE);
+   if (pTree->pRoot == NULL) {
+      CFL_MEM_FREE(pTree);
+      return NULL;
+   }
+   return pTree;
+}
+
+static void cfl_cbtree_freeNodes(CFL_CBTREEP pTree, CFL_CBTREE_NODEP pNode, BTREE_FREE_KEY_FUNC pFreeValue) {
+   CFL_INT32 i;
+   if (pNode->bIsLeafNode) {
+      if (pFreeValue != NULL) {
+         for (i = 0; i < pNode->lNumKeys; i++) {
+            pFreeValue(NODE_VALUE(pTree, pNode, i));
+         }
+      }
+   } else {
+      for (i = 0; i <= pNode->lNumKeys; i++) {
+         cfl_cbtree_freeNodes(pTree, NODE_CHILD(pTree, pNode, i), pFreeValue);
+      }
+   }
+   CFL_MEM_FREE(pNode);
+}
+
+void cfl_cbtree_free(CFL_CBTREEP pTree, BTREE_FREE_KEY_FUNC pFreeValue) {
+   if (pTree == NULL) {
+      return;
+   }
+   cfl_cbtree_freeNodes(pTree, pTree->pRoot, pFreeValue);
+   CFL_MEM_FREE(pTree);
+}
+
+// Split a full node locked by the caller, together with its parent (NULL if the node is the root). The parent is not
+// full, because full nodes are split on the way down. The new node is filled before it is published in the parent.
+
+static CFL_BOOL cfl_cbtree_split(CFL_CBTREEP pTree, CFL_CBTREE_NODEP pNode, CFL_CBTREE_NODEP pParent) {
+   CFL_CBTREE_NODEP pNewNode = cfl_cbtree_node_new(pTree, pNode->bIsLeafNode);
+   CFL_INT32 lLeftKeys = pNode->lNumKeys / 2;
+   CFL_INT64 separator;
+   void **pParentPointers;
+   CFL_INT32 i;
+
+   if (pNewNode == NULL) {
+      return CFL_FALSE;
+   }
+   if (pNode->bIsLeafNode) {
+      pNewNode->lNumKeys = pNode->lNumKeys - lLeftKeys;
+      memcpy(pNewNode->keys, &pNode->keys[lLeftKeys], sizeof(CFL_INT64) * pNewNode->lNumKeys);
+      memcpy(NODE_POINTERS(pTree, pNewNode), &NODE_POINTERS(pTree, pNode)[lLeftKeys], sizeof(void *) * pNewNode->lNumKeys);
+      separator = pNewNode->keys[0];
+   } else {
+      // The median key moves up to the parent
+      separator = pNode->keys[lLeftKeys];
+      pNewNode->lNumKeys = pNode->lNumKeys - lLeftKeys - 1;
+      memcpy(pNewNode->keys, &pNode->keys[lLeftKeys + 1], sizeof(CFL_INT64) * pNewNode->lNumKeys);
+      memcpy(NODE_POINTERS(pTree, pNewNode), &NODE_POINTERS(pTree, pNode)[lLeftKeys + 1],
+             sizeof(void *) * (pNewNode->lNumKeys + 1));
+   }
+   pNode->lNumKeys = lLeftKeys;
+
+   if (pParent == NULL) {
+      CFL_CBTREE_NODEP pNewRoot = cfl_cbtree_node_new(pTree, CFL_FALSE);
+      if (pNewRoot == NULL) {
+         pNode->lNumKeys += pNewNode->lNumKeys + (pNode->bIsLeafNode ? 0 : 1);
+         CFL_MEM_FREE(pNewNode);
+         return CFL_FALSE;
+      }
+      pNewRoot->keys[0] = separator;
+      NODE_POINTERS(pTree, pNewRoot)[0] = pNode;
+      NODE_POINTERS(pTree, pNewRoot)[1] = pNewNode;
+      pNewRoot->lNumKeys = 1;
+      STORE_ROOT(pTree, pNewRoot);
+   } else {
+      pParentPointers = NODE_POINTERS(pTree, pParent);
+      i = cfl_cbtree_countLess(pTree, pParent, separator, CFL_TRUE);
+      memmove(&pParent->keys[i + 1], &pParent->keys[i], sizeof(CFL_INT64) * (pParent->lNumKeys - i));
+      memmove(&pParentPointers[i + 2], &pParentPointers[i + 1], sizeof(void *) * (pParent->lNumKeys - i));
+      pParent->keys[i] = separator;
+      pParentPointers[i + 1] = pNewNode;
+      ++(pParent->lNumKeys);
+   }
+   return CFL_TRUE;
+}
+
+// Optimistic descent to the leaf of key. On return the leaf version was read after its parent was validated, and the
+// caller must validate the parent again (pParent/pParentVersion) after locking the leaf.
+
+static CFL_CBTREE_NODEP cfl_cbtree_findLeaf(CFL_CBTREEP pTree, CFL_INT64 key, CFL_INT32 *pVersion,
+                                            CFL_CBTREE_NODEP *ppParent, CFL_INT32 *pParentVersion) {
+   CFL_CBTREE_NODEP pParent = NULL;
+   CFL_INT32 parentVersion = 0;
+   CFL_CBTREE_NODEP pNode = LOAD_ROOT(pTree);
+   CFL_INT32 version;
+
+   if (!cfl_cbtree_readLock(pNode, &version) || pNode != LOAD_ROOT(pTree)) {
+      return NULL;
+   }
+   while (!pNode->bIsLeafNode) {
+      CFL_CBTREE_NODEP pChild = NODE_CHILD(pTree, pNode, cfl_cbtree_countLess(pTree, pNode, key, CFL_TRUE));
+      if (!cfl_cbtree_validate(pNode, version)) {
+         return NULL;
+      }
+      if (pParent != NULL && !cfl_cbtree_validate(pParent, parentVersion)) {
+         return NULL;
+      }
+      pParent = pNode;
+      parentVersion = version;
+      pNode = pChild;
+      if (!cfl_cbtree_readLock(pNode, &version)) {
+         return NULL;
+      }
+   }
+   *pVersion = version;
+   *ppParent = pParent;
+   *pParentVersion = parentVersion;
+   return pNode;
+}
+
+static CFL_INT32 cfl_cbtree_trySearch(CFL_CBTREEP pTree, CFL_INT64 key, void **ppValue) {
+   CFL_CBTREE_NODEP pParent;
+   CFL_INT32 parentVersion;
+   CFL_INT32 version;
+   CFL_CBTREE_NODEP pLeaf = cfl_cbtree_findLeaf(pTree, key, &version, &pParent, &parentVersion);
+   CFL_INT32 i;
+   CFL_BOOL bFound;
+   void *pValue;
+
+   if (pLeaf == NULL || (pParent != NULL && !cfl_cbtree_validate(pParent, parentVersion))) {
+      return ATTEMPT_RESTART;
+   }
+   i = cfl_cbtree_countLess(pTree, pLeaf, key, CFL_FALSE);
+   bFound = i < pLeaf->lNumKeys && pLeaf->keys[i] == key;
+   pValue = bFound ? NODE_VALUE(pTree, pLeaf, i) : NULL;
+   if (!cfl_cbtree_validate(pLeaf, version)) {
+      return ATTEMPT_RESTART;
+   }
+   *ppValue = pValue;
+   return bFound ? ATTEMPT_DONE : ATTEMPT_NOT_FOUND;
+}
+
+// Insertion descends optimistically as a reader. A full node found on the way is split, locking it and its parent,
+// and the insertion restarts; otherwise only the leaf is locked.
+
+static CFL_INT32 cfl_cbtree_tryAdd(CFL_CBTREEP pTree, CFL_INT64 key, void *pValue) {
+   CFL_CBTREE_NODEP pParent = NULL;
+   CFL_INT32 parentVersion = 0;
+   CFL_CBTREE_NODEP pNode = LOAD_ROOT(pTree);
+   CFL_INT32 version;
+   void **pPointers;
+   CFL_BOOL bSplit = CFL_TRUE;
+   CFL_INT32 i;
+
+   if (!cfl_cbtree_readLock(pNode, &version) || pNode != LOAD_ROOT(pTree)) {
+      return ATTEMPT_RESTART;
+   }
+   for (;;) {
+      if (pNode->lNumKeys >= pTree->lKeys) {
+         if (pParent != NULL && !cfl_cbtree_upgradeLock(pParent, parentVersion)) {
+            return ATTEMPT_RESTART;
+         }
+         if (!cfl_cbtree_upgradeLock(pNode, version)) {
+            if (pParent != NULL) {
+               cfl_cbtree_unlock(pParent);
+            }
+            return ATTEMPT_RESTART;
+         }
+         if (pParent != NULL || pNode == LOAD_ROOT(pTree)) {
+            bSplit = cfl_cbtree_split(pTree, pNode, pParent);
+         }
+         cfl_cbtree_unlock(pNode);
+         if (pParent != NULL) {
+            cfl_cbtree_unlock(pParent);
+         }
+         // Without memory for the split the insertion cannot progress
+         return bSplit ? ATTEMPT_RESTART : ATTEMPT_FAILED;
+      }
+      if (pNode->bIsLeafNode) {
+         break;
+      }
+      if (pParent != NULL && !cfl_cbtree_validate(pParent, parentVersion)) {
+         return ATTEMPT_RESTART;
+      }
+      pParent = pNode;
+      parentVersion = version;
+      pNode = NODE_CHILD(pTree, pParent, cfl_cbtree_countLess(pTree, pParent, key, CFL_TRUE));
+      if (!cfl_cbtree_validate(pParent, parentVersion) || !cfl_cbtree_readLock(pNode, &version)) {
+         return ATTEMPT_RESTART;
+      }
+   }
+
+   if (!cfl_cbtree_upgradeLock(pNode, version)) {
+      return ATTEMPT_RESTART;
+   }
+   if (pParent != NULL && !cfl_cbtree_validate(pParent, parentVersion)) {
+      cfl_cbtree_unlock(pNode);
+      return ATTEMPT_RESTART;
+   }
+   i = cfl_cbtree_countLess(pTree, pNode, key, CFL_FALSE);
+   if (i < pNode->lNumKeys && pNode->keys[i] == key) {
+      cfl_cbtree_unlock(pNode);
+      return ATTEMPT_NOT_FOUND;
+   }
+   pPointers = NODE_POINTERS(pTree, pNode);
+   memmove(&pNode->keys[i + 1], &pNode->keys[i], sizeof(CFL_INT64) * (pNode->lNumKeys - i));
+   memmove(&pPointers[i + 1], &pPointers[i], sizeof(void *) * (pNode->lNumKeys - i));
+   pNode->keys[i] = key;
+   pPointers[i] = pValue;
+   ++(pNode->lNumKeys);
+   cfl_cbtree_unlock(pNode);
+   return ATTEMPT_DONE;
+}
+
+static CFL_INT32 cfl_cbtree_tryDelete(CFL_CBTREEP pTree, CFL_INT64 key, void **ppValue) {
+   CFL_CBTREE_NODEP pParent;
+   CFL_INT32 parentVersion;
+   CFL_INT32 version;
+   CFL_CBTREE_NODEP pLeaf = cfl_cbtree_findLeaf(pTree, key, &version, &pParent, &parentVersion);
+   void **pPointers;
+   CFL_INT32 i;
+
+   if (pLeaf == NULL || !cfl_cbtree_upgradeLock(pLeaf, version)) {
+      return ATTEMPT_RESTART;
+   }
+   if (pParent != NULL && !cfl_cbtree_validate(pParent, parentVersion)) {
+      cfl_cbtree_unlock(pLeaf);
+      return ATTEMPT_RESTART;
+   }
+   i = cfl_cbtree_countLess(pTree, pLeaf, key, CFL_FALSE);
+   if (i >= pLeaf->lNumKeys || pLeaf->keys[i] != key) {
+      cfl_cbtree_unlock(pLeaf);
+      return ATTEMPT_NOT_FOUND;
+   }
+   pPointers = NODE_POINTERS(pTree, pLeaf);
+   *ppValue = pPointers[i];
+   memmove(&pLeaf->keys[i], &pLeaf->keys[i + 1], sizeof(CFL_INT64) * (pLeaf->lNumKeys - i - 1));
+   memmove(&pPointers[i], &pPointers[i + 1], sizeof(void *) * (pLeaf->lNumKeys - i - 1));
+   --(pLeaf->lNumKeys);
+   cfl_cbtree_unlock(pLeaf);
+   return ATTEMPT_DONE;
+}
+
+CFL_BOOL cfl_cbtree_add(CFL_CBTREEP pTree, CFL_INT64 key, void *pValue) {
+   CFL_UINT32 lRestarts = 0;
+   CFL_INT32 result;
+   while ((result = cfl_cbtree_tryAdd(pTree, key, pValue)) == ATTEMPT_RESTART) {
+      cfl_cbtree_backoff(&lRestarts);
+   }
+   if (result == ATTEMPT_DONE) {
+      cfl_atomic_addInt32(&pTree->lCount, 1);
+      return CFL_TRUE;
+   }
+   return CFL_FALSE;
+}
+
+void *cfl_cbtree_delete(CFL_CBTREEP pTree, CFL_INT64 key) {
+   CFL_UINT32 lRestarts = 0;
+   CFL_INT32 result;
+   void *pValue = NULL;
+   while ((result = cfl_cbtree_tryDelete(pTree, key, &pValue)) == ATTEMPT_RESTART) {
+      cfl_cbtree_backoff(&lRestarts);
+   }
+   if (result == ATTEMPT_DONE) {
+      cfl_atomic_subInt32(&pTree->lCount, 1);
+      return pValue;
+   }
+   return NULL;
+}
+
+void *cfl_cbtree_search(CFL_CBTREEP pTree, CFL_INT64 key) {
+   CFL_UINT32 lRestarts = 0;
+   void *pValue = NULL;
+   while (cfl_cbtree_trySearch(pTree, key, &pValue) == ATTEMPT_RESTART) {
+      cfl_cbtree_backoff(&lRestarts);
+   }
+   return pValue;
+}
+
+CFL_BOOL cfl_cbtree_contains(CFL_CBTREEP pTree, CFL_INT64 key) {
+   CFL_UINT32 lRestarts = 0;
+   CFL_INT32 result;
+   void *pValue;
+   while ((result = cfl_cbtree_trySearch(pTree, key, &pValue)) == ATTEMPT_RESTART) {
+      cfl_cbtree_backoff(&lRestarts);
+   }
+   return result == ATTEMPT_DONE;
+}
+
+CFL_INT32 cfl_cbtree_count(CFL_CBTREEP pTree) {
+   return cfl_atomic_getInt32(&pTree->lCount);
+}
@@ -0,0 +1,306 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "cfl_deque.h"
+#include "cfl_mem.h"
+
+#define MIN_CAPACITY     16
+
+#define SLOT(d, i)       ((d)->items[((d)->head + (i)) & ((d)->capacity - 1)])
+
+typedef struct _DEQUE_ITERATOR {
+   CFL_DEQUEP deque;
+   CFL_UINT32 index;
+} DEQUE_ITERATOR, *DEQUE_ITERATORP;
+
+static CFL_BOOL iteratorHasNext(CFL_ITERATORP it);
+static void * iteratorNext(CFL_ITERATORP it);
+static void * iteratorValue(CFL_ITERATORP it);
+static void iteratorRemove(CFL_ITERATORP it);
+static void iteratorFirst(CFL_ITERATORP it);
+static CFL_BOOL iteratorHasPrevious(CFL_ITERATORP it);
+static void * iteratorPrevious(CFL_ITERATORP it);
+static void iteratorLast(CFL_ITERATORP it);
+static CFL_UINT32 iteratorNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
+
+static const CFL_ITERATOR_CLASS s_dequeIteratorClass = {
+   iteratorHasNext,
+   iteratorNext,
+   iteratorValue,
+   iteratorRemove,
+   NULL,
+   iteratorFirst,
+   iteratorHasPrevious,
+   iteratorPrevious,
+   iteratorLast,
+   NULL,
+   NULL,
+   iteratorNextBatch
+};
+
+static CFL_UINT32 roundCapacity(CFL_UINT32 capacity) {
+   CFL_UINT32 rounded = MIN_CAPACITY;
+   while (rounded < capacity && rounded < 0x80000000) {
+      rounded <<= 1;
+   }
+   return rounded;
+}
+
+/*
+ * Doubles the buffer. The items are copied to the start of the new buffer in deque order, so the head goes back to 0.
+ */
+static CFL_BOOL grow(CFL_DEQUEP deque) {
+   CFL_UINT32 newCapacity;
+   void **newItems;
+
+   if (deque->capacity == 0) {
+      newCapacity = MIN_CAPACITY;
+   } else if (deque->capacity < 0x80000000) {
+      newCapacity = deque->capacity << 1;
+   } else {
+      return CFL_FALSE;
+   }
+   newItems = (void **) CFL_MEM_ALLOC((size_t) newCapacity * sizeof(void *));
+   if (newItems == NULL) {
+      return CFL_FALSE;
+   }
+   if (deque->length > 0) {
+      CFL_UINT32 firstPart = deque->capacity - deque->head;
+      if (firstPart > deque->length) {
+         firstPart = deque->length;
+      }
+      memcpy(newItems, &deque->items[deque->head], (size_t) firstPart * sizeof(void *));
+      memcpy(&newItems[firstPart], deque->items, (size_t) (deque->length - firstPart) * sizeof(void *));
+   }
+   if (deque->items != NULL) {
+      CFL_MEM_FREE(deque->items);
+   }
+   deque->items = newItems;
+   deque->capacity = newCapacity;
+   deque->head = 0;
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_deque_init(CFL_DEQUEP deque, CFL_UINT32 capacity) {
+   deque->head = 0;
+   deque->length = 0;
+   deque->allocated = CFL_FALSE;
+   if (capacity > 0) {
+      deque->capacity = roundCapacity(capacity);
+      deque->items = (void **) CFL_MEM_ALLOC((size_t) deque->capacity * sizeof(void *));
+      if (deque->items == NULL) {
+         deque->capacity = 0;
+         return CFL_FALSE;
+      }
+   } else {
+      deque->capacity = 0;
+      deque->items = NULL;
+   }
+   return CFL_TRUE;
+}
+
+CFL_DEQUEP cfl_deque_new(CFL_UINT32 capacity) {
+   CFL_DEQUEP deque = (CFL_DEQUEP) CFL_MEM_ALLOC(sizeof(CFL_DEQUE));
+   if (deque == NULL) {
+      return NULL;
+   }
+   if (! cfl_deque_init(deque, capacity)) {
+      CFL_MEM_FREE(deque);
+      return NULL;
+   }
+   deque->allocated = CFL_TRUE;
+   return deque;
+}
+
+void cfl_deque_free(CFL_DEQUEP deque) {
+   if (deque != NULL) {
+      if (deque->items != NULL) {
+         CFL_MEM_FREE(deque->items);
+         deque->items = NULL;
+      }
+      if (deque->allocated) {
+         CFL_MEM_FREE(deque);
+      }
+   }
+}
+
+CFL_BOOL cfl_deque_addLast(CFL_DEQUEP deque, void *item) {
+   if (deque->length == deque->capacity && ! grow(deque)) {
+      return CFL_FALSE;
+   }
+   SLOT(deque, deque->length) = item;
+   deque->length++;
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_deque_addFirst(CFL_DEQUEP deque, void *item) {
+   if (deque->length == deque->capacity && ! grow(deque)) {
+      return CFL_FALSE;
+   }
+   deque->head = (deque->head - 1) & (deque->capacity - 1);
+   deque->items[deque->head] = item;
+   deque->length++;
+   return CFL_TRUE;
+}
+
+void *cfl_deque_removeFirst(CFL_DEQUEP deque) {
+   void *item;
+   if (deque->length == 0) {
+      return NULL;
+   }
+   item = deque->items[deque->head];
+   deque->head = (deque->head + 1) & (deque->capacity - 1);
+   deque->length--;
+   return item;
+}
+
+void *cfl_deque_removeLast(CFL_DEQUEP deque) {
+   if (deque->length == 0) {
+      return NULL;
+   }
+   deque->length--;
+   return SLOT(deque, deque->length);
+}
+
+void *cfl_deque_getFirst(const CFL_DEQUEP deque) {
+   return deque->length > 0 ? deque->items[deque->head] : NULL;
+}
+
+void *cfl_deque_getLast(const CFL_DEQUEP deque) {
+   return deque->length > 0 ? SLOT(deque, deque->length - 1) : NULL;
+}
+
+void *cfl_deque_get(const CFL_DEQUEP deque, CFL_UINT32 ulIndex) {
+   return ulIndex < deque->length ? SLOT(deque, ulIndex) : NULL;
+}
+
+void cfl_deque_set(CFL_DEQUEP deque, CFL_UINT32 ulIndex, void *item) {
+   if (ulIndex < deque->length) {
+      SLOT(deque, ulIndex) = item;
+   }
+}
+
+void *cfl_deque_remove(CFL_DEQUEP deque, CFL_UINT32 ulIndex) {
+   void *item;
+   CFL_UINT32 i;
+
+   if (ulIndex >= deque->length) {
+      return NULL;
+   }
+   item = SLOT(deque, ulIndex);
+   if (ulIndex < deque->length / 2) {
+      for (i = ulIndex; i > 0; i--) {
+         SLOT(deque, i) = SLOT(deque, i - 1);
+      }
+      deque->head = (deque->head + 1) & (deque->capacity - 1);
+   } else {
+      for (i = ulIndex + 1; i < deque->length; i++) {
+         SLOT(deque, i - 1) = SLOT(deque, i);
+      }
+   }
+   deque->length--;
+   return item;
+}
+
+void cfl_deque_clear(CFL_DEQUEP deque) {
+   if (deque != NULL) {
+      deque->head = 0;
+      deque->length = 0;
+   }
+}
+
+CFL_UINT32 cfl_deque_length(const CFL_DEQUEP deque) {
+   return deque != NULL ? deque->length : 0;
+}
+
+CFL_BOOL cfl_deque_isEmpty(const CFL_DEQUEP deque) {
+   return deque == NULL || deque->length == 0;
+}
+
+static CFL_BOOL iteratorHasNext(CFL_ITERATORP it) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   return data->index < data->deque->length;
+}
+
+static void * iteratorNext(CFL_ITERATORP it) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   if (data->index < data->deque->length) {
+      return SLOT(data->deque, data->index++);
+   }
+   return NULL;
+}
+
+static void * iteratorValue(CFL_ITERATORP it) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   return data->index > 0 ? cfl_deque_get(data->deque, data->index - 1) : NULL;
+}
+
+static void iteratorRemove(CFL_ITERATORP it) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   if (data->index > 0 && data->index <= data->deque->length) {
+      cfl_deque_remove(data->deque, --(data->index));
+   }
+}
+
+static void iteratorFirst(CFL_ITERATORP it) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   data->index = data->deque->length > 0 ? 1 : 0;
+}
+
+static CFL_BOOL iteratorHasPrevious(CFL_ITERATORP it) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   return data->index > 1;
+}
+
+static void * iteratorPrevious(CFL_ITERATORP it) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   if (data->index > 0) {
+      --(data->index);
+   }
+   return data->index > 0 ? cfl_deque_get(data->deque, data->index - 1) : NULL;
+}
+
+static void iteratorLast(CFL_ITERATORP it) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   data->index = data->deque->length;
+}
+
+static CFL_UINT32 iteratorNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   DEQUE_ITERATORP data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   CFL_UINT32 count = 0;
+   while (count < n && data->index < data->deque->length) {
+      out[count++] = SLOT(data->deque, data->index++);
+   }
+   return count;
+}
+
+CFL_ITERATORP cfl_deque_iterator(CFL_DEQUEP deque) {
+   CFL_ITERATORP it = cfl_iterator_new(sizeof(DEQUE_ITERATOR));
+   DEQUE_ITERATORP data;
+   if (it == NULL) {
+      return NULL;
+   }
+   data = (DEQUE_ITERATORP) cfl_iterator_data(it);
+   it->itClass = (CFL_ITERATOR_CLASS *) &s_dequeIteratorClass;
+   data->deque = deque;
+   data->index = 0;
+   return it;
+}
@@ -78,6 +78,7 @@ static void * iteratorValue(CFL_ITERATORP it);
 static void iteratorRemove(CFL_ITERATORP it);
 static void iteratorFree(CFL_ITERATORP it);
 static void iteratorFirst(CFL_ITERATORP it);
+static CFL_UINT32 iteratorNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
 
 static const CFL_ITERATOR_CLASS s_hashIteratorClass = {
    iteratorHasNext,
@@ -90,6 +91,8 @@ static const CFL_ITERATOR_CLASS s_hashIteratorClass = {
    NULL,
    NULL,
    NULL,
+   NULL,
+   iteratorNextBatch,
 };
 
 static const CFL_UINT32 s_primes[] = {
@@ -262,6 +265,43 @@ void * cfl_hash_search(CFL_HASHP hash, void *key) {
    return NULL;
 }
 
+/*****************************************************************************/
+/* Lookups are done in groups so that the bucket and the first entry of every
+ * key in the group are requested from memory before any chain is walked,
+ * overlapping the cache misses of independent searches. */
+#define HASH_BATCH_SIZE 16
+
+void cfl_hash_searchBatch(CFL_HASHP hash, void **keys, void **values, CFL_UINT32 count) {
+   CFL_UINT32 hashvalues[HASH_BATCH_SIZE];
+   CFL_HASH_ENTRYP entries[HASH_BATCH_SIZE];
+   CFL_UINT32 start;
+   CFL_UINT32 groupSize;
+   CFL_UINT32 i;
+
+   for (start = 0; start < count; start += groupSize) {
+      groupSize = count - start < HASH_BATCH_SIZE ? count - start : HASH_BATCH_SIZE;
+      for (i = 0; i < groupSize; i++) {
+         hashvalues[i] = cfl_hash_calc(hash, keys[start + i]);
+         CFL_PREFETCH(&hash->table[indexFor(hash->tablelength, hashvalues[i])]);
+      }
+      for (i = 0; i < groupSize; i++) {
+         entries[i] = hash->table[indexFor(hash->tablelength, hashvalues[i])];
+         CFL_PREFETCH(entries[i]);
+      }
+      for (i = 0; i < groupSize; i++) {
+         CFL_HASH_ENTRYP e = entries[i];
+         values[start + i] = NULL;
+         while (NULL != e) {
+            if ((hashvalues[i] == e->hash) && (hash->eqfn(keys[start + i], e->key))) {
+               values[start + i] = e->value;
+               break;
+            }
+            e = e->next;
+         }
+      }
+   }
+}
+
 /*****************************************************************************/
 void * cfl_hash_remove(CFL_HASHP hash, void *key) {
    /* TODO: consider compacting the table when the load factor drops enough,
@@ -395,6 +435,16 @@ static void *iteratorNext(CFL_ITERATORP it) {
    return ((HASH_ITERATORP)it)->currEntry->value;
 }
 
+static CFL_UINT32 iteratorNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   HASH_ITERATORP itHash = (HASH_ITERATORP)it;
+   CFL_UINT32 count = 0;
+   while (count < n && itHash->nextEntry != NULL) {
+      findNextEntry(itHash);
+      out[count++] = itHash->currEntry->value;
+   }
+   return count;
+}
+
 static void * iteratorValue(CFL_ITERATORP it) {
    if (((HASH_ITERATORP)it)->currEntry != NULL) {
       return ((HASH_ITERATORP)it)->currEntry->value;
@@ -440,6 +490,11 @@ CFL_ITERATORP cfl_hash_iterator(CFL_HASHP hash) {
    if (pIt == NULL) {
       return NULL;
    }
+   return cfl_hash_iteratorInit((CFL_ITERATORP) pIt, hash);
+}
+
+CFL_ITERATORP cfl_hash_iteratorInit(CFL_ITERATORP it, CFL_HASHP hash) {
+   HASH_ITERATORP pIt = (HASH_ITERATORP) it;
    pIt->iterator.itClass = (CFL_ITERATOR_CLASS *) &s_hashIteratorClass;
    pIt->hash = hash;
    pIt->lastIndex = 0;
@@ -450,7 +505,7 @@ CFL_ITERATORP cfl_hash_iterator(CFL_HASHP hash) {
    pIt->currEntry = NULL;
    pIt->nextEntry = NULL;
    findNextEntry(pIt);
-   return (CFL_ITERATORP) pIt;
+   return it;
 }
 
 CFL_UINT32 cfl_hash_murmur3(const void * key, CFL_UINT32 len) {
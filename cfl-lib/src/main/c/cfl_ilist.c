@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "cfl_ilist.h"
+
+static void linkBetween(CFL_ILIST_NODEP node, CFL_ILIST_NODEP previous, CFL_ILIST_NODEP next) {
+   node->previous = previous;
+   node->next = next;
+   previous->next = node;
+   next->previous = node;
+}
+
+static void unlinkNode(CFL_ILIST_NODEP node) {
+   node->previous->next = node->next;
+   node->next->previous = node->previous;
+}
+
+static void spliceBetween(CFL_ILISTP other, CFL_ILIST_NODEP previous, CFL_ILIST_NODEP next) {
+   CFL_ILIST_NODEP first = other->head.next;
+   CFL_ILIST_NODEP last = other->head.previous;
+   first->previous = previous;
+   previous->next = first;
+   last->next = next;
+   next->previous = last;
+}
+
+void cfl_ilist_init(CFL_ILISTP list) {
+   list->head.next = &list->head;
+   list->head.previous = &list->head;
+   list->length = 0;
+}
+
+void cfl_ilist_nodeInit(CFL_ILIST_NODEP node) {
+   node->next = NULL;
+   node->previous = NULL;
+}
+
+CFL_BOOL cfl_ilist_isLinked(const CFL_ILIST_NODEP node) {
+   return node->next != NULL ? CFL_TRUE : CFL_FALSE;
+}
+
+void cfl_ilist_addFirst(CFL_ILISTP list, CFL_ILIST_NODEP node) {
+   linkBetween(node, &list->head, list->head.next);
+   list->length++;
+}
+
+void cfl_ilist_addLast(CFL_ILISTP list, CFL_ILIST_NODEP node) {
+   linkBetween(node, list->head.previous, &list->head);
+   list->length++;
+}
+
+void cfl_ilist_insertBefore(CFL_ILISTP list, CFL_ILIST_NODEP position, CFL_ILIST_NODEP node) {
+   linkBetween(node, position->previous, position);
+   list->length++;
+}
+
+void cfl_ilist_insertAfter(CFL_ILISTP list, CFL_ILIST_NODEP position, CFL_ILIST_NODEP node) {
+   linkBetween(node, position, position->next);
+   list->length++;
+}
+
+void cfl_ilist_remove(CFL_ILISTP list, CFL_ILIST_NODEP node) {
+   if (node->next != NULL) {
+      unlinkNode(node);
+      node->next = NULL;
+      node->previous = NULL;
+      list->length--;
+   }
+}
+
+CFL_ILIST_NODEP cfl_ilist_removeFirst(CFL_ILISTP list) {
+   CFL_ILIST_NODEP node = cfl_ilist_first(list);
+   if (node != NULL) {
+      cfl_ilist_remove(list, node);
+   }
+   return node;
+}
+
+CFL_ILIST_NODEP cfl_ilist_removeLast(CFL_ILISTP list) {
+   CFL_ILIST_NODEP node = cfl_ilist_last(list);
+   if (node != NULL) {
+      cfl_ilist_remove(list, node);
+   }
+   return node;
+}
+
+void cfl_ilist_moveToFirst(CFL_ILISTP list, CFL_ILIST_NODEP node) {
+   if (list->head.next != node) {
+      unlinkNode(node);
+      linkBetween(node, &list->head, list->head.next);
+   }
+}
+
+void cfl_ilist_moveToLast(CFL_ILISTP list, CFL_ILIST_NODEP node) {
+   if (list->head.previous != node) {
+      unlinkNode(node);
+      linkBetween(node, list->head.previous, &list->head);
+   }
+}
+
+void cfl_ilist_spliceFirst(CFL_ILISTP list, CFL_ILISTP other) {
+   if (other->length > 0) {
+      spliceBetween(other, &list->head, list->head.next);
+      list->length += other->length;
+      cfl_ilist_init(other);
+   }
+}
+
+void cfl_ilist_spliceLast(CFL_ILISTP list, CFL_ILISTP other) {
+   if (other->length > 0) {
+      spliceBetween(other, list->head.previous, &list->head);
+      list->length += other->length;
+      cfl_ilist_init(other);
+   }
+}
+
+CFL_ILIST_NODEP cfl_ilist_first(const CFL_ILISTP list) {
+   return list->head.next != &list->head ? list->head.next : NULL;
+}
+
+CFL_ILIST_NODEP cfl_ilist_last(const CFL_ILISTP list) {
+   return list->head.previous != &list->head ? list->head.previous : NULL;
+}
+
+CFL_ILIST_NODEP cfl_ilist_next(const CFL_ILISTP list, const CFL_ILIST_NODEP node) {
+   return node->next != &list->head ? node->next : NULL;
+}
+
+CFL_ILIST_NODEP cfl_ilist_previous(const CFL_ILISTP list, const CFL_ILIST_NODEP node) {
+   return node->previous != &list->head ? node->previous : NULL;
+}
+
+CFL_UINT32 cfl_ilist_length(const CFL_ILISTP list) {
+   return list->length;
+}
+
+CFL_BOOL cfl_ilist_isEmpty(const CFL_ILISTP list) {
+   return list->length == 0 ? CFL_TRUE : CFL_FALSE;
+}
@@ -22,6 +22,57 @@
 #include "cfl_iterator.h"
 #include "cfl_mem.h"
 
+#define SKIP_BUFFER_SIZE 32
+
+/*
+ * Data of the iterators created by the adapter functions. Each adapter uses the fields it needs: head keeps a value
+ * already read from a source and not returned yet, and count is the number of values left by limit and skip or the
+ * current source of concat.
+ */
+typedef struct _ADAPTER_ITERATOR {
+   CFL_ITERATORP source[2];
+   void *head[2];
+   CFL_BOOL hasHead[2];
+   void *current;
+   union {
+      CFL_ITERATOR_FILTER_FUNC filter;
+      CFL_ITERATOR_MAP_FUNC map;
+      CFL_ITERATOR_COMPARE_FUNC compare;
+   } func;
+   void *context;
+   CFL_UINT32 count;
+} ADAPTER_ITERATOR, *ADAPTER_ITERATORP;
+
+static void * adapterValue(CFL_ITERATORP it);
+static void adapterFree(CFL_ITERATORP it);
+static CFL_BOOL filterHasNext(CFL_ITERATORP it);
+static void * filterNext(CFL_ITERATORP it);
+static CFL_UINT32 filterNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
+static CFL_BOOL mapHasNext(CFL_ITERATORP it);
+static void * mapNext(CFL_ITERATORP it);
+static CFL_UINT32 mapNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
+static CFL_BOOL limitHasNext(CFL_ITERATORP it);
+static void * limitNext(CFL_ITERATORP it);
+static CFL_UINT32 limitNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
+static CFL_BOOL skipHasNext(CFL_ITERATORP it);
+static void * skipNext(CFL_ITERATORP it);
+static CFL_UINT32 skipNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
+static CFL_BOOL concatHasNext(CFL_ITERATORP it);
+static void * concatNext(CFL_ITERATORP it);
+static CFL_UINT32 concatNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
+static CFL_BOOL mergeHasNext(CFL_ITERATORP it);
+static void * mergeNext(CFL_ITERATORP it);
+
+#define ADAPTER_CLASS(hasNext, next, nextBatch) \
+   { hasNext, next, adapterValue, NULL, adapterFree, NULL, NULL, NULL, NULL, NULL, NULL, nextBatch }
+
+static const CFL_ITERATOR_CLASS s_filterIteratorClass = ADAPTER_CLASS(filterHasNext, filterNext, filterNextBatch);
+static const CFL_ITERATOR_CLASS s_mapIteratorClass = ADAPTER_CLASS(mapHasNext, mapNext, mapNextBatch);
+static const CFL_ITERATOR_CLASS s_limitIteratorClass = ADAPTER_CLASS(limitHasNext, limitNext, limitNextBatch);
+static const CFL_ITERATOR_CLASS s_skipIteratorClass = ADAPTER_CLASS(skipHasNext, skipNext, skipNextBatch);
+static const CFL_ITERATOR_CLASS s_concatIteratorClass = ADAPTER_CLASS(concatHasNext, concatNext, concatNextBatch);
+static const CFL_ITERATOR_CLASS s_mergeIteratorClass = ADAPTER_CLASS(mergeHasNext, mergeNext, NULL);
+
 CFL_ITERATORP cfl_iterator_new(size_t dataSize) {
    CFL_ITERATORP it = CFL_MEM_ALLOC(sizeof(CFL_ITERATOR) + dataSize);
    if (it) {
@@ -42,6 +93,13 @@ void cfl_iterator_free(CFL_ITERATORP it) {
    }
 }
 
+void cfl_iterator_dispose(CFL_ITERATORP it) {
+   if (it->itClass != NULL && it->itClass->dispose != NULL) {
+      it->itClass->dispose(it);
+   }
+   it->itClass = NULL;
+}
+
 CFL_BOOL cfl_iterator_hasNext(CFL_ITERATORP it) {
    return it->itClass->has_next(it);
 }
@@ -54,6 +112,17 @@ void * cfl_iterator_next(CFL_ITERATORP it) {
    return it->itClass->next(it);
 }
 
+CFL_UINT32 cfl_iterator_nextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   CFL_UINT32 count = 0;
+   if (it->itClass->next_batch != NULL) {
+      return it->itClass->next_batch(it, out, n);
+   }
+   while (count < n && it->itClass->has_next(it)) {
+      out[count++] = it->itClass->next(it);
+   }
+   return count;
+}
+
 void * cfl_iterator_value(CFL_ITERATORP it) {
    if (it->itClass->current_value != NULL) {
       return it->itClass->current_value(it);
@@ -92,3 +161,316 @@ void cfl_iterator_last(CFL_ITERATORP it) {
    }
 }
 
+static void freeSources(CFL_ITERATORP first, CFL_ITERATORP second) {
+   if (first != NULL) {
+      cfl_iterator_free(first);
+   }
+   if (second != NULL) {
+      cfl_iterator_free(second);
+   }
+}
+
+static CFL_ITERATORP adapterNew(const CFL_ITERATOR_CLASS *itClass, CFL_ITERATORP first, CFL_ITERATORP second) {
+   CFL_ITERATORP it;
+   ADAPTER_ITERATORP data;
+
+   if (first == NULL) {
+      freeSources(first, second);
+      return NULL;
+   }
+   it = cfl_iterator_new(sizeof(ADAPTER_ITERATOR));
+   if (it == NULL) {
+      freeSources(first, second);
+      return NULL;
+   }
+   it->itClass = (CFL_ITERATOR_CLASS *) itClass;
+   data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   data->source[0] = first;
+   data->source[1] = second;
+   return it;
+}
+
+static void * adapterValue(CFL_ITERATORP it) {
+   return ((ADAPTER_ITERATORP) cfl_iterator_data(it))->current;
+}
+
+static void adapterFree(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   freeSources(data->source[0], data->source[1]);
+   CFL_MEM_FREE(it);
+}
+
+static CFL_BOOL filterHasNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   while (! data->hasHead[0]) {
+      void *value;
+      if (! cfl_iterator_hasNext(data->source[0])) {
+         return CFL_FALSE;
+      }
+      value = cfl_iterator_next(data->source[0]);
+      if (data->func.filter(value, data->context)) {
+         data->head[0] = value;
+         data->hasHead[0] = CFL_TRUE;
+      }
+   }
+   return CFL_TRUE;
+}
+
+static void * filterNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   if (! filterHasNext(it)) {
+      return NULL;
+   }
+   data->hasHead[0] = CFL_FALSE;
+   data->current = data->head[0];
+   return data->current;
+}
+
+static CFL_UINT32 filterNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   CFL_UINT32 count = 0;
+
+   if (n > 0 && data->hasHead[0]) {
+      out[count++] = data->head[0];
+      data->hasHead[0] = CFL_FALSE;
+   }
+   // The source values are read into the free part of out and the accepted ones are moved to its end
+   while (count < n) {
+      CFL_UINT32 base = count;
+      CFL_UINT32 requested = n - count;
+      CFL_UINT32 read = cfl_iterator_nextBatch(data->source[0], &out[base], requested);
+      CFL_UINT32 i;
+      for (i = 0; i < read; i++) {
+         if (data->func.filter(out[base + i], data->context)) {
+            out[count++] = out[base + i];
+         }
+      }
+      if (read < requested) {
+         break;
+      }
+   }
+   if (count > 0) {
+      data->current = out[count - 1];
+   }
+   return count;
+}
+
+static CFL_BOOL mapHasNext(CFL_ITERATORP it) {
+   return cfl_iterator_hasNext(((ADAPTER_ITERATORP) cfl_iterator_data(it))->source[0]);
+}
+
+static void * mapNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   if (! cfl_iterator_hasNext(data->source[0])) {
+      return NULL;
+   }
+   data->current = data->func.map(cfl_iterator_next(data->source[0]), data->context);
+   return data->current;
+}
+
+static CFL_UINT32 mapNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   CFL_UINT32 count = cfl_iterator_nextBatch(data->source[0], out, n);
+   CFL_UINT32 i;
+
+   for (i = 0; i < count; i++) {
+      out[i] = data->func.map(out[i], data->context);
+   }
+   if (count > 0) {
+      data->current = out[count - 1];
+   }
+   return count;
+}
+
+static CFL_BOOL limitHasNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   return data->count > 0 && cfl_iterator_hasNext(data->source[0]);
+}
+
+static void * limitNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   if (data->count == 0) {
+      return NULL;
+   }
+   data->count--;
+   data->current = cfl_iterator_next(data->source[0]);
+   return data->current;
+}
+
+static CFL_UINT32 limitNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   CFL_UINT32 count = cfl_iterator_nextBatch(data->source[0], out, n < data->count ? n : data->count);
+
+   data->count -= count;
+   if (count > 0) {
+      data->current = out[count - 1];
+   }
+   return count;
+}
+
+static void skipPending(ADAPTER_ITERATORP data) {
+   void *skipped[SKIP_BUFFER_SIZE];
+   while (data->count > 0) {
+      CFL_UINT32 read = cfl_iterator_nextBatch(data->source[0], skipped,
+                                               data->count < SKIP_BUFFER_SIZE ? data->count : SKIP_BUFFER_SIZE);
+      if (read == 0) {
+         data->count = 0;
+      } else {
+         data->count -= read;
+      }
+   }
+}
+
+static CFL_BOOL skipHasNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   skipPending(data);
+   return cfl_iterator_hasNext(data->source[0]);
+}
+
+static void * skipNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   skipPending(data);
+   data->current = cfl_iterator_next(data->source[0]);
+   return data->current;
+}
+
+static CFL_UINT32 skipNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   CFL_UINT32 count;
+
+   skipPending(data);
+   count = cfl_iterator_nextBatch(data->source[0], out, n);
+   if (count > 0) {
+      data->current = out[count - 1];
+   }
+   return count;
+}
+
+static CFL_BOOL concatHasNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   while (data->count < 2) {
+      if (cfl_iterator_hasNext(data->source[data->count])) {
+         return CFL_TRUE;
+      }
+      data->count++;
+   }
+   return CFL_FALSE;
+}
+
+static void * concatNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   if (! concatHasNext(it)) {
+      return NULL;
+   }
+   data->current = cfl_iterator_next(data->source[data->count]);
+   return data->current;
+}
+
+static CFL_UINT32 concatNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   CFL_UINT32 count = 0;
+
+   while (count < n && data->count < 2) {
+      count += cfl_iterator_nextBatch(data->source[data->count], &out[count], n - count);
+      if (count < n) {
+         data->count++;
+      }
+   }
+   if (count > 0) {
+      data->current = out[count - 1];
+   }
+   return count;
+}
+
+static void mergeReadHeads(ADAPTER_ITERATORP data) {
+   int i;
+   for (i = 0; i < 2; i++) {
+      if (! data->hasHead[i] && cfl_iterator_hasNext(data->source[i])) {
+         data->head[i] = cfl_iterator_next(data->source[i]);
+         data->hasHead[i] = CFL_TRUE;
+      }
+   }
+}
+
+static CFL_BOOL mergeHasNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   mergeReadHeads(data);
+   return data->hasHead[0] || data->hasHead[1];
+}
+
+static void * mergeNext(CFL_ITERATORP it) {
+   ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+   int i;
+
+   mergeReadHeads(data);
+   if (data->hasHead[0]) {
+      i = data->hasHead[1] && data->func.compare(data->head[1], data->head[0], data->context) < 0 ? 1 : 0;
+   } else if (data->hasHead[1]) {
+      i = 1;
+   } else {
+      return NULL;
+   }
+   data->hasHead[i] = CFL_FALSE;
+   data->current = data->head[i];
+   return data->current;
+}
+
+CFL_ITERATORP cfl_iterator_filter(CFL_ITERATORP source, CFL_ITERATOR_FILTER_FUNC filter, void *context) {
+   CFL_ITERATORP it = adapterNew(&s_filterIteratorClass, source, NULL);
+   if (it != NULL) {
+      ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+      data->func.filter = filter;
+      data->context = context;
+   }
+   return it;
+}
+
+CFL_ITERATORP cfl_iterator_map(CFL_ITERATORP source, CFL_ITERATOR_MAP_FUNC map, void *context) {
+   CFL_ITERATORP it = adapterNew(&s_mapIteratorClass, source, NULL);
+   if (it != NULL) {
+      ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+      data->func.map = map;
+      data->context = context;
+   }
+   return it;
+}
+
+CFL_ITERATORP cfl_iterator_limit(CFL_ITERATORP source, CFL_UINT32 count) {
+   CFL_ITERATORP it = adapterNew(&s_limitIteratorClass, source, NULL);
+   if (it != NULL) {
+      ((ADAPTER_ITERATORP) cfl_iterator_data(it))->count = count;
+   }
+   return it;
+}
+
+CFL_ITERATORP cfl_iterator_skip(CFL_ITERATORP source, CFL_UINT32 count) {
+   CFL_ITERATORP it = adapterNew(&s_skipIteratorClass, source, NULL);
+   if (it != NULL) {
+      ((ADAPTER_ITERATORP) cfl_iterator_data(it))->count = count;
+   }
+   return it;
+}
+
+CFL_ITERATORP cfl_iterator_concat(CFL_ITERATORP first, CFL_ITERATORP second) {
+   if (second == NULL) {
+      freeSources(first, NULL);
+      return NULL;
+   }
+   return adapterNew(&s_concatIteratorClass, first, second);
+}
+
+CFL_ITERATORP cfl_iterator_merge(CFL_ITERATORP first, CFL_ITERATORP second, CFL_ITERATOR_COMPARE_FUNC compare,
+                                 void *context) {
+   CFL_ITERATORP it;
+   if (second == NULL) {
+      freeSources(first, NULL);
+      return NULL;
+   }
+   it = adapterNew(&s_mergeIteratorClass, first, second);
+   if (it != NULL) {
+      ADAPTER_ITERATORP data = (ADAPTER_ITERATORP) cfl_iterator_data(it);
+      data->func.compare = compare;
+      data->context = context;
+   }
+   return it;
+}
@@ -22,6 +22,41 @@
 #include "cfl_list.h"
 #include "cfl_mem.h"
 
+typedef struct _LIST_KEY_ITEM {
+   CFL_UINT64 key;
+   void *item;
+} LIST_KEY_ITEM;
+
+typedef struct _LIST_ITERATOR {
+   CFL_LISTP list;
+   CFL_UINT32 index;
+} LIST_ITERATOR, *LIST_ITERATORP;
+
+static CFL_BOOL iteratorHasNext(CFL_ITERATORP it);
+static void * iteratorNext(CFL_ITERATORP it);
+static void * iteratorValue(CFL_ITERATORP it);
+static void iteratorRemove(CFL_ITERATORP it);
+static void iteratorFirst(CFL_ITERATORP it);
+static CFL_BOOL iteratorHasPrevious(CFL_ITERATORP it);
+static void * iteratorPrevious(CFL_ITERATORP it);
+static void iteratorLast(CFL_ITERATORP it);
+static CFL_UINT32 iteratorNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n);
+
+static const CFL_ITERATOR_CLASS s_listIteratorClass = {
+   iteratorHasNext,
+   iteratorNext,
+   iteratorValue,
+   iteratorRemove,
+   NULL,
+   iteratorFirst,
+   iteratorHasPrevious,
+   iteratorPrevious,
+   iteratorLast,
+   NULL,
+   NULL,
+   iteratorNextBatch
+};
+
 void cfl_list_init(CFL_LISTP list, CFL_UINT32 capacity) {
    if (list == NULL) {
       return;
@@ -174,6 +209,153 @@ void cfl_list_setLength(CFL_LISTP list, CFL_UINT32 newLen) {
    }
 }
 
+static CFL_BOOL list_setCapacity(CFL_LISTP list, CFL_UINT32 capacity) {
+   void **items;
+   if (list->items != NULL) {
+      items = (void **) CFL_MEM_REALLOC(list->items, (size_t) capacity * sizeof(void *));
+   } else {
+      items = (void **) CFL_MEM_ALLOC((size_t) capacity * sizeof(void *));
+   }
+   if (items == NULL) {
+      return CFL_FALSE;
+   }
+   list->items = items;
+   list->capacity = capacity;
+   return CFL_TRUE;
+}
+
+static CFL_BOOL list_grow(CFL_LISTP list, CFL_UINT32 count) {
+   CFL_UINT32 needed = list->length + count;
+   CFL_UINT32 capacity;
+   if (needed < list->length) {
+      return CFL_FALSE;
+   }
+   if (needed <= list->capacity && list->items != NULL) {
+      return CFL_TRUE;
+   }
+   capacity = ( list->capacity >> 1 ) + 1 + list->length;
+   if (capacity < needed) {
+      capacity = needed;
+   }
+   return list_setCapacity(list, capacity);
+}
+
+CFL_BOOL cfl_list_reserve(CFL_LISTP list, CFL_UINT32 capacity) {
+   if (list == NULL) {
+      return CFL_FALSE;
+   }
+   if (capacity <= list->capacity && (list->items != NULL || capacity == 0)) {
+      return CFL_TRUE;
+   }
+   return list_setCapacity(list, capacity);
+}
+
+void cfl_list_shrinkToFit(CFL_LISTP list) {
+   if (list == NULL) {
+      return;
+   }
+   if (list->length == 0) {
+      if (list->items != NULL) {
+         CFL_MEM_FREE(list->items);
+         list->items = NULL;
+      }
+      list->capacity = 0;
+   } else if (list->length < list->capacity) {
+      list_setCapacity(list, list->length);
+   }
+}
+
+// Returns the index of items if it points into the list, which growing the list may move, or -1 otherwise
+static CFL_INT64 list_indexOf(const CFL_LISTP list, void **items) {
+   if (list->items != NULL && items >= list->items && items < list->items + list->length) {
+      return (CFL_INT64) (items - list->items);
+   }
+   return -1;
+}
+
+CFL_BOOL cfl_list_appendN(CFL_LISTP list, void **items, CFL_UINT32 count) {
+   CFL_INT64 srcIndex;
+   if (list == NULL) {
+      return CFL_FALSE;
+   }
+   srcIndex = list_indexOf(list, items);
+   if (! list_grow(list, count)) {
+      return CFL_FALSE;
+   }
+   if (count > 0) {
+      if (srcIndex >= 0) {
+         items = &list->items[srcIndex];
+      }
+      memcpy(&list->items[list->length], items, (size_t) count * sizeof(void *));
+      list->length += count;
+   }
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_list_addAll(CFL_LISTP list, const CFL_LISTP other) {
+   if (other == NULL) {
+      return list != NULL;
+   }
+   return cfl_list_appendN(list, other->items, other->length);
+}
+
+CFL_BOOL cfl_list_insertRange(CFL_LISTP list, CFL_UINT32 ulIndex, void **items, CFL_UINT32 count) {
+   CFL_INT64 srcIndex;
+   if (list == NULL || ulIndex > list->length) {
+      return CFL_FALSE;
+   }
+   srcIndex = list_indexOf(list, items);
+   if (! list_grow(list, count)) {
+      return CFL_FALSE;
+   }
+   if (count > 0) {
+      memmove(&list->items[ulIndex + count], &list->items[ulIndex], (size_t) (list->length - ulIndex) * sizeof(void *));
+      if (srcIndex >= 0) {
+         // Items from the list at or after the insertion point were moved up by count
+         CFL_UINT32 before = srcIndex < ulIndex ? ulIndex - (CFL_UINT32) srcIndex : 0;
+         if (before > count) {
+            before = count;
+         }
+         memcpy(&list->items[ulIndex], &list->items[srcIndex], (size_t) before * sizeof(void *));
+         memcpy(&list->items[ulIndex + before], &list->items[srcIndex + before + count],
+                (size_t) (count - before) * sizeof(void *));
+      } else {
+         memcpy(&list->items[ulIndex], items, (size_t) count * sizeof(void *));
+      }
+      list->length += count;
+   }
+   return CFL_TRUE;
+}
+
+void cfl_list_deleteRange(CFL_LISTP list, CFL_UINT32 ulIndex, CFL_UINT32 count) {
+   if (list == NULL || ulIndex >= list->length) {
+      return;
+   }
+   if (count > list->length - ulIndex) {
+      count = list->length - ulIndex;
+   }
+   memmove(&list->items[ulIndex], &list->items[ulIndex + count],
+           (size_t) (list->length - ulIndex - count) * sizeof(void *));
+   list->length -= count;
+   memset(&list->items[list->length], 0, (size_t) count * sizeof(void *));
+}
+
+CFL_BOOL cfl_list_resize(CFL_LISTP list, CFL_UINT32 newLen, CFL_BOOL bZeroFill) {
+   if (list == NULL) {
+      return CFL_FALSE;
+   }
+   if (newLen > list->length) {
+      if (! list_grow(list, newLen - list->length)) {
+         return CFL_FALSE;
+      }
+      if (bZeroFill) {
+         memset(&list->items[list->length], 0, (size_t) (newLen - list->length) * sizeof(void *));
+      }
+   }
+   list->length = newLen;
+   return CFL_TRUE;
+}
+
 CFL_LISTP cfl_list_clone(const CFL_LISTP other) {
    CFL_LISTP clone = cfl_list_newLen(other->length);
    if (clone != NULL) {
@@ -181,3 +363,123 @@ CFL_LISTP cfl_list_clone(const CFL_LISTP other) {
    }
    return clone;
 }
+
+void cfl_list_sort(CFL_LISTP list, CFL_SORT_CMP_FUNC cmp) {
+   if (list != NULL) {
+      cfl_sort(list->items, list->length, sizeof(void *), cmp);
+   }
+}
+
+CFL_BOOL cfl_list_sortStable(CFL_LISTP list, CFL_SORT_CMP_FUNC cmp) {
+   if (list == NULL) {
+      return CFL_TRUE;
+   }
+   return cfl_sort_stable(list->items, list->length, sizeof(void *), cmp);
+}
+
+CFL_BOOL cfl_list_sortByKey(CFL_LISTP list, LIST_KEY_FUNC keyFunc) {
+   LIST_KEY_ITEM *keyItems;
+   CFL_UINT32 i;
+
+   if (list == NULL || list->length < 2) {
+      return CFL_TRUE;
+   }
+   // The keys are sorted along with the items, so that each key is computed only once
+   keyItems = (LIST_KEY_ITEM *) CFL_MEM_ALLOC(list->length * sizeof(LIST_KEY_ITEM));
+   if (keyItems == NULL) {
+      return CFL_FALSE;
+   }
+   for (i = 0; i < list->length; i++) {
+      keyItems[i].key = keyFunc(list->items[i]);
+      keyItems[i].item = list->items[i];
+   }
+   if (!cfl_sort_radix(keyItems, list->length, sizeof(LIST_KEY_ITEM), 0, sizeof(CFL_UINT64), CFL_SORT_KEY_UNSIGNED)) {
+      CFL_MEM_FREE(keyItems);
+      return CFL_FALSE;
+   }
+   for (i = 0; i < list->length; i++) {
+      list->items[i] = keyItems[i].item;
+   }
+   CFL_MEM_FREE(keyItems);
+   return CFL_TRUE;
+}
+
+static CFL_BOOL iteratorHasNext(CFL_ITERATORP it) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   return data->index < data->list->length;
+}
+
+static void * iteratorNext(CFL_ITERATORP it) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   if (data->index < data->list->length) {
+      return data->list->items[data->index++];
+   }
+   return NULL;
+}
+
+static void * iteratorValue(CFL_ITERATORP it) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   return data->index > 0 ? cfl_list_get(data->list, data->index - 1) : NULL;
+}
+
+static void iteratorRemove(CFL_ITERATORP it) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   if (data->index > 0 && data->index <= data->list->length) {
+      cfl_list_del(data->list, --(data->index));
+   }
+}
+
+static void iteratorFirst(CFL_ITERATORP it) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   data->index = data->list->length > 0 ? 1 : 0;
+}
+
+static CFL_BOOL iteratorHasPrevious(CFL_ITERATORP it) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   return data->index > 1;
+}
+
+static void * iteratorPrevious(CFL_ITERATORP it) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   if (data->index > 0) {
+      --(data->index);
+   }
+   return data->index > 0 ? cfl_list_get(data->list, data->index - 1) : NULL;
+}
+
+static void iteratorLast(CFL_ITERATORP it) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   data->index = data->list->length;
+}
+
+static CFL_UINT32 iteratorNextBatch(CFL_ITERATORP it, void **out, CFL_UINT32 n) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   CFL_UINT32 count;
+
+   if (data->index >= data->list->length) {
+      return 0;
+   }
+   count = data->list->length - data->index;
+   if (count > n) {
+      count = n;
+   }
+   memcpy(out, &data->list->items[data->index], count * sizeof(void *));
+   data->index += count;
+   return count;
+}
+
+CFL_ITERATORP cfl_list_iterator(CFL_LISTP list) {
+   CFL_ITERATORP it = cfl_iterator_new(sizeof(LIST_ITERATOR));
+   if (it == NULL) {
+      return NULL;
+   }
+   return cfl_list_iteratorInit(it, list);
+}
+
+CFL_ITERATORP cfl_list_iteratorInit(CFL_ITERATORP it, CFL_LISTP list) {
+   LIST_ITERATORP data = (LIST_ITERATORP) cfl_iterator_data(it);
+   it->itClass = (CFL_ITERATOR_CLASS *) &s_listIteratorClass;
+   data->list = list;
+   data->index = 0;
+   return it;
+}
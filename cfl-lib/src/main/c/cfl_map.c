@@ -21,6 +21,7 @@
 #include <stdlib.h>
 
 #include "cfl_map.h"
+#include "cfl_iterator.h"
 #include "cfl_mem.h"
 
 #define GET_KEY(e)         ((void *) (e)->data)
@@ -28,10 +29,43 @@
 #define SET_KEY(m, e, k)   memcpy((e)->data, k, (m)->keySize)
 #define SET_VALUE(m, e, v) memcpy(&((e)->data[(m)->keySize]), v, (m)->valueSize)
 
+#define ENTRY_AT(m, i)     ((CFL_MAP_ENTRYP) &(m)->entries.items[(i) * (m)->entries.ulItemSize])
+
 typedef struct _CFL_MAP_ENTRY {
    char data[1];
 } CFL_MAP_ENTRY, *CFL_MAP_ENTRYP;
 
+typedef struct _MAP_RANGE_ITERATOR {
+   CFL_MAPP   map;
+   CFL_UINT32 startIndex;
+   CFL_UINT32 endIndex;
+   CFL_UINT32 index;
+} MAP_RANGE_ITERATOR, *MAP_RANGE_ITERATORP;
+
+static CFL_BOOL iteratorHasNext(CFL_ITERATORP it);
+static void * iteratorNext(CFL_ITERATORP it);
+static void * iteratorValue(CFL_ITERATORP it);
+static void iteratorRemove(CFL_ITERATORP it);
+static void iteratorFirst(CFL_ITERATORP it);
+static CFL_BOOL iteratorHasPrevious(CFL_ITERATORP it);
+static void * iteratorPrevious(CFL_ITERATORP it);
+static void iteratorLast(CFL_ITERATORP it);
+
+static const CFL_ITERATOR_CLASS s_mapRangeIteratorClass = {
+   iteratorHasNext,
+   iteratorNext,
+   iteratorValue,
+   iteratorRemove,
+   NULL,
+   iteratorFirst,
+   iteratorHasPrevious,
+   iteratorPrevious,
+   iteratorLast,
+   NULL,
+   NULL,
+   NULL
+};
+
 static void freeMapEntries(CFL_MAPP map) {
    CFL_UINT32 len;
    CFL_UINT32 i;
@@ -45,6 +79,147 @@ static void freeMapEntries(CFL_MAPP map) {
    }
 }
 
+/**
+ * Binary search over the sorted entries. Returns the index of the first entry not less than key (or greater than key when
+ * bUpper is set).
+ */
+static CFL_UINT32 searchBound(CFL_MAPP map, const void *key, CFL_BOOL bUpper) {
+   CFL_UINT32 first = 0;
+   CFL_UINT32 last = cfl_array_length(&map->entries);
+   while (first < last) {
+      CFL_UINT32 middle = first + ((last - first) >> 1);
+      int cmp = map->keyCompFunc(GET_KEY(ENTRY_AT(map, middle)), key);
+      if (cmp < 0 || (bUpper && cmp == 0)) {
+         first = middle + 1;
+      } else {
+         last = middle;
+      }
+   }
+   return first;
+}
+
+/**
+ * Returns the index of the entry with the given key or the map length if not found.
+ */
+static CFL_UINT32 findEntry(CFL_MAPP map, const void *key) {
+   CFL_UINT32 len = cfl_array_length(&map->entries);
+   CFL_UINT32 i;
+   if (map->sorted) {
+      i = searchBound(map, key, CFL_FALSE);
+      if (i < len && map->keyCompFunc(GET_KEY(ENTRY_AT(map, i)), key) == 0) {
+         return i;
+      }
+      return len;
+   }
+   for (i = 0; i < len; i++) {
+      if (map->keyCompFunc(GET_KEY(ENTRY_AT(map, i)), key) == 0) {
+         return i;
+      }
+   }
+   return len;
+}
+
+/**
+ * Stable in place insertion sort of the entries by key, used when there is no memory for the merge sort buffer.
+ */
+static void insertionSortEntries(CFL_MAPP map) {
+   CFL_UINT32 len = cfl_array_length(&map->entries);
+   CFL_UINT32 itemSize = map->entries.ulItemSize;
+   CFL_UINT8 *items = map->entries.items;
+   CFL_UINT32 i;
+
+   for (i = 1; i < len; i++) {
+      CFL_UINT32 j;
+      for (j = i; j > 0 && map->keyCompFunc(&items[j * itemSize], &items[(j - 1) * itemSize]) < 0; j--) {
+         CFL_UINT8 *a = &items[(j - 1) * itemSize];
+         CFL_UINT8 *b = &items[j * itemSize];
+         CFL_UINT32 k;
+         for (k = 0; k < itemSize; k++) {
+            CFL_UINT8 tmp = a[k];
+            a[k] = b[k];
+            b[k] = tmp;
+         }
+      }
+   }
+}
+
+/**
+ * Stable bottom-up merge sort of the entries by key, so that entries with equal keys keep their insertion order.
+ */
+static void sortEntries(CFL_MAPP map) {
+   CFL_UINT32 len = cfl_array_length(&map->entries);
+   CFL_UINT32 itemSize = map->entries.ulItemSize;
+   CFL_UINT8 *src = map->entries.items;
+   CFL_UINT8 *dst;
+   CFL_UINT8 *buffer;
+   CFL_UINT32 width;
+
+   if (len < 2) {
+      return;
+   }
+   buffer = (CFL_UINT8 *) CFL_MEM_ALLOC(len * itemSize);
+   if (buffer == NULL) {
+      // The map is searched by halving, so it must be sorted even without memory
+      insertionSortEntries(map);
+      return;
+   }
+   dst = buffer;
+   for (width = 1; width < len; width *= 2) {
+      CFL_UINT32 start;
+      CFL_UINT8 *aux;
+      for (start = 0; start < len; start += 2 * width) {
+         CFL_UINT32 left = start;
+         CFL_UINT32 middle = start + width < len ? start + width : len;
+         CFL_UINT32 end = start + 2 * width < len ? start + 2 * width : len;
+         CFL_UINT32 right = middle;
+         CFL_UINT32 out = start;
+         while (left < middle && right < end) {
+            if (map->keyCompFunc(&src[right * itemSize], &src[left * itemSize]) < 0) {
+               memcpy(&dst[out++ * itemSize], &src[right++ * itemSize], itemSize);
+            } else {
+               memcpy(&dst[out++ * itemSize], &src[left++ * itemSize], itemSize);
+            }
+         }
+         if (left < middle) {
+            memcpy(&dst[out * itemSize], &src[left * itemSize], (middle - left) * itemSize);
+            out += middle - left;
+         }
+         if (right < end) {
+            memcpy(&dst[out * itemSize], &src[right * itemSize], (end - right) * itemSize);
+         }
+      }
+      aux = src;
+      src = dst;
+      dst = aux;
+   }
+   if (src != map->entries.items) {
+      memcpy(map->entries.items, src, len * itemSize);
+   }
+   CFL_MEM_FREE(buffer);
+}
+
+/**
+ * Removes adjacent entries with equal keys from a sorted map keeping the last one of each run.
+ */
+static void removeDuplicates(CFL_MAPP map) {
+   CFL_UINT32 len = cfl_array_length(&map->entries);
+   CFL_UINT32 itemSize = map->entries.ulItemSize;
+   CFL_UINT32 out = 0;
+   CFL_UINT32 i;
+   if (len < 2) {
+      return;
+   }
+   for (i = 1; i < len; i++) {
+      if (map->keyCompFunc(GET_KEY(ENTRY_AT(map, out)), GET_KEY(ENTRY_AT(map, i))) != 0) {
+         ++out;
+      }
+      if (out != i) {
+         memcpy(ENTRY_AT(map, out), ENTRY_AT(map, i), itemSize);
+      }
+   }
+   cfl_array_setLength(&map->entries, out + 1);
+}
+
 /**********************************************************************************************************************************/
 /*                                                            MAP API                                                             */
 /**********************************************************************************************************************************/
@@ -71,9 +246,21 @@ void cfl_map_init(CFL_MAPP map, CFL_UINT32 keySize, CFL_UINT32 valueSize, MAP_CO
    map->valueSize = valueSize;
    map->keyCompFunc = keyCompFunc;
    map->freeEntryFunc = freeEntryFunc;
+   map->sorted = CFL_FALSE;
    map->allocated = CFL_FALSE;
 }
 
+/**
+ *
+ */
+void cfl_map_initSorted(CFL_MAPP map, CFL_UINT32 keySize, CFL_UINT32 valueSize, MAP_COMP_FUNC keyCompFunc, MAP_KEY_VALUE_FUNC freeEntryFunc) {
+   if (map == NULL) {
+      return;
+   }
+   cfl_map_init(map, keySize, valueSize, keyCompFunc, freeEntryFunc);
+   map->sorted = CFL_TRUE;
+}
+
 /**
  *
  */
@@ -86,18 +273,25 @@ CFL_MAPP cfl_map_new(CFL_UINT32 keySize, CFL_UINT32 valueSize, MAP_COMP_FUNC key
    return map;
 }
 
+/**
+ *
+ */
+CFL_MAPP cfl_map_newSorted(CFL_UINT32 keySize, CFL_UINT32 valueSize, MAP_COMP_FUNC keyCompFunc, MAP_KEY_VALUE_FUNC freeEntryFunc) {
+   CFL_MAPP map = CFL_MEM_ALLOC(sizeof(CFL_MAP));
+   if (map != NULL) {
+      cfl_map_initSorted(map, keySize, valueSize, keyCompFunc, freeEntryFunc);
+      map->allocated = CFL_TRUE;
+   }
+   return map;
+}
+
 /**
  *
  */
 const void * cfl_map_get(CFL_MAPP map, const void *key) {
-   CFL_UINT32 len = cfl_array_length(&map->entries);
-   CFL_UINT32 i;
-   for (i = 0; i < len; i++) {
-      CFL_MAP_ENTRYP entry = (CFL_MAP_ENTRYP) cfl_array_get(&map->entries, i);
-      void *value = GET_VALUE(map, entry);
-      if (map->keyCompFunc(GET_KEY(entry), key) == 0) {
-         return value;
-      }
+   CFL_UINT32 i = findEntry(map, key);
+   if (i < cfl_array_length(&map->entries)) {
+      return GET_VALUE(map, ENTRY_AT(map, i));
    }
    return NULL;
 }
@@ -109,22 +303,25 @@ const void *cfl_map_getIndex(CFL_MAPP map, CFL_UINT32 index) {
    return NULL;
 }
 
+const void *cfl_map_getKeyIndex(CFL_MAPP map, CFL_UINT32 index) {
+   if (index < cfl_array_length(&map->entries)) {
+      return GET_KEY((CFL_MAP_ENTRYP) cfl_array_get(&map->entries, index));
+   }
+   return NULL;
+}
+
 /**
  *
  */
 CFL_BOOL cfl_map_del(CFL_MAPP map, const void *key) {
-   CFL_UINT32 len = cfl_array_length(&map->entries);
-   CFL_UINT32 i;
-   for (i = 0; i < len; i++) {
-      CFL_MAP_ENTRYP entry = (CFL_MAP_ENTRYP) cfl_array_get(&map->entries, i);
-      void *entryKey = GET_KEY(entry);
-      if (map->keyCompFunc(entryKey, key) == 0) {
-         if (map->freeEntryFunc != NULL) {
-            map->freeEntryFunc(entryKey, key);
-         }
-         cfl_array_del(&map->entries, i);
-         return CFL_TRUE;
+   CFL_UINT32 i = findEntry(map, key);
+   if (i < cfl_array_length(&map->entries)) {
+      void *entryKey = GET_KEY(ENTRY_AT(map, i));
+      if (map->freeEntryFunc != NULL) {
+         map->freeEntryFunc(entryKey, key);
       }
+      cfl_array_del(&map->entries, i);
+      return CFL_TRUE;
    }
    return CFL_FALSE;
 }
@@ -136,6 +333,17 @@ void cfl_map_set(CFL_MAPP map, const void *newKey, const void *newValue) {
    CFL_MAP_ENTRYP entry;
    CFL_UINT32 len = cfl_array_length(&map->entries);
    CFL_UINT32 i;
+   if (map->sorted) {
+      i = searchBound(map, newKey, CFL_FALSE);
+      if (i < len && map->keyCompFunc(GET_KEY(ENTRY_AT(map, i)), newKey) == 0) {
+         entry = ENTRY_AT(map, i);
+      } else {
+         entry = (CFL_MAP_ENTRYP) cfl_array_insert(&map->entries, i);
+         SET_KEY(map, entry, newKey);
+      }
+      SET_VALUE(map, entry, newValue);
+      return;
+   }
    for (i = 0; i < len; i++) {
       void *key;
       entry = (CFL_MAP_ENTRYP) cfl_array_get(&map->entries, i);
@@ -167,6 +375,76 @@ void cfl_map_copy(CFL_MAPP toMap, CFL_MAPP fromMap) {
       SET_KEY(toMap, toEntry, GET_KEY(fromEntry));
       SET_VALUE(toMap, toEntry, GET_VALUE(fromMap, fromEntry));
    }
+   if (toMap->sorted && ! (fromMap->sorted && fromMap->keyCompFunc == toMap->keyCompFunc)) {
+      sortEntries(toMap);
+   }
+}
+
+/**
+ *
+ */
+CFL_BOOL cfl_map_setAll(CFL_MAPP map, const void *keys, const void *values, CFL_UINT32 count) {
+   const CFL_UINT8 *key = (const CFL_UINT8 *) keys;
+   const CFL_UINT8 *value = (const CFL_UINT8 *) values;
+   CFL_UINT32 i;
+   if (! map->sorted) {
+      for (i = 0; i < count; i++) {
+         cfl_map_set(map, &key[i * map->keySize], &value[i * map->valueSize]);
+      }
+      return CFL_TRUE;
+   }
+   if (count == 0) {
+      return CFL_TRUE;
+   }
+   i = cfl_array_length(&map->entries);
+   if (! cfl_array_resize(&map->entries, i + count, CFL_FALSE)) {
+      return CFL_FALSE;
+   }
+   for (; count > 0; count--, i++) {
+      CFL_MAP_ENTRYP entry = ENTRY_AT(map, i);
+      SET_KEY(map, entry, key);
+      SET_VALUE(map, entry, value);
+      key += map->keySize;
+      value += map->valueSize;
+   }
+   sortEntries(map);
+   removeDuplicates(map);
+   return CFL_TRUE;
+}
+
+/**
+ *
+ */
+CFL_UINT32 cfl_map_lowerBound(CFL_MAPP map, const void *key) {
+   return searchBound(map, key, CFL_FALSE);
+}
+
+/**
+ *
+ */
+CFL_UINT32 cfl_map_upperBound(CFL_MAPP map, const void *key) {
+   return searchBound(map, key, CFL_TRUE);
+}
+
+/**
+ *
+ */
+CFL_ITERATORP cfl_map_iteratorRange(CFL_MAPP map, const void *fromKey, const void *toKey) {
+   CFL_ITERATORP it = cfl_iterator_new(sizeof(MAP_RANGE_ITERATOR));
+   MAP_RANGE_ITERATORP data;
+   if (it == NULL) {
+      return NULL;
+   }
+   data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   it->itClass = (CFL_ITERATOR_CLASS *) &s_mapRangeIteratorClass;
+   data->map = map;
+   data->startIndex = fromKey != NULL ? searchBound(map, fromKey, CFL_FALSE) : 0;
+   data->endIndex = toKey != NULL ? searchBound(map, toKey, CFL_TRUE) : cfl_array_length(&map->entries);
+   if (data->endIndex < data->startIndex) {
+      data->endIndex = data->startIndex;
+   }
+   data->index = data->startIndex;
+   return it;
 }
 
 /**
@@ -176,3 +454,63 @@ CFL_UINT32 cfl_map_length(CFL_MAPP map) {
    return cfl_array_length(&map->entries);
 }
 
+static CFL_BOOL iteratorHasNext(CFL_ITERATORP it) {
+   MAP_RANGE_ITERATORP data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   return data->index < data->endIndex;
+}
+
+static void * iteratorNext(CFL_ITERATORP it) {
+   MAP_RANGE_ITERATORP data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   if (data->index < data->endIndex) {
+      return GET_VALUE(data->map, ENTRY_AT(data->map, (data->index)++));
+   }
+   return NULL;
+}
+
+static void * iteratorValue(CFL_ITERATORP it) {
+   MAP_RANGE_ITERATORP data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   if (data->index > data->startIndex) {
+      return GET_VALUE(data->map, ENTRY_AT(data->map, data->index - 1));
+   }
+   return NULL;
+}
+
+static void iteratorRemove(CFL_ITERATORP it) {
+   MAP_RANGE_ITERATORP data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   if (data->index > data->startIndex) {
+      CFL_MAPP map = data->map;
+      CFL_MAP_ENTRYP entry = ENTRY_AT(map, data->index - 1);
+      if (map->freeEntryFunc != NULL) {
+         map->freeEntryFunc(GET_KEY(entry), GET_VALUE(map, entry));
+      }
+      cfl_array_del(&map->entries, data->index - 1);
+      --(data->index);
+      --(data->endIndex);
+   }
+}
+
+static void iteratorFirst(CFL_ITERATORP it) {
+   MAP_RANGE_ITERATORP data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   data->index = data->startIndex;
+}
+
+static CFL_BOOL iteratorHasPrevious(CFL_ITERATORP it) {
+   MAP_RANGE_ITERATORP data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   return data->index > data->startIndex + 1;
+}
+
+static void * iteratorPrevious(CFL_ITERATORP it) {
+   MAP_RANGE_ITERATORP data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   if (data->index > data->startIndex) {
+      --(data->index);
+   }
+   if (data->index > data->startIndex) {
+      return GET_VALUE(data->map, ENTRY_AT(data->map, data->index - 1));
+   }
+   return NULL;
+}
+
+static void iteratorLast(CFL_ITERATORP it) {
+   MAP_RANGE_ITERATORP data = (MAP_RANGE_ITERATORP) cfl_iterator_data(it);
+   data->index = data->endIndex;
+}
@@ -1,8 +1,11 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "cfl_map_str.h"
 #include "cfl_mem.h"
 
+#define PACKED_COMPACT_MIN_WASTE 256
+
 /**********************************************************************************************************************************/
 /*                                                       MAPSTR_ENTRY API                                                         */
 /**********************************************************************************************************************************/
@@ -16,6 +19,9 @@ static void map_entry_init(CFL_MAPSTR_ENTRYP entry) {
    }
    cfl_str_init(&entry->key);
    cfl_str_init(&entry->value);
+   entry->packed = NULL;
+   entry->keyOffset = 0;
+   entry->valueOffset = 0;
    entry->allocated = CFL_FALSE;
 }
 
@@ -33,11 +39,17 @@ static void map_entry_free(CFL_MAPSTR_ENTRYP entry) {
    }
 }
 
+static void setPackedString(CFL_MAPSTRP map, CFL_STRP str, CFL_UINT32 *offset, const char *buffer, CFL_UINT32 len);
+
 /**
  * 
  */
 void cfl_mapstr_entry_setKey(CFL_MAPSTR_ENTRYP entry, const char *key) {
-   cfl_str_setValue(&entry->key, key);
+   if (entry->packed != NULL) {
+      setPackedString(entry->packed, &entry->key, &entry->keyOffset, key, key != NULL ? (CFL_UINT32) strlen(key) : 0);
+   } else {
+      cfl_str_setValue(&entry->key, key);
+   }
 }
 
 /**
@@ -58,7 +70,11 @@ CFL_STRP cfl_mapstr_entry_getKeyStr(CFL_MAPSTR_ENTRYP entry) {
  * 
  */
 void cfl_mapstr_entry_setValue(CFL_MAPSTR_ENTRYP entry, const char *value) {
-   cfl_str_setValue(&entry->value, value);
+   if (entry->packed != NULL) {
+      setPackedString(entry->packed, &entry->value, &entry->valueOffset, value, value != NULL ? (CFL_UINT32) strlen(value) : 0);
+   } else {
+      cfl_str_setValue(&entry->value, value);
+   }
 }
 
 /**
@@ -83,6 +99,152 @@ static void freeMapEntries(CFL_ARRAYP entries) {
    }
 }
 
+/**********************************************************************************************************************************/
+/*                                                         PACKED ARENA                                                           */
+/**********************************************************************************************************************************/
+
+/**
+ * Strings of a packed map are constant views over the arena. A string that was changed directly through its CFL_STRP owns its
+ * own buffer or points to a constant, so it is part of the arena only while it still points to the bytes at its offset.
+ */
+static CFL_BOOL isArenaView(const char *arena, CFL_STRP str, CFL_UINT32 offset) {
+   return arena != NULL && ! str->isVarData && str->data == &arena[offset];
+}
+
+static CFL_BOOL isArenaString(CFL_MAPSTRP map, CFL_STRP str, CFL_UINT32 offset) {
+   return map->packed && isArenaView(map->arena, str, offset);
+}
+
+static void setArenaView(CFL_MAPSTRP map, CFL_STRP str, CFL_UINT32 offset, CFL_UINT32 len) {
+   str->data = &map->arena[offset];
+   str->length = len;
+   str->dataSize = 0;
+   str->hashValue = 0;
+   str->isVarData = CFL_FALSE;
+}
+
+/**
+ * Points the entry strings that were views over oldArena to the same offsets of the map arena. The old arena must still be
+ * allocated, so that the views are recognized by their addresses.
+ */
+static void rebaseEntries(CFL_MAPSTRP map, const char *oldArena) {
+   CFL_UINT32 len = cfl_array_length(&map->entries);
+   CFL_UINT32 i;
+   for (i = 0; i < len; i++) {
+      CFL_MAPSTR_ENTRYP entry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&map->entries, i);
+      if (isArenaView(oldArena, &entry->key, entry->keyOffset)) {
+         entry->key.data = &map->arena[entry->keyOffset];
+      }
+      if (isArenaView(oldArena, &entry->value, entry->valueOffset)) {
+         entry->value.data = &map->arena[entry->valueOffset];
+      }
+      entry->packed = map;
+   }
+}
+
+static CFL_BOOL arenaReserve(CFL_MAPSTRP map, CFL_UINT32 len) {
+   CFL_UINT32 newLen = map->arenaLength + len;
+   if (newLen > map->arenaCapacity) {
+      CFL_UINT32 newCapacity = (map->arenaCapacity >> 1) + 1 + newLen;
+      char *oldArena = map->arena;
+      /* Not reallocated in place: the old arena is needed to recognize the strings that still view it */
+      char *newArena = (char *) CFL_MEM_ALLOC(newCapacity);
+      if (newArena == NULL) {
+         return CFL_FALSE;
+      }
+      if (map->arenaLength > 0) {
+         memcpy(newArena, oldArena, map->arenaLength);
+      }
+      map->arena = newArena;
+      map->arenaCapacity = newCapacity;
+      if (oldArena != NULL) {
+         rebaseEntries(map, oldArena);
+         CFL_MEM_FREE(oldArena);
+      }
+   }
+   return CFL_TRUE;
+}
+
+/**
+ * Appends a null terminated copy of buffer to the arena and returns its offset.
+ */
+static CFL_BOOL arenaAppend(CFL_MAPSTRP map, const char *buffer, CFL_UINT32 len, CFL_UINT32 *offset) {
+   /* The source may be a string of this same map, so it must survive an arena reallocation */
+   if (map->arena != NULL && buffer >= map->arena && buffer < map->arena + map->arenaLength) {
+      CFL_UINT32 srcOffset = (CFL_UINT32) (buffer - map->arena);
+      if (! arenaReserve(map, len + 1)) {
+         return CFL_FALSE;
+      }
+      buffer = &map->arena[srcOffset];
+   } else if (! arenaReserve(map, len + 1)) {
+      return CFL_FALSE;
+   }
+   *offset = map->arenaLength;
+   if (len > 0) {
+      memcpy(&map->arena[map->arenaLength], buffer, len);
+   }
+   map->arena[map->arenaLength + len] = '\0';
+   map->arenaLength += len + 1;
+   return CFL_TRUE;
+}
+
+static void setPackedString(CFL_MAPSTRP map, CFL_STRP str, CFL_UINT32 *offset, const char *buffer, CFL_UINT32 len) {
+   CFL_BOOL inArena = isArenaString(map, str, *offset);
+   if (buffer == NULL) {
+      buffer = "";
+      len = 0;
+   }
+   if (inArena && len <= str->length) {
+      /* Overwrite in place, the remaining bytes are lost until the next compaction */
+      memmove(&map->arena[*offset], buffer, len);
+      map->arena[*offset + len] = '\0';
+      map->arenaWaste += str->length - len;
+      setArenaView(map, str, *offset, len);
+   } else if (arenaAppend(map, buffer, len, offset)) {
+      if (inArena) {
+         map->arenaWaste += str->length + 1;
+      } else {
+         cfl_str_free(str);
+      }
+      setArenaView(map, str, *offset, len);
+   }
+}
+
+static void setEntryValue(CFL_MAPSTRP map, CFL_MAPSTR_ENTRYP entry, const char *buffer, CFL_UINT32 len) {
+   if (map->packed) {
+      setPackedString(map, &entry->value, &entry->valueOffset, buffer, len);
+   } else {
+      cfl_str_setValueLen(&entry->value, buffer, len);
+   }
+}
+
+static void addEntry(CFL_MAPSTRP map, const char *key, CFL_UINT32 keyLen, const char *value, CFL_UINT32 valueLen) {
+   CFL_MAPSTR_ENTRYP entry = (CFL_MAPSTR_ENTRYP) cfl_array_add(&map->entries);
+   map_entry_init(entry);
+   if (map->packed) {
+      entry->packed = map;
+      if (arenaAppend(map, key != NULL ? key : "", keyLen, &entry->keyOffset)) {
+         setArenaView(map, &entry->key, entry->keyOffset, keyLen);
+      }
+      if (arenaAppend(map, value != NULL ? value : "", valueLen, &entry->valueOffset)) {
+         setArenaView(map, &entry->value, entry->valueOffset, valueLen);
+      }
+   } else {
+      cfl_str_setValueLen(&entry->key, key, keyLen);
+      cfl_str_setValueLen(&entry->value, value, valueLen);
+   }
+}
+
+static void releaseEntryStrings(CFL_MAPSTRP map, CFL_MAPSTR_ENTRYP entry) {
+   if (isArenaString(map, &entry->key, entry->keyOffset)) {
+      map->arenaWaste += entry->key.length + 1;
+   }
+   if (isArenaString(map, &entry->value, entry->valueOffset)) {
+      map->arenaWaste += entry->value.length + 1;
+   }
+   map_entry_free(entry);
+}
+
 /**********************************************************************************************************************************/
 /*                                                          MAPSTR API                                                            */
 /**********************************************************************************************************************************/
@@ -92,6 +254,9 @@ void cfl_mapstr_free(CFL_MAPSTRP map) {
    }
    freeMapEntries(&map->entries);
    cfl_array_free(&map->entries);
+   if (map->arena != NULL) {
+      CFL_MEM_FREE(map->arena);
+   }
    if (map->allocated) {
       CFL_MEM_FREE(map);
    }
@@ -105,9 +270,31 @@ void cfl_mapstr_init(CFL_MAPSTRP map) {
       return;
    }
    cfl_array_init(&map->entries, 16, sizeof(CFL_MAPSTR_ENTRY));
+   map->arena = NULL;
+   map->arenaLength = 0;
+   map->arenaCapacity = 0;
+   map->arenaWaste = 0;
+   map->packed = CFL_FALSE;
    map->allocated = CFL_FALSE;
 }
 
+/**
+ * 
+ */
+void cfl_mapstr_initPacked(CFL_MAPSTRP map, CFL_UINT32 arenaCapacity) {
+   if (map == NULL) {
+      return;
+   }
+   cfl_mapstr_init(map);
+   map->packed = CFL_TRUE;
+   if (arenaCapacity > 0) {
+      map->arena = (char *) CFL_MEM_ALLOC(arenaCapacity);
+      if (map->arena != NULL) {
+         map->arenaCapacity = arenaCapacity;
+      }
+   }
+}
+
 /**
  * 
  */
@@ -120,6 +307,73 @@ CFL_MAPSTRP cfl_mapstr_new(void) {
    return map;
 }
 
+/**
+ * 
+ */
+CFL_MAPSTRP cfl_mapstr_newPacked(CFL_UINT32 arenaCapacity) {
+   CFL_MAPSTRP map = CFL_MEM_ALLOC(sizeof(CFL_MAPSTR));
+   if (map != NULL) {
+      cfl_mapstr_initPacked(map, arenaCapacity);
+      map->allocated = CFL_TRUE;
+   }
+   return map;
+}
+
+/**
+ * 
+ */
+CFL_BOOL cfl_mapstr_isPacked(CFL_MAPSTRP map) {
+   return map->packed;
+}
+
+/**
+ * 
+ */
+void cfl_mapstr_compact(CFL_MAPSTRP map) {
+   CFL_UINT32 len;
+   CFL_UINT32 used = 0;
+   CFL_UINT32 i;
+   char *newArena;
+
+   if (! map->packed || map->arenaWaste == 0) {
+      return;
+   }
+   len = cfl_array_length(&map->entries);
+   for (i = 0; i < len; i++) {
+      CFL_MAPSTR_ENTRYP entry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&map->entries, i);
+      if (isArenaString(map, &entry->key, entry->keyOffset)) {
+         used += entry->key.length + 1;
+      }
+      if (isArenaString(map, &entry->value, entry->valueOffset)) {
+         used += entry->value.length + 1;
+      }
+   }
+   newArena = (char *) CFL_MEM_ALLOC(used > 0 ? used : 1);
+   if (newArena == NULL) {
+      return;
+   }
+   used = 0;
+   for (i = 0; i < len; i++) {
+      CFL_MAPSTR_ENTRYP entry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&map->entries, i);
+      if (isArenaString(map, &entry->key, entry->keyOffset)) {
+         memcpy(&newArena[used], &map->arena[entry->keyOffset], entry->key.length + 1);
+         entry->key.data = &newArena[used];
+         entry->keyOffset = used;
+         used += entry->key.length + 1;
+      }
+      if (isArenaString(map, &entry->value, entry->valueOffset)) {
+         memcpy(&newArena[used], &map->arena[entry->valueOffset], entry->value.length + 1);
+         entry->value.data = &newArena[used];
+         entry->valueOffset = used;
+         used += entry->value.length + 1;
+      }
+   }
+   CFL_MEM_FREE(map->arena);
+   map->arena = newArena;
+   map->arenaLength = used;
+   map->arenaCapacity = used > 0 ? used : 1;
+   map->arenaWaste = 0;
+}
 
 /**
  * 
@@ -211,8 +465,11 @@ CFL_BOOL cfl_mapstr_del(CFL_MAPSTRP map, const char *key) {
    for (i = 0; i < len; i++) {
       CFL_MAPSTR_ENTRYP entry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&map->entries, i);
       if (cfl_str_bufferEquals(&entry->key, key)) {
-         map_entry_free(entry);
+         releaseEntryStrings(map, entry);
          cfl_array_del(&map->entries, i);
+         if (map->arenaWaste >= PACKED_COMPACT_MIN_WASTE && map->arenaWaste > (map->arenaLength >> 1)) {
+            cfl_mapstr_compact(map);
+         }
          return CFL_TRUE;
       }
    }
@@ -225,18 +482,16 @@ CFL_BOOL cfl_mapstr_del(CFL_MAPSTRP map, const char *key) {
 void cfl_mapstr_set(CFL_MAPSTRP map, const char *key, const char *value) {
    CFL_MAPSTR_ENTRYP entry;
    CFL_UINT32 len = cfl_array_length(&map->entries);
+   CFL_UINT32 valueLen = value != NULL ? (CFL_UINT32) strlen(value) : 0;
    CFL_UINT32 i;
    for (i = 0; i < len; i++) {
       entry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&map->entries, i);
       if (cfl_str_bufferEquals(&entry->key, key)) {
-         cfl_str_setValue(&entry->value, value);
+         setEntryValue(map, entry, value, valueLen);
          return;
       }
    }
-   entry = (CFL_MAPSTR_ENTRYP) cfl_array_add(&map->entries);
-   map_entry_init(entry);
-   cfl_str_setValue(&entry->key, key);
-   cfl_str_setValue(&entry->value, value);
+   addEntry(map, key, key != NULL ? (CFL_UINT32) strlen(key) : 0, value, valueLen);
 }
 
 void cfl_mapstr_setStr(CFL_MAPSTRP map, CFL_STRP key, CFL_STRP value) {
@@ -246,14 +501,11 @@ void cfl_mapstr_setStr(CFL_MAPSTRP map, CFL_STRP key, CFL_STRP value) {
    for (i = 0; i < len; i++) {
       entry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&map->entries, i);
       if (cfl_str_equals(&entry->key, key)) {
-         cfl_str_setStr(&entry->value, value);
+         setEntryValue(map, entry, value != NULL ? value->data : NULL, value != NULL ? value->length : 0);
          return;
       }
    }
-   entry = (CFL_MAPSTR_ENTRYP) cfl_array_add(&map->entries);
-   map_entry_init(entry);
-   cfl_str_setStr(&entry->key, key);
-   cfl_str_setStr(&entry->value, value);
+   addEntry(map, key->data, key->length, value != NULL ? value->data : NULL, value != NULL ? value->length : 0);
 }
 
 /**
@@ -267,6 +519,16 @@ void cfl_mapstr_setFormat(CFL_MAPSTRP map, const char *key, const char *format,
 
    va_start(varArgs, format);
 
+   if (map->packed) {
+      CFL_STR value;
+      cfl_str_init(&value);
+      cfl_str_setFormatArgs(&value, format, varArgs);
+      va_end(varArgs);
+      cfl_mapstr_set(map, key, cfl_str_getPtr(&value));
+      cfl_str_free(&value);
+      return;
+   }
+
    for (i = 0; i < len; i++) {
       entry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&map->entries, i);
       if (cfl_str_bufferEquals(&entry->key, key)) {
@@ -285,15 +547,53 @@ void cfl_mapstr_setFormat(CFL_MAPSTRP map, const char *key, const char *format,
 /**
  * 
  */
+static CFL_BOOL copyPackedArena(CFL_MAPSTRP toMap, CFL_MAPSTRP fromMap) {
+   CFL_UINT32 len = cfl_array_length(&fromMap->entries);
+   CFL_UINT32 i;
+   char *arena;
+
+   for (i = 0; i < len; i++) {
+      CFL_MAPSTR_ENTRYP entry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&fromMap->entries, i);
+      if (entry->key.isVarData || entry->value.isVarData) {
+         return CFL_FALSE;
+      }
+   }
+   arena = (char *) CFL_MEM_ALLOC(fromMap->arenaLength > 0 ? fromMap->arenaLength : 1);
+   if (arena == NULL) {
+      return CFL_FALSE;
+   }
+   memcpy(arena, fromMap->arena, fromMap->arenaLength);
+   if (toMap->arena != NULL) {
+      CFL_MEM_FREE(toMap->arena);
+   }
+   toMap->arena = arena;
+   toMap->arenaLength = fromMap->arenaLength;
+   toMap->arenaCapacity = fromMap->arenaLength > 0 ? fromMap->arenaLength : 1;
+   toMap->arenaWaste = fromMap->arenaWaste;
+   cfl_array_setLength(&toMap->entries, len);
+   memcpy(toMap->entries.items, fromMap->entries.items, len * sizeof(CFL_MAPSTR_ENTRY));
+   rebaseEntries(toMap, fromMap->arena);
+   return CFL_TRUE;
+}
+
 void cfl_mapstr_copy(CFL_MAPSTRP toMap, CFL_MAPSTRP fromMap) {
    CFL_UINT32 len = cfl_array_length(&fromMap->entries);
    CFL_UINT32 i;
+   /* Packed to empty packed map: the whole arena and entry table are copied in one step */
+   if (toMap->packed && fromMap->packed && cfl_array_length(&toMap->entries) == 0 && copyPackedArena(toMap, fromMap)) {
+      return;
+   }
+   if (toMap->packed) {
+      CFL_UINT32 total = 0;
+      for (i = 0; i < len; i++) {
+         CFL_MAPSTR_ENTRYP fromEntry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&fromMap->entries, i);
+         total += fromEntry->key.length + fromEntry->value.length + 2;
+      }
+      arenaReserve(toMap, total);
+   }
    for (i = 0; i < len; i++) {
       CFL_MAPSTR_ENTRYP fromEntry = (CFL_MAPSTR_ENTRYP) cfl_array_get(&fromMap->entries, i);
-      CFL_MAPSTR_ENTRYP toEntry = (CFL_MAPSTR_ENTRYP) cfl_array_add(&toMap->entries);
-      map_entry_init(toEntry);
-      cfl_str_setStr(&toEntry->key, &fromEntry->key);
-      cfl_str_setStr(&toEntry->value, &fromEntry->value);
+      addEntry(toMap, fromEntry->key.data, fromEntry->key.length, fromEntry->value.data, fromEntry->value.length);
    }
 }
 
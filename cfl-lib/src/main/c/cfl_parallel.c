@@ -0,0 +1,560 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "cfl_parallel.h"
+#include "cfl_atomic.h"
+#include "cfl_mem.h"
+
+#if ! defined(CFL_OS_WINDOWS)
+   #include <unistd.h>
+#endif
+
+// chunks created per thread, so that threads finishing early can take more work
+#define CHUNKS_PER_THREAD 4
+
+// smallest run sorted by a single thread
+#define SORT_MIN_RUN      2048
+
+typedef void (*PARALLEL_TASK_FUNC)(CFL_UINT32 task, void *context);
+
+/*
+ * A job is published in pool->job and its tasks are taken by the calling thread and the workers through the atomic
+ * nextTask counter. Workers register in activeWorkers under the pool lock before touching the job, and the calling
+ * thread only returns (releasing the job, which lives in its stack) when no worker is left inside it.
+ */
+typedef struct _CFL_PARALLEL_JOB {
+   PARALLEL_TASK_FUNC task;
+   void              *context;
+   CFL_INT32          taskCount;
+   CFL_INT32          nextTask;
+   CFL_UINT32         activeWorkers;
+} PARALLEL_JOB;
+
+typedef struct {
+   CFL_UINT32              count;
+   CFL_UINT32              chunks;
+   CFL_PARALLEL_RANGE_FUNC func;
+   void                   *context;
+} RANGE_CONTEXT;
+
+typedef struct {
+   CFL_PARALLEL_ITEM_FUNC func;
+   void                  *context;
+   CFL_UINT8             *items;
+   CFL_UINT32             itemSize;
+} ITEM_CONTEXT;
+
+typedef struct {
+   CFL_UINT32               count;
+   CFL_UINT32               chunks;
+   CFL_UINT8               *partials;
+   CFL_UINT32               resultSize;
+   CFL_PARALLEL_REDUCE_FUNC func;
+   void                    *context;
+} REDUCE_CONTEXT;
+
+typedef struct {
+   CFL_PARALLEL_ACCUM_FUNC   func;
+   CFL_PARALLEL_COMBINE_FUNC combine;
+   void                     *context;
+   CFL_UINT8                *items;
+   CFL_UINT32                itemSize;
+   CFL_BOOL                  isList;
+} ACCUM_CONTEXT;
+
+typedef struct {
+   CFL_UINT8        *src;
+   CFL_UINT8        *dest;
+   CFL_UINT32        count;
+   CFL_UINT32        itemSize;
+   CFL_UINT32        runs;
+   CFL_UINT32        runWidth;
+   CFL_UINT32        pieces;
+   CFL_SORT_CMP_FUNC cmp;
+} SORT_JOB;
+
+static CFL_PARALLELP s_sharedPool = NULL;
+
+static void parallel_execute(PARALLEL_JOB *job) {
+   CFL_INT32 task;
+   while ((task = cfl_atomic_addInt32(&job->nextTask, 1)) < job->taskCount) {
+      job->task((CFL_UINT32) task, job->context);
+   }
+}
+
+static void parallel_worker(void *param) {
+   CFL_PARALLELP pool = (CFL_PARALLELP) param;
+   CFL_UINT32 seenGeneration = 0;
+
+   cfl_lock_acquire(&pool->lock);
+   for (;;) {
+      PARALLEL_JOB *job;
+      while (! pool->stop && (pool->job == NULL || pool->generation == seenGeneration)) {
+         cfl_lock_conditionWait(&pool->lock, &pool->jobReady);
+      }
+      if (pool->stop) {
+         break;
+      }
+      seenGeneration = pool->generation;
+      job = pool->job;
+      ++job->activeWorkers;
+      cfl_lock_release(&pool->lock);
+
+      parallel_execute(job);
+
+      cfl_lock_acquire(&pool->lock);
+      if (--job->activeWorkers == 0) {
+         cfl_lock_conditionWake(&pool->jobDone);
+      }
+   }
+   cfl_lock_release(&pool->lock);
+}
+
+static void parallel_run(CFL_PARALLELP pool, CFL_UINT32 taskCount, PARALLEL_TASK_FUNC task, void *context) {
+   PARALLEL_JOB job;
+
+   job.task = task;
+   job.context = context;
+   job.taskCount = (CFL_INT32) taskCount;
+   job.nextTask = 0;
+   job.activeWorkers = 0;
+   // a busy pool (another thread's job or a nested call from a task) runs the job on this thread
+   if (taskCount <= 1 || pool->workerCount == 0 || ! cfl_lock_tryAcquire(&pool->runLock)) {
+      parallel_execute(&job);
+      return;
+   }
+   cfl_lock_acquire(&pool->lock);
+   pool->job = &job;
+   ++pool->generation;
+   cfl_lock_conditionWakeAll(&pool->jobReady);
+   cfl_lock_release(&pool->lock);
+
+   parallel_execute(&job);
+
+   cfl_lock_acquire(&pool->lock);
+   while (job.activeWorkers > 0) {
+      cfl_lock_conditionWait(&pool->lock, &pool->jobDone);
+   }
+   pool->job = NULL;
+   cfl_lock_release(&pool->lock);
+   cfl_lock_release(&pool->runLock);
+}
+
+static CFL_PARALLELP parallel_pool(CFL_PARALLELP pool) {
+   return pool != NULL ? pool : cfl_parallel_shared();
+}
+
+static CFL_UINT32 parallel_chunks(CFL_PARALLELP pool, CFL_UINT32 count) {
+   CFL_UINT32 chunks;
+   if (pool == NULL || pool->workerCount == 0) {
+      return count > 0 ? 1 : 0;
+   }
+   chunks = (pool->workerCount + 1) * CHUNKS_PER_THREAD;
+   return count < chunks ? count : chunks;
+}
+
+#define CHUNK_START(count, chunks, i) ((CFL_UINT32) (((CFL_UINT64) (count) * (i)) / (chunks)))
+
+CFL_UINT32 cfl_parallel_cpuCount(void) {
+#if defined(CFL_OS_WINDOWS)
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return info.dwNumberOfProcessors > 0 ? (CFL_UINT32) info.dwNumberOfProcessors : 1;
+#else
+   long count = sysconf(_SC_NPROCESSORS_ONLN);
+   return count > 0 ? (CFL_UINT32) count : 1;
+#endif
+}
+
+CFL_PARALLELP cfl_parallel_new(CFL_UINT32 threads) {
+   CFL_PARALLELP pool;
+   CFL_UINT32 i;
+
+   if (threads == 0) {
+      threads = cfl_parallel_cpuCount();
+   }
+   pool = (CFL_PARALLELP) CFL_MEM_ALLOC(sizeof(CFL_PARALLEL));
+   if (pool == NULL) {
+      return NULL;
+   }
+   memset(pool, 0, sizeof(CFL_PARALLEL));
+   if (threads > 1) {
+      pool->workers = (CFL_THREADP *) CFL_MEM_ALLOC(sizeof(CFL_THREADP) * (threads - 1));
+      if (pool->workers == NULL) {
+         CFL_MEM_FREE(pool);
+         return NULL;
+      }
+   }
+   cfl_lock_init(&pool->lock);
+   cfl_lock_init(&pool->runLock);
+   cfl_lock_initConditionVar(&pool->jobReady);
+   cfl_lock_initConditionVar(&pool->jobDone);
+   // workers that fail to start only reduce the parallelism
+   for (i = 1; i < threads; i++) {
+      CFL_THREADP worker = cfl_thread_newWithDescription(parallel_worker, "CFL Parallel Worker");
+      if (worker == NULL) {
+         break;
+      }
+      if (! cfl_thread_start(worker, pool)) {
+         cfl_thread_free(worker);
+         break;
+      }
+      pool->workers[pool->workerCount++] = worker;
+   }
+   return pool;
+}
+
+void cfl_parallel_free(CFL_PARALLELP pool) {
+   CFL_UINT32 i;
+
+   if (pool == NULL) {
+      return;
+   }
+   cfl_lock_acquire(&pool->lock);
+   pool->stop = CFL_TRUE;
+   cfl_lock_conditionWakeAll(&pool->jobReady);
+   cfl_lock_release(&pool->lock);
+   for (i = 0; i < pool->workerCount; i++) {
+      cfl_thread_wait(pool->workers[i]);
+      cfl_thread_free(pool->workers[i]);
+   }
+   if (pool->workers != NULL) {
+      CFL_MEM_FREE(pool->workers);
+   }
+   cfl_lock_freeConditionVar(&pool->jobReady);
+   cfl_lock_freeConditionVar(&pool->jobDone);
+   cfl_lock_free(&pool->runLock);
+   cfl_lock_free(&pool->lock);
+   CFL_MEM_FREE(pool);
+}
+
+CFL_PARALLELP cfl_parallel_shared(void) {
+   CFL_PARALLELP pool = (CFL_PARALLELP) cfl_atomic_getPointer((void **) &s_sharedPool);
+   if (pool == NULL) {
+      CFL_PARALLELP newPool = cfl_parallel_new(0);
+      if (newPool == NULL) {
+         return NULL;
+      }
+      // another thread may have created it first
+      pool = (CFL_PARALLELP) cfl_atomic_compareAndSetPointer((void **) &s_sharedPool, NULL, newPool);
+      if (pool == NULL) {
+         pool = newPool;
+      } else {
+         cfl_parallel_free(newPool);
+      }
+   }
+   return pool;
+}
+
+void cfl_parallel_freeShared(void) {
+   CFL_PARALLELP pool = (CFL_PARALLELP) cfl_atomic_setPointer((void **) &s_sharedPool, NULL);
+   cfl_parallel_free(pool);
+}
+
+CFL_UINT32 cfl_parallel_threads(CFL_PARALLELP pool) {
+   pool = parallel_pool(pool);
+   return pool != NULL ? pool->workerCount + 1 : 1;
+}
+
+static void range_task(CFL_UINT32 task, void *context) {
+   RANGE_CONTEXT *ctx = (RANGE_CONTEXT *) context;
+   ctx->func(CHUNK_START(ctx->count, ctx->chunks, task), CHUNK_START(ctx->count, ctx->chunks, task + 1), ctx->context);
+}
+
+void cfl_parallel_for(CFL_PARALLELP pool, CFL_UINT32 count, CFL_PARALLEL_RANGE_FUNC func, void *context) {
+   RANGE_CONTEXT ctx;
+
+   if (count == 0) {
+      return;
+   }
+   pool = parallel_pool(pool);
+   if (pool == NULL) {
+      func(0, count, context);
+      return;
+   }
+   ctx.count = count;
+   ctx.chunks = parallel_chunks(pool, count);
+   ctx.func = func;
+   ctx.context = context;
+   parallel_run(pool, ctx.chunks, range_task, &ctx);
+}
+
+static void array_items(CFL_UINT32 start, CFL_UINT32 end, void *context) {
+   ITEM_CONTEXT *ctx = (ITEM_CONTEXT *) context;
+   CFL_UINT8 *item = ctx->items + (size_t) start * ctx->itemSize;
+   CFL_UINT32 i;
+   for (i = start; i < end; i++) {
+      ctx->func(item, ctx->context);
+      item += ctx->itemSize;
+   }
+}
+
+static void list_items(CFL_UINT32 start, CFL_UINT32 end, void *context) {
+   ITEM_CONTEXT *ctx = (ITEM_CONTEXT *) context;
+   void **items = (void **) ctx->items;
+   CFL_UINT32 i;
+   for (i = start; i < end; i++) {
+      ctx->func(items[i], ctx->context);
+   }
+}
+
+void cfl_parallel_forArray(CFL_PARALLELP pool, CFL_ARRAYP array, CFL_PARALLEL_ITEM_FUNC func, void *context) {
+   ITEM_CONTEXT ctx;
+   ctx.func = func;
+   ctx.context = context;
+   ctx.items = array->items;
+   ctx.itemSize = array->ulItemSize;
+   cfl_parallel_for(pool, array->ulLength, array_items, &ctx);
+}
+
+void cfl_parallel_forList(CFL_PARALLELP pool, CFL_LISTP list, CFL_PARALLEL_ITEM_FUNC func, void *context) {
+   ITEM_CONTEXT ctx;
+   ctx.func = func;
+   ctx.context = context;
+   ctx.items = (CFL_UINT8 *) list->items;
+   ctx.itemSize = sizeof(void *);
+   cfl_parallel_for(pool, list->length, list_items, &ctx);
+}
+
+static void reduce_task(CFL_UINT32 task, void *context) {
+   REDUCE_CONTEXT *ctx = (REDUCE_CONTEXT *) context;
+   ctx->func(CHUNK_START(ctx->count, ctx->chunks, task), CHUNK_START(ctx->count, ctx->chunks, task + 1),
+             ctx->partials + (size_t) task * ctx->resultSize, ctx->context);
+}
+
+void cfl_parallel_reduce(CFL_PARALLELP pool, CFL_UINT32 count, void *result, CFL_UINT32 resultSize,
+                         CFL_PARALLEL_REDUCE_FUNC reduceFunc, CFL_PARALLEL_COMBINE_FUNC combineFunc,
+                         void *context) {
+   REDUCE_CONTEXT ctx;
+   CFL_UINT32 i;
+
+   if (count == 0) {
+      return;
+   }
+   pool = parallel_pool(pool);
+   ctx.chunks = parallel_chunks(pool, count);
+   ctx.partials = ctx.chunks > 1 ? (CFL_UINT8 *) CFL_MEM_ALLOC((size_t) ctx.chunks * resultSize) : NULL;
+   // a single chunk accumulates directly into the result
+   if (ctx.partials == NULL) {
+      reduceFunc(0, count, result, context);
+      return;
+   }
+   for (i = 0; i < ctx.chunks; i++) {
+      memcpy(ctx.partials + (size_t) i * resultSize, result, resultSize);
+   }
+   ctx.count = count;
+   ctx.resultSize = resultSize;
+   ctx.func = reduceFunc;
+   ctx.context = context;
+   parallel_run(pool, ctx.chunks, reduce_task, &ctx);
+   for (i = 0; i < ctx.chunks; i++) {
+      combineFunc(result, ctx.partials + (size_t) i * resultSize, context);
+   }
+   CFL_MEM_FREE(ctx.partials);
+}
+
+static void accum_items(CFL_UINT32 start, CFL_UINT32 end, void *partial, void *context) {
+   ACCUM_CONTEXT *ctx = (ACCUM_CONTEXT *) context;
+   CFL_UINT32 i;
+   if (ctx->isList) {
+      void **items = (void **) ctx->items;
+      for (i = start; i < end; i++) {
+         ctx->func(partial, items[i], ctx->context);
+      }
+   } else {
+      CFL_UINT8 *item = ctx->items + (size_t) start * ctx->itemSize;
+      for (i = start; i < end; i++) {
+         ctx->func(partial, item, ctx->context);
+         item += ctx->itemSize;
+      }
+   }
+}
+
+static void accum_combine(void *result, const void *partial, void *context) {
+   ACCUM_CONTEXT *ctx = (ACCUM_CONTEXT *) context;
+   ctx->combine(result, partial, ctx->context);
+}
+
+void cfl_parallel_reduceArray(CFL_PARALLELP pool, CFL_ARRAYP array, void *result, CFL_UINT32 resultSize,
+                              CFL_PARALLEL_ACCUM_FUNC accumFunc, CFL_PARALLEL_COMBINE_FUNC combineFunc,
+                              void *context) {
+   ACCUM_CONTEXT ctx;
+   ctx.func = accumFunc;
+   ctx.combine = combineFunc;
+   ctx.context = context;
+   ctx.items = array->items;
+   ctx.itemSize = array->ulItemSize;
+   ctx.isList = CFL_FALSE;
+   cfl_parallel_reduce(pool, array->ulLength, result, resultSize, accum_items, accum_combine, &ctx);
+}
+
+void cfl_parallel_reduceList(CFL_PARALLELP pool, CFL_LISTP list, void *result, CFL_UINT32 resultSize,
+                             CFL_PARALLEL_ACCUM_FUNC accumFunc, CFL_PARALLEL_COMBINE_FUNC combineFunc,
+                             void *context) {
+   ACCUM_CONTEXT ctx;
+   ctx.func = accumFunc;
+   ctx.combine = combineFunc;
+   ctx.context = context;
+   ctx.items = (CFL_UINT8 *) list->items;
+   ctx.itemSize = sizeof(void *);
+   ctx.isList = CFL_TRUE;
+   cfl_parallel_reduce(pool, list->length, result, resultSize, accum_items, accum_combine, &ctx);
+}
+
+static CFL_INLINE void sort_copy(CFL_UINT8 *dest, const CFL_UINT8 *src, size_t size) {
+   switch (size) {
+      case 4:
+         memcpy(dest, src, 4);
+         break;
+      case 8:
+         memcpy(dest, src, 8);
+         break;
+      default:
+         memcpy(dest, src, size);
+         break;
+   }
+}
+
+/*
+ * Number of items taken from a in the first diag items of the merge of a and b, equal items of a going first. Found
+ * by a binary search on the diagonal diag of the merge path, so that a merge can be split in independent pieces.
+ */
+static CFL_UINT32 sort_coRank(SORT_JOB *job, const CFL_UINT8 *a, CFL_UINT32 lenA, const CFL_UINT8 *b,
+                              CFL_UINT32 lenB, CFL_UINT32 diag) {
+   size_t size = job->itemSize;
+   CFL_UINT32 lo = diag > lenB ? diag - lenB : 0;
+   CFL_UINT32 hi = diag < lenA ? diag : lenA;
+   while (lo < hi) {
+      CFL_UINT32 mid = lo + ((hi - lo) >> 1);
+      if (job->cmp(b + (size_t) (diag - mid - 1) * size, a + (size_t) mid * size) < 0) {
+         hi = mid;
+      } else {
+         lo = mid + 1;
+      }
+   }
+   return lo;
+}
+
+static void sort_mergeRange(SORT_JOB *job, const CFL_UINT8 *a, const CFL_UINT8 *aEnd, const CFL_UINT8 *b,
+                            const CFL_UINT8 *bEnd, CFL_UINT8 *dest) {
+   size_t size = job->itemSize;
+   while (a < aEnd && b < bEnd) {
+      if (job->cmp(b, a) < 0) {
+         sort_copy(dest, b, size);
+         b += size;
+      } else {
+         sort_copy(dest, a, size);
+         a += size;
+      }
+      dest += size;
+   }
+   if (a < aEnd) {
+      memcpy(dest, a, (size_t) (aEnd - a));
+   } else if (b < bEnd) {
+      memcpy(dest, b, (size_t) (bEnd - b));
+   }
+}
+
+static void sort_runTask(CFL_UINT32 task, void *context) {
+   SORT_JOB *job = (SORT_JOB *) context;
+   CFL_UINT32 start = CHUNK_START(job->count, job->runs, task);
+   CFL_UINT32 end = CHUNK_START(job->count, job->runs, task + 1);
+   cfl_sort(job->src + (size_t) start * job->itemSize, end - start, job->itemSize, job->cmp);
+}
+
+static void sort_mergeTask(CFL_UINT32 task, void *context) {
+   SORT_JOB *job = (SORT_JOB *) context;
+   size_t size = job->itemSize;
+   CFL_UINT32 firstRun = (task / job->pieces) * job->runWidth * 2;
+   CFL_UINT32 piece = task % job->pieces;
+   CFL_UINT32 lo = CHUNK_START(job->count, job->runs, firstRun);
+   CFL_UINT32 mid = CHUNK_START(job->count, job->runs, firstRun + job->runWidth);
+   CFL_UINT32 hi = CHUNK_START(job->count, job->runs, firstRun + job->runWidth * 2);
+   CFL_UINT8 *a = job->src + (size_t) lo * size;
+   CFL_UINT8 *b = job->src + (size_t) mid * size;
+   CFL_UINT32 diagStart = CHUNK_START(hi - lo, job->pieces, piece);
+   CFL_UINT32 diagEnd = CHUNK_START(hi - lo, job->pieces, piece + 1);
+   CFL_UINT32 aStart = sort_coRank(job, a, mid - lo, b, hi - mid, diagStart);
+   CFL_UINT32 aEnd = sort_coRank(job, a, mid - lo, b, hi - mid, diagEnd);
+   sort_mergeRange(job, a + (size_t) aStart * size, a + (size_t) aEnd * size,
+                   b + (size_t) (diagStart - aStart) * size, b + (size_t) (diagEnd - aEnd) * size,
+                   job->dest + (size_t) (lo + diagStart) * size);
+}
+
+static void sort_copyTask(CFL_UINT32 task, void *context) {
+   SORT_JOB *job = (SORT_JOB *) context;
+   size_t start = (size_t) CHUNK_START(job->count, job->runs, task) * job->itemSize;
+   size_t end = (size_t) CHUNK_START(job->count, job->runs, task + 1) * job->itemSize;
+   memcpy(job->dest + start, job->src + start, end - start);
+}
+
+void cfl_parallel_sort(CFL_PARALLELP pool, void *base, CFL_UINT32 count, CFL_UINT32 itemSize,
+                       CFL_SORT_CMP_FUNC cmp) {
+   SORT_JOB job;
+   CFL_UINT32 threads;
+   CFL_UINT8 *aux;
+
+   pool = parallel_pool(pool);
+   threads = pool != NULL ? pool->workerCount + 1 : 1;
+   if (threads == 1 || count < SORT_MIN_RUN * 2) {
+      cfl_sort(base, count, itemSize, cmp);
+      return;
+   }
+   aux = (CFL_UINT8 *) CFL_MEM_ALLOC((size_t) count * itemSize);
+   if (aux == NULL) {
+      cfl_sort(base, count, itemSize, cmp);
+      return;
+   }
+   // a power of two number of runs, so that every merge round pairs all of them
+   job.runs = 2;
+   while (job.runs < threads && count / (job.runs * 2) >= SORT_MIN_RUN) {
+      job.runs <<= 1;
+   }
+   job.src = (CFL_UINT8 *) base;
+   job.dest = aux;
+   job.count = count;
+   job.itemSize = itemSize;
+   job.cmp = cmp;
+   parallel_run(pool, job.runs, sort_runTask, &job);
+   for (job.runWidth = 1; job.runWidth < job.runs; job.runWidth <<= 1) {
+      CFL_UINT32 merges = job.runs / (job.runWidth * 2);
+      CFL_UINT8 *tmp;
+      // the last rounds have few merges, split them to keep all threads busy
+      job.pieces = (threads * 2 + merges - 1) / merges;
+      parallel_run(pool, merges * job.pieces, sort_mergeTask, &job);
+      tmp = job.src;
+      job.src = job.dest;
+      job.dest = tmp;
+   }
+   if (job.src != (CFL_UINT8 *) base) {
+      job.dest = (CFL_UINT8 *) base;
+      parallel_run(pool, job.runs, sort_copyTask, &job);
+   }
+   CFL_MEM_FREE(aux);
+}
+
+void cfl_parallel_sortArray(CFL_PARALLELP pool, CFL_ARRAYP array, CFL_SORT_CMP_FUNC cmp) {
+   cfl_parallel_sort(pool, array->items, array->ulLength, array->ulItemSize, cmp);
+}
+
+void cfl_parallel_sortList(CFL_PARALLELP pool, CFL_LISTP list, CFL_SORT_CMP_FUNC cmp) {
+   cfl_parallel_sort(pool, list->items, list->length, sizeof(void *), cmp);
+}
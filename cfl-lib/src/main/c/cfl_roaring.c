@@ -0,0 +1,1231 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "cfl_roaring.h"
+#include "cfl_mem.h"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#define CONTAINER_ARRAY   1
+#define CONTAINER_BITMAP  2
+#define CONTAINER_RUN     3
+
+#define CHUNK_BITS        65536
+#define ARRAY_MAX_VALUES  4096
+#define BITMAP_WORDS      1024
+#define BITMAP_BYTES      (BITMAP_WORDS * sizeof(CFL_UINT64))
+/* A run takes 4 bytes, so with more runs than this a bitmap is smaller */
+#define RUN_MAX_COUNT     2048
+#define MAX_RUN_COUNT     (CHUNK_BITS / 2)
+
+#define VALUES(c)         ((CFL_UINT16 *) (c)->data)
+#define WORDS(c)          ((CFL_UINT64 *) (c)->data)
+#define RUNS(c)           ((ROARING_RUN *) (c)->data)
+
+#define BIT_MASK(pos)     (((CFL_UINT64) 1) << ((pos) & 63))
+
+#define HIGH_BITS(value)  ((CFL_UINT16) ((value) >> 16))
+#define LOW_BITS(value)   ((CFL_UINT16) ((value) & 0xFFFF))
+
+typedef struct _ROARING_RUN {
+   CFL_UINT16 start;
+   CFL_UINT16 length; /* Number of values after start */
+} ROARING_RUN;
+
+struct _CFL_ROARING_CONTAINER {
+   CFL_UINT16 key;
+   CFL_UINT8 type;
+   CFL_UINT32 cardinality;
+   CFL_UINT32 count;    /* Values of an array or runs of a run container */
+   CFL_UINT32 capacity; /* Allocated values or runs */
+   void *data;
+};
+
+static CFL_INLINE CFL_UINT32 popCount(CFL_UINT64 word) {
+#if defined(__GNUC__) || defined(__clang__)
+   return (CFL_UINT32) __builtin_popcountll(word);
+#else
+   word = word - ((word >> 1) & 0x5555555555555555ULL);
+   word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+   word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+   return (CFL_UINT32) ((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* Position of the lowest set bit. The word must not be zero. */
+static CFL_INLINE CFL_UINT32 trailingZeros(CFL_UINT64 word) {
+#if defined(__GNUC__) || defined(__clang__)
+   return (CFL_UINT32) __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   unsigned long index;
+   _BitScanForward64(&index, word);
+   return (CFL_UINT32) index;
+#else
+   CFL_UINT32 count = 0;
+   while ((word & 1) == 0) {
+      word >>= 1;
+      ++count;
+   }
+   return count;
+#endif
+}
+
+/*
+ * Word helpers, used for bitmap containers and as the common format when
+ * combining containers of different types.
+ */
+
+static void wordsSetRange(CFL_UINT64 *words, CFL_UINT32 start, CFL_UINT32 end) {
+   CFL_UINT32 first = start >> 6;
+   CFL_UINT32 last = end >> 6;
+   CFL_UINT64 firstMask = ~((CFL_UINT64) 0) << (start & 63);
+   CFL_UINT64 lastMask = ~((CFL_UINT64) 0) >> (63 - (end & 63));
+   CFL_UINT32 i;
+
+   if (first == last) {
+      words[first] |= firstMask & lastMask;
+   } else {
+      words[first] |= firstMask;
+      for (i = first + 1; i < last; i++) {
+         words[i] = ~((CFL_UINT64) 0);
+      }
+      words[last] |= lastMask;
+   }
+}
+
+static CFL_UINT32 wordsCardinality(const CFL_UINT64 *words) {
+   CFL_UINT32 count = 0;
+   CFL_UINT32 i;
+   for (i = 0; i < BITMAP_WORDS; i++) {
+      count += popCount(words[i]);
+   }
+   return count;
+}
+
+/* Counts the sequences of consecutive set bits */
+static CFL_UINT32 wordsRunCount(const CFL_UINT64 *words) {
+   CFL_UINT32 count = 0;
+   CFL_UINT64 carry = 0;
+   CFL_UINT32 i;
+   for (i = 0; i < BITMAP_WORDS; i++) {
+      CFL_UINT64 word = words[i];
+      count += popCount(word & ~((word << 1) | carry));
+      carry = word >> 63;
+   }
+   return count;
+}
+
+/* Returns CHUNK_BITS if there is no set bit at or after from */
+static CFL_UINT32 wordsNextSet(const CFL_UINT64 *words, CFL_UINT32 from) {
+   CFL_UINT32 index = from >> 6;
+   CFL_UINT64 word;
+
+   if (from >= CHUNK_BITS) {
+      return CHUNK_BITS;
+   }
+   word = words[index] & (~((CFL_UINT64) 0) << (from & 63));
+   while (word == 0) {
+      if (++index >= BITMAP_WORDS) {
+         return CHUNK_BITS;
+      }
+      word = words[index];
+   }
+   return (index << 6) + trailingZeros(word);
+}
+
+/* Returns CHUNK_BITS if there is no clear bit at or after from */
+static CFL_UINT32 wordsNextClear(const CFL_UINT64 *words, CFL_UINT32 from) {
+   CFL_UINT32 index = from >> 6;
+   CFL_UINT64 word;
+
+   if (from >= CHUNK_BITS) {
+      return CHUNK_BITS;
+   }
+   word = ~words[index] & (~((CFL_UINT64) 0) << (from & 63));
+   while (word == 0) {
+      if (++index >= BITMAP_WORDS) {
+         return CHUNK_BITS;
+      }
+      word = ~words[index];
+   }
+   return (index << 6) + trailingZeros(word);
+}
+
+/*
+ * Container helpers.
+ */
+
+/* Position of value in the array, or where it would be inserted */
+static CFL_UINT32 arrayLowerBound(const CFL_UINT16 *values, CFL_UINT32 count, CFL_UINT16 value) {
+   CFL_UINT32 low = 0;
+   CFL_UINT32 high = count;
+   while (low < high) {
+      CFL_UINT32 middle = (low + high) >> 1;
+      if (values[middle] < value) {
+         low = middle + 1;
+      } else {
+         high = middle;
+      }
+   }
+   return low;
+}
+
+/* Index of the last run starting at or before value, or -1 */
+static CFL_INT32 runFind(const ROARING_RUN *runs, CFL_UINT32 count, CFL_UINT16 value) {
+   CFL_INT32 low = 0;
+   CFL_INT32 high = (CFL_INT32) count - 1;
+   while (low <= high) {
+      CFL_INT32 middle = (low + high) >> 1;
+      if (runs[middle].start <= value) {
+         low = middle + 1;
+      } else {
+         high = middle - 1;
+      }
+   }
+   return high;
+}
+
+static void containerToWords(const CFL_ROARING_CONTAINER *container, CFL_UINT64 *words) {
+   CFL_UINT32 i;
+   if (container->type == CONTAINER_BITMAP) {
+      memcpy(words, container->data, BITMAP_BYTES);
+      return;
+   }
+   memset(words, 0, BITMAP_BYTES);
+   if (container->type == CONTAINER_ARRAY) {
+      const CFL_UINT16 *values = VALUES(container);
+      for (i = 0; i < container->count; i++) {
+         words[values[i] >> 6] |= BIT_MASK(values[i]);
+      }
+   } else {
+      const ROARING_RUN *runs = RUNS(container);
+      for (i = 0; i < container->count; i++) {
+         wordsSetRange(words, runs[i].start, (CFL_UINT32) runs[i].start + runs[i].length);
+      }
+   }
+}
+
+/* Picks the smallest container for the given number of values and runs */
+static CFL_UINT8 bestType(CFL_UINT32 cardinality, CFL_UINT32 runCount) {
+   CFL_UINT32 runSize = runCount * (CFL_UINT32) sizeof(ROARING_RUN);
+   if (cardinality <= ARRAY_MAX_VALUES) {
+      return runSize < cardinality * sizeof(CFL_UINT16) ? CONTAINER_RUN : CONTAINER_ARRAY;
+   }
+   return runSize < BITMAP_BYTES ? CONTAINER_RUN : CONTAINER_BITMAP;
+}
+
+/* Replaces the container contents with the bits of words, stored as type */
+static CFL_BOOL containerFromWords(CFL_ROARING_CONTAINER *container, const CFL_UINT64 *words,
+                                   CFL_UINT32 cardinality, CFL_UINT8 type) {
+   void *data;
+   CFL_UINT32 count = 0;
+   CFL_UINT32 i;
+
+   if (type == CONTAINER_ARRAY) {
+      CFL_UINT16 *values;
+      data = CFL_MEM_ALLOC((cardinality > 0 ? cardinality : 1) * sizeof(CFL_UINT16));
+      if (data == NULL) {
+         return CFL_FALSE;
+      }
+      values = (CFL_UINT16 *) data;
+      for (i = 0; i < BITMAP_WORDS; i++) {
+         CFL_UINT64 word = words[i];
+         while (word != 0) {
+            values[count++] = (CFL_UINT16) ((i << 6) + trailingZeros(word));
+            word &= word - 1;
+         }
+      }
+   } else if (type == CONTAINER_BITMAP) {
+      data = CFL_MEM_ALLOC(BITMAP_BYTES);
+      if (data == NULL) {
+         return CFL_FALSE;
+      }
+      memcpy(data, words, BITMAP_BYTES);
+   } else {
+      ROARING_RUN *runs;
+      CFL_UINT32 start = wordsNextSet(words, 0);
+      CFL_UINT32 runCount = wordsRunCount(words);
+      data = CFL_MEM_ALLOC((runCount > 0 ? runCount : 1) * sizeof(ROARING_RUN));
+      if (data == NULL) {
+         return CFL_FALSE;
+      }
+      runs = (ROARING_RUN *) data;
+      while (start < CHUNK_BITS) {
+         CFL_UINT32 end = wordsNextClear(words, start);
+         runs[count].start = (CFL_UINT16) start;
+         runs[count].length = (CFL_UINT16) (end - start - 1);
+         ++count;
+         start = wordsNextSet(words, end);
+      }
+   }
+   if (container->data != NULL) {
+      CFL_MEM_FREE(container->data);
+   }
+   container->data = data;
+   container->type = type;
+   container->cardinality = cardinality;
+   container->count = count;
+   container->capacity = count;
+   return CFL_TRUE;
+}
+
+static CFL_BOOL containerFromWordsBest(CFL_ROARING_CONTAINER *container, const CFL_UINT64 *words) {
+   CFL_UINT32 cardinality = wordsCardinality(words);
+   return containerFromWords(container, words, cardinality, bestType(cardinality, wordsRunCount(words)));
+}
+
+/* Converts a full array or a run container with too many runs to a bitmap */
+static CFL_BOOL containerToBitmap(CFL_ROARING_CONTAINER *container) {
+   CFL_UINT64 *words = (CFL_UINT64 *) CFL_MEM_ALLOC(BITMAP_BYTES);
+   if (words == NULL) {
+      return CFL_FALSE;
+   }
+   containerToWords(container, words);
+   CFL_MEM_FREE(container->data);
+   container->data = words;
+   container->type = CONTAINER_BITMAP;
+   container->count = 0;
+   container->capacity = 0;
+   return CFL_TRUE;
+}
+
+static CFL_BOOL containerReserve(CFL_ROARING_CONTAINER *container, CFL_UINT32 count, size_t itemSize) {
+   void *data;
+   CFL_UINT32 newCapacity;
+   if (count <= container->capacity) {
+      return CFL_TRUE;
+   }
+   newCapacity = container->capacity < 4 ? 4 : container->capacity * 2;
+   if (newCapacity < count) {
+      newCapacity = count;
+   }
+   data = CFL_MEM_REALLOC(container->data, newCapacity * itemSize);
+   if (data == NULL) {
+      return CFL_FALSE;
+   }
+   container->data = data;
+   container->capacity = newCapacity;
+   return CFL_TRUE;
+}
+
+static CFL_BOOL containerCopy(CFL_ROARING_CONTAINER *dest, const CFL_ROARING_CONTAINER *src) {
+   size_t size;
+   if (src->type == CONTAINER_ARRAY) {
+      size = src->count * sizeof(CFL_UINT16);
+   } else if (src->type == CONTAINER_BITMAP) {
+      size = BITMAP_BYTES;
+   } else {
+      size = src->count * sizeof(ROARING_RUN);
+   }
+   *dest = *src;
+   dest->data = CFL_MEM_ALLOC(size > 0 ? size : 1);
+   if (dest->data == NULL) {
+      return CFL_FALSE;
+   }
+   memcpy(dest->data, src->data, size);
+   if (src->type != CONTAINER_BITMAP) {
+      dest->capacity = src->count;
+   }
+   return CFL_TRUE;
+}
+
+static CFL_BOOL containerContains(const CFL_ROARING_CONTAINER *container, CFL_UINT16 value) {
+   if (container->type == CONTAINER_ARRAY) {
+      CFL_UINT32 index = arrayLowerBound(VALUES(container), container->count, value);
+      return index < container->count && VALUES(container)[index] == value;
+   } else if (container->type == CONTAINER_BITMAP) {
+      return (WORDS(container)[value >> 6] & BIT_MASK(value)) != 0;
+   } else {
+      CFL_INT32 index = runFind(RUNS(container), container->count, value);
+      return index >= 0 && value <= (CFL_UINT32) RUNS(container)[index].start + RUNS(container)[index].length;
+   }
+}
+
+static CFL_BOOL containerAdd(CFL_ROARING_CONTAINER *container, CFL_UINT16 value) {
+   if (container->type == CONTAINER_ARRAY) {
+      CFL_UINT16 *values = VALUES(container);
+      CFL_UINT32 index = arrayLowerBound(values, container->count, value);
+      if (index < container->count && values[index] == value) {
+         return CFL_TRUE;
+      }
+      if (container->count < ARRAY_MAX_VALUES) {
+         if (!containerReserve(container, container->count + 1, sizeof(CFL_UINT16))) {
+            return CFL_FALSE;
+         }
+         values = VALUES(container);
+         memmove(&values[index + 1], &values[index], (container->count - index) * sizeof(CFL_UINT16));
+         values[index] = value;
+         container->count++;
+         container->cardinality++;
+         return CFL_TRUE;
+      }
+      if (!containerToBitmap(container)) {
+         return CFL_FALSE;
+      }
+   }
+   if (container->type == CONTAINER_BITMAP) {
+      CFL_UINT64 *word = &WORDS(container)[value >> 6];
+      if ((*word & BIT_MASK(value)) == 0) {
+         *word |= BIT_MASK(value);
+         container->cardinality++;
+      }
+   } else {
+      ROARING_RUN *runs = RUNS(container);
+      CFL_INT32 index = runFind(runs, container->count, value);
+      CFL_BOOL extendsPrevious;
+      CFL_BOOL joinsNext;
+
+      if (index >= 0 && value <= (CFL_UINT32) runs[index].start + runs[index].length) {
+         return CFL_TRUE;
+      }
+      extendsPrevious = index >= 0 && (CFL_UINT32) runs[index].start + runs[index].length + 1 == value;
+      joinsNext = (CFL_UINT32) (index + 1) < container->count && runs[index + 1].start == (CFL_UINT32) value + 1;
+      if (extendsPrevious && joinsNext) {
+         runs[index].length += runs[index + 1].length + 2;
+         memmove(&runs[index + 1], &runs[index + 2], (container->count - index - 2) * sizeof(ROARING_RUN));
+         container->count--;
+      } else if (extendsPrevious) {
+         runs[index].length++;
+      } else if (joinsNext) {
+         runs[index + 1].start--;
+         runs[index + 1].length++;
+      } else {
+         if (!containerReserve(container, container->count + 1, sizeof(ROARING_RUN))) {
+            return CFL_FALSE;
+         }
+         runs = RUNS(container);
+         memmove(&runs[index + 2], &runs[index + 1], (container->count - index - 1) * sizeof(ROARING_RUN));
+         runs[index + 1].start = value;
+         runs[index + 1].length = 0;
+         container->count++;
+      }
+      container->cardinality++;
+      if (container->count > RUN_MAX_COUNT) {
+         /* Keeping the runs is still valid if the conversion fails */
+         containerToBitmap(container);
+      }
+   }
+   return CFL_TRUE;
+}
+
+static CFL_BOOL containerRemove(CFL_ROARING_CONTAINER *container, CFL_UINT16 value) {
+   if (container->type == CONTAINER_ARRAY) {
+      CFL_UINT16 *values = VALUES(container);
+      CFL_UINT32 index = arrayLowerBound(values, container->count, value);
+      if (index < container->count && values[index] == value) {
+         memmove(&values[index], &values[index + 1], (container->count - index - 1) * sizeof(CFL_UINT16));
+         container->count--;
+         container->cardinality--;
+      }
+   } else if (container->type == CONTAINER_BITMAP) {
+      CFL_UINT64 *word = &WORDS(container)[value >> 6];
+      if ((*word & BIT_MASK(value)) != 0) {
+         *word &= ~BIT_MASK(value);
+         container->cardinality--;
+         if (container->cardinality <= ARRAY_MAX_VALUES) {
+            /* Keeping the bitmap is still valid if the conversion fails */
+            containerFromWords(container, WORDS(container), container->cardinality, CONTAINER_ARRAY);
+         }
+      }
+   } else {
+      ROARING_RUN *runs = RUNS(container);
+      CFL_INT32 index = runFind(runs, container->count, value);
+      CFL_UINT32 end;
+
+      if (index < 0 || value > (CFL_UINT32) runs[index].start + runs[index].length) {
+         return CFL_TRUE;
+      }
+      end = (CFL_UINT32) runs[index].start + runs[index].length;
+      if (runs[index].length == 0) {
+         memmove(&runs[index], &runs[index + 1], (container->count - index - 1) * sizeof(ROARING_RUN));
+         container->count--;
+      } else if (value == runs[index].start) {
+         runs[index].start++;
+         runs[index].length--;
+      } else if (value == end) {
+         runs[index].length--;
+      } else {
+         if (!containerReserve(container, container->count + 1, sizeof(ROARING_RUN))) {
+            return CFL_FALSE;
+         }
+         runs = RUNS(container);
+         memmove(&runs[index + 2], &runs[index + 1], (container->count - index - 1) * sizeof(ROARING_RUN));
+         runs[index + 1].start = (CFL_UINT16) (value + 1);
+         runs[index + 1].length = (CFL_UINT16) (end - value - 1);
+         runs[index].length = (CFL_UINT16) (value - runs[index].start - 1);
+         container->count++;
+      }
+      container->cardinality--;
+   }
+   return CFL_TRUE;
+}
+
+static CFL_BOOL containerOr(const CFL_ROARING_CONTAINER *c1, const CFL_ROARING_CONTAINER *c2,
+                            CFL_ROARING_CONTAINER *result, CFL_UINT64 *words1, CFL_UINT64 *words2) {
+   CFL_UINT32 i;
+
+   memset(result, 0, sizeof(CFL_ROARING_CONTAINER));
+   result->key = c1->key;
+   if (c1->type == CONTAINER_ARRAY && c2->type == CONTAINER_ARRAY
+       && c1->cardinality + c2->cardinality <= ARRAY_MAX_VALUES) {
+      const CFL_UINT16 *values1 = VALUES(c1);
+      const CFL_UINT16 *values2 = VALUES(c2);
+      CFL_UINT32 i1 = 0;
+      CFL_UINT32 i2 = 0;
+      CFL_UINT16 *values = (CFL_UINT16 *) CFL_MEM_ALLOC((c1->count + c2->count) * sizeof(CFL_UINT16));
+      if (values == NULL) {
+         return CFL_FALSE;
+      }
+      i = 0;
+      while (i1 < c1->count && i2 < c2->count) {
+         if (values1[i1] < values2[i2]) {
+            values[i++] = values1[i1++];
+         } else if (values1[i1] > values2[i2]) {
+            values[i++] = values2[i2++];
+         } else {
+            values[i++] = values1[i1++];
+            ++i2;
+         }
+      }
+      while (i1 < c1->count) {
+         values[i++] = values1[i1++];
+      }
+      while (i2 < c2->count) {
+         values[i++] = values2[i2++];
+      }
+      result->type = CONTAINER_ARRAY;
+      result->data = values;
+      result->count = i;
+      result->capacity = c1->count + c2->count;
+      result->cardinality = i;
+      return CFL_TRUE;
+   }
+   containerToWords(c1, words1);
+   containerToWords(c2, words2);
+   for (i = 0; i < BITMAP_WORDS; i++) {
+      words1[i] |= words2[i];
+   }
+   return containerFromWordsBest(result, words1);
+}
+
+static CFL_BOOL containerAnd(const CFL_ROARING_CONTAINER *c1, const CFL_ROARING_CONTAINER *c2,
+                             CFL_ROARING_CONTAINER *result, CFL_UINT64 *words1, CFL_UINT64 *words2) {
+   CFL_UINT32 i;
+
+   memset(result, 0, sizeof(CFL_ROARING_CONTAINER));
+   result->key = c1->key;
+   if (c1->type == CONTAINER_ARRAY || c2->type == CONTAINER_ARRAY) {
+      const CFL_ROARING_CONTAINER *array = c1->type == CONTAINER_ARRAY ? c1 : c2;
+      const CFL_ROARING_CONTAINER *other = array == c1 ? c2 : c1;
+      const CFL_UINT16 *source = VALUES(array);
+      CFL_UINT32 count = 0;
+      CFL_UINT16 *values = (CFL_UINT16 *) CFL_MEM_ALLOC((array->count > 0 ? array->count : 1) * sizeof(CFL_UINT16));
+      if (values == NULL) {
+         return CFL_FALSE;
+      }
+      if (other->type == CONTAINER_ARRAY) {
+         const CFL_UINT16 *otherValues = VALUES(other);
+         CFL_UINT32 j = 0;
+         i = 0;
+         while (i < array->count && j < other->count) {
+            if (source[i] < otherValues[j]) {
+               ++i;
+            } else if (source[i] > otherValues[j]) {
+               ++j;
+            } else {
+               values[count++] = source[i++];
+               ++j;
+            }
+         }
+      } else {
+         for (i = 0; i < array->count; i++) {
+            if (containerContains(other, source[i])) {
+               values[count++] = source[i];
+            }
+         }
+      }
+      result->type = CONTAINER_ARRAY;
+      result->data = values;
+      result->count = count;
+      result->capacity = array->count;
+      result->cardinality = count;
+      return CFL_TRUE;
+   }
+   containerToWords(c1, words1);
+   containerToWords(c2, words2);
+   for (i = 0; i < BITMAP_WORDS; i++) {
+      words1[i] &= words2[i];
+   }
+   return containerFromWordsBest(result, words1);
+}
+
+static CFL_BOOL containerEquals(const CFL_ROARING_CONTAINER *c1, const CFL_ROARING_CONTAINER *c2,
+                                CFL_UINT64 *words1, CFL_UINT64 *words2) {
+   if (c1->key != c2->key || c1->cardinality != c2->cardinality) {
+      return CFL_FALSE;
+   }
+   if (c1->type == c2->type) {
+      if (c1->type == CONTAINER_ARRAY) {
+         return memcmp(c1->data, c2->data, c1->count * sizeof(CFL_UINT16)) == 0;
+      } else if (c1->type == CONTAINER_BITMAP) {
+         return memcmp(c1->data, c2->data, BITMAP_BYTES) == 0;
+      }
+      /* Runs are never adjacent, so equal sets have equal runs */
+      return c1->count == c2->count && memcmp(c1->data, c2->data, c1->count * sizeof(ROARING_RUN)) == 0;
+   }
+   containerToWords(c1, words1);
+   containerToWords(c2, words2);
+   return memcmp(words1, words2, BITMAP_BYTES) == 0;
+}
+
+/*
+ * Bitmap helpers.
+ */
+
+/* Index of the container of key, or -(insertion point + 1) */
+static CFL_INT32 findContainer(const CFL_ROARINGP roaring, CFL_UINT16 key) {
+   CFL_INT32 low = 0;
+   CFL_INT32 high = (CFL_INT32) roaring->count - 1;
+   while (low <= high) {
+      CFL_INT32 middle = (low + high) >> 1;
+      CFL_UINT16 middleKey = roaring->containers[middle].key;
+      if (middleKey < key) {
+         low = middle + 1;
+      } else if (middleKey > key) {
+         high = middle - 1;
+      } else {
+         return middle;
+      }
+   }
+   return -(low + 1);
+}
+
+static CFL_BOOL reserveContainers(CFL_ROARINGP roaring, CFL_UINT32 count) {
+   CFL_ROARING_CONTAINER *containers;
+   CFL_UINT32 newCapacity;
+   if (count <= roaring->capacity) {
+      return CFL_TRUE;
+   }
+   newCapacity = (roaring->capacity >> 1) + 1 + count;
+   containers = (CFL_ROARING_CONTAINER *) CFL_MEM_REALLOC(roaring->containers,
+                                                           newCapacity * sizeof(CFL_ROARING_CONTAINER));
+   if (containers == NULL) {
+      return CFL_FALSE;
+   }
+   roaring->containers = containers;
+   roaring->capacity = newCapacity;
+   return CFL_TRUE;
+}
+
+/* Inserts an empty array container at index */
+static CFL_ROARING_CONTAINER *insertContainer(CFL_ROARINGP roaring, CFL_UINT32 index, CFL_UINT16 key) {
+   CFL_ROARING_CONTAINER *container;
+   if (!reserveContainers(roaring, roaring->count + 1)) {
+      return NULL;
+   }
+   memmove(&roaring->containers[index + 1], &roaring->containers[index],
+           (roaring->count - index) * sizeof(CFL_ROARING_CONTAINER));
+   roaring->count++;
+   container = &roaring->containers[index];
+   memset(container, 0, sizeof(CFL_ROARING_CONTAINER));
+   container->key = key;
+   container->type = CONTAINER_ARRAY;
+   return container;
+}
+
+static void removeContainer(CFL_ROARINGP roaring, CFL_UINT32 index) {
+   if (roaring->containers[index].data != NULL) {
+      CFL_MEM_FREE(roaring->containers[index].data);
+   }
+   memmove(&roaring->containers[index], &roaring->containers[index + 1],
+           (roaring->count - index - 1) * sizeof(CFL_ROARING_CONTAINER));
+   roaring->count--;
+}
+
+static void freeContainers(CFL_ROARING_CONTAINER *containers, CFL_UINT32 count) {
+   CFL_UINT32 i;
+   for (i = 0; i < count; i++) {
+      if (containers[i].data != NULL) {
+         CFL_MEM_FREE(containers[i].data);
+      }
+   }
+}
+
+/* Replaces the containers of the bitmap with a new array of containers */
+static void replaceContainers(CFL_ROARINGP roaring, CFL_ROARING_CONTAINER *containers, CFL_UINT32 count,
+                              CFL_UINT32 capacity) {
+   if (roaring->containers != NULL) {
+      CFL_MEM_FREE(roaring->containers);
+   }
+   roaring->containers = containers;
+   roaring->count = count;
+   roaring->capacity = capacity;
+}
+
+void cfl_roaring_init(CFL_ROARINGP roaring) {
+   roaring->containers = NULL;
+   roaring->count = 0;
+   roaring->capacity = 0;
+   roaring->allocated = CFL_FALSE;
+}
+
+CFL_ROARINGP cfl_roaring_new(void) {
+   CFL_ROARINGP roaring = (CFL_ROARINGP) CFL_MEM_ALLOC(sizeof(CFL_ROARING));
+   if (roaring == NULL) {
+      return NULL;
+   }
+   cfl_roaring_init(roaring);
+   roaring->allocated = CFL_TRUE;
+   return roaring;
+}
+
+void cfl_roaring_free(CFL_ROARINGP roaring) {
+   if (roaring != NULL) {
+      freeContainers(roaring->containers, roaring->count);
+      if (roaring->containers != NULL) {
+         CFL_MEM_FREE(roaring->containers);
+         roaring->containers = NULL;
+      }
+      roaring->count = 0;
+      roaring->capacity = 0;
+      if (roaring->allocated) {
+         CFL_MEM_FREE(roaring);
+      }
+   }
+}
+
+CFL_ROARINGP cfl_roaring_clone(const CFL_ROARINGP roaring) {
+   CFL_ROARINGP clone = cfl_roaring_new();
+   CFL_UINT32 i;
+
+   if (clone == NULL) {
+      return NULL;
+   }
+   if (!reserveContainers(clone, roaring->count)) {
+      cfl_roaring_free(clone);
+      return NULL;
+   }
+   for (i = 0; i < roaring->count; i++) {
+      if (!containerCopy(&clone->containers[i], &roaring->containers[i])) {
+         cfl_roaring_free(clone);
+         return NULL;
+      }
+      clone->count++;
+   }
+   return clone;
+}
+
+void cfl_roaring_clear(CFL_ROARINGP roaring) {
+   freeContainers(roaring->containers, roaring->count);
+   roaring->count = 0;
+}
+
+CFL_BOOL cfl_roaring_add(CFL_ROARINGP roaring, CFL_UINT32 value) {
+   CFL_INT32 index = findContainer(roaring, HIGH_BITS(value));
+   CFL_ROARING_CONTAINER *container;
+
+   if (index >= 0) {
+      return containerAdd(&roaring->containers[index], LOW_BITS(value));
+   }
+   index = -(index + 1);
+   container = insertContainer(roaring, (CFL_UINT32) index, HIGH_BITS(value));
+   if (container == NULL) {
+      return CFL_FALSE;
+   }
+   if (!containerAdd(container, LOW_BITS(value))) {
+      removeContainer(roaring, (CFL_UINT32) index);
+      return CFL_FALSE;
+   }
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_roaring_addRange(CFL_ROARINGP roaring, CFL_UINT32 from, CFL_UINT32 to) {
+   CFL_UINT64 *words = NULL;
+   CFL_UINT32 key;
+
+   if (from > to) {
+      return CFL_TRUE;
+   }
+   for (key = HIGH_BITS(from); key <= HIGH_BITS(to); key++) {
+      CFL_UINT16 low = key == HIGH_BITS(from) ? LOW_BITS(from) : 0;
+      CFL_UINT16 high = key == HIGH_BITS(to) ? LOW_BITS(to) : 0xFFFF;
+      CFL_INT32 index = findContainer(roaring, (CFL_UINT16) key);
+      CFL_ROARING_CONTAINER *container;
+
+      if (index < 0) {
+         index = -(index + 1);
+         container = insertContainer(roaring, (CFL_UINT32) index, (CFL_UINT16) key);
+         if (container == NULL || !containerReserve(container, 1, sizeof(ROARING_RUN))) {
+            if (container != NULL) {
+               removeContainer(roaring, (CFL_UINT32) index);
+            }
+            break;
+         }
+         container->type = CONTAINER_RUN;
+         RUNS(container)[0].start = low;
+         RUNS(container)[0].length = (CFL_UINT16) (high - low);
+         container->count = 1;
+         container->cardinality = (CFL_UINT32) (high - low) + 1;
+         continue;
+      }
+      container = &roaring->containers[index];
+      if (container->cardinality == CHUNK_BITS) {
+         continue;
+      }
+      if (words == NULL) {
+         words = (CFL_UINT64 *) CFL_MEM_ALLOC(BITMAP_BYTES);
+         if (words == NULL) {
+            break;
+         }
+      }
+      containerToWords(container, words);
+      wordsSetRange(words, low, high);
+      if (!containerFromWordsBest(container, words)) {
+         break;
+      }
+   }
+   if (words != NULL) {
+      CFL_MEM_FREE(words);
+   }
+   return key > HIGH_BITS(to) ? CFL_TRUE : CFL_FALSE;
+}
+
+CFL_BOOL cfl_roaring_remove(CFL_ROARINGP roaring, CFL_UINT32 value) {
+   CFL_INT32 index = findContainer(roaring, HIGH_BITS(value));
+   if (index < 0) {
+      return CFL_TRUE;
+   }
+   if (!containerRemove(&roaring->containers[index], LOW_BITS(value))) {
+      return CFL_FALSE;
+   }
+   if (roaring->containers[index].cardinality == 0) {
+      removeContainer(roaring, (CFL_UINT32) index);
+   }
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_roaring_contains(const CFL_ROARINGP roaring, CFL_UINT32 value) {
+   CFL_INT32 index = findContainer(roaring, HIGH_BITS(value));
+   return index >= 0 && containerContains(&roaring->containers[index], LOW_BITS(value));
+}
+
+CFL_UINT64 cfl_roaring_cardinality(const CFL_ROARINGP roaring) {
+   CFL_UINT64 count = 0;
+   CFL_UINT32 i;
+   for (i = 0; i < roaring->count; i++) {
+      count += roaring->containers[i].cardinality;
+   }
+   return count;
+}
+
+CFL_BOOL cfl_roaring_isEmpty(const CFL_ROARINGP roaring) {
+   return roaring->count == 0 ? CFL_TRUE : CFL_FALSE;
+}
+
+CFL_BOOL cfl_roaring_or(CFL_ROARINGP roaring, const CFL_ROARINGP other) {
+   CFL_UINT32 capacity = roaring->count + other->count;
+   CFL_ROARING_CONTAINER *containers;
+   CFL_UINT64 *words;
+   CFL_UINT32 count = 0;
+   CFL_UINT32 i = 0;
+   CFL_UINT32 j = 0;
+
+   if (other->count == 0) {
+      return CFL_TRUE;
+   }
+   containers = (CFL_ROARING_CONTAINER *) CFL_MEM_ALLOC(capacity * sizeof(CFL_ROARING_CONTAINER));
+   words = (CFL_UINT64 *) CFL_MEM_ALLOC(2 * BITMAP_BYTES);
+   if (containers == NULL || words == NULL) {
+      if (containers != NULL) {
+         CFL_MEM_FREE(containers);
+      }
+      if (words != NULL) {
+         CFL_MEM_FREE(words);
+      }
+      return CFL_FALSE;
+   }
+   /* Containers only in the bitmap are moved, the others are new */
+   while (i < roaring->count || j < other->count) {
+      CFL_BOOL success = CFL_TRUE;
+      if (j >= other->count || (i < roaring->count && roaring->containers[i].key < other->containers[j].key)) {
+         containers[count++] = roaring->containers[i++];
+         continue;
+      } else if (i >= roaring->count || other->containers[j].key < roaring->containers[i].key) {
+         success = containerCopy(&containers[count], &other->containers[j++]);
+      } else {
+         success = containerOr(&roaring->containers[i++], &other->containers[j++], &containers[count], words,
+                               &words[BITMAP_WORDS]);
+      }
+      if (!success) {
+         for (i = 0; i < count; i++) {
+            if (findContainer(other, containers[i].key) >= 0) {
+               CFL_MEM_FREE(containers[i].data);
+            }
+         }
+         CFL_MEM_FREE(containers);
+         CFL_MEM_FREE(words);
+         return CFL_FALSE;
+      }
+      ++count;
+   }
+   CFL_MEM_FREE(words);
+   for (i = 0; i < roaring->count; i++) {
+      if (findContainer(other, roaring->containers[i].key) >= 0) {
+         CFL_MEM_FREE(roaring->containers[i].data);
+      }
+   }
+   replaceContainers(roaring, containers, count, capacity);
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_roaring_and(CFL_ROARINGP roaring, const CFL_ROARINGP other) {
+   CFL_UINT32 capacity = roaring->count < other->count ? roaring->count : other->count;
+   CFL_ROARING_CONTAINER *containers;
+   CFL_UINT64 *words;
+   CFL_UINT32 count = 0;
+   CFL_UINT32 i = 0;
+   CFL_UINT32 j = 0;
+
+   if (capacity == 0) {
+      cfl_roaring_clear(roaring);
+      return CFL_TRUE;
+   }
+   containers = (CFL_ROARING_CONTAINER *) CFL_MEM_ALLOC(capacity * sizeof(CFL_ROARING_CONTAINER));
+   words = (CFL_UINT64 *) CFL_MEM_ALLOC(2 * BITMAP_BYTES);
+   if (containers == NULL || words == NULL) {
+      if (containers != NULL) {
+         CFL_MEM_FREE(containers);
+      }
+      if (words != NULL) {
+         CFL_MEM_FREE(words);
+      }
+      return CFL_FALSE;
+   }
+   while (i < roaring->count && j < other->count) {
+      CFL_UINT16 key1 = roaring->containers[i].key;
+      CFL_UINT16 key2 = other->containers[j].key;
+      if (key1 < key2) {
+         ++i;
+      } else if (key1 > key2) {
+         ++j;
+      } else {
+         if (!containerAnd(&roaring->containers[i++], &other->containers[j++], &containers[count], words,
+                           &words[BITMAP_WORDS])) {
+            freeContainers(containers, count);
+            CFL_MEM_FREE(containers);
+            CFL_MEM_FREE(words);
+            return CFL_FALSE;
+         }
+         if (containers[count].cardinality > 0) {
+            ++count;
+         } else {
+            CFL_MEM_FREE(containers[count].data);
+         }
+      }
+   }
+   CFL_MEM_FREE(words);
+   freeContainers(roaring->containers, roaring->count);
+   replaceContainers(roaring, containers, count, capacity);
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_roaring_optimize(CFL_ROARINGP roaring) {
+   CFL_UINT64 *words;
+   CFL_BOOL success = CFL_TRUE;
+   CFL_UINT32 i;
+
+   if (roaring->count == 0) {
+      return CFL_TRUE;
+   }
+   words = (CFL_UINT64 *) CFL_MEM_ALLOC(BITMAP_BYTES);
+   if (words == NULL) {
+      return CFL_FALSE;
+   }
+   for (i = 0; i < roaring->count && success; i++) {
+      CFL_ROARING_CONTAINER *container = &roaring->containers[i];
+      CFL_UINT8 type;
+      containerToWords(container, words);
+      type = bestType(container->cardinality, wordsRunCount(words));
+      if (type != container->type) {
+         success = containerFromWords(container, words, container->cardinality, type);
+      } else if (container->type != CONTAINER_BITMAP && container->capacity > container->count) {
+         /* Release the space reserved for growth */
+         success = containerFromWords(container, words, container->cardinality, type);
+      }
+   }
+   CFL_MEM_FREE(words);
+   return success;
+}
+
+CFL_BOOL cfl_roaring_forEach(const CFL_ROARINGP roaring, CFL_ROARING_FUNC func, void *context) {
+   CFL_UINT32 i;
+   CFL_UINT32 j;
+
+   for (i = 0; i < roaring->count; i++) {
+      const CFL_ROARING_CONTAINER *container = &roaring->containers[i];
+      CFL_UINT32 base = (CFL_UINT32) container->key << 16;
+      if (container->type == CONTAINER_ARRAY) {
+         const CFL_UINT16 *values = VALUES(container);
+         for (j = 0; j < container->count; j++) {
+            if (!func(base | values[j], context)) {
+               return CFL_FALSE;
+            }
+         }
+      } else if (container->type == CONTAINER_BITMAP) {
+         const CFL_UINT64 *words = WORDS(container);
+         for (j = 0; j < BITMAP_WORDS; j++) {
+            CFL_UINT64 word = words[j];
+            while (word != 0) {
+               if (!func(base | ((j << 6) + trailingZeros(word)), context)) {
+                  return CFL_FALSE;
+               }
+               word &= word - 1;
+            }
+         }
+      } else {
+         const ROARING_RUN *runs = RUNS(container);
+         for (j = 0; j < container->count; j++) {
+            CFL_UINT32 value = runs[j].start;
+            CFL_UINT32 end = value + runs[j].length;
+            for (; value <= end; value++) {
+               if (!func(base | value, context)) {
+                  return CFL_FALSE;
+               }
+            }
+         }
+      }
+   }
+   return CFL_TRUE;
+}
+
+CFL_UINT32 cfl_roaring_toArray(const CFL_ROARINGP roaring, CFL_UINT32 *out, CFL_UINT32 maxCount) {
+   CFL_UINT32 count = 0;
+   CFL_UINT32 i;
+   CFL_UINT32 j;
+
+   for (i = 0; i < roaring->count && count < maxCount; i++) {
+      const CFL_ROARING_CONTAINER *container = &roaring->containers[i];
+      CFL_UINT32 base = (CFL_UINT32) container->key << 16;
+      if (container->type == CONTAINER_ARRAY) {
+         const CFL_UINT16 *values = VALUES(container);
+         for (j = 0; j < container->count && count < maxCount; j++) {
+            out[count++] = base | values[j];
+         }
+      } else if (container->type == CONTAINER_BITMAP) {
+         const CFL_UINT64 *words = WORDS(container);
+         for (j = 0; j < BITMAP_WORDS && count < maxCount; j++) {
+            CFL_UINT64 word = words[j];
+            while (word != 0 && count < maxCount) {
+               out[count++] = base | ((j << 6) + trailingZeros(word));
+               word &= word - 1;
+            }
+         }
+      } else {
+         const ROARING_RUN *runs = RUNS(container);
+         for (j = 0; j < container->count && count < maxCount; j++) {
+            CFL_UINT32 value = runs[j].start;
+            CFL_UINT32 end = value + runs[j].length;
+            for (; value <= end && count < maxCount; value++) {
+               out[count++] = base | value;
+            }
+         }
+      }
+   }
+   return count;
+}
+
+CFL_BOOL cfl_roaring_equals(const CFL_ROARINGP roaring1, const CFL_ROARINGP roaring2) {
+   CFL_UINT64 *words = NULL;
+   CFL_BOOL equal = CFL_TRUE;
+   CFL_UINT32 i;
+
+   if (roaring1->count != roaring2->count) {
+      return CFL_FALSE;
+   }
+   for (i = 0; i < roaring1->count && equal; i++) {
+      if (words == NULL && roaring1->containers[i].type != roaring2->containers[i].type) {
+         words = (CFL_UINT64 *) CFL_MEM_ALLOC(2 * BITMAP_BYTES);
+         if (words == NULL) {
+            return CFL_FALSE;
+         }
+      }
+      equal = containerEquals(&roaring1->containers[i], &roaring2->containers[i], words, &words[BITMAP_WORDS]);
+   }
+   if (words != NULL) {
+      CFL_MEM_FREE(words);
+   }
+   return equal;
+}
+
+/*
+ * Serialized format: number of containers (UInt32), then for each container
+ * its key (UInt16), type (UInt8) and count (UInt32), followed by its data:
+ * count UInt16 values for an array, 1024 UInt64 words for a bitmap (count is
+ * the cardinality) or count runs of start and length UInt16 pairs.
+ */
+
+#define CONTAINER_HEADER_SIZE 7
+
+static CFL_BOOL putContainerData(CFL_BUFFERP buffer, const CFL_ROARING_CONTAINER *container) {
+   CFL_UINT32 i;
+   if (container->type == CONTAINER_ARRAY) {
+      return cfl_buffer_put(buffer, container->data, container->count * (CFL_UINT32) sizeof(CFL_UINT16));
+   } else if (container->type == CONTAINER_BITMAP) {
+      return cfl_buffer_put(buffer, container->data, (CFL_UINT32) BITMAP_BYTES);
+   }
+   for (i = 0; i < container->count; i++) {
+      if (!cfl_buffer_putUInt16(buffer, RUNS(container)[i].start)
+          || !cfl_buffer_putUInt16(buffer, RUNS(container)[i].length)) {
+         return CFL_FALSE;
+      }
+   }
+   return CFL_TRUE;
+}
+
+CFL_BOOL cfl_roaring_serialize(const CFL_ROARINGP roaring, CFL_BUFFERP buffer) {
+   CFL_UINT32 i;
+
+   if (!cfl_buffer_putUInt32(buffer, roaring->count)) {
+      return CFL_FALSE;
+   }
+   for (i = 0; i < roaring->count; i++) {
+      const CFL_ROARING_CONTAINER *container = &roaring->containers[i];
+      if (!cfl_buffer_putUInt16(buffer, container->key) || !cfl_buffer_putUInt8(buffer, container->type)
+          || !cfl_buffer_putUInt32(buffer,
+                                   container->type == CONTAINER_BITMAP ? container->cardinality : container->count)
+          || !putContainerData(buffer, container)) {
+         return CFL_FALSE;
+      }
+   }
+   return CFL_TRUE;
+}
+
+/* Reads the data of a container whose key and type are already set */
+static CFL_BOOL getContainerData(CFL_BUFFERP buffer, CFL_ROARING_CONTAINER *container, CFL_UINT32 count) {
+   CFL_UINT32 i;
+
+   if (container->type == CONTAINER_ARRAY) {
+      CFL_UINT16 *values;
+      if (count == 0 || count > ARRAY_MAX_VALUES || !cfl_buffer_haveEnough(buffer, count * sizeof(CFL_UINT16))) {
+         return CFL_FALSE;
+      }
+      container->data = CFL_MEM_ALLOC(count * sizeof(CFL_UINT16));
+      if (container->data == NULL) {
+         return CFL_FALSE;
+      }
+      values = VALUES(container);
+      cfl_buffer_copy(buffer, (CFL_UINT8 *) values, count * (CFL_UINT32) sizeof(CFL_UINT16));
+      for (i = 1; i < count; i++) {
+         if (values[i] <= values[i - 1]) {
+            return CFL_FALSE;
+         }
+      }
+      container->count = count;
+      container->capacity = count;
+      container->cardinality = count;
+   } else if (container->type == CONTAINER_BITMAP) {
+      if (!cfl_buffer_haveEnough(buffer, (CFL_UINT32) BITMAP_BYTES)) {
+         return CFL_FALSE;
+      }
+      container->data = CFL_MEM_ALLOC(BITMAP_BYTES);
+      if (container->data == NULL) {
+         return CFL_FALSE;
+      }
+      cfl_buffer_copy(buffer, (CFL_UINT8 *) container->data, (CFL_UINT32) BITMAP_BYTES);
+      container->cardinality = wordsCardinality(WORDS(container));
+      if (container->cardinality == 0 || container->cardinality != count) {
+         return CFL_FALSE;
+      }
+   } else if (container->type == CONTAINER_RUN) {
+      ROARING_RUN *runs;
+      CFL_UINT32 next = 0;
+      if (count == 0 || count > MAX_RUN_COUNT || !cfl_buffer_haveEnough(buffer, count * sizeof(ROARING_RUN))) {
+         return CFL_FALSE;
+      }
+      container->data = CFL_MEM_ALLOC(count * sizeof(ROARING_RUN));
+      if (container->data == NULL) {
+         return CFL_FALSE;
+      }
+      runs = RUNS(container);
+      for (i = 0; i < count; i++) {
+         runs[i].start = cfl_buffer_getUInt16(buffer);
+         runs[i].length = cfl_buffer_getUInt16(buffer);
+         /* Runs must be ordered, separated by at least one value and end in the chunk */
+         if ((i > 0 && runs[i].start <= next) || (CFL_UINT32) runs[i].start + runs[i].length >= CHUNK_BITS) {
+            return CFL_FALSE;
+         }
+         next = (CFL_UINT32) runs[i].start + runs[i].length + 1;
+         container->cardinality += (CFL_UINT32) runs[i].length + 1;
+      }
+      container->count = count;
+      container->capacity = count;
+   } else {
+      return CFL_FALSE;
+   }
+   return CFL_TRUE;
+}
+
+CFL_ROARINGP cfl_roaring_deserialize(CFL_BUFFERP buffer) {
+   CFL_ROARINGP roaring;
+   CFL_UINT32 count;
+   CFL_UINT32 i;
+
+   if (!cfl_buffer_haveEnough(buffer, sizeof(CFL_UINT32))) {
+      return NULL;
+   }
+   count = cfl_buffer_getUInt32(buffer);
+   if (count > CHUNK_BITS || (CFL_UINT64) count * CONTAINER_HEADER_SIZE > cfl_buffer_remaining(buffer)) {
+      return NULL;
+   }
+   roaring = cfl_roaring_new();
+   if (roaring == NULL) {
+      return NULL;
+   }
+   if (!reserveContainers(roaring, count)) {
+      cfl_roaring_free(roaring);
+      return NULL;
+   }
+   for (i = 0; i < count; i++) {
+      CFL_ROARING_CONTAINER *container = &roaring->containers[i];
+      CFL_UINT32 containerCount;
+      CFL_BOOL success;
+
+      if (!cfl_buffer_haveEnough(buffer, CONTAINER_HEADER_SIZE)) {
+         cfl_roaring_free(roaring);
+         return NULL;
+      }
+      memset(container, 0, sizeof(CFL_ROARING_CONTAINER));
+      container->key = cfl_buffer_getUInt16(buffer);
+      container->type = cfl_buffer_getUInt8(buffer);
+      containerCount = cfl_buffer_getUInt32(buffer);
+      success = (i == 0 || container->key > roaring->containers[i - 1].key)
+                && getContainerData(buffer, container, containerCount);
+      /* Count the container so that its data is freed on failure */
+      roaring->count++;
+      if (!success) {
+         cfl_roaring_free(roaring);
+         return NULL;
+      }
+   }
+   return roaring;
+}
@@ -0,0 +1,519 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfl_mem.h"
+#include "cfl_sort.h"
+
+// Partitions smaller than this are sorted by insertion.
+#define INSERTION_SORT_THRESHOLD 24
+// Partitions larger than this use the median of 3 medians of 3 (ninther) as pivot.
+#define NINTHER_THRESHOLD 128
+// Number of moves allowed when trying to finish an almost sorted partition by insertion.
+#define PARTIAL_INSERTION_SORT_LIMIT 8
+// Items up to this size use a scratch item on the stack.
+#define STACK_ITEM_SIZE 64
+
+typedef struct _SORT_CONTEXT {
+   CFL_SORT_CMP_FUNC cmp;
+   size_t size;
+   CFL_UINT8 *tmp;
+} SORT_CONTEXT;
+
+// Scratch item with the strictest alignment the comparison function may expect
+typedef union _SORT_ITEM {
+   CFL_UINT8 bytes[STACK_ITEM_SIZE];
+   CFL_INT64 i64;
+   double d;
+   void *p;
+} SORT_ITEM;
+
+#define LESS(c, a, b) ((c)->cmp((a), (b)) < 0)
+
+static CFL_INLINE void sort_copy(CFL_UINT8 *dest, const CFL_UINT8 *src, size_t size) {
+   if (size == 8) {
+      memcpy(dest, src, 8);
+   } else if (size == 4) {
+      memcpy(dest, src, 4);
+   } else {
+      memcpy(dest, src, size);
+   }
+}
+
+static CFL_INLINE void sort_swap(CFL_UINT8 *a, CFL_UINT8 *b, size_t size) {
+   if (size == 8) {
+      CFL_UINT64 t;
+      memcpy(&t, a, 8);
+      memcpy(a, b, 8);
+      memcpy(b, &t, 8);
+   } else if (size == 4) {
+      CFL_UINT32 t;
+      memcpy(&t, a, 4);
+      memcpy(a, b, 4);
+      memcpy(b, &t, 4);
+   } else {
+      CFL_UINT8 t[STACK_ITEM_SIZE];
+      while (size > 0) {
+         size_t chunk = size < sizeof(t) ? size : sizeof(t);
+         memcpy(t, a, chunk);
+         memcpy(a, b, chunk);
+         memcpy(b, t, chunk);
+         a += chunk;
+         b += chunk;
+         size -= chunk;
+      }
+   }
+}
+
+static CFL_INLINE void sort_sort2(SORT_CONTEXT *c, CFL_UINT8 *a, CFL_UINT8 *b) {
+   if (LESS(c, b, a)) {
+      sort_swap(a, b, c->size);
+   }
+}
+
+static CFL_INLINE void sort_sort3(SORT_CONTEXT *c, CFL_UINT8 *a, CFL_UINT8 *b, CFL_UINT8 *d) {
+   sort_sort2(c, a, b);
+   sort_sort2(c, b, d);
+   sort_sort2(c, a, b);
+}
+
+// Sorts [begin, end) by insertion. Equal items are never moved past each other, so the sort is stable.
+// When bGuarded is false the item before begin must not be greater than any item of the range.
+
+static void sort_insertion(SORT_CONTEXT *c, CFL_UINT8 *begin, CFL_UINT8 *end, CFL_BOOL bGuarded) {
+   size_t size = c->size;
+   CFL_UINT8 *cur;
+
+   if (begin == end) {
+      return;
+   }
+   for (cur = begin + size; cur < end; cur += size) {
+      CFL_UINT8 *sift = cur;
+      CFL_UINT8 *sift1 = cur - size;
+      if (LESS(c, sift, sift1)) {
+         sort_copy(c->tmp, sift, size);
+         do {
+            sort_copy(sift, sift1, size);
+            sift -= size;
+         } while ((!bGuarded || sift != begin) && LESS(c, c->tmp, (sift1 -= size)));
+         sort_copy(sift, c->tmp, size);
+      }
+   }
+}
+
+// Attempts to sort [begin, end) by insertion, giving up after too many moves.
+
+static CFL_BOOL sort_partialInsertion(SORT_CONTEXT *c, CFL_UINT8 *begin, CFL_UINT8 *end) {
+   size_t size = c->size;
+   size_t limit = 0;
+   CFL_UINT8 *cur;
+
+   if (begin == end) {
+      return CFL_TRUE;
+   }
+   for (cur = begin + size; cur < end; cur += size) {
+      CFL_UINT8 *sift = cur;
+      CFL_UINT8 *sift1 = cur - size;
+      if (LESS(c, sift, sift1)) {
+         sort_copy(c->tmp, sift, size);
+         do {
+            sort_copy(sift, sift1, size);
+            sift -= size;
+         } while (sift != begin && LESS(c, c->tmp, (sift1 -= size)));
+         sort_copy(sift, c->tmp, size);
+         limit += (size_t) (cur - sift) / size;
+      }
+      if (limit > PARTIAL_INSERTION_SORT_LIMIT) {
+         return CFL_FALSE;
+      }
+   }
+   return CFL_TRUE;
+}
+
+static void sort_siftDown(SORT_CONTEXT *c, CFL_UINT8 *base, size_t root, size_t count) {
+   size_t size = c->size;
+   for (;;) {
+      size_t child = root * 2 + 1;
+      if (child >= count) {
+         return;
+      }
+      if (child + 1 < count && LESS(c, base + child * size, base + (child + 1) * size)) {
+         ++child;
+      }
+      if (!LESS(c, base + root * size, base + child * size)) {
+         return;
+      }
+      sort_swap(base + root * size, base + child * size, size);
+      root = child;
+   }
+}
+
+static void sort_heap(SORT_CONTEXT *c, CFL_UINT8 *begin, CFL_UINT8 *end) {
+   size_t size = c->size;
+   size_t count = (size_t) (end - begin) / size;
+   size_t i;
+
+   for (i = count / 2; i > 0; i--) {
+      sort_siftDown(c, begin, i - 1, count);
+   }
+   for (i = count - 1; i > 0; i--) {
+      sort_swap(begin, begin + i * size, size);
+      sort_siftDown(c, begin, 0, i);
+   }
+}
+
+// Partitions [begin, end) around the pivot at begin, putting the items equal to the pivot on the right side.
+// Returns the final position of the pivot. The pivot stays at begin while partitioning, so it is compared in place.
+
+static CFL_UINT8 *sort_partitionRight(SORT_CONTEXT *c, CFL_UINT8 *begin, CFL_UINT8 *end, CFL_BOOL *pAlreadyPartitioned) {
+   size_t size = c->size;
+   CFL_UINT8 *first = begin;
+   CFL_UINT8 *last = end;
+   CFL_UINT8 *pivotPos;
+
+   // The median of 3 selection guarantees an item not less than the pivot on the right.
+   while (LESS(c, (first += size), begin)) {
+   }
+   // Without an item less than the pivot on the left, the search for one from the right must be guarded.
+   if (first - size == begin) {
+      while (first < last && !LESS(c, (last -= size), begin)) {
+      }
+   } else {
+      while (!LESS(c, (last -= size), begin)) {
+      }
+   }
+   *pAlreadyPartitioned = first >= last;
+   while (first < last) {
+      sort_swap(first, last, size);
+      while (LESS(c, (first += size), begin)) {
+      }
+      while (!LESS(c, (last -= size), begin)) {
+      }
+   }
+   pivotPos = first - size;
+   if (pivotPos != begin) {
+      sort_swap(begin, pivotPos, size);
+   }
+   return pivotPos;
+}
+
+// Partitions [begin, end) around the pivot at begin, putting the items equal to the pivot on the left side.
+// Used when the pivot equals the item before the range, so the left side only gets items equal to the pivot.
+
+static CFL_UINT8 *sort_partitionLeft(SORT_CONTEXT *c, CFL_UINT8 *begin, CFL_UINT8 *end) {
+   size_t size = c->size;
+   CFL_UINT8 *first = begin;
+   CFL_UINT8 *last = end;
+
+   while (LESS(c, begin, (last -= size))) {
+   }
+   if (last + size == end) {
+      while (first < last && !LESS(c, begin, (first += size))) {
+      }
+   } else {
+      while (!LESS(c, begin, (first += size))) {
+      }
+   }
+   while (first < last) {
+      sort_swap(first, last, size);
+      while (LESS(c, begin, (last -= size))) {
+      }
+      while (!LESS(c, begin, (first += size))) {
+      }
+   }
+   if (last != begin) {
+      sort_swap(begin, last, size);
+   }
+   return last;
+}
+
+static void sort_pdq(SORT_CONTEXT *c, CFL_UINT8 *begin, CFL_UINT8 *end, int badAllowed, CFL_BOOL bLeftmost) {
+   size_t size = c->size;
+
+   for (;;) {
+      size_t count = (size_t) (end - begin) / size;
+      size_t half = count / 2;
+      size_t leftCount;
+      size_t rightCount;
+      CFL_UINT8 *pivotPos;
+      CFL_BOOL bAlreadyPartitioned;
+
+      if (count < INSERTION_SORT_THRESHOLD) {
+         sort_insertion(c, begin, end, bLeftmost);
+         return;
+      }
+
+      // Choose the pivot as the median of 3 or the pseudomedian of 9 and move it to begin.
+      if (count > NINTHER_THRESHOLD) {
+         sort_sort3(c, begin, begin + half * size, end - size);
+         sort_sort3(c, begin + size, begin + (half - 1) * size, end - 2 * size);
+         sort_sort3(c, begin + 2 * size, begin + (half + 1) * size, end - 3 * size);
+         sort_sort3(c, begin + (half - 1) * size, begin + half * size, begin + (half + 1) * size);
+         sort_swap(begin, begin + half * size, size);
+      } else {
+         sort_sort3(c, begin + half * size, begin, end - size);
+      }
+
+      // If the pivot equals the item before the range (the pivot of an ancestor partition), all the items equal to
+      // it are put on the left and skipped, so inputs with many duplicates take linear time.
+      if (!bLeftmost && !LESS(c, begin - size, begin)) {
+         begin = sort_partitionLeft(c, begin, end) + size;
+         continue;
+      }
+
+      pivotPos = sort_partitionRight(c, begin, end, &bAlreadyPartitioned);
+      leftCount = (size_t) (pivotPos - begin) / size;
+      rightCount = (size_t) (end - (pivotPos + size)) / size;
+
+      if (leftCount < count / 8 || rightCount < count / 8) {
+         // Too many bad partitions mean an adversarial input: fall back to heapsort to keep O(n log n).
+         if (--badAllowed == 0) {
+            sort_heap(c, begin, end);
+            return;
+         }
+         // Shuffle some items to break the patterns that caused the bad partition.
+         if (leftCount >= INSERTION_SORT_THRESHOLD) {
+            sort_swap(begin, begin + (leftCount / 4) * size, size);
+            sort_swap(pivotPos - size, pivotPos - (leftCount / 4) * size, size);
+            if (leftCount > NINTHER_THRESHOLD) {
+               sort_swap(begin + size, begin + (leftCount / 4 + 1) * size, size);
+               sort_swap(begin + 2 * size, begin + (leftCount / 4 + 2) * size, size);
+               sort_swap(pivotPos - 2 * size, pivotPos - (leftCount / 4 + 1) * size, size);
+               sort_swap(pivotPos - 3 * size, pivotPos - (leftCount / 4 + 2) * size, size);
+            }
+         }
+         if (rightCount >= INSERTION_SORT_THRESHOLD) {
+            sort_swap(pivotPos + size, pivotPos + (1 + rightCount / 4) * size, size);
+            sort_swap(end - size, end - (rightCount / 4) * size, size);
+            if (rightCount > NINTHER_THRESHOLD) {
+               sort_swap(pivotPos + 2 * size, pivotPos + (2 + rightCount / 4) * size, size);
+               sort_swap(pivotPos + 3 * size, pivotPos + (3 + rightCount / 4) * size, size);
+               sort_swap(end - 2 * size, end - (1 + rightCount / 4) * size, size);
+               sort_swap(end - 3 * size, end - (2 + rightCount / 4) * size, size);
+            }
+         }
+      } else if (bAlreadyPartitioned
+                 && sort_partialInsertion(c, begin, pivotPos)
+                 && sort_partialInsertion(c, pivotPos + size, end)) {
+         // A partition without swaps suggests a sorted input, which is finished by insertion if it really is.
+         return;
+      }
+
+      // Recurse on the left side and loop on the right side.
+      sort_pdq(c, begin, pivotPos, badAllowed, bLeftmost);
+      begin = pivotPos + size;
+      bLeftmost = CFL_FALSE;
+   }
+}
+
+static CFL_UINT8 *sort_allocTmp(SORT_ITEM *pStackItem, size_t size) {
+   if (size <= sizeof(SORT_ITEM)) {
+      return pStackItem->bytes;
+   }
+   return (CFL_UINT8 *) CFL_MEM_ALLOC(size);
+}
+
+static void sort_freeTmp(SORT_ITEM *pStackItem, CFL_UINT8 *tmp) {
+   if (tmp != pStackItem->bytes) {
+      CFL_MEM_FREE(tmp);
+   }
+}
+
+void cfl_sort(void *base, CFL_UINT32 count, CFL_UINT32 itemSize, CFL_SORT_CMP_FUNC cmp) {
+   SORT_CONTEXT ctx;
+   SORT_ITEM stackItem;
+   int badAllowed = 1;
+   CFL_UINT32 n;
+
+   if (count < 2 || itemSize == 0) {
+      return;
+   }
+   ctx.cmp = cmp;
+   ctx.size = itemSize;
+   ctx.tmp = sort_allocTmp(&stackItem, itemSize);
+   if (ctx.tmp == NULL) {
+      // Without a scratch item heapsort still works, since it only swaps
+      sort_heap(&ctx, (CFL_UINT8 *) base, (CFL_UINT8 *) base + (size_t) count * itemSize);
+      return;
+   }
+   for (n = count; n > 1; n >>= 1) {
+      ++badAllowed;
+   }
+   sort_pdq(&ctx, (CFL_UINT8 *) base, (CFL_UINT8 *) base + (size_t) count * itemSize, badAllowed, CFL_TRUE);
+   sort_freeTmp(&stackItem, ctx.tmp);
+}
+
+// Merge sort of [begin, end) using aux, which has room for half of the items.
+
+static void sort_merge(SORT_CONTEXT *c, CFL_UINT8 *begin, size_t count, CFL_UINT8 *aux) {
+   size_t size = c->size;
+   size_t middle;
+   CFL_UINT8 *left;
+   CFL_UINT8 *leftEnd;
+   CFL_UINT8 *right;
+   CFL_UINT8 *end;
+   CFL_UINT8 *dest;
+
+   if (count < INSERTION_SORT_THRESHOLD) {
+      sort_insertion(c, begin, begin + count * size, CFL_TRUE);
+      return;
+   }
+   middle = count / 2;
+   sort_merge(c, begin, middle, aux);
+   sort_merge(c, begin + middle * size, count - middle, aux);
+   right = begin + middle * size;
+   // Already in order
+   if (!LESS(c, right, right - size)) {
+      return;
+   }
+   memcpy(aux, begin, middle * size);
+   left = aux;
+   leftEnd = aux + middle * size;
+   end = begin + count * size;
+   dest = begin;
+   while (left < leftEnd && right < end) {
+      // Take from the right only when strictly less, keeping equal items in their original order
+      if (LESS(c, right, left)) {
+         sort_copy(dest, right, size);
+         right += size;
+      } else {
+         sort_copy(dest, left, size);
+         left += size;
+      }
+      dest += size;
+   }
+   if (left < leftEnd) {
+      memcpy(dest, left, (size_t) (leftEnd - left));
+   }
+}
+
+CFL_BOOL cfl_sort_stable(void *base, CFL_UINT32 count, CFL_UINT32 itemSize, CFL_SORT_CMP_FUNC cmp) {
+   SORT_CONTEXT ctx;
+   SORT_ITEM stackItem;
+   CFL_UINT8 *aux;
+
+   if (count < 2 || itemSize == 0) {
+      return CFL_TRUE;
+   }
+   ctx.cmp = cmp;
+   ctx.size = itemSize;
+   ctx.tmp = sort_allocTmp(&stackItem, itemSize);
+   if (ctx.tmp == NULL) {
+      return CFL_FALSE;
+   }
+   aux = (CFL_UINT8 *) CFL_MEM_ALLOC(((size_t) count / 2 + 1) * itemSize);
+   if (aux == NULL) {
+      sort_freeTmp(&stackItem, ctx.tmp);
+      return CFL_FALSE;
+   }
+   sort_merge(&ctx, (CFL_UINT8 *) base, count, aux);
+   CFL_MEM_FREE(aux);
+   sort_freeTmp(&stackItem, ctx.tmp);
+   return CFL_TRUE;
+}
+
+static CFL_BOOL sort_isBigEndian(void) {
+   CFL_UINT16 value = 1;
+   return *((CFL_UINT8 *) &value) == 0;
+}
+
+CFL_BOOL cfl_sort_radix(void *base, CFL_UINT32 count, CFL_UINT32 itemSize, CFL_UINT32 keyOffset,
+                        CFL_UINT32 keySize, CFL_SORT_KEY_TYPE keyType) {
+   CFL_UINT32 *histograms;
+   CFL_UINT8 *buffer;
+   CFL_UINT8 *src;
+   CFL_UINT8 *dest;
+   CFL_BOOL bMostSignificantFirst;
+   CFL_UINT32 pass;
+   size_t i;
+
+   if (keySize == 0 || keyOffset >= itemSize || keySize > itemSize - keyOffset) {
+      return CFL_FALSE;
+   }
+   if (keyType != CFL_SORT_KEY_BYTES && keySize != 1 && keySize != 2 && keySize != 4 && keySize != 8) {
+      return CFL_FALSE;
+   }
+   if (count < 2) {
+      return CFL_TRUE;
+   }
+   histograms = (CFL_UINT32 *) CFL_MEM_ALLOC((size_t) keySize * 256 * sizeof(CFL_UINT32));
+   if (histograms == NULL) {
+      return CFL_FALSE;
+   }
+   buffer = (CFL_UINT8 *) CFL_MEM_ALLOC((size_t) count * itemSize);
+   if (buffer == NULL) {
+      CFL_MEM_FREE(histograms);
+      return CFL_FALSE;
+   }
+   // Byte strings and big endian integers have the most significant byte first
+   bMostSignificantFirst = keyType == CFL_SORT_KEY_BYTES || sort_isBigEndian();
+
+   // Count the digits of all the passes in a single read of the items. The histogram of pass p counts the p-th least
+   // significant byte of the keys, with the sign bit of signed keys flipped so that negative values come first.
+   memset(histograms, 0, (size_t) keySize * 256 * sizeof(CFL_UINT32));
+   src = (CFL_UINT8 *) base + keyOffset;
+   for (i = 0; i < count; i++) {
+      for (pass = 0; pass < keySize; pass++) {
+         CFL_UINT32 byteIndex = bMostSignificantFirst ? keySize - 1 - pass : pass;
+         CFL_UINT8 digit = src[byteIndex];
+         if (keyType == CFL_SORT_KEY_SIGNED && pass == keySize - 1) {
+            digit ^= 0x80;
+         }
+         ++histograms[pass * 256 + digit];
+      }
+      src += itemSize;
+   }
+
+   src = (CFL_UINT8 *) base;
+   dest = buffer;
+   for (pass = 0; pass < keySize; pass++) {
+      CFL_UINT32 *histogram = &histograms[pass * 256];
+      CFL_UINT32 byteIndex = keyOffset + (bMostSignificantFirst ? keySize - 1 - pass : pass);
+      CFL_UINT8 flip = (CFL_UINT8) (keyType == CFL_SORT_KEY_SIGNED && pass == keySize - 1 ? 0x80 : 0);
+      CFL_UINT32 offset = 0;
+      CFL_UINT32 digit;
+      CFL_UINT8 *item;
+      CFL_UINT8 *srcEnd;
+
+      // All the items have the same digit in this pass
+      if (histogram[src[byteIndex] ^ flip] == count) {
+         continue;
+      }
+      for (digit = 0; digit < 256; digit++) {
+         CFL_UINT32 digitCount = histogram[digit];
+         histogram[digit] = offset;
+         offset += digitCount;
+      }
+      srcEnd = src + (size_t) count * itemSize;
+      for (item = src; item < srcEnd; item += itemSize) {
+         sort_copy(dest + (size_t) histogram[item[byteIndex] ^ flip]++ * itemSize, item, itemSize);
+      }
+      item = src;
+      src = dest;
+      dest = item;
+   }
+   if (src != (CFL_UINT8 *) base) {
+      memcpy(base, src, (size_t) count * itemSize);
+   }
+   CFL_MEM_FREE(buffer);
+   CFL_MEM_FREE(histograms);
+   return CFL_TRUE;
+}
@@ -55,8 +55,144 @@ TEST_CASE(test_cfl_array_remove) {
     cfl_array_free(array);
 }
 
+static int compare_doubles(const void *a, const void *b) {
+    double d1 = *(const double *)a;
+    double d2 = *(const double *)b;
+    return d1 < d2 ? -1 : (d1 > d2 ? 1 : 0);
+}
+
+TEST_CASE(test_cfl_array_sort) {
+    CFL_ARRAYP array = cfl_array_new(5, sizeof(double));
+    CFL_ARRAYP ints = cfl_array_new(5, sizeof(CFL_INT32));
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        *(double *)cfl_array_add(array) = (double)((i * 37) % 100) / 4;
+        *(CFL_INT32 *)cfl_array_add(ints) = (i * 37) % 100 - 50;
+    }
+    cfl_array_sort(array, compare_doubles);
+    TEST_ASSERT(cfl_array_sortByKey(ints, 0, sizeof(CFL_INT32), CFL_SORT_KEY_SIGNED));
+    for (i = 0; i < 100; i++) {
+        TEST_ASSERT(*(double *)cfl_array_get(array, i) == (double)i / 4);
+        TEST_ASSERT_EQUAL_INT(i - 50, *(CFL_INT32 *)cfl_array_get(ints, i));
+    }
+    TEST_ASSERT(cfl_array_sortStable(array, compare_doubles));
+    TEST_ASSERT(*(double *)cfl_array_get(array, 99) == 24.75);
+
+    cfl_array_free(array);
+    cfl_array_free(ints);
+}
+
+TEST_CASE(test_cfl_array_bulk) {
+    CFL_ARRAYP array = cfl_array_new(0, sizeof(CFL_INT32));
+    CFL_ARRAYP other = cfl_array_new(4, sizeof(CFL_INT32));
+    CFL_INT32 values[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    CFL_INT32 *slots;
+    int i;
+
+    TEST_ASSERT(cfl_array_reserve(array, 100));
+    TEST_ASSERT_EQUAL_INT(100, array->ulCapacity);
+    TEST_ASSERT(cfl_array_appendN(array, values, 10) != NULL);
+    TEST_ASSERT_EQUAL_INT(10, cfl_array_length(array));
+    TEST_ASSERT_EQUAL_INT(100, array->ulCapacity);
+
+    // insert 100, 101 and 102 after 4
+    slots = (CFL_INT32 *)cfl_array_insertRange(array, 5, NULL, 3);
+    TEST_ASSERT(slots != NULL);
+    for (i = 0; i < 3; i++) {
+        slots[i] = 100 + i;
+    }
+    TEST_ASSERT_EQUAL_INT(13, cfl_array_length(array));
+    TEST_ASSERT_EQUAL_INT(4, *(CFL_INT32 *)cfl_array_get(array, 4));
+    TEST_ASSERT_EQUAL_INT(101, *(CFL_INT32 *)cfl_array_get(array, 6));
+    TEST_ASSERT_EQUAL_INT(5, *(CFL_INT32 *)cfl_array_get(array, 8));
+    TEST_ASSERT(cfl_array_insertRange(array, 14, values, 1) == NULL);
+
+    cfl_array_deleteRange(array, 5, 3);
+    for (i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT(i, *(CFL_INT32 *)cfl_array_get(array, i));
+    }
+    cfl_array_deleteRange(array, 8, 100);
+    TEST_ASSERT_EQUAL_INT(8, cfl_array_length(array));
+
+    *(CFL_INT32 *)cfl_array_add(other) = 42;
+    TEST_ASSERT(cfl_array_addAll(array, other));
+    TEST_ASSERT_EQUAL_INT(42, *(CFL_INT32 *)cfl_array_get(array, 8));
+
+    TEST_ASSERT(cfl_array_resize(array, 20, CFL_TRUE));
+    TEST_ASSERT_EQUAL_INT(0, *(CFL_INT32 *)cfl_array_get(array, 19));
+    TEST_ASSERT(cfl_array_resize(array, 200, CFL_FALSE));
+    TEST_ASSERT_EQUAL_INT(200, cfl_array_length(array));
+    TEST_ASSERT(array->ulCapacity >= 200);
+    TEST_ASSERT(cfl_array_resize(array, 9, CFL_FALSE));
+    cfl_array_shrinkToFit(array);
+    TEST_ASSERT_EQUAL_INT(9, array->ulCapacity);
+    TEST_ASSERT_EQUAL_INT(42, *(CFL_INT32 *)cfl_array_get(array, 8));
+    cfl_array_clear(array);
+    cfl_array_shrinkToFit(array);
+    TEST_ASSERT(array->items == NULL);
+    *(CFL_INT32 *)cfl_array_add(array) = 7;
+    TEST_ASSERT_EQUAL_INT(7, *(CFL_INT32 *)cfl_array_get(array, 0));
+
+    cfl_array_free(array);
+    cfl_array_free(other);
+}
+
+TEST_CASE(test_cfl_array_self_append) {
+    CFL_ARRAYP array = cfl_array_new(0, sizeof(CFL_INT32));
+    CFL_INT32 values[4] = { 0, 1, 2, 3 };
+    CFL_INT32 expected[] = { 0, 1, 0, 1, 2, 3, 2, 3, 2, 3, 2, 3 };
+    CFL_UINT32 i;
+
+    // The source is in the array, which must grow before the copy
+    TEST_ASSERT(cfl_array_appendN(array, values, 4) != NULL);
+    cfl_array_shrinkToFit(array);
+    TEST_ASSERT(cfl_array_addAll(array, array));
+    TEST_ASSERT_EQUAL_INT(8, cfl_array_length(array));
+    for (i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_INT(i % 4, *(CFL_INT32 *)cfl_array_get(array, i));
+    }
+
+    // Insert 1, 2 and 3 before 2: the source spans the insertion point
+    cfl_array_clear(array);
+    TEST_ASSERT(cfl_array_appendN(array, values, 4) != NULL);
+    cfl_array_shrinkToFit(array);
+    TEST_ASSERT(cfl_array_insertRange(array, 2, cfl_array_get(array, 0), 4) != NULL);
+    TEST_ASSERT(cfl_array_insertRange(array, 8, cfl_array_get(array, 4), 4) != NULL);
+    TEST_ASSERT_EQUAL_INT(12, cfl_array_length(array));
+    for (i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL_INT(expected[i], *(CFL_INT32 *)cfl_array_get(array, i));
+    }
+    cfl_array_free(array);
+}
+
+TEST_CASE(test_cfl_array_iterator_init) {
+    CFL_ARRAYP array = cfl_array_new(5, sizeof(int));
+    CFL_ITERATOR_BUFFER buffer;
+    CFL_ITERATORP it;
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        *(int *)cfl_array_add(array) = i * 10;
+    }
+    it = cfl_array_iteratorInit(&buffer.iterator, array);
+    TEST_ASSERT(it == &buffer.iterator);
+    for (i = 0; cfl_iterator_hasNext(it); i++) {
+        TEST_ASSERT_EQUAL_INT(i * 10, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT_EQUAL_INT(5, i);
+    TEST_ASSERT_EQUAL_INT(30, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_dispose(it);
+
+    cfl_array_free(array);
+}
+
 TEST_SUITE_BEGIN()
     RUN_TEST(test_cfl_array_new_free);
     RUN_TEST(test_cfl_array_add_get);
     RUN_TEST(test_cfl_array_remove);
+    RUN_TEST(test_cfl_array_sort);
+    RUN_TEST(test_cfl_array_bulk);
+    RUN_TEST(test_cfl_array_self_append);
+    RUN_TEST(test_cfl_array_iterator_init);
 TEST_SUITE_END()
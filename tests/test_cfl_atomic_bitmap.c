@@ -0,0 +1,117 @@
+#include "cfl_test.h"
+#include "cfl_atomic_bitmap.h"
+#include "cfl_thread.h"
+
+#define THREAD_COUNT 4
+#define SLOT_COUNT 1000
+
+typedef struct {
+    CFL_ATOMIC_BITMAPP bitmap;
+    CFL_UINT32 hint;
+    CFL_INT64 slots[SLOT_COUNT];
+    CFL_UINT32 acquired;
+} WORKER;
+
+static void acquire_slots(void *arg) {
+    WORKER *worker = (WORKER *)arg;
+    CFL_UINT32 i;
+    // Churn: take and give back slots before keeping a share of them
+    for (i = 0; i < 2000; i++) {
+        CFL_INT64 slot = cfl_atomic_bitmap_tryAcquireFirstClear(worker->bitmap, &worker->hint);
+        if (slot >= 0) {
+            cfl_atomic_bitmap_release(worker->bitmap, (CFL_UINT32)slot);
+        }
+    }
+    for (i = 0; i < SLOT_COUNT / THREAD_COUNT; i++) {
+        worker->slots[i] = cfl_atomic_bitmap_tryAcquireFirstClear(worker->bitmap, &worker->hint);
+        if (worker->slots[i] >= 0) {
+            worker->acquired++;
+        }
+    }
+}
+
+TEST_CASE(test_cfl_atomic_bitmap_acquire_release) {
+    CFL_ATOMIC_BITMAPP bitmap = cfl_atomic_bitmap_new(130);
+    CFL_ATOMIC_BITMAP empty;
+    CFL_UINT32 hint = 0;
+    CFL_UINT32 i;
+
+    TEST_ASSERT(bitmap != NULL);
+    TEST_ASSERT_EQUAL_INT(130, cfl_atomic_bitmap_size(bitmap));
+    TEST_ASSERT_EQUAL_INT(0, cfl_atomic_bitmap_count(bitmap));
+
+    TEST_ASSERT_EQUAL_INT(0, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, NULL));
+    TEST_ASSERT_EQUAL_INT(1, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, &hint));
+    TEST_ASSERT_EQUAL_INT(1, hint);
+    TEST_ASSERT(cfl_atomic_bitmap_tryAcquire(bitmap, 2));
+    TEST_ASSERT(!cfl_atomic_bitmap_tryAcquire(bitmap, 2));
+    TEST_ASSERT(!cfl_atomic_bitmap_tryAcquire(bitmap, 130));
+    TEST_ASSERT_EQUAL_INT(3, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, &hint));
+    TEST_ASSERT_EQUAL_INT(4, cfl_atomic_bitmap_count(bitmap));
+
+    // The search starts at the hint and wraps around
+    hint = 128;
+    TEST_ASSERT_EQUAL_INT(128, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, &hint));
+    TEST_ASSERT_EQUAL_INT(129, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, &hint));
+    TEST_ASSERT_EQUAL_INT(4, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, &hint));
+
+    TEST_ASSERT(cfl_atomic_bitmap_release(bitmap, 1));
+    TEST_ASSERT(!cfl_atomic_bitmap_release(bitmap, 1));
+    TEST_ASSERT(!cfl_atomic_bitmap_get(bitmap, 1));
+    TEST_ASSERT(cfl_atomic_bitmap_get(bitmap, 2));
+    hint = 100;
+    for (i = 0; i < 124; i++) {
+        TEST_ASSERT(cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, &hint) >= 0);
+    }
+    TEST_ASSERT_EQUAL_INT(130, cfl_atomic_bitmap_count(bitmap));
+    TEST_ASSERT_EQUAL_INT(-1, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, &hint));
+    TEST_ASSERT(cfl_atomic_bitmap_release(bitmap, 77));
+    TEST_ASSERT_EQUAL_INT(77, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, &hint));
+    cfl_atomic_bitmap_free(bitmap);
+
+    TEST_ASSERT(cfl_atomic_bitmap_init(&empty, 0));
+    TEST_ASSERT_EQUAL_INT(-1, (int)cfl_atomic_bitmap_tryAcquireFirstClear(&empty, NULL));
+    TEST_ASSERT_EQUAL_INT(0, cfl_atomic_bitmap_count(&empty));
+    cfl_atomic_bitmap_free(&empty);
+}
+
+TEST_CASE(test_cfl_atomic_bitmap_threads) {
+    CFL_ATOMIC_BITMAPP bitmap = cfl_atomic_bitmap_new(SLOT_COUNT);
+    CFL_THREADP threads[THREAD_COUNT];
+    static WORKER workers[THREAD_COUNT];
+    CFL_UINT8 seen[SLOT_COUNT];
+    CFL_UINT32 i;
+    CFL_UINT32 j;
+
+    memset(seen, 0, sizeof(seen));
+    for (i = 0; i < THREAD_COUNT; i++) {
+        memset(&workers[i], 0, sizeof(WORKER));
+        workers[i].bitmap = bitmap;
+        workers[i].hint = i * (SLOT_COUNT / THREAD_COUNT);
+        threads[i] = cfl_thread_new(acquire_slots);
+        TEST_ASSERT(threads[i] != NULL);
+        cfl_thread_start(threads[i], &workers[i]);
+    }
+    for (i = 0; i < THREAD_COUNT; i++) {
+        cfl_thread_wait(threads[i]);
+        cfl_thread_free(threads[i]);
+    }
+
+    // Every thread got its share and no slot was given twice
+    for (i = 0; i < THREAD_COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT(SLOT_COUNT / THREAD_COUNT, workers[i].acquired);
+        for (j = 0; j < workers[i].acquired; j++) {
+            TEST_ASSERT(workers[i].slots[j] >= 0 && workers[i].slots[j] < SLOT_COUNT);
+            TEST_ASSERT_EQUAL_INT(0, seen[workers[i].slots[j]]);
+            seen[workers[i].slots[j]] = 1;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(SLOT_COUNT, cfl_atomic_bitmap_count(bitmap));
+    TEST_ASSERT_EQUAL_INT(-1, (int)cfl_atomic_bitmap_tryAcquireFirstClear(bitmap, NULL));
+    cfl_atomic_bitmap_free(bitmap);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_atomic_bitmap_acquire_release);
+    RUN_TEST(test_cfl_atomic_bitmap_threads);
+TEST_SUITE_END()
@@ -0,0 +1,166 @@
+#include "cfl_test.h"
+#include "cfl_bitset.h"
+
+static CFL_BOOL collect_positions(CFL_UINT32 pos, void *context) {
+    CFL_UINT32 *positions = (CFL_UINT32 *)context;
+    positions[++positions[0]] = pos;
+    return positions[0] < 4;
+}
+
+TEST_CASE(test_cfl_bitset_set_get) {
+    CFL_BITSETP bitset = cfl_bitset_new(1000);
+    CFL_BITSET local;
+
+    TEST_ASSERT(bitset != NULL);
+    TEST_ASSERT_EQUAL_INT(1000, (int)cfl_bitset_size(bitset));
+    TEST_ASSERT_EQUAL_INT(16, bitset->wordCount);
+    TEST_ASSERT_EQUAL_INT(0, (int)cfl_bitset_count(bitset));
+
+    cfl_bitset_set(bitset, 0);
+    cfl_bitset_set(bitset, 63);
+    cfl_bitset_set(bitset, 64);
+    cfl_bitset_set(bitset, 999);
+    cfl_bitset_set(bitset, 1000);
+    TEST_ASSERT(cfl_bitset_get(bitset, 0));
+    TEST_ASSERT(cfl_bitset_get(bitset, 63));
+    TEST_ASSERT(cfl_bitset_get(bitset, 64));
+    TEST_ASSERT(cfl_bitset_get(bitset, 999));
+    TEST_ASSERT(!cfl_bitset_get(bitset, 1));
+    TEST_ASSERT(!cfl_bitset_get(bitset, 1000));
+    TEST_ASSERT_EQUAL_INT(4, (int)cfl_bitset_count(bitset));
+
+    cfl_bitset_reset(bitset, 63);
+    TEST_ASSERT(!cfl_bitset_get(bitset, 63));
+    TEST_ASSERT_EQUAL_INT(3, (int)cfl_bitset_count(bitset));
+
+    cfl_bitset_fill(bitset);
+    TEST_ASSERT_EQUAL_INT(1000, (int)cfl_bitset_count(bitset));
+    cfl_bitset_clear(bitset);
+    TEST_ASSERT_EQUAL_INT(0, (int)cfl_bitset_count(bitset));
+    cfl_bitset_free(bitset);
+
+    TEST_ASSERT(cfl_bitset_init(&local, 0));
+    TEST_ASSERT_EQUAL_INT(0, (int)cfl_bitset_count(&local));
+    TEST_ASSERT_EQUAL_INT(-1, (int)cfl_bitset_nextSet(&local, 0));
+    TEST_ASSERT(cfl_bitset_resize(&local, 130));
+    cfl_bitset_set(&local, 129);
+    TEST_ASSERT_EQUAL_INT(129, (int)cfl_bitset_nextSet(&local, 0));
+    TEST_ASSERT(cfl_bitset_resize(&local, 129));
+    TEST_ASSERT_EQUAL_INT(0, (int)cfl_bitset_count(&local));
+    TEST_ASSERT(cfl_bitset_resize(&local, 200));
+    TEST_ASSERT(!cfl_bitset_get(&local, 129));
+    cfl_bitset_free(&local);
+
+    TEST_ASSERT(cfl_bitset_new(CFL_BITSET_MAX_BITS + 1) == NULL);
+}
+
+TEST_CASE(test_cfl_bitset_scan) {
+    CFL_BITSETP bitset = cfl_bitset_new(300);
+    CFL_UINT32 positions[10];
+    CFL_UINT32 i;
+
+    TEST_ASSERT_EQUAL_INT(-1, (int)cfl_bitset_nextSet(bitset, 0));
+    TEST_ASSERT_EQUAL_INT(0, (int)cfl_bitset_nextClear(bitset, 0));
+
+    cfl_bitset_set(bitset, 5);
+    cfl_bitset_set(bitset, 64);
+    cfl_bitset_set(bitset, 200);
+    cfl_bitset_set(bitset, 299);
+    TEST_ASSERT_EQUAL_INT(5, (int)cfl_bitset_nextSet(bitset, 0));
+    TEST_ASSERT_EQUAL_INT(5, (int)cfl_bitset_nextSet(bitset, 5));
+    TEST_ASSERT_EQUAL_INT(64, (int)cfl_bitset_nextSet(bitset, 6));
+    TEST_ASSERT_EQUAL_INT(200, (int)cfl_bitset_nextSet(bitset, 65));
+    TEST_ASSERT_EQUAL_INT(299, (int)cfl_bitset_nextSet(bitset, 201));
+    TEST_ASSERT_EQUAL_INT(-1, (int)cfl_bitset_nextSet(bitset, 300));
+
+    TEST_ASSERT_EQUAL_INT(6, (int)cfl_bitset_nextClear(bitset, 5));
+    cfl_bitset_fill(bitset);
+    cfl_bitset_reset(bitset, 130);
+    TEST_ASSERT_EQUAL_INT(130, (int)cfl_bitset_nextClear(bitset, 0));
+    TEST_ASSERT_EQUAL_INT(-1, (int)cfl_bitset_nextClear(bitset, 131));
+
+    cfl_bitset_clear(bitset);
+    cfl_bitset_set(bitset, 1);
+    cfl_bitset_set(bitset, 70);
+    cfl_bitset_set(bitset, 71);
+    cfl_bitset_set(bitset, 150);
+    cfl_bitset_set(bitset, 250);
+    positions[0] = 0;
+    TEST_ASSERT(!cfl_bitset_forEach(bitset, collect_positions, positions));
+    TEST_ASSERT_EQUAL_INT(4, positions[0]);
+    TEST_ASSERT_EQUAL_INT(1, positions[1]);
+    TEST_ASSERT_EQUAL_INT(150, positions[4]);
+
+    TEST_ASSERT_EQUAL_INT(3, cfl_bitset_toArray(bitset, 2, positions, 3));
+    TEST_ASSERT_EQUAL_INT(70, positions[0]);
+    TEST_ASSERT_EQUAL_INT(150, positions[2]);
+    TEST_ASSERT_EQUAL_INT(2, cfl_bitset_toArray(bitset, 150, positions, 10));
+    TEST_ASSERT_EQUAL_INT(250, positions[1]);
+    for (i = 0; i < 10; i++) {
+        positions[i] = 0;
+    }
+    TEST_ASSERT_EQUAL_INT(0, cfl_bitset_toArray(bitset, 251, positions, 10));
+    cfl_bitset_free(bitset);
+}
+
+TEST_CASE(test_cfl_bitset_operations) {
+    CFL_BITSETP multiplesOf2 = cfl_bitset_new(1000);
+    CFL_BITSETP multiplesOf3 = cfl_bitset_new(1000);
+    CFL_BITSETP small = cfl_bitset_new(100);
+    CFL_BITSETP result;
+    CFL_UINT32 i;
+
+    for (i = 0; i < 1000; i++) {
+        if (i % 2 == 0) {
+            cfl_bitset_set(multiplesOf2, i);
+        }
+        if (i % 3 == 0) {
+            cfl_bitset_set(multiplesOf3, i);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(167, (int)cfl_bitset_andCount(multiplesOf2, multiplesOf3));
+
+    result = cfl_bitset_clone(multiplesOf2);
+    TEST_ASSERT(cfl_bitset_equals(result, multiplesOf2));
+    cfl_bitset_and(result, multiplesOf3);
+    TEST_ASSERT_EQUAL_INT(167, (int)cfl_bitset_count(result));
+    TEST_ASSERT(cfl_bitset_get(result, 996));
+    TEST_ASSERT(!cfl_bitset_get(result, 994));
+    cfl_bitset_free(result);
+
+    result = cfl_bitset_clone(multiplesOf2);
+    cfl_bitset_or(result, multiplesOf3);
+    TEST_ASSERT_EQUAL_INT(667, (int)cfl_bitset_count(result));
+    cfl_bitset_free(result);
+
+    result = cfl_bitset_clone(multiplesOf2);
+    cfl_bitset_xor(result, multiplesOf3);
+    TEST_ASSERT_EQUAL_INT(500, (int)cfl_bitset_count(result));
+    cfl_bitset_free(result);
+
+    result = cfl_bitset_clone(multiplesOf2);
+    cfl_bitset_andNot(result, multiplesOf3);
+    TEST_ASSERT_EQUAL_INT(333, (int)cfl_bitset_count(result));
+    TEST_ASSERT(!cfl_bitset_equals(result, multiplesOf2));
+    cfl_bitset_free(result);
+
+    // Operands of different sizes
+    cfl_bitset_fill(small);
+    result = cfl_bitset_clone(multiplesOf2);
+    cfl_bitset_and(result, small);
+    TEST_ASSERT_EQUAL_INT(50, (int)cfl_bitset_count(result));
+    cfl_bitset_or(small, multiplesOf3);
+    TEST_ASSERT_EQUAL_INT(100, (int)cfl_bitset_count(small));
+    TEST_ASSERT_EQUAL_INT(-1, (int)cfl_bitset_nextSet(small, 100));
+    cfl_bitset_free(result);
+
+    cfl_bitset_free(multiplesOf2);
+    cfl_bitset_free(multiplesOf3);
+    cfl_bitset_free(small);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_bitset_set_get);
+    RUN_TEST(test_cfl_bitset_scan);
+    RUN_TEST(test_cfl_bitset_operations);
+TEST_SUITE_END()
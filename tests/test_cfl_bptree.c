@@ -0,0 +1,226 @@
+#include "cfl_test.h"
+#include "cfl_bptree.h"
+#include "cfl_mem.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int allocations_left;
+
+static void *limited_malloc(size_t size) {
+    if (allocations_left == 0) {
+        return NULL;
+    }
+    --allocations_left;
+    return malloc(size);
+}
+
+static CFL_INT16 compare_int_keys(void *k1, void *k2, CFL_BOOL bExact) {
+    int i1 = *(int*)k1;
+    int i2 = *(int*)k2;
+    (void)bExact;
+    return (CFL_INT16)(i1 < i2 ? -1 : (i1 > i2 ? 1 : 0));
+}
+
+static CFL_INT16 compare_str_keys(void *k1, void *k2, CFL_BOOL bExact) {
+    int cmp;
+    if (bExact) {
+        cmp = strcmp((const char *)k1, (const char *)k2);
+    } else {
+        cmp = strncmp((const char *)k1, (const char *)k2, strlen((const char *)k1));
+    }
+    return (CFL_INT16)(cmp < 0 ? -1 : (cmp > 0 ? 1 : 0));
+}
+
+TEST_CASE(test_cfl_bptree_add_search) {
+    CFL_BPTREEP tree = cfl_bptree_new(3, compare_int_keys);
+    int keys[200];
+    int i;
+
+    for (i = 0; i < 200; i++) {
+        keys[i] = (i * 37) % 200;
+        TEST_ASSERT(cfl_bptree_add(tree, &keys[i]));
+    }
+    TEST_ASSERT(!cfl_bptree_add(tree, &keys[10]));
+    TEST_ASSERT_EQUAL_INT(200, cfl_bptree_count(tree));
+
+    for (i = 0; i < 200; i++) {
+        int *found = (int *)cfl_bptree_search(tree, &i);
+        TEST_ASSERT(found != NULL);
+        TEST_ASSERT_EQUAL_INT(i, *found);
+    }
+    i = 500;
+    TEST_ASSERT(cfl_bptree_search(tree, &i) == NULL);
+
+    cfl_bptree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_bptree_delete) {
+    CFL_BPTREEP tree = cfl_bptree_new(4, compare_int_keys);
+    int keys[300];
+    int i;
+    int expected;
+    CFL_ITERATORP it;
+
+    for (i = 0; i < 300; i++) {
+        keys[i] = i;
+        cfl_bptree_add(tree, &keys[i]);
+    }
+    // remove the odd keys out of order
+    for (i = 299; i >= 0; i -= 2) {
+        TEST_ASSERT(cfl_bptree_delete(tree, &keys[i]) == &keys[i]);
+        keys[i] = -1; // deleted keys may be released by the caller
+    }
+    i = 1;
+    TEST_ASSERT(cfl_bptree_delete(tree, &i) == NULL);
+    TEST_ASSERT_EQUAL_INT(150, cfl_bptree_count(tree));
+
+    expected = 0;
+    it = cfl_bptree_iterator(tree);
+    while (cfl_iterator_hasNext(it)) {
+        TEST_ASSERT_EQUAL_INT(expected, *(int *)cfl_iterator_next(it));
+        expected += 2;
+    }
+    TEST_ASSERT_EQUAL_INT(300, expected);
+    cfl_iterator_free(it);
+
+    for (i = 0; i < 300; i += 2) {
+        TEST_ASSERT(cfl_bptree_delete(tree, &keys[i]) == &keys[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, cfl_bptree_count(tree));
+    it = cfl_bptree_iterator(tree);
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    cfl_bptree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_bptree_iterator) {
+    CFL_BPTREEP tree = cfl_bptree_new(3, compare_int_keys);
+    int keys[50];
+    int i;
+    int from = 10, to = 19;
+    CFL_ITERATORP it;
+
+    for (i = 0; i < 50; i++) {
+        keys[i] = 49 - i;
+        cfl_bptree_add(tree, &keys[i]);
+    }
+
+    it = cfl_bptree_iteratorLast(tree);
+    for (i = 49; i >= 0; i--) {
+        TEST_ASSERT(cfl_iterator_hasPrevious(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_previous(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasPrevious(it));
+    cfl_iterator_free(it);
+
+    it = cfl_bptree_iteratorRange(tree, &from, &to);
+    for (i = 10; i <= 19; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_value(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    TEST_ASSERT_EQUAL_INT(19, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_last(it);
+    TEST_ASSERT_EQUAL_INT(19, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_first(it);
+    TEST_ASSERT(!cfl_iterator_hasPrevious(it));
+    TEST_ASSERT_EQUAL_INT(10, *(int *)cfl_iterator_next(it));
+    cfl_iterator_free(it);
+
+    it = cfl_bptree_iteratorSearch(tree, &to);
+    TEST_ASSERT(it != NULL);
+    TEST_ASSERT_EQUAL_INT(19, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(20, *(int *)cfl_iterator_next(it));
+    cfl_iterator_free(it);
+
+    i = 100;
+    TEST_ASSERT(cfl_bptree_iteratorSearch(tree, &i) == NULL);
+
+    cfl_bptree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_bptree_like) {
+    CFL_BPTREEP tree = cfl_bptree_new(3, compare_str_keys);
+    char *words[] = { "banana", "apple", "carrot", "apricot", "avocado", "beet", "apex", "cherry", "ap", "b" };
+    char *expected[] = { "ap", "apex", "apple", "apricot" };
+    CFL_ITERATORP it;
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        cfl_bptree_add(tree, words[i]);
+    }
+
+    TEST_ASSERT_EQUAL_STRING("ap", (char *)cfl_bptree_searchLike(tree, "ap"));
+    TEST_ASSERT_EQUAL_STRING("beet", (char *)cfl_bptree_searchLike(tree, "be"));
+    TEST_ASSERT(cfl_bptree_searchLike(tree, "d") == NULL);
+
+    it = cfl_bptree_iteratorSearchLike(tree, "ap");
+    TEST_ASSERT(it != NULL);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_STRING(expected[i], (char *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    it = cfl_bptree_iteratorSearchLastLike(tree, "ap");
+    TEST_ASSERT(it != NULL);
+    for (i = 3; i >= 0; i--) {
+        TEST_ASSERT_EQUAL_STRING(expected[i], (char *)cfl_iterator_previous(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasPrevious(it));
+    cfl_iterator_free(it);
+
+    TEST_ASSERT(cfl_bptree_iteratorSearchLike(tree, "x") == NULL);
+
+    cfl_bptree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_bptree_out_of_memory) {
+    CFL_BPTREEP tree = cfl_bptree_new(2, compare_int_keys);
+    int keys[100];
+    int failures = 0;
+    int i;
+    CFL_ITERATORP it;
+
+    // Each key is retried with one more allocation until the splits it needs can be made
+    for (i = 0; i < 100; i++) {
+        int allowed = 0;
+        keys[i] = i;
+        for (;;) {
+            CFL_BOOL added;
+            allocations_left = allowed++;
+            cfl_mem_set(limited_malloc, NULL, NULL);
+            added = cfl_bptree_add(tree, &keys[i]);
+            cfl_mem_set(malloc, NULL, NULL);
+            if (added) {
+                break;
+            }
+            ++failures;
+            TEST_ASSERT_EQUAL_INT(i, cfl_bptree_count(tree));
+            TEST_ASSERT(cfl_bptree_search(tree, &keys[i]) == NULL);
+        }
+    }
+    TEST_ASSERT(failures > 100);
+    TEST_ASSERT_EQUAL_INT(100, cfl_bptree_count(tree));
+
+    it = cfl_bptree_iterator(tree);
+    for (i = 0; i < 100; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    cfl_bptree_free(tree, NULL);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_bptree_add_search);
+    RUN_TEST(test_cfl_bptree_delete);
+    RUN_TEST(test_cfl_bptree_iterator);
+    RUN_TEST(test_cfl_bptree_like);
+    RUN_TEST(test_cfl_bptree_out_of_memory);
+TEST_SUITE_END()
@@ -68,8 +68,299 @@ TEST_CASE(test_cfl_btree_delete) {
     cfl_btree_free(tree, NULL);
 }
 
+TEST_CASE(test_cfl_btree_position) {
+    CFL_BTREEP tree = cfl_btree_new(4, compare_int_keys);
+    int keys[500];
+    int i;
+
+    for (i = 0; i < 500; i++) {
+        keys[i] = (i * 7) % 500;
+        cfl_btree_add(tree, &keys[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(500, cfl_btree_count(tree));
+    for (i = 0; i < 500; i++) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_btree_searchPosition(tree, i + 1));
+    }
+    TEST_ASSERT(cfl_btree_searchPosition(tree, 0) == NULL);
+    TEST_ASSERT(cfl_btree_searchPosition(tree, 501) == NULL);
+
+    for (i = 0; i < 500; i += 2) {
+        int key = i;
+        TEST_ASSERT(cfl_btree_delete(tree, &key) != NULL);
+    }
+    TEST_ASSERT_EQUAL_INT(250, cfl_btree_count(tree));
+    for (i = 1; i < 500; i += 2) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_btree_searchPosition(tree, (i + 1) / 2));
+        TEST_ASSERT_EQUAL_INT((i + 1) / 2, cfl_btree_rank(tree, &i));
+    }
+    i = 100;
+    TEST_ASSERT_EQUAL_INT(0, cfl_btree_rank(tree, &i));
+
+    cfl_btree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_btree_iterator_at) {
+    CFL_BTREEP tree = cfl_btree_new(3, compare_int_keys);
+    int keys[200];
+    int i;
+    CFL_ITERATORP it;
+
+    for (i = 0; i < 200; i++) {
+        keys[i] = 199 - i;
+        cfl_btree_add(tree, &keys[i]);
+    }
+
+    it = cfl_btree_iterator(tree);
+    for (i = 0; i < 200; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    for (i = 199; i >= 0; i--) {
+        TEST_ASSERT(cfl_iterator_hasPrevious(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_previous(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasPrevious(it));
+    cfl_iterator_free(it);
+
+    for (i = 1; i <= 200; i += 13) {
+        it = cfl_btree_iteratorAt(tree, i);
+        TEST_ASSERT(it != NULL);
+        TEST_ASSERT_EQUAL_INT(i - 1, *(int *)cfl_iterator_next(it));
+        TEST_ASSERT_EQUAL_INT(i - 1, *(int *)cfl_iterator_value(it));
+        if (i < 200) {
+            TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+        }
+        cfl_iterator_free(it);
+    }
+    TEST_ASSERT(cfl_btree_iteratorAt(tree, 201) == NULL);
+
+    i = 120;
+    it = cfl_btree_iteratorSearch(tree, &i);
+    TEST_ASSERT(it != NULL);
+    TEST_ASSERT_EQUAL_INT(119, *(int *)cfl_iterator_previous(it));
+    TEST_ASSERT_EQUAL_INT(119, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(120, *(int *)cfl_iterator_next(it));
+    cfl_iterator_free(it);
+
+    cfl_btree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_btree_bulk_load) {
+    CFL_BTREEP tree = cfl_btree_new(8, compare_int_keys);
+    static int keys[1000];
+    static void *ptrs[1000];
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        keys[i] = i;
+        ptrs[i] = &keys[(i * 337) % 1000];
+    }
+    TEST_ASSERT(cfl_btree_sortAndLoad(tree, ptrs, 1000, 0.75));
+    TEST_ASSERT_EQUAL_INT(1000, cfl_btree_count(tree));
+    for (i = 0; i < 1000; i++) {
+        TEST_ASSERT(ptrs[i] == &keys[i]);
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_btree_searchPosition(tree, i + 1));
+    }
+    // the tree must not be reloaded
+    TEST_ASSERT(!cfl_btree_bulkLoad(tree, ptrs, 1000, 1.0));
+
+    // keeps working as a regular tree
+    i = 500;
+    TEST_ASSERT(cfl_btree_delete(tree, &i) == &keys[500]);
+    TEST_ASSERT(cfl_btree_add(tree, &keys[500]));
+    TEST_ASSERT_EQUAL_INT(501, cfl_btree_rank(tree, &i));
+    cfl_btree_free(tree, NULL);
+
+    // unsorted input and duplicates are rejected
+    tree = cfl_btree_new(8, compare_int_keys);
+    ptrs[0] = &keys[1];
+    ptrs[1] = &keys[0];
+    TEST_ASSERT(!cfl_btree_bulkLoad(tree, ptrs, 2, 1.0));
+    ptrs[1] = &keys[1];
+    TEST_ASSERT(!cfl_btree_sortAndLoad(tree, ptrs, 2, 1.0));
+    TEST_ASSERT_EQUAL_INT(0, cfl_btree_count(tree));
+    cfl_btree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_btree_search_batch) {
+    CFL_BTREEP tree = cfl_btree_new(4, compare_int_keys);
+    static int keys[1000];
+    void *searchKeys[1000];
+    void *results[1000];
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        keys[i] = (i * 337) % 1000;
+        searchKeys[i] = &keys[i];
+        if (keys[i] % 4 != 0) {
+            cfl_btree_add(tree, &keys[i]);
+        }
+    }
+    cfl_btree_searchBatch(tree, searchKeys, results, 1000);
+    for (i = 0; i < 1000; i++) {
+        TEST_ASSERT(results[i] == cfl_btree_search(tree, &keys[i]));
+        if (keys[i] % 4 == 0) {
+            TEST_ASSERT(results[i] == NULL);
+        } else {
+            TEST_ASSERT(results[i] == &keys[i]);
+        }
+    }
+    cfl_btree_free(tree, NULL);
+
+    // empty tree
+    tree = cfl_btree_new(4, compare_int_keys);
+    cfl_btree_searchBatch(tree, searchKeys, results, 3);
+    TEST_ASSERT(results[0] == NULL && results[1] == NULL && results[2] == NULL);
+    cfl_btree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_btree_snapshot) {
+    CFL_BTREEP tree = cfl_btree_new(3, compare_int_keys);
+    CFL_BTREEP snapshot;
+    CFL_BTREEP snapshot2;
+    CFL_ITERATOR_BUFFER buffer;
+    CFL_ITERATORP it;
+    static int keys[1000];
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        keys[i] = i;
+    }
+    for (i = 0; i < 1000; i += 2) {
+        cfl_btree_add(tree, &keys[i]);
+    }
+    snapshot = cfl_btree_snapshot(tree);
+    TEST_ASSERT(snapshot != NULL);
+
+    // modify the tree after the snapshot
+    for (i = 1; i < 1000; i += 2) {
+        TEST_ASSERT(cfl_btree_add(tree, &keys[i]));
+    }
+    for (i = 0; i < 1000; i += 4) {
+        TEST_ASSERT(cfl_btree_delete(tree, &keys[i]) == &keys[i]);
+    }
+    snapshot2 = cfl_btree_snapshot(tree);
+    for (i = 1; i < 1000; i += 4) {
+        TEST_ASSERT(cfl_btree_delete(tree, &keys[i]) == &keys[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(500, cfl_btree_count(tree));
+
+    // the snapshots still see the keys they had when taken
+    TEST_ASSERT_EQUAL_INT(500, cfl_btree_count(snapshot));
+    it = cfl_btree_iterator(snapshot);
+    for (i = 0; i < 1000; i += 2) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    // rewinding stays on the snapshot, not on the modified tree
+    cfl_iterator_first(it);
+    for (i = 0; i < 1000; i += 2) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_last(it);
+    TEST_ASSERT_EQUAL_INT(998, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_free(it);
+    it = cfl_btree_iteratorSearch(snapshot, &keys[500]);
+    TEST_ASSERT(it != NULL);
+    cfl_iterator_first(it);
+    TEST_ASSERT_EQUAL_INT(0, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(2, *(int *)cfl_iterator_next(it));
+    cfl_iterator_free(it);
+    it = cfl_btree_iteratorInit(&buffer.iterator, snapshot);
+    for (i = 0; i < 1000; i += 2) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_first(it);
+    TEST_ASSERT_EQUAL_INT(0, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(2, *(int *)cfl_iterator_next(it));
+    cfl_iterator_dispose(it);
+    it = cfl_btree_iteratorLastInit(&buffer.iterator, snapshot);
+    TEST_ASSERT_EQUAL_INT(998, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_first(it);
+    cfl_iterator_last(it);
+    TEST_ASSERT_EQUAL_INT(998, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_dispose(it);
+    TEST_ASSERT_EQUAL_INT(750, cfl_btree_count(snapshot2));
+    for (i = 0; i < 1000; i++) {
+        TEST_ASSERT((cfl_btree_search(snapshot2, &keys[i]) != NULL) == (i % 4 != 0));
+        TEST_ASSERT((cfl_btree_search(tree, &keys[i]) != NULL) == (i % 4 == 2 || i % 4 == 3));
+    }
+
+    // snapshots are read-only
+    TEST_ASSERT(!cfl_btree_add(snapshot, &keys[1]));
+    TEST_ASSERT(cfl_btree_delete(snapshot, &keys[0]) == NULL);
+    TEST_ASSERT_EQUAL_INT(500, cfl_btree_count(snapshot));
+
+    cfl_btree_free(snapshot, NULL);
+    for (i = 0; i < 1000; i += 4) {
+        TEST_ASSERT(cfl_btree_add(tree, &keys[i]));
+    }
+    TEST_ASSERT_EQUAL_INT(750, cfl_btree_count(snapshot2));
+    cfl_btree_free(snapshot2, NULL);
+    TEST_ASSERT_EQUAL_INT(750, cfl_btree_count(tree));
+    cfl_btree_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_btree_iterator_init) {
+    CFL_BTREEP tree = cfl_btree_new(3, compare_int_keys);
+    static int keys[2000];
+    CFL_ITERATOR_BUFFER buffer;
+    CFL_ITERATORP it;
+    int i;
+
+    it = cfl_btree_iteratorInit(&buffer.iterator, tree);
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    TEST_ASSERT(cfl_iterator_next(it) == NULL);
+    cfl_iterator_dispose(it);
+
+    for (i = 0; i < 2000; i++) {
+        keys[i] = (i * 7) % 2000;
+        cfl_btree_add(tree, &keys[i]);
+    }
+
+    it = cfl_btree_iteratorInit(&buffer.iterator, tree);
+    TEST_ASSERT(!cfl_iterator_hasPrevious(it));
+    for (i = 0; cfl_iterator_hasNext(it); i++) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_value(it));
+    }
+    TEST_ASSERT_EQUAL_INT(2000, i);
+    TEST_ASSERT(cfl_iterator_next(it) == NULL);
+    for (i = 1999; cfl_iterator_hasPrevious(it); i--) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_previous(it));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, i);
+    cfl_iterator_last(it);
+    TEST_ASSERT_EQUAL_INT(1999, *(int *)cfl_iterator_previous(it));
+    TEST_ASSERT_EQUAL_INT(1999, *(int *)cfl_iterator_next(it));
+    cfl_iterator_first(it);
+    TEST_ASSERT_EQUAL_INT(0, *(int *)cfl_iterator_next(it));
+    cfl_iterator_dispose(it);
+
+    it = cfl_btree_iteratorLastInit(&buffer.iterator, tree);
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    for (i = 1999; cfl_iterator_hasPrevious(it); i--) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_previous(it));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, i);
+    cfl_iterator_dispose(it);
+
+    cfl_btree_free(tree, NULL);
+}
+
 TEST_SUITE_BEGIN()
     RUN_TEST(test_cfl_btree_lifecycle);
     RUN_TEST(test_cfl_btree_add_find);
     RUN_TEST(test_cfl_btree_delete);
+    RUN_TEST(test_cfl_btree_position);
+    RUN_TEST(test_cfl_btree_iterator_at);
+    RUN_TEST(test_cfl_btree_bulk_load);
+    RUN_TEST(test_cfl_btree_search_batch);
+    RUN_TEST(test_cfl_btree_snapshot);
+    RUN_TEST(test_cfl_btree_iterator_init);
 TEST_SUITE_END()
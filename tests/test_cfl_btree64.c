@@ -0,0 +1,159 @@
+#include <stdlib.h>
+
+#include "cfl_test.h"
+#include "cfl_btree64.h"
+#include "cfl_mem.h"
+
+static int allocations_left;
+
+static void *limited_malloc(size_t size) {
+    if (allocations_left == 0) {
+        return NULL;
+    }
+    --allocations_left;
+    return malloc(size);
+}
+
+TEST_CASE(test_cfl_btree64_add_search) {
+    CFL_BTREE64P tree = cfl_btree64_new(4);
+    static int values[1000];
+    CFL_INT64 key;
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        values[i] = i;
+        key = ((CFL_INT64) ((i * 337) % 1000) - 500) * 10000000000LL;
+        TEST_ASSERT(cfl_btree64_add(tree, key, &values[(i * 337) % 1000]));
+    }
+    TEST_ASSERT(!cfl_btree64_add(tree, 0, NULL));
+    TEST_ASSERT_EQUAL_INT(1000, cfl_btree64_count(tree));
+
+    for (i = 0; i < 1000; i++) {
+        key = ((CFL_INT64) i - 500) * 10000000000LL;
+        TEST_ASSERT(cfl_btree64_search(tree, key) == &values[i]);
+        TEST_ASSERT(!cfl_btree64_contains(tree, key + 1));
+    }
+    TEST_ASSERT(cfl_btree64_search(tree, CFL_INT64_MAX) == NULL);
+
+    cfl_btree64_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_btree64_delete) {
+    CFL_BTREE64P tree = cfl_btree64_new(0);
+    static int values[2000];
+    int i;
+
+    for (i = 0; i < 2000; i++) {
+        values[i] = i;
+        cfl_btree64_add(tree, i, &values[i]);
+    }
+    for (i = 1999; i >= 0; i -= 2) {
+        TEST_ASSERT(cfl_btree64_delete(tree, i) == &values[i]);
+    }
+    TEST_ASSERT(cfl_btree64_delete(tree, 1) == NULL);
+    TEST_ASSERT_EQUAL_INT(1000, cfl_btree64_count(tree));
+    for (i = 0; i < 2000; i++) {
+        TEST_ASSERT(cfl_btree64_contains(tree, i) == (i % 2 == 0));
+    }
+    for (i = 0; i < 2000; i += 2) {
+        TEST_ASSERT(cfl_btree64_delete(tree, i) == &values[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, cfl_btree64_count(tree));
+    TEST_ASSERT(cfl_btree64_add(tree, 7, NULL));
+    TEST_ASSERT(cfl_btree64_contains(tree, 7));
+
+    cfl_btree64_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_btree64_iterator) {
+    CFL_BTREE64P tree = cfl_btree64_new(3);
+    static int values[100];
+    CFL_ITERATORP it;
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        values[i] = i;
+        cfl_btree64_add(tree, 99 - i, &values[99 - i]);
+    }
+
+    it = cfl_btree64_iterator(tree);
+    for (i = 0; i < 100; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+        TEST_ASSERT(cfl_btree64_iteratorKey(it) == i);
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_last(it);
+    TEST_ASSERT_EQUAL_INT(99, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_free(it);
+
+    it = cfl_btree64_iteratorRange(tree, 40, 59);
+    for (i = 40; i <= 59; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    for (i = 59; i >= 40; i--) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_previous(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasPrevious(it));
+    cfl_iterator_last(it);
+    TEST_ASSERT_EQUAL_INT(59, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_free(it);
+
+    // values may be NULL
+    cfl_btree64_add(tree, 1000, NULL);
+    it = cfl_btree64_iteratorRange(tree, 100, 2000);
+    TEST_ASSERT(cfl_iterator_hasNext(it));
+    TEST_ASSERT(cfl_iterator_next(it) == NULL);
+    TEST_ASSERT(cfl_btree64_iteratorKey(it) == 1000);
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    cfl_btree64_free(tree, NULL);
+}
+
+TEST_CASE(test_cfl_btree64_out_of_memory) {
+    CFL_BTREE64P tree = cfl_btree64_new(3);
+    int failures = 0;
+    CFL_INT64 key;
+    CFL_ITERATORP it;
+
+    // Each key is retried with one more allocation until the splits it needs can be made
+    for (key = 0; key < 100; key++) {
+        int allowed = 0;
+        for (;;) {
+            CFL_BOOL added;
+            allocations_left = allowed++;
+            cfl_mem_set(limited_malloc, NULL, NULL);
+            added = cfl_btree64_add(tree, key, NULL);
+            cfl_mem_set(malloc, NULL, NULL);
+            if (added) {
+                break;
+            }
+            ++failures;
+            TEST_ASSERT_EQUAL_INT(key, cfl_btree64_count(tree));
+            TEST_ASSERT(!cfl_btree64_contains(tree, key));
+        }
+    }
+    TEST_ASSERT(failures > 50);
+    TEST_ASSERT_EQUAL_INT(100, cfl_btree64_count(tree));
+
+    it = cfl_btree64_iterator(tree);
+    for (key = 0; key < 100; key++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        cfl_iterator_next(it);
+        TEST_ASSERT(key == cfl_btree64_iteratorKey(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    cfl_btree64_free(tree, NULL);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_btree64_add_search);
+    RUN_TEST(test_cfl_btree64_delete);
+    RUN_TEST(test_cfl_btree64_iterator);
+    RUN_TEST(test_cfl_btree64_out_of_memory);
+TEST_SUITE_END()
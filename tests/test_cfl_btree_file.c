@@ -0,0 +1,227 @@
+#include "cfl_test.h"
+#include "cfl_btree_file.h"
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_FILE "test_cfl_btree_file.dat"
+
+static CFL_INT16 compare_int_keys(void *k1, void *k2, CFL_BOOL bExact) {
+    int i1 = *(int*)k1;
+    int i2 = *(int*)k2;
+    (void)bExact;
+    return (CFL_INT16)(i1 < i2 ? -1 : (i1 > i2 ? 1 : 0));
+}
+
+static CFL_INT16 compare_str_keys(void *k1, void *k2, CFL_BOOL bExact) {
+    int cmp;
+    if (bExact) {
+        cmp = strcmp((const char *)k1, (const char *)k2);
+    } else {
+        cmp = strncmp((const char *)k1, (const char *)k2, strlen((const char *)k1));
+    }
+    return (CFL_INT16)(cmp < 0 ? -1 : (cmp > 0 ? 1 : 0));
+}
+
+static CFL_UINT32 int_key_size(void *key) {
+    (void)key;
+    return sizeof(int);
+}
+
+static CFL_UINT32 str_key_size(void *key) {
+    return (CFL_UINT32)strlen((const char *)key) + 1;
+}
+
+TEST_CASE(test_cfl_btree_file_int_keys) {
+    CFL_BTREEP tree = cfl_btree_new(16, compare_int_keys);
+    CFL_BTREE_FILEP file;
+    CFL_ITERATORP it;
+    static int keys[5000];
+    int i;
+
+    for (i = 0; i < 5000; i++) {
+        keys[i] = i * 2;
+        cfl_btree_add(tree, &keys[i]);
+    }
+    TEST_ASSERT(cfl_btree_file_write(tree, TEST_FILE, 256, int_key_size));
+    cfl_btree_free(tree, NULL);
+
+    file = cfl_btree_file_open(TEST_FILE, compare_int_keys);
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT_EQUAL_INT(5000, cfl_btree_file_count(file));
+    for (i = 0; i < 10000; i++) {
+        int *found = (int *)cfl_btree_file_search(file, &i);
+        if (i % 2 == 0) {
+            TEST_ASSERT(found != NULL);
+            TEST_ASSERT_EQUAL_INT(i, *found);
+        } else {
+            TEST_ASSERT(found == NULL);
+        }
+    }
+
+    it = cfl_btree_file_iterator(file);
+    for (i = 0; i < 5000; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i * 2, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    it = cfl_btree_file_iteratorLast(file);
+    TEST_ASSERT_EQUAL_INT(9998, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_free(it);
+
+    i = 4000;
+    it = cfl_btree_file_iteratorSearch(file, &i);
+    TEST_ASSERT(it != NULL);
+    TEST_ASSERT_EQUAL_INT(4000, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(4002, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(4002, *(int *)cfl_iterator_previous(it));
+    TEST_ASSERT_EQUAL_INT(4000, *(int *)cfl_iterator_previous(it));
+    TEST_ASSERT_EQUAL_INT(3998, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_free(it);
+
+    cfl_btree_file_close(file);
+    remove(TEST_FILE);
+}
+
+TEST_CASE(test_cfl_btree_file_str_keys) {
+    CFL_BTREEP tree = cfl_btree_new(3, compare_str_keys);
+    CFL_BTREE_FILEP file;
+    CFL_ITERATORP it;
+    char *words[] = { "banana", "apple", "carrot", "apricot", "avocado", "beet", "apex", "cherry", "ap", "b" };
+    char *expected[] = { "ap", "apex", "apple", "apricot" };
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        cfl_btree_add(tree, words[i]);
+    }
+    TEST_ASSERT(cfl_btree_file_write(tree, TEST_FILE, 0, str_key_size));
+    cfl_btree_free(tree, NULL);
+
+    file = cfl_btree_file_open(TEST_FILE, compare_str_keys);
+    TEST_ASSERT(file != NULL);
+    TEST_ASSERT_EQUAL_STRING("carrot", (char *)cfl_btree_file_search(file, "carrot"));
+    TEST_ASSERT(cfl_btree_file_search(file, "car") == NULL);
+    TEST_ASSERT_EQUAL_STRING("beet", (char *)cfl_btree_file_searchLike(file, "be"));
+
+    it = cfl_btree_file_iteratorSearchLike(file, "ap");
+    TEST_ASSERT(it != NULL);
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_STRING(expected[i], (char *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+    TEST_ASSERT(cfl_btree_file_iteratorSearchLike(file, "x") == NULL);
+
+    cfl_btree_file_close(file);
+    remove(TEST_FILE);
+}
+
+TEST_CASE(test_cfl_btree_file_invalid) {
+    CFL_BTREEP tree = cfl_btree_new(3, compare_str_keys);
+    FILE *stream;
+    char big[300];
+
+    // empty tree
+    TEST_ASSERT(cfl_btree_file_write(tree, TEST_FILE, 0, str_key_size));
+    {
+        CFL_BTREE_FILEP file = cfl_btree_file_open(TEST_FILE, compare_str_keys);
+        CFL_ITERATORP it;
+        TEST_ASSERT(file != NULL);
+        TEST_ASSERT_EQUAL_INT(0, cfl_btree_file_count(file));
+        TEST_ASSERT(cfl_btree_file_search(file, "a") == NULL);
+        it = cfl_btree_file_iterator(file);
+        TEST_ASSERT(!cfl_iterator_hasNext(it));
+        cfl_iterator_free(it);
+        cfl_btree_file_close(file);
+    }
+
+    // a key that does not fit in a page
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    cfl_btree_add(tree, big);
+    TEST_ASSERT(!cfl_btree_file_write(tree, TEST_FILE, 256, str_key_size));
+    TEST_ASSERT(!cfl_btree_file_write(tree, TEST_FILE, 100, str_key_size));
+    cfl_btree_free(tree, NULL);
+
+    stream = fopen(TEST_FILE, "wb");
+    fputs("not a btree file", stream);
+    fclose(stream);
+    TEST_ASSERT(cfl_btree_file_open(TEST_FILE, compare_str_keys) == NULL);
+    remove(TEST_FILE);
+    TEST_ASSERT(cfl_btree_file_open(TEST_FILE, compare_str_keys) == NULL);
+}
+
+static CFL_BOOL write_int_file(void) {
+    CFL_BTREEP tree = cfl_btree_new(16, compare_int_keys);
+    static int keys[500];
+    CFL_BOOL written;
+    int i;
+
+    for (i = 0; i < 500; i++) {
+        keys[i] = i;
+        cfl_btree_add(tree, &keys[i]);
+    }
+    written = cfl_btree_file_write(tree, TEST_FILE, 256, int_key_size);
+    cfl_btree_free(tree, NULL);
+    return written;
+}
+
+// Overwrite a 32-bit field of the page header or slots of the first leaf (page 1 of 256 bytes)
+static void patch_first_leaf(long offset, CFL_UINT32 value) {
+    FILE *stream = fopen(TEST_FILE, "r+b");
+    fseek(stream, 256 + offset, SEEK_SET);
+    fwrite(&value, sizeof(value), 1, stream);
+    fclose(stream);
+}
+
+TEST_CASE(test_cfl_btree_file_corrupt) {
+    CFL_BTREE_FILEP file;
+    FILE *stream;
+    char page[256];
+
+    TEST_ASSERT(write_int_file());
+    file = cfl_btree_file_open(TEST_FILE, compare_int_keys);
+    TEST_ASSERT(file != NULL);
+    cfl_btree_file_close(file);
+
+    // more keys than slots fit in the page
+    TEST_ASSERT(write_int_file());
+    patch_first_leaf(0, 0xFFFF);
+    TEST_ASSERT(cfl_btree_file_open(TEST_FILE, compare_int_keys) == NULL);
+
+    // a leaf linked to itself
+    TEST_ASSERT(write_int_file());
+    patch_first_leaf(12, 1);
+    TEST_ASSERT(cfl_btree_file_open(TEST_FILE, compare_int_keys) == NULL);
+
+    // a leaf linked past the last page
+    TEST_ASSERT(write_int_file());
+    patch_first_leaf(12, 100000);
+    TEST_ASSERT(cfl_btree_file_open(TEST_FILE, compare_int_keys) == NULL);
+
+    // a key offset outside the page
+    TEST_ASSERT(write_int_file());
+    patch_first_leaf(16, 300);
+    TEST_ASSERT(cfl_btree_file_open(TEST_FILE, compare_int_keys) == NULL);
+
+    // a truncated file
+    TEST_ASSERT(write_int_file());
+    stream = fopen(TEST_FILE, "rb");
+    TEST_ASSERT(fread(page, sizeof(page), 1, stream) == 1);
+    fclose(stream);
+    stream = fopen(TEST_FILE, "wb");
+    fwrite(page, sizeof(page), 1, stream);
+    fclose(stream);
+    TEST_ASSERT(cfl_btree_file_open(TEST_FILE, compare_int_keys) == NULL);
+
+    remove(TEST_FILE);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_btree_file_int_keys);
+    RUN_TEST(test_cfl_btree_file_str_keys);
+    RUN_TEST(test_cfl_btree_file_invalid);
+    RUN_TEST(test_cfl_btree_file_corrupt);
+TEST_SUITE_END()
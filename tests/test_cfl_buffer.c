@@ -1,4 +1,5 @@
 #include "cfl_buffer.h"
+#include "cfl_mem.h"
 #include "cfl_str.h"
 #include "cfl_test.h"
 
@@ -61,8 +62,271 @@ TEST_CASE(test_cfl_buffer_putFormatArgs) {
    TEST_ASSERT(cfl_buffer_getUInt8(buf) == 13);
 }
 
+TEST_CASE(test_cfl_buffer_varint) {
+   CFL_BUFFERP buf = cfl_buffer_new();
+   CFL_UINT32 values32[] = {0, 1, 127, 128, 16383, 16384, 2097151, 2097152, 268435455, 268435456, CFL_UINT32_MAX};
+   CFL_UINT32 sizes32[] = {1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5};
+   CFL_UINT32 i;
+
+   for (i = 0; i < sizeof(values32) / sizeof(values32[0]); i++) {
+      cfl_buffer_reset(buf);
+      TEST_ASSERT(cfl_buffer_putVarUInt32(buf, values32[i]));
+      TEST_ASSERT_EQUAL_INT(sizes32[i], cfl_buffer_length(buf));
+      cfl_buffer_rewind(buf);
+      TEST_ASSERT(cfl_buffer_getVarUInt32(buf) == values32[i]);
+      TEST_ASSERT_EQUAL_INT(sizes32[i], cfl_buffer_position(buf));
+   }
+
+   cfl_buffer_reset(buf);
+   TEST_ASSERT(cfl_buffer_putVarUInt64(buf, 0xFFFFFFFFFFFFFFFFULL));
+   TEST_ASSERT_EQUAL_INT(10, cfl_buffer_length(buf));
+   TEST_ASSERT(cfl_buffer_putVarUInt64(buf, 1ULL << 35));
+   TEST_ASSERT_EQUAL_INT(16, cfl_buffer_length(buf));
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT(cfl_buffer_getVarUInt64(buf) == 0xFFFFFFFFFFFFFFFFULL);
+   TEST_ASSERT(cfl_buffer_getVarUInt64(buf) == 1ULL << 35);
+
+   // Zigzag keeps small negative values short
+   cfl_buffer_reset(buf);
+   TEST_ASSERT(cfl_buffer_putVarInt32(buf, -1));
+   TEST_ASSERT_EQUAL_INT(1, cfl_buffer_length(buf));
+   TEST_ASSERT(cfl_buffer_putVarInt32(buf, -64));
+   TEST_ASSERT(cfl_buffer_putVarInt32(buf, 64));
+   TEST_ASSERT_EQUAL_INT(4, cfl_buffer_length(buf));
+   TEST_ASSERT(cfl_buffer_putVarInt32(buf, -2147483647 - 1));
+   TEST_ASSERT(cfl_buffer_putVarInt32(buf, 2147483647));
+   TEST_ASSERT(cfl_buffer_putVarInt64(buf, -1));
+   TEST_ASSERT(cfl_buffer_putVarInt64(buf, (CFL_INT64)(-9223372036854775807LL - 1)));
+   TEST_ASSERT(cfl_buffer_putVarInt64(buf, 9223372036854775807LL));
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT_EQUAL_INT(-1, cfl_buffer_getVarInt32(buf));
+   TEST_ASSERT_EQUAL_INT(-64, cfl_buffer_getVarInt32(buf));
+   TEST_ASSERT_EQUAL_INT(64, cfl_buffer_getVarInt32(buf));
+   TEST_ASSERT(cfl_buffer_getVarInt32(buf) == -2147483647 - 1);
+   TEST_ASSERT(cfl_buffer_getVarInt32(buf) == 2147483647);
+   TEST_ASSERT(cfl_buffer_getVarInt64(buf) == -1);
+   TEST_ASSERT(cfl_buffer_getVarInt64(buf) == -9223372036854775807LL - 1);
+   TEST_ASSERT(cfl_buffer_getVarInt64(buf) == 9223372036854775807LL);
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_remaining(buf));
+
+   // Truncated and too long values move to the end
+   cfl_buffer_reset(buf);
+   cfl_buffer_putUInt8(buf, 0x80);
+   cfl_buffer_putUInt8(buf, 0x80);
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_getVarUInt32(buf));
+   TEST_ASSERT_EQUAL_INT(2, cfl_buffer_position(buf));
+   cfl_buffer_reset(buf);
+   for (i = 0; i < 5; i++) {
+      cfl_buffer_putUInt8(buf, 0xFF);
+   }
+   cfl_buffer_putUInt8(buf, 0x01);
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_getVarUInt32(buf));
+   TEST_ASSERT_EQUAL_INT(6, cfl_buffer_position(buf));
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT(cfl_buffer_getVarUInt64(buf) == 0xFFFFFFFFFULL);
+   cfl_buffer_reset(buf);
+   for (i = 0; i < 9; i++) {
+      cfl_buffer_putUInt8(buf, 0xFF);
+   }
+   cfl_buffer_putUInt8(buf, 0x02);
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT(cfl_buffer_getVarUInt64(buf) == 0);
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_remaining(buf));
+   cfl_buffer_free(buf);
+}
+
+TEST_CASE(test_cfl_buffer_varint_array) {
+   CFL_BUFFERP buf = cfl_buffer_new();
+   CFL_UINT32 values[40];
+   CFL_UINT32 decoded[40];
+   CFL_UINT64 decoded64[40];
+   CFL_UINT32 i;
+
+   // Runs of one-byte values mixed with longer ones
+   for (i = 0; i < 40; i++) {
+      values[i] = (i % 13 == 12) ? i * 100000 : i;
+      cfl_buffer_putVarUInt32(buf, values[i]);
+   }
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT_EQUAL_INT(40, cfl_buffer_getVarUInt32Array(buf, decoded, 40));
+   TEST_ASSERT(memcmp(values, decoded, sizeof(values)) == 0);
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_remaining(buf));
+
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT_EQUAL_INT(40, cfl_buffer_getVarUInt64Array(buf, decoded64, 40));
+   for (i = 0; i < 40; i++) {
+      TEST_ASSERT(decoded64[i] == values[i]);
+   }
+
+   // Stops at the end of the data
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT_EQUAL_INT(40, cfl_buffer_getVarUInt32Array(buf, decoded, 40));
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_getVarUInt32Array(buf, decoded, 5));
+   cfl_buffer_setLength(buf, cfl_buffer_length(buf) - 2);
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT_EQUAL_INT(38, cfl_buffer_getVarUInt32Array(buf, decoded, 40));
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_remaining(buf));
+   cfl_buffer_free(buf);
+}
+
+TEST_CASE(test_cfl_buffer_var_string) {
+   CFL_BUFFERP buf = cfl_buffer_new();
+   CFL_STRP str = cfl_str_newBuffer("varint prefixed");
+   CFL_STRP copy = cfl_str_new(16);
+   CFL_STRP read;
+   char *chars;
+
+   TEST_ASSERT(cfl_buffer_putVarString(buf, str));
+   TEST_ASSERT_EQUAL_INT(16, cfl_buffer_length(buf));
+   TEST_ASSERT(cfl_buffer_putVarCharArray(buf, "abc"));
+   TEST_ASSERT(cfl_buffer_putVarString(buf, str));
+   TEST_ASSERT(cfl_buffer_putVarCharArray(buf, ""));
+   cfl_buffer_rewind(buf);
+   read = cfl_buffer_getVarString(buf);
+   TEST_ASSERT(strcmp(cfl_str_getPtr(read), "varint prefixed") == 0);
+   chars = cfl_buffer_getVarCharArray(buf);
+   TEST_ASSERT(strcmp(chars, "abc") == 0);
+   CFL_MEM_FREE(chars);
+   cfl_buffer_copyVarString(buf, copy);
+   TEST_ASSERT(strcmp(cfl_str_getPtr(copy), "varint prefixed") == 0);
+   chars = cfl_buffer_getVarCharArray(buf);
+   TEST_ASSERT(chars[0] == 0);
+   CFL_MEM_FREE(chars);
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_remaining(buf));
+
+   cfl_str_free(read);
+   cfl_str_free(copy);
+   cfl_str_free(str);
+   cfl_buffer_free(buf);
+}
+
+TEST_CASE(test_cfl_buffer_byte_order) {
+   CFL_BUFFERP buf = cfl_buffer_new();
+   const CFL_UINT8 *data;
+
+   // An odd first byte leaves the following values unaligned
+   cfl_buffer_putUInt8(buf, 0xAA);
+   TEST_ASSERT(cfl_buffer_putUInt32BE(buf, 0x01020304));
+   TEST_ASSERT(cfl_buffer_putUInt32LE(buf, 0x01020304));
+   TEST_ASSERT(cfl_buffer_putUInt16BE(buf, 0x0506));
+   TEST_ASSERT(cfl_buffer_putUInt16LE(buf, 0x0506));
+   TEST_ASSERT(cfl_buffer_putUInt64BE(buf, 0x0102030405060708ULL));
+   TEST_ASSERT_EQUAL_INT(21, cfl_buffer_length(buf));
+   data = cfl_buffer_getDataPtr(buf);
+   TEST_ASSERT(memcmp(data + 1, "\x01\x02\x03\x04\x04\x03\x02\x01\x05\x06\x06\x05", 12) == 0);
+   TEST_ASSERT(memcmp(data + 13, "\x01\x02\x03\x04\x05\x06\x07\x08", 8) == 0);
+
+   cfl_buffer_setPosition(buf, 1);
+   TEST_ASSERT(cfl_buffer_getUInt32BE(buf) == 0x01020304);
+   TEST_ASSERT(cfl_buffer_getUInt32LE(buf) == 0x01020304);
+   TEST_ASSERT(cfl_buffer_getUInt16BE(buf) == 0x0506);
+   TEST_ASSERT(cfl_buffer_getUInt16LE(buf) == 0x0506);
+   TEST_ASSERT(cfl_buffer_getUInt64BE(buf) == 0x0102030405060708ULL);
+   // Reading past the end returns 0
+   TEST_ASSERT(cfl_buffer_getUInt32BE(buf) == 0);
+
+   cfl_buffer_reset(buf);
+   TEST_ASSERT(cfl_buffer_putInt16BE(buf, -2));
+   TEST_ASSERT(cfl_buffer_putInt32LE(buf, -3));
+   TEST_ASSERT(cfl_buffer_putInt64BE(buf, -4));
+   TEST_ASSERT(cfl_buffer_putInt64LE(buf, -5));
+   TEST_ASSERT(cfl_buffer_putFloatBE(buf, 1.5f));
+   TEST_ASSERT(cfl_buffer_putDoubleBE(buf, -2.25));
+   TEST_ASSERT(cfl_buffer_putDoubleLE(buf, 1e100));
+   data = cfl_buffer_getDataPtr(buf);
+   TEST_ASSERT(memcmp(data + 22, "\x3F\xC0\x00\x00", 4) == 0);
+   TEST_ASSERT(memcmp(data + 26, "\xC0\x02\x00\x00\x00\x00\x00\x00", 8) == 0);
+   cfl_buffer_rewind(buf);
+   TEST_ASSERT_EQUAL_INT(-2, cfl_buffer_getInt16BE(buf));
+   TEST_ASSERT_EQUAL_INT(-3, cfl_buffer_getInt32LE(buf));
+   TEST_ASSERT(cfl_buffer_getInt64BE(buf) == -4);
+   TEST_ASSERT(cfl_buffer_getInt64LE(buf) == -5);
+   TEST_ASSERT(cfl_buffer_getFloatBE(buf) == 1.5f);
+   TEST_ASSERT(cfl_buffer_getDoubleBE(buf) == -2.25);
+   TEST_ASSERT(cfl_buffer_getDoubleLE(buf) == 1e100);
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_remaining(buf));
+   cfl_buffer_free(buf);
+}
+
+TEST_CASE(test_cfl_buffer_arrays) {
+   CFL_BUFFERP buf = cfl_buffer_newCapacity(16);
+   CFL_INT32 ints[100];
+   CFL_INT32 intsRead[100];
+   CFL_INT16 shorts[3] = {1, -2, 0x0102};
+   CFL_INT16 shortsRead[3];
+   double doubles[5] = {0.0, -1.5, 3.25, 1e300, -1e-300};
+   double doublesRead[5];
+   CFL_INT64 longs[2] = {-1, 0x0102030405060708LL};
+   CFL_INT64 longsRead[2];
+   const CFL_UINT8 *data;
+   CFL_UINT32 i;
+
+   for (i = 0; i < 100; i++) {
+      ints[i] = (CFL_INT32)(i * 100003) - 5000000;
+   }
+   // The buffer grows once for the whole array
+   cfl_buffer_putUInt8(buf, 7);
+   TEST_ASSERT(cfl_buffer_putInt32Array(buf, ints, 100));
+   TEST_ASSERT(cfl_buffer_putInt32ArrayBE(buf, ints, 100));
+   TEST_ASSERT(cfl_buffer_putInt32ArrayLE(buf, ints, 100));
+   TEST_ASSERT(cfl_buffer_putInt16ArrayBE(buf, shorts, 3));
+   TEST_ASSERT(cfl_buffer_putDoubleArrayBE(buf, doubles, 5));
+   TEST_ASSERT(cfl_buffer_putDoubleArray(buf, doubles, 5));
+   TEST_ASSERT(cfl_buffer_putInt64ArrayLE(buf, longs, 2));
+   TEST_ASSERT(cfl_buffer_putInt32Array(buf, ints, 0));
+   TEST_ASSERT_EQUAL_INT(1 + 1200 + 6 + 80 + 16, cfl_buffer_length(buf));
+
+   // The array functions write the same bytes as the single value ones
+   data = cfl_buffer_getDataPtr(buf);
+   TEST_ASSERT(memcmp(data + 1201, "\x00\x01\xFF\xFE\x01\x02", 6) == 0);
+   cfl_buffer_setPosition(buf, 401);
+   for (i = 0; i < 100; i++) {
+      TEST_ASSERT(cfl_buffer_getInt32BE(buf) == ints[i]);
+   }
+   cfl_buffer_setPosition(buf, 1);
+   TEST_ASSERT_EQUAL_INT(100, cfl_buffer_getInt32Array(buf, intsRead, 100));
+   TEST_ASSERT(memcmp(ints, intsRead, sizeof(ints)) == 0);
+   memset(intsRead, 0, sizeof(intsRead));
+   TEST_ASSERT_EQUAL_INT(100, cfl_buffer_getInt32ArrayBE(buf, intsRead, 100));
+   TEST_ASSERT(memcmp(ints, intsRead, sizeof(ints)) == 0);
+   memset(intsRead, 0, sizeof(intsRead));
+   TEST_ASSERT_EQUAL_INT(100, cfl_buffer_getInt32ArrayLE(buf, intsRead, 100));
+   TEST_ASSERT(memcmp(ints, intsRead, sizeof(ints)) == 0);
+   TEST_ASSERT_EQUAL_INT(3, cfl_buffer_getInt16ArrayBE(buf, shortsRead, 3));
+   TEST_ASSERT(memcmp(shorts, shortsRead, sizeof(shorts)) == 0);
+   TEST_ASSERT_EQUAL_INT(5, cfl_buffer_getDoubleArrayBE(buf, doublesRead, 5));
+   TEST_ASSERT(memcmp(doubles, doublesRead, sizeof(doubles)) == 0);
+   TEST_ASSERT_EQUAL_INT(5, cfl_buffer_getDoubleArray(buf, doublesRead, 5));
+   TEST_ASSERT(memcmp(doubles, doublesRead, sizeof(doubles)) == 0);
+   TEST_ASSERT_EQUAL_INT(2, cfl_buffer_getInt64ArrayLE(buf, longsRead, 2));
+   TEST_ASSERT(memcmp(longs, longsRead, sizeof(longs)) == 0);
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_remaining(buf));
+
+   // Counts that are not a multiple of the vector size
+   cfl_buffer_reset(buf);
+   TEST_ASSERT(cfl_buffer_putInt32ArrayBE(buf, ints, 7));
+   cfl_buffer_rewind(buf);
+   for (i = 0; i < 7; i++) {
+      TEST_ASSERT(cfl_buffer_getInt32BE(buf) == ints[i]);
+   }
+
+   // Only the complete values left are read
+   cfl_buffer_setPosition(buf, cfl_buffer_length(buf) - 10);
+   TEST_ASSERT_EQUAL_INT(2, cfl_buffer_getInt32Array(buf, intsRead, 100));
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_remaining(buf));
+   TEST_ASSERT_EQUAL_INT(0, cfl_buffer_getInt32Array(buf, intsRead, 100));
+   cfl_buffer_free(buf);
+}
+
 TEST_SUITE_BEGIN()
 RUN_TEST(test_cfl_buffer_lifecycle);
 RUN_TEST(test_cfl_buffer_write_read);
 RUN_TEST(test_cfl_buffer_putFormatArgs);
+RUN_TEST(test_cfl_buffer_varint);
+RUN_TEST(test_cfl_buffer_varint_array);
+RUN_TEST(test_cfl_buffer_var_string);
+RUN_TEST(test_cfl_buffer_byte_order);
+RUN_TEST(test_cfl_buffer_arrays);
 TEST_SUITE_END()
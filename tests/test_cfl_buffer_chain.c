@@ -0,0 +1,148 @@
+#include "cfl_test.h"
+#include "cfl_buffer_chain.h"
+#include "cfl_mem.h"
+
+static int freed_count = 0;
+
+static void count_free(void *data, void *context) {
+    CFL_UNUSED(data);
+    CFL_UNUSED(context);
+    freed_count++;
+}
+
+static CFL_BOOL chain_equals(CFL_BUFFER_CHAINP chain, const char *expected) {
+    char text[256];
+    CFL_UINT32 length = cfl_buffer_chain_copy(chain, 0, text, sizeof(text) - 1);
+    text[length] = '\0';
+    return length == cfl_buffer_chain_length(chain) && strcmp(text, expected) == 0;
+}
+
+TEST_CASE(test_cfl_buffer_chain_append) {
+    CFL_BUFFER_CHAIN chain;
+    CFL_IOVEC iov[4];
+    char large[CFL_BUFFER_CHAIN_SEGMENT_SIZE + 10];
+    char bytes[4];
+
+    cfl_buffer_chain_init(&chain);
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_chain_length(&chain));
+    TEST_ASSERT(cfl_buffer_chain_append(&chain, "hello", 5));
+    TEST_ASSERT(cfl_buffer_chain_append(&chain, " world", 6));
+    // Small appends share the free space of the last segment
+    TEST_ASSERT_EQUAL_INT(1, cfl_buffer_chain_sliceCount(&chain));
+    TEST_ASSERT(cfl_buffer_chain_prepend(&chain, "> ", 2));
+    TEST_ASSERT_EQUAL_INT(2, cfl_buffer_chain_sliceCount(&chain));
+    TEST_ASSERT(chain_equals(&chain, "> hello world"));
+
+    TEST_ASSERT_EQUAL_INT(2, cfl_buffer_chain_toIovec(&chain, iov, 4));
+    TEST_ASSERT_EQUAL_INT(2, (int)iov[0].iov_len);
+    TEST_ASSERT(memcmp(iov[0].iov_base, "> ", 2) == 0);
+    TEST_ASSERT_EQUAL_INT(11, (int)iov[1].iov_len);
+    TEST_ASSERT_EQUAL_INT(1, cfl_buffer_chain_toIovec(&chain, iov, 1));
+
+    TEST_ASSERT_EQUAL_INT(3, cfl_buffer_chain_copy(&chain, 10, bytes, 4));
+    TEST_ASSERT(memcmp(bytes, "rld", 3) == 0);
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_chain_copy(&chain, 13, bytes, 4));
+
+    cfl_buffer_chain_skip(&chain, 4);
+    TEST_ASSERT(chain_equals(&chain, "llo world"));
+    TEST_ASSERT_EQUAL_INT(1, cfl_buffer_chain_sliceCount(&chain));
+    cfl_buffer_chain_skip(&chain, 100);
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_chain_length(&chain));
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_chain_sliceCount(&chain));
+
+    // Appends larger than the free space continue in a new segment
+    memset(large, 'x', sizeof(large));
+    TEST_ASSERT(cfl_buffer_chain_append(&chain, "ab", 2));
+    TEST_ASSERT(cfl_buffer_chain_append(&chain, large, sizeof(large)));
+    TEST_ASSERT_EQUAL_INT(2, cfl_buffer_chain_sliceCount(&chain));
+    TEST_ASSERT_EQUAL_INT(sizeof(large) + 2, cfl_buffer_chain_length(&chain));
+    TEST_ASSERT_EQUAL_INT(4, cfl_buffer_chain_copy(&chain, 0, bytes, 4));
+    TEST_ASSERT(memcmp(bytes, "abxx", 4) == 0);
+    cfl_buffer_chain_free(&chain);
+}
+
+TEST_CASE(test_cfl_buffer_chain_references) {
+    CFL_BUFFER_CHAINP chain = cfl_buffer_chain_new();
+    CFL_BUFFER_CHAINP slice;
+    CFL_BUFFER_CHAINP tail;
+    CFL_BUFFERP buffer = cfl_buffer_new();
+    CFL_BUFFERP output = cfl_buffer_new();
+    static char external[] = "external";
+    CFL_UINT8 *bufferData;
+    CFL_IOVEC iov[8];
+
+    freed_count = 0;
+    TEST_ASSERT(cfl_buffer_chain_append(chain, "head-", 5));
+    TEST_ASSERT(cfl_buffer_chain_appendRef(chain, external, 8, count_free, NULL));
+
+    // The buffer memory moves to the chain without copying
+    cfl_buffer_put(buffer, "..payload", 9);
+    cfl_buffer_flip(buffer);
+    cfl_buffer_skip(buffer, 2);
+    bufferData = cfl_buffer_getDataPtr(buffer);
+    TEST_ASSERT(cfl_buffer_chain_appendBuffer(chain, buffer));
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_length(buffer));
+    TEST_ASSERT(cfl_buffer_putUInt8(buffer, 1));
+
+    // A buffer without remaining bytes is left empty as well
+    TEST_ASSERT_EQUAL_INT(1, cfl_buffer_position(buffer));
+    TEST_ASSERT(cfl_buffer_chain_appendBuffer(chain, buffer));
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_length(buffer));
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_position(buffer));
+    TEST_ASSERT_EQUAL_INT(3, cfl_buffer_chain_toIovec(chain, iov, 8));
+    TEST_ASSERT(iov[1].iov_base == (void *)external);
+    TEST_ASSERT(iov[2].iov_base == (void *)(bufferData + 2));
+    TEST_ASSERT(chain_equals(chain, "head-externalpayload"));
+
+    // Slices share the segments and keep them alive
+    slice = cfl_buffer_chain_slice(chain, 3, 12);
+    TEST_ASSERT(slice != NULL);
+    TEST_ASSERT(chain_equals(slice, "d-externalpa"));
+    TEST_ASSERT(cfl_buffer_chain_slice(chain, 21, 1) == NULL);
+    cfl_buffer_chain_free(chain);
+    TEST_ASSERT_EQUAL_INT(0, freed_count);
+    TEST_ASSERT(chain_equals(slice, "d-externalpa"));
+
+    // Appending to a shared segment does not overwrite the other chain
+    tail = cfl_buffer_chain_split(slice, 5);
+    TEST_ASSERT(tail != NULL);
+    TEST_ASSERT(chain_equals(slice, "d-ext"));
+    TEST_ASSERT(chain_equals(tail, "ernalpa"));
+    TEST_ASSERT(cfl_buffer_chain_append(slice, "!", 1));
+    TEST_ASSERT(chain_equals(slice, "d-ext!"));
+    TEST_ASSERT(chain_equals(tail, "ernalpa"));
+
+    TEST_ASSERT(cfl_buffer_chain_appendChain(tail, slice));
+    TEST_ASSERT(cfl_buffer_chain_appendChain(tail, tail));
+    TEST_ASSERT(chain_equals(tail, "ernalpad-ext!ernalpad-ext!"));
+    TEST_ASSERT(cfl_buffer_chain_toBuffer(tail, output));
+    TEST_ASSERT_EQUAL_INT(26, cfl_buffer_length(output));
+    TEST_ASSERT(memcmp(cfl_buffer_getDataPtr(output), "ernalpad-ext!ernalpad-ext!", 26) == 0);
+
+    cfl_buffer_chain_free(slice);
+    TEST_ASSERT_EQUAL_INT(0, freed_count);
+    cfl_buffer_chain_free(tail);
+    TEST_ASSERT_EQUAL_INT(1, freed_count);
+
+    // Splitting at the ends
+    chain = cfl_buffer_chain_new();
+    TEST_ASSERT(cfl_buffer_chain_append(chain, "abc", 3));
+    tail = cfl_buffer_chain_split(chain, 3);
+    TEST_ASSERT(tail != NULL);
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_chain_length(tail));
+    cfl_buffer_chain_free(tail);
+    tail = cfl_buffer_chain_split(chain, 0);
+    TEST_ASSERT(chain_equals(tail, "abc"));
+    TEST_ASSERT_EQUAL_INT(0, cfl_buffer_chain_length(chain));
+    TEST_ASSERT(cfl_buffer_chain_split(chain, 1) == NULL);
+    cfl_buffer_chain_free(tail);
+    cfl_buffer_chain_free(chain);
+
+    cfl_buffer_free(buffer);
+    cfl_buffer_free(output);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_buffer_chain_append);
+    RUN_TEST(test_cfl_buffer_chain_references);
+TEST_SUITE_END()
@@ -0,0 +1,148 @@
+#include <stdlib.h>
+
+#include "cfl_test.h"
+#include "cfl_cbtree.h"
+#include "cfl_thread.h"
+#include "cfl_atomic.h"
+#include "cfl_mem.h"
+
+#define WRITERS 2
+#define READERS 2
+#define KEYS_PER_WRITER 20000
+
+typedef struct {
+    CFL_CBTREEP tree;
+    CFL_INT32 first;
+    CFL_INT32 errors;
+    CFL_BOOL stop;
+} THREAD_ARG;
+
+TEST_CASE(test_cfl_cbtree_single_thread) {
+    CFL_CBTREEP tree = cfl_cbtree_new(4);
+    static int values[1000];
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        values[i] = i;
+        TEST_ASSERT(cfl_cbtree_add(tree, (i * 337) % 1000, &values[(i * 337) % 1000]));
+    }
+    TEST_ASSERT(!cfl_cbtree_add(tree, 10, NULL));
+    TEST_ASSERT_EQUAL_INT(1000, cfl_cbtree_count(tree));
+    for (i = 0; i < 1000; i++) {
+        TEST_ASSERT(cfl_cbtree_search(tree, i) == &values[i]);
+    }
+    TEST_ASSERT(!cfl_cbtree_contains(tree, 1000));
+
+    for (i = 0; i < 1000; i += 2) {
+        TEST_ASSERT(cfl_cbtree_delete(tree, i) == &values[i]);
+    }
+    TEST_ASSERT(cfl_cbtree_delete(tree, 0) == NULL);
+    TEST_ASSERT_EQUAL_INT(500, cfl_cbtree_count(tree));
+    for (i = 0; i < 1000; i++) {
+        TEST_ASSERT(cfl_cbtree_contains(tree, i) == (i % 2 == 1));
+    }
+    TEST_ASSERT(cfl_cbtree_add(tree, 0, &values[0]));
+    TEST_ASSERT(cfl_cbtree_search(tree, 0) == &values[0]);
+
+    cfl_cbtree_free(tree, NULL);
+}
+
+static void *failing_malloc(size_t size) {
+    CFL_UNUSED(size);
+    return NULL;
+}
+
+TEST_CASE(test_cfl_cbtree_out_of_memory) {
+    CFL_CBTREEP tree = cfl_cbtree_new(4);
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        TEST_ASSERT(cfl_cbtree_add(tree, i, NULL));
+    }
+    // The full root cannot be split, so the insertion fails instead of retrying
+    cfl_mem_set(failing_malloc, NULL, NULL);
+    TEST_ASSERT(!cfl_cbtree_add(tree, 4, NULL));
+    cfl_mem_set(malloc, NULL, NULL);
+    TEST_ASSERT_EQUAL_INT(4, cfl_cbtree_count(tree));
+    TEST_ASSERT(!cfl_cbtree_contains(tree, 4));
+    TEST_ASSERT(cfl_cbtree_add(tree, 4, NULL));
+    for (i = 0; i < 5; i++) {
+        TEST_ASSERT(cfl_cbtree_contains(tree, i));
+    }
+    cfl_cbtree_free(tree, NULL);
+}
+
+static void writer_func(void *param) {
+    THREAD_ARG *arg = (THREAD_ARG *)param;
+    CFL_INT32 i;
+    for (i = 0; i < KEYS_PER_WRITER; i++) {
+        CFL_INT64 key = (CFL_INT64)i * WRITERS + arg->first;
+        if (!cfl_cbtree_add(arg->tree, key, (void *)(size_t)(key + 1))) {
+            arg->errors++;
+        }
+    }
+}
+
+// Odd keys are loaded before the threads start and must always be found with their values
+static void reader_func(void *param) {
+    THREAD_ARG *arg = (THREAD_ARG *)param;
+    CFL_INT64 key = arg->first;
+    while (!cfl_atomic_getBoolean(&arg->stop)) {
+        key = (key + 7919) % (KEYS_PER_WRITER * WRITERS);
+        if ((key & 1) != 0 && cfl_cbtree_search(arg->tree, -key) != (void *)(size_t)(key + 1)) {
+            arg->errors++;
+        }
+    }
+}
+
+TEST_CASE(test_cfl_cbtree_concurrent) {
+    CFL_CBTREEP tree = cfl_cbtree_new(8);
+    THREAD_ARG writerArgs[WRITERS];
+    THREAD_ARG readerArgs[READERS];
+    CFL_THREADP writers[WRITERS];
+    CFL_THREADP readers[READERS];
+    CFL_INT64 key;
+    int i;
+
+    for (key = 1; key < KEYS_PER_WRITER * WRITERS; key += 2) {
+        cfl_cbtree_add(tree, -key, (void *)(size_t)(key + 1));
+    }
+    for (i = 0; i < READERS; i++) {
+        readerArgs[i].tree = tree;
+        readerArgs[i].first = i;
+        readerArgs[i].errors = 0;
+        readerArgs[i].stop = CFL_FALSE;
+        readers[i] = cfl_thread_new(reader_func);
+        cfl_thread_start(readers[i], &readerArgs[i]);
+    }
+    for (i = 0; i < WRITERS; i++) {
+        writerArgs[i].tree = tree;
+        writerArgs[i].first = i;
+        writerArgs[i].errors = 0;
+        writers[i] = cfl_thread_new(writer_func);
+        cfl_thread_start(writers[i], &writerArgs[i]);
+    }
+    for (i = 0; i < WRITERS; i++) {
+        cfl_thread_wait(writers[i]);
+        cfl_thread_free(writers[i]);
+        TEST_ASSERT_EQUAL_INT(0, writerArgs[i].errors);
+    }
+    for (i = 0; i < READERS; i++) {
+        cfl_atomic_setBoolean(&readerArgs[i].stop, CFL_TRUE);
+        cfl_thread_wait(readers[i]);
+        cfl_thread_free(readers[i]);
+        TEST_ASSERT_EQUAL_INT(0, readerArgs[i].errors);
+    }
+
+    TEST_ASSERT_EQUAL_INT(KEYS_PER_WRITER * WRITERS + (KEYS_PER_WRITER * WRITERS) / 2, cfl_cbtree_count(tree));
+    for (key = 0; key < KEYS_PER_WRITER * WRITERS; key++) {
+        TEST_ASSERT(cfl_cbtree_search(tree, key) == (void *)(size_t)(key + 1));
+    }
+    cfl_cbtree_free(tree, NULL);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_cbtree_single_thread);
+    RUN_TEST(test_cfl_cbtree_out_of_memory);
+    RUN_TEST(test_cfl_cbtree_concurrent);
+TEST_SUITE_END()
@@ -0,0 +1,109 @@
+#include "cfl_test.h"
+#include "cfl_deque.h"
+
+TEST_CASE(test_cfl_deque_fifo) {
+    CFL_DEQUEP deque = cfl_deque_new(0);
+    static int values[1000];
+    int i;
+
+    TEST_ASSERT(deque != NULL);
+    TEST_ASSERT(cfl_deque_isEmpty(deque));
+    TEST_ASSERT(cfl_deque_removeFirst(deque) == NULL);
+    TEST_ASSERT(cfl_deque_removeLast(deque) == NULL);
+    TEST_ASSERT(cfl_deque_getFirst(deque) == NULL);
+
+    // keep the head moving around the ring while the buffer grows
+    for (i = 0; i < 1000; i++) {
+        values[i] = i;
+        TEST_ASSERT(cfl_deque_addLast(deque, &values[i]));
+        if (i % 3 == 2) {
+            TEST_ASSERT_EQUAL_INT(i / 3, *(int *)cfl_deque_removeFirst(deque));
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(1000 - 333, cfl_deque_length(deque));
+    TEST_ASSERT_EQUAL_INT(333, *(int *)cfl_deque_getFirst(deque));
+    TEST_ASSERT_EQUAL_INT(999, *(int *)cfl_deque_getLast(deque));
+    for (i = 0; i < 1000 - 333; i++) {
+        TEST_ASSERT_EQUAL_INT(333 + i, *(int *)cfl_deque_get(deque, i));
+    }
+    TEST_ASSERT(cfl_deque_get(deque, 1000 - 333) == NULL);
+    for (i = 333; i < 1000; i++) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_deque_removeFirst(deque));
+    }
+    TEST_ASSERT(cfl_deque_isEmpty(deque));
+    cfl_deque_free(deque);
+}
+
+TEST_CASE(test_cfl_deque_both_ends) {
+    CFL_DEQUE deque;
+    int values[40];
+    int i;
+
+    TEST_ASSERT(cfl_deque_init(&deque, 5));
+    TEST_ASSERT_EQUAL_INT(16, deque.capacity);
+    // 19 ... 0 20 ... 39
+    for (i = 0; i < 20; i++) {
+        values[i] = i;
+        values[20 + i] = 20 + i;
+        cfl_deque_addFirst(&deque, &values[i]);
+        cfl_deque_addLast(&deque, &values[20 + i]);
+    }
+    TEST_ASSERT_EQUAL_INT(40, cfl_deque_length(&deque));
+    TEST_ASSERT_EQUAL_INT(19, *(int *)cfl_deque_get(&deque, 0));
+    TEST_ASSERT_EQUAL_INT(0, *(int *)cfl_deque_get(&deque, 19));
+    TEST_ASSERT_EQUAL_INT(20, *(int *)cfl_deque_get(&deque, 20));
+    TEST_ASSERT_EQUAL_INT(39, *(int *)cfl_deque_removeLast(&deque));
+    TEST_ASSERT_EQUAL_INT(19, *(int *)cfl_deque_removeFirst(&deque));
+
+    // remove near the front and near the back
+    TEST_ASSERT_EQUAL_INT(17, *(int *)cfl_deque_remove(&deque, 1));
+    TEST_ASSERT_EQUAL_INT(36, *(int *)cfl_deque_remove(&deque, 34));
+    TEST_ASSERT_EQUAL_INT(36, cfl_deque_length(&deque));
+    TEST_ASSERT_EQUAL_INT(18, *(int *)cfl_deque_get(&deque, 0));
+    TEST_ASSERT_EQUAL_INT(16, *(int *)cfl_deque_get(&deque, 1));
+    TEST_ASSERT_EQUAL_INT(35, *(int *)cfl_deque_get(&deque, 33));
+    TEST_ASSERT_EQUAL_INT(37, *(int *)cfl_deque_get(&deque, 34));
+    TEST_ASSERT(cfl_deque_remove(&deque, 36) == NULL);
+
+    cfl_deque_set(&deque, 0, &values[0]);
+    TEST_ASSERT_EQUAL_INT(0, *(int *)cfl_deque_getFirst(&deque));
+    cfl_deque_clear(&deque);
+    TEST_ASSERT(cfl_deque_isEmpty(&deque));
+    cfl_deque_free(&deque);
+}
+
+TEST_CASE(test_cfl_deque_iterator) {
+    CFL_DEQUEP deque = cfl_deque_new(4);
+    CFL_ITERATORP it;
+    int values[6] = { 0, 1, 2, 3, 4, 5 };
+    int i;
+
+    for (i = 3; i < 6; i++) {
+        cfl_deque_addLast(deque, &values[i]);
+    }
+    for (i = 2; i >= 0; i--) {
+        cfl_deque_addFirst(deque, &values[i]);
+    }
+    it = cfl_deque_iterator(deque);
+    for (i = 0; i < 6; i++) {
+        TEST_ASSERT(cfl_iterator_hasNext(it));
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+        // drop the odd values
+        if (i % 2 == 1) {
+            cfl_iterator_remove(it);
+        }
+    }
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+    TEST_ASSERT_EQUAL_INT(3, cfl_deque_length(deque));
+    TEST_ASSERT_EQUAL_INT(0, *(int *)cfl_deque_get(deque, 0));
+    TEST_ASSERT_EQUAL_INT(2, *(int *)cfl_deque_get(deque, 1));
+    TEST_ASSERT_EQUAL_INT(4, *(int *)cfl_deque_get(deque, 2));
+    cfl_deque_free(deque);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_deque_fifo);
+    RUN_TEST(test_cfl_deque_both_ends);
+    RUN_TEST(test_cfl_deque_iterator);
+TEST_SUITE_END()
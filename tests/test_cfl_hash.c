@@ -93,6 +93,58 @@ TEST_CASE(test_cfl_hash_iterator) {
     cfl_hash_free(hash, CFL_FALSE);
 }
 
+TEST_CASE(test_cfl_hash_search_batch) {
+    CFL_HASHP hash = cfl_hash_new(10, my_hash_str, my_eq_str, NULL);
+    static char keys[300][8];
+    void *searchKeys[300];
+    void *values[300];
+    int i;
+
+    for (i = 0; i < 300; i++) {
+        sprintf(keys[i], "k%d", i);
+        searchKeys[i] = keys[i];
+        if (i % 3 != 0) {
+            cfl_hash_insert(hash, keys[i], keys[i]);
+        }
+    }
+    cfl_hash_searchBatch(hash, searchKeys, values, 300);
+    for (i = 0; i < 300; i++) {
+        TEST_ASSERT(values[i] == cfl_hash_search(hash, keys[i]));
+        TEST_ASSERT((values[i] == NULL) == (i % 3 == 0));
+    }
+    cfl_hash_searchBatch(hash, searchKeys, values, 0);
+
+    cfl_hash_free(hash, CFL_FALSE);
+}
+
+TEST_CASE(test_cfl_hash_iterator_init) {
+    CFL_HASHP hash = cfl_hash_new(10, my_hash_str, my_eq_str, NULL);
+    CFL_ITERATOR_BUFFER buffer;
+    CFL_ITERATORP it;
+    int count = 0;
+
+    cfl_hash_insert(hash, "A", "1");
+    cfl_hash_insert(hash, "B", "2");
+    cfl_hash_insert(hash, "C", "3");
+
+    it = cfl_hash_iteratorInit(&buffer.iterator, hash);
+    while (cfl_iterator_hasNext(it)) {
+        TEST_ASSERT(cfl_iterator_next(it) != NULL);
+        count++;
+    }
+    TEST_ASSERT_EQUAL_INT(3, count);
+    cfl_iterator_first(it);
+    count = 0;
+    while (cfl_iterator_hasNext(it)) {
+        cfl_iterator_next(it);
+        count++;
+    }
+    TEST_ASSERT_EQUAL_INT(3, count);
+    cfl_iterator_dispose(it);
+
+    cfl_hash_free(hash, CFL_FALSE);
+}
+
 TEST_SUITE_BEGIN()
     RUN_TEST(test_cfl_hash_lifecycle);
     printf("lifecycle passed\n");
@@ -100,4 +152,6 @@ TEST_SUITE_BEGIN()
     printf("insert_search_remove passed\n");
     RUN_TEST(test_cfl_hash_iterator);
     printf("iterator passed\n");
+    RUN_TEST(test_cfl_hash_iterator_init);
+    RUN_TEST(test_cfl_hash_search_batch);
 TEST_SUITE_END()
@@ -0,0 +1,119 @@
+#include "cfl_test.h"
+#include "cfl_ilist.h"
+
+typedef struct {
+    int id;
+    CFL_ILIST_NODE node;
+} ITEM;
+
+static int item_id(CFL_ILIST_NODEP node) {
+    return node != NULL ? CFL_ILIST_ENTRY(node, ITEM, node)->id : -1;
+}
+
+static int list_matches(CFL_ILISTP list, const int *ids, int count) {
+    CFL_ILIST_NODEP node;
+    int i = 0;
+    CFL_ILIST_FOR_EACH(list, node) {
+        if (i >= count || item_id(node) != ids[i]) {
+            return 0;
+        }
+        i++;
+    }
+    // walk back as well to check the previous links
+    for (node = cfl_ilist_last(list); node != NULL; node = cfl_ilist_previous(list, node)) {
+        if (item_id(node) != ids[--i]) {
+            return 0;
+        }
+    }
+    return i == 0 && (int)cfl_ilist_length(list) == count;
+}
+
+TEST_CASE(test_cfl_ilist_add_remove) {
+    CFL_ILIST list;
+    ITEM items[5];
+    int i;
+
+    cfl_ilist_init(&list);
+    TEST_ASSERT(cfl_ilist_isEmpty(&list));
+    TEST_ASSERT(cfl_ilist_first(&list) == NULL);
+    TEST_ASSERT(cfl_ilist_removeFirst(&list) == NULL);
+    for (i = 0; i < 5; i++) {
+        items[i].id = i;
+        cfl_ilist_nodeInit(&items[i].node);
+        TEST_ASSERT(!cfl_ilist_isLinked(&items[i].node));
+    }
+    cfl_ilist_addLast(&list, &items[2].node);
+    cfl_ilist_addFirst(&list, &items[0].node);
+    cfl_ilist_insertAfter(&list, &items[0].node, &items[1].node);
+    cfl_ilist_addLast(&list, &items[4].node);
+    cfl_ilist_insertBefore(&list, &items[4].node, &items[3].node);
+    {
+        int expected[] = { 0, 1, 2, 3, 4 };
+        TEST_ASSERT(list_matches(&list, expected, 5));
+    }
+    TEST_ASSERT(cfl_ilist_isLinked(&items[3].node));
+
+    cfl_ilist_remove(&list, &items[2].node);
+    TEST_ASSERT(!cfl_ilist_isLinked(&items[2].node));
+    // removing a node that is not linked does nothing
+    cfl_ilist_remove(&list, &items[2].node);
+    TEST_ASSERT_EQUAL_INT(0, item_id(cfl_ilist_removeFirst(&list)));
+    TEST_ASSERT_EQUAL_INT(4, item_id(cfl_ilist_removeLast(&list)));
+    {
+        int expected[] = { 1, 3 };
+        TEST_ASSERT(list_matches(&list, expected, 2));
+    }
+    TEST_ASSERT_EQUAL_INT(3, item_id(cfl_ilist_next(&list, &items[1].node)));
+    TEST_ASSERT(cfl_ilist_next(&list, &items[3].node) == NULL);
+    TEST_ASSERT(cfl_ilist_previous(&list, &items[1].node) == NULL);
+}
+
+TEST_CASE(test_cfl_ilist_move_splice) {
+    CFL_ILIST list;
+    CFL_ILIST other;
+    CFL_ILIST_NODEP node;
+    CFL_ILIST_NODEP nextNode;
+    ITEM items[8];
+    int i;
+
+    cfl_ilist_init(&list);
+    cfl_ilist_init(&other);
+    for (i = 0; i < 8; i++) {
+        items[i].id = i;
+        cfl_ilist_addLast(i < 4 ? &list : &other, &items[i].node);
+    }
+    // LRU style: touched items go to the front, the last one is evicted
+    cfl_ilist_moveToFirst(&list, &items[2].node);
+    cfl_ilist_moveToFirst(&list, &items[2].node);
+    cfl_ilist_moveToLast(&list, &items[0].node);
+    {
+        int expected[] = { 2, 1, 3, 0 };
+        TEST_ASSERT(list_matches(&list, expected, 4));
+    }
+
+    cfl_ilist_spliceLast(&list, &other);
+    TEST_ASSERT(cfl_ilist_isEmpty(&other));
+    {
+        int expected[] = { 2, 1, 3, 0, 4, 5, 6, 7 };
+        TEST_ASSERT(list_matches(&list, expected, 8));
+    }
+    // move the odd ids to the other list, then put them back in front
+    CFL_ILIST_FOR_EACH_SAFE(&list, node, nextNode) {
+        if (item_id(node) % 2 == 1) {
+            cfl_ilist_remove(&list, node);
+            cfl_ilist_addLast(&other, node);
+        }
+    }
+    cfl_ilist_spliceFirst(&list, &other);
+    {
+        int expected[] = { 1, 3, 5, 7, 2, 0, 4, 6 };
+        TEST_ASSERT(list_matches(&list, expected, 8));
+    }
+    cfl_ilist_spliceFirst(&list, &other);
+    TEST_ASSERT_EQUAL_INT(8, cfl_ilist_length(&list));
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_ilist_add_remove);
+    RUN_TEST(test_cfl_ilist_move_splice);
+TEST_SUITE_END()
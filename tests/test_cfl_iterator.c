@@ -1,6 +1,10 @@
 #include "cfl_test.h"
 #include "cfl_list.h"
 #include "cfl_iterator.h"
+#include "cfl_array.h"
+#include "cfl_btree.h"
+#include "cfl_deque.h"
+#include "cfl_hash.h"
 
 // Helper to create a list for iteration
 static CFL_LISTP create_list() {
@@ -34,6 +38,247 @@ TEST_CASE(test_cfl_iterator_basic) {
     cfl_iterator_free(it);
 }
 
+typedef struct {
+    int current;
+    int end;
+} COUNTER_DATA;
+
+static CFL_BOOL counter_has_next(CFL_ITERATORP it) {
+    COUNTER_DATA *data = (COUNTER_DATA *)cfl_iterator_data(it);
+    return data->current < data->end;
+}
+
+static void *counter_next(CFL_ITERATORP it) {
+    COUNTER_DATA *data = (COUNTER_DATA *)cfl_iterator_data(it);
+    return (void *)(size_t)++data->current;
+}
+
+static CFL_ITERATOR_CLASS counter_class = {
+    counter_has_next, counter_next, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+static CFL_INT16 compare_int_keys(void *k1, void *k2, CFL_BOOL bExact) {
+    (void)bExact;
+    return (CFL_INT16)(*(int *)k1 - *(int *)k2);
+}
+
+static CFL_UINT32 hash_int(void *key) {
+    return (CFL_UINT32)*(int *)key;
+}
+
+static int equal_int(void *k1, void *k2) {
+    return *(int *)k1 == *(int *)k2;
+}
+
+// Reads the iterator in batches of 7 and checks that the values are 0..count-1 as ints
+static int drain_ints(CFL_ITERATORP it, int count, CFL_BOOL sorted) {
+    void *batch[7];
+    int seen[1000] = {0};
+    int total = 0;
+    CFL_UINT32 n;
+    CFL_UINT32 i;
+
+    while ((n = cfl_iterator_nextBatch(it, batch, 7)) > 0) {
+        for (i = 0; i < n; i++) {
+            int value = *(int *)batch[i];
+            if (value < 0 || value >= count || seen[value] || (sorted && value != total)) {
+                return -1;
+            }
+            seen[value] = 1;
+            total++;
+        }
+        if (n < 7) {
+            break;
+        }
+    }
+    return total;
+}
+
+TEST_CASE(test_cfl_iterator_next_batch) {
+    static int values[1000];
+    void *batch[16];
+    CFL_ARRAYP array = cfl_array_new(10, sizeof(int));
+    CFL_LISTP list = cfl_list_new(10);
+    CFL_DEQUEP deque = cfl_deque_new(0);
+    CFL_HASHP hash = cfl_hash_new(10, hash_int, equal_int, NULL);
+    CFL_BTREEP tree = cfl_btree_new(3, compare_int_keys);
+    CFL_ITERATOR_BUFFER buffer;
+    CFL_ITERATORP it;
+    COUNTER_DATA *counter;
+    int i;
+
+    for (i = 0; i < 1000; i++) {
+        values[i] = (i * 7) % 1000;
+        *(int *)cfl_array_add(array) = i;
+        cfl_list_add(list, &values[i]);
+        cfl_deque_addFirst(deque, &values[999 - i]);
+        cfl_hash_insert(hash, &values[i], &values[i]);
+        cfl_btree_add(tree, &values[i]);
+    }
+
+    it = cfl_array_iteratorInit(&buffer.iterator, array);
+    TEST_ASSERT_EQUAL_INT(1000, drain_ints(it, 1000, CFL_TRUE));
+    TEST_ASSERT_EQUAL_INT(0, cfl_iterator_nextBatch(it, batch, 16));
+    cfl_iterator_dispose(it);
+
+    it = cfl_list_iterator(list);
+    TEST_ASSERT_EQUAL_INT(1000, drain_ints(it, 1000, CFL_FALSE));
+    cfl_iterator_first(it);
+    TEST_ASSERT_EQUAL_INT(16, cfl_iterator_nextBatch(it, batch, 16));
+    TEST_ASSERT(batch[0] == &values[1]);
+    TEST_ASSERT(cfl_iterator_value(it) == &values[16]);
+    cfl_iterator_free(it);
+
+    it = cfl_deque_iterator(deque);
+    TEST_ASSERT_EQUAL_INT(1000, drain_ints(it, 1000, CFL_FALSE));
+    cfl_iterator_free(it);
+
+    it = cfl_hash_iteratorInit(&buffer.iterator, hash);
+    TEST_ASSERT_EQUAL_INT(1000, drain_ints(it, 1000, CFL_FALSE));
+    cfl_iterator_dispose(it);
+
+    it = cfl_btree_iterator(tree);
+    TEST_ASSERT_EQUAL_INT(1000, drain_ints(it, 1000, CFL_TRUE));
+    cfl_iterator_free(it);
+
+    it = cfl_btree_iterator(tree);
+    TEST_ASSERT_EQUAL_INT(3, cfl_iterator_nextBatch(it, batch, 3));
+    TEST_ASSERT_EQUAL_INT(3, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(3, *(int *)cfl_iterator_value(it));
+    cfl_iterator_free(it);
+
+    it = cfl_btree_iteratorInit(&buffer.iterator, tree);
+    TEST_ASSERT_EQUAL_INT(1000, drain_ints(it, 1000, CFL_TRUE));
+    TEST_ASSERT_EQUAL_INT(999, *(int *)cfl_iterator_value(it));
+    TEST_ASSERT_EQUAL_INT(999, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_dispose(it);
+
+    // Generic fallback through has_next and next
+    it = cfl_iterator_new(sizeof(COUNTER_DATA));
+    it->itClass = &counter_class;
+    counter = (COUNTER_DATA *)cfl_iterator_data(it);
+    counter->end = 20;
+    TEST_ASSERT_EQUAL_INT(16, cfl_iterator_nextBatch(it, batch, 16));
+    TEST_ASSERT(batch[15] == (void *)16);
+    TEST_ASSERT_EQUAL_INT(4, cfl_iterator_nextBatch(it, batch, 16));
+    TEST_ASSERT(batch[3] == (void *)20);
+    cfl_iterator_free(it);
+
+    cfl_array_free(array);
+    cfl_list_free(list);
+    cfl_deque_free(deque);
+    cfl_hash_free(hash, CFL_FALSE);
+    cfl_btree_free(tree, NULL);
+}
+
+static CFL_BOOL is_even(void *value, void *context) {
+    (void)context;
+    return *(int *)value % 2 == 0;
+}
+
+static void *square(void *value, void *context) {
+    int *squares = (int *)context;
+    return &squares[*(int *)value];
+}
+
+static int compare_ints(void *value1, void *value2, void *context) {
+    (void)context;
+    return *(int *)value1 - *(int *)value2;
+}
+
+static CFL_LISTP int_list(int *values, int from, int to, int step) {
+    CFL_LISTP list = cfl_list_new(10);
+    int i;
+    for (i = from; i < to; i += step) {
+        cfl_list_add(list, &values[i]);
+    }
+    return list;
+}
+
+TEST_CASE(test_cfl_iterator_adapters) {
+    static int values[100];
+    static int squares[100];
+    void *batch[100];
+    CFL_LISTP list;
+    CFL_LISTP evens;
+    CFL_LISTP odds;
+    CFL_ITERATORP it;
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        values[i] = i;
+        squares[i] = i * i;
+    }
+    list = int_list(values, 0, 100, 1);
+    evens = int_list(values, 0, 100, 2);
+    odds = int_list(values, 1, 100, 2);
+
+    // skip 10, keep the even values, square them and stop after 5: 100, 144, 196, 256, 324
+    it = cfl_iterator_limit(cfl_iterator_map(cfl_iterator_filter(cfl_iterator_skip(cfl_list_iterator(list), 10),
+                                                                 is_even, NULL), square, squares), 5);
+    TEST_ASSERT(it != NULL);
+    for (i = 0; cfl_iterator_hasNext(it); i++) {
+        int expected = (10 + i * 2) * (10 + i * 2);
+        TEST_ASSERT_EQUAL_INT(expected, *(int *)cfl_iterator_next(it));
+        TEST_ASSERT_EQUAL_INT(expected, *(int *)cfl_iterator_value(it));
+    }
+    TEST_ASSERT_EQUAL_INT(5, i);
+    TEST_ASSERT(cfl_iterator_next(it) == NULL);
+    cfl_iterator_free(it);
+
+    // Same pipeline read in batches
+    it = cfl_iterator_limit(cfl_iterator_map(cfl_iterator_filter(cfl_iterator_skip(cfl_list_iterator(list), 10),
+                                                                 is_even, NULL), square, squares), 5);
+    TEST_ASSERT_EQUAL_INT(3, cfl_iterator_nextBatch(it, batch, 3));
+    TEST_ASSERT_EQUAL_INT(144, *(int *)batch[1]);
+    TEST_ASSERT_EQUAL_INT(2, cfl_iterator_nextBatch(it, batch, 100));
+    TEST_ASSERT_EQUAL_INT(324, *(int *)batch[1]);
+    TEST_ASSERT_EQUAL_INT(0, cfl_iterator_nextBatch(it, batch, 100));
+    cfl_iterator_free(it);
+
+    it = cfl_iterator_filter(cfl_list_iterator(list), is_even, NULL);
+    TEST_ASSERT(cfl_iterator_hasNext(it));
+    TEST_ASSERT_EQUAL_INT(50, cfl_iterator_nextBatch(it, batch, 100));
+    TEST_ASSERT_EQUAL_INT(98, *(int *)batch[49]);
+    cfl_iterator_free(it);
+
+    it = cfl_iterator_skip(cfl_list_iterator(list), 1000);
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    it = cfl_iterator_concat(cfl_iterator_limit(cfl_list_iterator(odds), 2), cfl_list_iterator(evens));
+    TEST_ASSERT_EQUAL_INT(1, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(3, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(0, *(int *)cfl_iterator_next(it));
+    TEST_ASSERT_EQUAL_INT(49, cfl_iterator_nextBatch(it, batch, 100));
+    TEST_ASSERT_EQUAL_INT(98, *(int *)batch[48]);
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    it = cfl_iterator_merge(cfl_list_iterator(odds), cfl_list_iterator(evens), compare_ints, NULL);
+    for (i = 0; cfl_iterator_hasNext(it); i++) {
+        TEST_ASSERT_EQUAL_INT(i, *(int *)cfl_iterator_next(it));
+    }
+    TEST_ASSERT_EQUAL_INT(100, i);
+    cfl_iterator_free(it);
+
+    it = cfl_iterator_merge(cfl_list_iterator(evens), cfl_iterator_skip(cfl_list_iterator(list), 90), compare_ints, NULL);
+    TEST_ASSERT_EQUAL_INT(60, cfl_iterator_nextBatch(it, batch, 100));
+    TEST_ASSERT(batch[45] == &values[90]);
+    TEST_ASSERT(batch[46] == &values[90]);
+    TEST_ASSERT_EQUAL_INT(99, *(int *)batch[59]);
+    cfl_iterator_free(it);
+
+    TEST_ASSERT(cfl_iterator_map(cfl_iterator_filter(NULL, is_even, NULL), square, squares) == NULL);
+    TEST_ASSERT(cfl_iterator_concat(cfl_list_iterator(list), NULL) == NULL);
+
+    cfl_list_free(list);
+    cfl_list_free(evens);
+    cfl_list_free(odds);
+}
+
 TEST_SUITE_BEGIN()
     RUN_TEST(test_cfl_iterator_basic);
+    RUN_TEST(test_cfl_iterator_next_batch);
+    RUN_TEST(test_cfl_iterator_adapters);
 TEST_SUITE_END()
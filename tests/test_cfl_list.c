@@ -40,8 +40,117 @@ TEST_CASE(test_cfl_list_del) {
     cfl_list_free(list);
 }
 
+static int compare_strings(const void *a, const void *b) {
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+static CFL_UINT64 string_length(void *item) {
+    return strlen((char *)item);
+}
+
+TEST_CASE(test_cfl_list_sort) {
+    CFL_LISTP list = cfl_list_new(5);
+    char *words[] = { "pear", "fig", "apple", "kiwi", "banana", "date" };
+    int i;
+
+    for (i = 0; i < 6; i++) {
+        cfl_list_add(list, words[i]);
+    }
+    cfl_list_sort(list, compare_strings);
+    TEST_ASSERT_EQUAL_STRING("apple", (char *)cfl_list_get(list, 0));
+    TEST_ASSERT_EQUAL_STRING("banana", (char *)cfl_list_get(list, 1));
+    TEST_ASSERT_EQUAL_STRING("pear", (char *)cfl_list_get(list, 5));
+
+    // by length, keeping the alphabetical order of words with the same length
+    TEST_ASSERT(cfl_list_sortByKey(list, string_length));
+    TEST_ASSERT_EQUAL_STRING("fig", (char *)cfl_list_get(list, 0));
+    TEST_ASSERT_EQUAL_STRING("date", (char *)cfl_list_get(list, 1));
+    TEST_ASSERT_EQUAL_STRING("kiwi", (char *)cfl_list_get(list, 2));
+    TEST_ASSERT_EQUAL_STRING("pear", (char *)cfl_list_get(list, 3));
+    TEST_ASSERT_EQUAL_STRING("apple", (char *)cfl_list_get(list, 4));
+    TEST_ASSERT_EQUAL_STRING("banana", (char *)cfl_list_get(list, 5));
+
+    TEST_ASSERT(cfl_list_sortStable(list, compare_strings));
+    TEST_ASSERT_EQUAL_STRING("apple", (char *)cfl_list_get(list, 0));
+    TEST_ASSERT_EQUAL_STRING("pear", (char *)cfl_list_get(list, 5));
+
+    cfl_list_free(list);
+}
+
+TEST_CASE(test_cfl_list_bulk) {
+    CFL_LISTP list = cfl_list_new(0);
+    CFL_LISTP other = cfl_list_new(2);
+    char *words[] = { "a", "b", "c", "d", "e" };
+    char *inserted[] = { "x", "y" };
+
+    TEST_ASSERT(cfl_list_reserve(list, 50));
+    TEST_ASSERT_EQUAL_INT(50, list->capacity);
+    TEST_ASSERT(cfl_list_appendN(list, (void **)words, 5));
+    TEST_ASSERT(cfl_list_insertRange(list, 2, (void **)inserted, 2));
+    TEST_ASSERT(!cfl_list_insertRange(list, 8, (void **)inserted, 2));
+    TEST_ASSERT_EQUAL_INT(7, cfl_list_length(list));
+    TEST_ASSERT_EQUAL_STRING("b", (char *)cfl_list_get(list, 1));
+    TEST_ASSERT_EQUAL_STRING("x", (char *)cfl_list_get(list, 2));
+    TEST_ASSERT_EQUAL_STRING("y", (char *)cfl_list_get(list, 3));
+    TEST_ASSERT_EQUAL_STRING("c", (char *)cfl_list_get(list, 4));
+
+    cfl_list_deleteRange(list, 2, 2);
+    TEST_ASSERT_EQUAL_INT(5, cfl_list_length(list));
+    TEST_ASSERT_EQUAL_STRING("c", (char *)cfl_list_get(list, 2));
+    TEST_ASSERT(list->items[5] == NULL && list->items[6] == NULL);
+    cfl_list_deleteRange(list, 3, 10);
+    TEST_ASSERT_EQUAL_INT(3, cfl_list_length(list));
+
+    cfl_list_add(other, "z");
+    TEST_ASSERT(cfl_list_addAll(list, other));
+    TEST_ASSERT_EQUAL_STRING("z", (char *)cfl_list_get(list, 3));
+
+    TEST_ASSERT(cfl_list_resize(list, 6, CFL_TRUE));
+    TEST_ASSERT(cfl_list_get(list, 5) == NULL);
+    TEST_ASSERT(cfl_list_resize(list, 100, CFL_FALSE));
+    TEST_ASSERT_EQUAL_INT(100, cfl_list_length(list));
+    TEST_ASSERT(cfl_list_resize(list, 4, CFL_FALSE));
+    cfl_list_shrinkToFit(list);
+    TEST_ASSERT_EQUAL_INT(4, list->capacity);
+    TEST_ASSERT_EQUAL_STRING("z", (char *)cfl_list_get(list, 3));
+    cfl_list_clear(list);
+    cfl_list_shrinkToFit(list);
+    TEST_ASSERT(list->items == NULL);
+    cfl_list_add(list, "w");
+    TEST_ASSERT_EQUAL_STRING("w", (char *)cfl_list_get(list, 0));
+
+    cfl_list_free(list);
+    cfl_list_free(other);
+}
+
+TEST_CASE(test_cfl_list_self_append) {
+    CFL_LISTP list = cfl_list_new(0);
+    char *words[] = { "a", "b", "c" };
+    const char *expected = "abcabcaabcbc";
+    CFL_UINT32 i;
+
+    // The source is in the list, which must grow before the copy
+    TEST_ASSERT(cfl_list_appendN(list, (void **)words, 3));
+    cfl_list_shrinkToFit(list);
+    TEST_ASSERT(cfl_list_addAll(list, list));
+    TEST_ASSERT_EQUAL_INT(6, cfl_list_length(list));
+
+    // Insert "abc" from index 6 before index 7: the source spans the insertion point
+    TEST_ASSERT(cfl_list_appendN(list, list->items, 3));
+    cfl_list_shrinkToFit(list);
+    TEST_ASSERT(cfl_list_insertRange(list, 7, &list->items[6], 3));
+    TEST_ASSERT_EQUAL_INT(12, cfl_list_length(list));
+    for (i = 0; i < 12; i++) {
+        TEST_ASSERT(((char *)cfl_list_get(list, i))[0] == expected[i]);
+    }
+    cfl_list_free(list);
+}
+
 TEST_SUITE_BEGIN()
     RUN_TEST(test_cfl_list_new_free);
     RUN_TEST(test_cfl_list_add_get);
     RUN_TEST(test_cfl_list_del);
+    RUN_TEST(test_cfl_list_sort);
+    RUN_TEST(test_cfl_list_bulk);
+    RUN_TEST(test_cfl_list_self_append);
 TEST_SUITE_END()
@@ -1,5 +1,8 @@
 #include "cfl_test.h"
 #include "cfl_map.h"
+#include "cfl_iterator.h"
+#include "cfl_mem.h"
+#include <stdlib.h>
 #include <string.h>
 
 // Helper functions for map
@@ -9,6 +12,17 @@ static int compare_ints(const void *k1, const void *k2) {
     return i1 - i2;
 }
 
+static void *failing_malloc(size_t size) {
+    (void)size;
+    return NULL;
+}
+
+static void *failing_realloc(void *ptr, size_t size) {
+    (void)ptr;
+    (void)size;
+    return NULL;
+}
+
 TEST_CASE(test_cfl_map_lifecycle) {
     CFL_MAPP map = cfl_map_new(sizeof(int), sizeof(int), compare_ints, NULL);
     TEST_ASSERT(map != NULL);
@@ -58,8 +72,154 @@ TEST_CASE(test_cfl_map_del) {
     cfl_map_free(map);
 }
 
+TEST_CASE(test_cfl_map_sorted) {
+    CFL_MAPP map = cfl_map_newSorted(sizeof(int), sizeof(int), compare_ints, NULL);
+    int keys[] = { 50, 10, 40, 20, 30 };
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        int value = keys[i] * 10;
+        cfl_map_set(map, &keys[i], &value);
+    }
+    TEST_ASSERT_EQUAL_INT(5, cfl_map_length(map));
+    for (i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT((i + 1) * 10, *(const int *)cfl_map_getKeyIndex(map, i));
+        TEST_ASSERT_EQUAL_INT((i + 1) * 100, *(const int *)cfl_map_getIndex(map, i));
+    }
+
+    int k = 30, v = 333;
+    cfl_map_set(map, &k, &v);
+    TEST_ASSERT_EQUAL_INT(5, cfl_map_length(map));
+    TEST_ASSERT_EQUAL_INT(333, *(const int *)cfl_map_get(map, &k));
+
+    k = 35;
+    TEST_ASSERT(cfl_map_get(map, &k) == NULL);
+    TEST_ASSERT_EQUAL_INT(3, cfl_map_lowerBound(map, &k));
+    TEST_ASSERT_EQUAL_INT(3, cfl_map_upperBound(map, &k));
+    k = 40;
+    TEST_ASSERT_EQUAL_INT(3, cfl_map_lowerBound(map, &k));
+    TEST_ASSERT_EQUAL_INT(4, cfl_map_upperBound(map, &k));
+
+    k = 10;
+    TEST_ASSERT(cfl_map_del(map, &k));
+    TEST_ASSERT(!cfl_map_del(map, &k));
+    TEST_ASSERT_EQUAL_INT(4, cfl_map_length(map));
+    TEST_ASSERT_EQUAL_INT(20, *(const int *)cfl_map_getKeyIndex(map, 0));
+
+    cfl_map_free(map);
+}
+
+TEST_CASE(test_cfl_map_sorted_set_all) {
+    CFL_MAPP map = cfl_map_newSorted(sizeof(int), sizeof(int), compare_ints, NULL);
+    int keys[] = { 9, 3, 7, 1, 3, 5, 9, 2 };
+    int values[] = { 90, 30, 70, 10, 31, 50, 91, 20 };
+    int expectedKeys[] = { 1, 2, 3, 5, 7, 9 };
+    int expectedValues[] = { 10, 20, 31, 50, 70, 91 };
+    int i;
+
+    cfl_map_setAll(map, keys, values, 8);
+    TEST_ASSERT_EQUAL_INT(6, cfl_map_length(map));
+    for (i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_INT(expectedKeys[i], *(const int *)cfl_map_getKeyIndex(map, i));
+        TEST_ASSERT_EQUAL_INT(expectedValues[i], *(const int *)cfl_map_getIndex(map, i));
+    }
+
+    CFL_MAPP unsorted = cfl_map_new(sizeof(int), sizeof(int), compare_ints, NULL);
+    cfl_map_setAll(unsorted, keys, values, 8);
+    TEST_ASSERT_EQUAL_INT(6, cfl_map_length(unsorted));
+    TEST_ASSERT_EQUAL_INT(91, *(const int *)cfl_map_get(unsorted, &keys[0]));
+
+    CFL_MAPP copy = cfl_map_newSorted(sizeof(int), sizeof(int), compare_ints, NULL);
+    cfl_map_copy(copy, unsorted);
+    for (i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_INT(expectedKeys[i], *(const int *)cfl_map_getKeyIndex(copy, i));
+    }
+
+    cfl_map_free(copy);
+    cfl_map_free(unsorted);
+    cfl_map_free(map);
+}
+
+TEST_CASE(test_cfl_map_sorted_set_all_out_of_memory) {
+    CFL_MAPP map = cfl_map_newSorted(sizeof(int), sizeof(int), compare_ints, NULL);
+    int keys[] = { 9, 3, 7, 1, 3, 5, 9, 2 };
+    int values[] = { 90, 30, 70, 10, 31, 50, 91, 20 };
+    int expectedKeys[] = { 1, 2, 3, 5, 7, 9 };
+    int expectedValues[] = { 10, 20, 31, 50, 70, 91 };
+    int i;
+
+    // Without room for the entries the map is unchanged
+    cfl_map_set(map, &keys[0], &values[0]);
+    cfl_mem_set(failing_malloc, failing_realloc, NULL);
+    TEST_ASSERT(!cfl_map_setAll(map, keys, values, 200));
+    cfl_mem_set(malloc, realloc, NULL);
+    TEST_ASSERT_EQUAL_INT(1, cfl_map_length(map));
+    TEST_ASSERT(cfl_map_del(map, &keys[0]));
+
+    // Without memory for the merge buffer the entries are still sorted
+    TEST_ASSERT(cfl_array_reserve(&map->entries, 8));
+    cfl_mem_set(failing_malloc, failing_realloc, NULL);
+    TEST_ASSERT(cfl_map_setAll(map, keys, values, 8));
+    cfl_mem_set(malloc, realloc, NULL);
+    TEST_ASSERT_EQUAL_INT(6, cfl_map_length(map));
+    for (i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_INT(expectedKeys[i], *(const int *)cfl_map_getKeyIndex(map, i));
+        TEST_ASSERT_EQUAL_INT(expectedValues[i], *(const int *)cfl_map_get(map, &expectedKeys[i]));
+    }
+
+    cfl_map_free(map);
+}
+
+TEST_CASE(test_cfl_map_sorted_range) {
+    CFL_MAPP map = cfl_map_newSorted(sizeof(int), sizeof(int), compare_ints, NULL);
+    CFL_ITERATORP it;
+    int i;
+    int count;
+    int from = 25, to = 60;
+
+    for (i = 10; i >= 1; i--) {
+        int key = i * 10;
+        cfl_map_set(map, &key, &i);
+    }
+
+    it = cfl_map_iteratorRange(map, &from, &to);
+    count = 0;
+    while (cfl_iterator_hasNext(it)) {
+        int value = *(int *)cfl_iterator_next(it);
+        TEST_ASSERT_EQUAL_INT(3 + count, value);
+        ++count;
+    }
+    TEST_ASSERT_EQUAL_INT(4, count);
+    TEST_ASSERT_EQUAL_INT(5, *(int *)cfl_iterator_previous(it));
+    cfl_iterator_first(it);
+    cfl_iterator_next(it);
+    cfl_iterator_remove(it);
+    TEST_ASSERT_EQUAL_INT(9, cfl_map_length(map));
+    TEST_ASSERT_EQUAL_INT(4, *(int *)cfl_iterator_next(it));
+    cfl_iterator_free(it);
+
+    it = cfl_map_iteratorRange(map, NULL, &from);
+    count = 0;
+    while (cfl_iterator_hasNext(it)) {
+        cfl_iterator_next(it);
+        ++count;
+    }
+    TEST_ASSERT_EQUAL_INT(2, count);
+    cfl_iterator_free(it);
+
+    it = cfl_map_iteratorRange(map, &to, &from);
+    TEST_ASSERT(!cfl_iterator_hasNext(it));
+    cfl_iterator_free(it);
+
+    cfl_map_free(map);
+}
+
 TEST_SUITE_BEGIN()
     RUN_TEST(test_cfl_map_lifecycle);
     RUN_TEST(test_cfl_map_set_get);
     RUN_TEST(test_cfl_map_del);
+    RUN_TEST(test_cfl_map_sorted);
+    RUN_TEST(test_cfl_map_sorted_set_all);
+    RUN_TEST(test_cfl_map_sorted_set_all_out_of_memory);
+    RUN_TEST(test_cfl_map_sorted_range);
 TEST_SUITE_END()
@@ -46,9 +46,114 @@ TEST_CASE(test_cfl_mapstr_format) {
     cfl_mapstr_free(map);
 }
 
+TEST_CASE(test_cfl_mapstr_packed) {
+    CFL_MAPSTRP map = cfl_mapstr_newPacked(16);
+    char key[16];
+    int i;
+
+    TEST_ASSERT(cfl_mapstr_isPacked(map));
+    for (i = 0; i < 200; i++) {
+        sprintf(key, "key%d", i);
+        cfl_mapstr_setFormat(map, key, "value%d", i);
+    }
+    TEST_ASSERT_EQUAL_INT(200, cfl_mapstr_length(map));
+    TEST_ASSERT_EQUAL_STRING("value0", cfl_mapstr_get(map, "key0"));
+    TEST_ASSERT_EQUAL_STRING("value199", cfl_mapstr_get(map, "key199"));
+
+    cfl_mapstr_set(map, "key10", "v");
+    TEST_ASSERT_EQUAL_STRING("v", cfl_mapstr_get(map, "key10"));
+    cfl_mapstr_set(map, "key10", "a much longer value");
+    TEST_ASSERT_EQUAL_STRING("a much longer value", cfl_mapstr_get(map, "key10"));
+    TEST_ASSERT_EQUAL_INT(19, cfl_str_length(cfl_mapstr_getStr(map, "key10")));
+
+    cfl_mapstr_free(map);
+}
+
+TEST_CASE(test_cfl_mapstr_packed_compact) {
+    CFL_MAPSTRP map = cfl_mapstr_newPacked(0);
+    char key[16];
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        sprintf(key, "key%d", i);
+        cfl_mapstr_set(map, key, "some value");
+    }
+    for (i = 0; i < 90; i++) {
+        sprintf(key, "key%d", i);
+        TEST_ASSERT(cfl_mapstr_del(map, key));
+    }
+    TEST_ASSERT_EQUAL_INT(10, cfl_mapstr_length(map));
+    cfl_mapstr_compact(map);
+    TEST_ASSERT_EQUAL_INT(0, map->arenaWaste);
+    TEST_ASSERT(map->arenaLength < 200);
+    TEST_ASSERT_EQUAL_STRING("key90", cfl_mapstr_getKeyIndex(map, 0));
+    TEST_ASSERT_EQUAL_STRING("some value", cfl_mapstr_get(map, "key99"));
+
+    cfl_mapstr_free(map);
+}
+
+TEST_CASE(test_cfl_mapstr_packed_copy) {
+    CFL_MAPSTRP from = cfl_mapstr_newPacked(64);
+    CFL_MAPSTRP packed = cfl_mapstr_newPacked(0);
+    CFL_MAPSTRP plain = cfl_mapstr_new();
+
+    cfl_mapstr_set(from, "a", "1");
+    cfl_mapstr_set(from, "b", "2");
+
+    cfl_mapstr_copy(packed, from);
+    cfl_mapstr_copy(plain, from);
+    cfl_mapstr_free(from);
+
+    TEST_ASSERT_EQUAL_INT(2, cfl_mapstr_length(packed));
+    TEST_ASSERT_EQUAL_STRING("1", cfl_mapstr_get(packed, "a"));
+    TEST_ASSERT_EQUAL_STRING("2", cfl_mapstr_get(packed, "b"));
+    TEST_ASSERT_EQUAL_INT(2, cfl_mapstr_length(plain));
+    TEST_ASSERT_EQUAL_STRING("2", cfl_mapstr_get(plain, "b"));
+
+    cfl_mapstr_free(packed);
+    cfl_mapstr_free(plain);
+}
+
+TEST_CASE(test_cfl_mapstr_packed_clear) {
+    CFL_MAPSTRP map = cfl_mapstr_newPacked(16);
+    char key[16];
+    int i;
+
+    cfl_mapstr_set(map, "a", "hello");
+    cfl_mapstr_set(map, "b", "world");
+    cfl_mapstr_set(map, "c", "other");
+    cfl_mapstr_entry_setValue(cfl_mapstr_getEntry(map, 0), "");
+    cfl_mapstr_entry_setValue(cfl_mapstr_getEntry(map, 1), NULL);
+    cfl_str_clear(cfl_mapstr_getStr(map, "c"));
+    cfl_mapstr_entry_setKey(cfl_mapstr_getEntry(map, 2), "renamed");
+
+    // The cleared strings must not follow the arena when it grows
+    for (i = 0; i < 100; i++) {
+        sprintf(key, "key%d", i);
+        cfl_mapstr_set(map, key, "some value");
+    }
+    TEST_ASSERT_EQUAL_STRING("", cfl_mapstr_get(map, "a"));
+    TEST_ASSERT_EQUAL_STRING("", cfl_mapstr_get(map, "b"));
+    TEST_ASSERT_EQUAL_STRING("", cfl_mapstr_get(map, "renamed"));
+    TEST_ASSERT(cfl_mapstr_get(map, "c") == NULL);
+
+    cfl_mapstr_compact(map);
+    TEST_ASSERT_EQUAL_INT(0, cfl_str_length(cfl_mapstr_getStr(map, "a")));
+    TEST_ASSERT_EQUAL_STRING("", cfl_mapstr_get(map, "a"));
+    TEST_ASSERT_EQUAL_STRING("", cfl_mapstr_get(map, "b"));
+    TEST_ASSERT_EQUAL_STRING("", cfl_mapstr_get(map, "renamed"));
+    TEST_ASSERT_EQUAL_STRING("some value", cfl_mapstr_get(map, "key99"));
+
+    cfl_mapstr_free(map);
+}
+
 TEST_SUITE_BEGIN()
     RUN_TEST(test_cfl_mapstr_lifecycle);
     RUN_TEST(test_cfl_mapstr_set_get);
     RUN_TEST(test_cfl_mapstr_del);
     RUN_TEST(test_cfl_mapstr_format);
+    RUN_TEST(test_cfl_mapstr_packed);
+    RUN_TEST(test_cfl_mapstr_packed_compact);
+    RUN_TEST(test_cfl_mapstr_packed_copy);
+    RUN_TEST(test_cfl_mapstr_packed_clear);
 TEST_SUITE_END()
@@ -0,0 +1,225 @@
+#include "cfl_test.h"
+#include "cfl_parallel.h"
+#include <stdlib.h>
+
+static int compare_ints(const void *a, const void *b) {
+    int i1 = *(const int *)a;
+    int i2 = *(const int *)b;
+    return i1 < i2 ? -1 : (i1 > i2 ? 1 : 0);
+}
+
+static int compare_pointed_ints(const void *a, const void *b) {
+    return compare_ints(*(void *const *)a, *(void *const *)b);
+}
+
+static void mark_range(CFL_UINT32 start, CFL_UINT32 end, void *context) {
+    int *visits = (int *)context;
+    CFL_UINT32 i;
+    for (i = start; i < end; i++) {
+        visits[i]++;
+    }
+}
+
+static void square_item(void *item, void *context) {
+    (void)context;
+    *(int *)item = *(int *)item * *(int *)item;
+}
+
+static void negate_item(void *item, void *context) {
+    (void)context;
+    *(int *)item = -*(int *)item;
+}
+
+static void sum_range(CFL_UINT32 start, CFL_UINT32 end, void *partial, void *context) {
+    CFL_UINT32 i;
+    (void)context;
+    for (i = start; i < end; i++) {
+        *(CFL_INT64 *)partial += i + 1;
+    }
+}
+
+static void sum_item(void *partial, void *item, void *context) {
+    (void)context;
+    *(CFL_INT64 *)partial += *(int *)item;
+}
+
+static void add_partial(void *result, const void *partial, void *context) {
+    (void)context;
+    *(CFL_INT64 *)result += *(const CFL_INT64 *)partial;
+}
+
+static void nested_for(void *item, void *context) {
+    int visits[10] = { 0 };
+    int i;
+    (void)context;
+    // the pool is busy with this job, so the nested loop runs on this thread
+    cfl_parallel_for(NULL, 10, mark_range, visits);
+    for (i = 0; i < 10; i++) {
+        if (visits[i] != 1) {
+            return;
+        }
+    }
+    *(int *)item = 1;
+}
+
+TEST_CASE(test_cfl_parallel_for) {
+    CFL_PARALLELP pool = cfl_parallel_new(4);
+    CFL_ARRAYP array = cfl_array_newLen(1000, sizeof(int));
+    CFL_LISTP list = cfl_list_new(100);
+    static int visits[10000];
+    static int values[100];
+    CFL_UINT32 i;
+    int ok = 1;
+
+    TEST_ASSERT(pool != NULL);
+    TEST_ASSERT_EQUAL_INT(4, cfl_parallel_threads(pool));
+    cfl_parallel_for(pool, 10000, mark_range, visits);
+    for (i = 0; i < 10000; i++) {
+        ok &= visits[i] == 1;
+    }
+    TEST_ASSERT(ok);
+    // fewer items than chunks
+    memset(visits, 0, sizeof(visits));
+    cfl_parallel_for(pool, 3, mark_range, visits);
+    TEST_ASSERT(visits[0] == 1 && visits[1] == 1 && visits[2] == 1 && visits[3] == 0);
+    cfl_parallel_for(pool, 0, mark_range, visits);
+
+    for (i = 0; i < 1000; i++) {
+        *(int *)cfl_array_get(array, i) = (int)i;
+    }
+    cfl_parallel_forArray(pool, array, square_item, NULL);
+    for (i = 0; i < 1000; i++) {
+        ok &= *(int *)cfl_array_get(array, i) == (int)(i * i);
+    }
+    TEST_ASSERT(ok);
+
+    for (i = 0; i < 100; i++) {
+        values[i] = (int)i;
+        cfl_list_add(list, &values[i]);
+    }
+    cfl_parallel_forList(pool, list, negate_item, NULL);
+    for (i = 0; i < 100; i++) {
+        ok &= values[i] == -(int)i;
+    }
+    TEST_ASSERT(ok);
+
+    cfl_list_free(list);
+    cfl_array_free(array);
+    cfl_parallel_free(pool);
+}
+
+TEST_CASE(test_cfl_parallel_reduce) {
+    CFL_PARALLELP pool = cfl_parallel_new(3);
+    CFL_ARRAYP array = cfl_array_newLen(5000, sizeof(int));
+    CFL_LISTP list = cfl_list_new(5000);
+    CFL_INT64 sum;
+    CFL_UINT32 i;
+
+    sum = 0;
+    cfl_parallel_reduce(pool, 100000, &sum, sizeof(sum), sum_range, add_partial, NULL);
+    TEST_ASSERT(sum == (CFL_INT64)100000 * 100001 / 2);
+    sum = 7;
+    cfl_parallel_reduce(pool, 0, &sum, sizeof(sum), sum_range, add_partial, NULL);
+    TEST_ASSERT(sum == 7);
+
+    for (i = 0; i < 5000; i++) {
+        *(int *)cfl_array_get(array, i) = (int)i - 1000;
+        cfl_list_add(list, cfl_array_get(array, i));
+    }
+    sum = 0;
+    cfl_parallel_reduceArray(pool, array, &sum, sizeof(sum), sum_item, add_partial, NULL);
+    TEST_ASSERT(sum == (CFL_INT64)4999 * 5000 / 2 - 5000 * 1000);
+    sum = 0;
+    cfl_parallel_reduceList(pool, list, &sum, sizeof(sum), sum_item, add_partial, NULL);
+    TEST_ASSERT(sum == (CFL_INT64)4999 * 5000 / 2 - 5000 * 1000);
+
+    cfl_list_free(list);
+    cfl_array_free(array);
+    cfl_parallel_free(pool);
+}
+
+static int sort_matches(CFL_PARALLELP pool, CFL_UINT32 count, int modulo) {
+    int *values = (int *)malloc(sizeof(int) * (count + 1));
+    int *expected = (int *)malloc(sizeof(int) * (count + 1));
+    CFL_UINT32 i;
+    int ok;
+
+    for (i = 0; i < count; i++) {
+        values[i] = rand() % modulo;
+    }
+    memcpy(expected, values, sizeof(int) * count);
+    qsort(expected, count, sizeof(int), compare_ints);
+    cfl_parallel_sort(pool, values, count, sizeof(int), compare_ints);
+    ok = count == 0 || memcmp(values, expected, sizeof(int) * count) == 0;
+    free(values);
+    free(expected);
+    return ok;
+}
+
+TEST_CASE(test_cfl_parallel_sort) {
+    CFL_PARALLELP pool4 = cfl_parallel_new(4);
+    CFL_PARALLELP pool3 = cfl_parallel_new(3);
+    CFL_PARALLELP pool1 = cfl_parallel_new(1);
+    CFL_ARRAYP array = cfl_array_newLen(50000, sizeof(int));
+    CFL_LISTP list = cfl_list_new(50000);
+    CFL_UINT32 i;
+    int ok = 1;
+
+    srand(37);
+    TEST_ASSERT(sort_matches(pool4, 0, 10));
+    TEST_ASSERT(sort_matches(pool4, 100, 1000));
+    TEST_ASSERT(sort_matches(pool4, 100000, 1000000));
+    TEST_ASSERT(sort_matches(pool4, 100000, 5));
+    TEST_ASSERT(sort_matches(pool4, 33333, 1000000));
+    TEST_ASSERT(sort_matches(pool3, 100000, 1000000));
+    TEST_ASSERT(sort_matches(pool1, 100000, 1000000));
+
+    for (i = 0; i < 50000; i++) {
+        *(int *)cfl_array_get(array, i) = (int)(50000 - i);
+    }
+    cfl_parallel_sortArray(pool4, array, compare_ints);
+    for (i = 0; i < 50000; i++) {
+        ok &= *(int *)cfl_array_get(array, i) == (int)(i + 1);
+    }
+    TEST_ASSERT(ok);
+
+    for (i = 0; i < 50000; i++) {
+        *(int *)cfl_array_get(array, i) = rand();
+        cfl_list_add(list, cfl_array_get(array, i));
+    }
+    cfl_parallel_sortList(pool3, list, compare_pointed_ints);
+    for (i = 1; i < 50000; i++) {
+        ok &= *(int *)cfl_list_get(list, i - 1) <= *(int *)cfl_list_get(list, i);
+    }
+    TEST_ASSERT(ok);
+
+    cfl_list_free(list);
+    cfl_array_free(array);
+    cfl_parallel_free(pool1);
+    cfl_parallel_free(pool3);
+    cfl_parallel_free(pool4);
+}
+
+TEST_CASE(test_cfl_parallel_shared) {
+    CFL_ARRAYP array = cfl_array_newLen(64, sizeof(int));
+    CFL_UINT32 i;
+    int ok = 1;
+
+    TEST_ASSERT(cfl_parallel_shared() != NULL);
+    TEST_ASSERT(cfl_parallel_shared() == cfl_parallel_shared());
+    TEST_ASSERT_EQUAL_INT(cfl_parallel_cpuCount(), cfl_parallel_threads(NULL));
+    cfl_parallel_forArray(NULL, array, nested_for, NULL);
+    for (i = 0; i < 64; i++) {
+        ok &= *(int *)cfl_array_get(array, i) == 1;
+    }
+    TEST_ASSERT(ok);
+    cfl_array_free(array);
+    cfl_parallel_freeShared();
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_parallel_for);
+    RUN_TEST(test_cfl_parallel_reduce);
+    RUN_TEST(test_cfl_parallel_sort);
+    RUN_TEST(test_cfl_parallel_shared);
+TEST_SUITE_END()
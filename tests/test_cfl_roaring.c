@@ -0,0 +1,236 @@
+#include "cfl_test.h"
+#include "cfl_roaring.h"
+#include "cfl_bitset.h"
+
+#define TEST_RANGE (4 * 65536)
+
+static CFL_BOOL collect_values(CFL_UINT32 value, void *context) {
+    CFL_UINT32 *values = (CFL_UINT32 *)context;
+    values[++values[0]] = value;
+    return values[0] < 4;
+}
+
+static CFL_UINT32 next_random(CFL_UINT32 *seed) {
+    *seed = *seed * 1103515245 + 12345;
+    return (*seed >> 8) & 0xFFFFFF;
+}
+
+/* Fills the chunks with, in order: sparse values, dense values, runs and nothing */
+static void fill_mixed(CFL_ROARINGP roaring, CFL_BITSETP bitset, CFL_UINT32 seed) {
+    CFL_UINT32 i;
+    for (i = 0; i < 1000; i++) {
+        CFL_UINT32 value = next_random(&seed) % 65536;
+        cfl_roaring_add(roaring, value);
+        cfl_bitset_set(bitset, value);
+    }
+    for (i = 0; i < 30000; i++) {
+        CFL_UINT32 value = 65536 + next_random(&seed) % 65536;
+        cfl_roaring_add(roaring, value);
+        cfl_bitset_set(bitset, value);
+    }
+    for (i = 0; i < 50; i++) {
+        CFL_UINT32 from = 2 * 65536 + next_random(&seed) % 65000;
+        CFL_UINT32 to = from + next_random(&seed) % 500;
+        CFL_UINT32 value;
+        cfl_roaring_addRange(roaring, from, to);
+        for (value = from; value <= to; value++) {
+            cfl_bitset_set(bitset, value);
+        }
+    }
+}
+
+static CFL_BOOL same_values(const CFL_ROARINGP roaring, const CFL_BITSETP bitset) {
+    static CFL_UINT32 values1[TEST_RANGE];
+    static CFL_UINT32 values2[TEST_RANGE];
+    CFL_UINT32 count1 = cfl_roaring_toArray(roaring, values1, TEST_RANGE);
+    CFL_UINT32 count2 = cfl_bitset_toArray(bitset, 0, values2, TEST_RANGE);
+    return count1 == count2 && cfl_roaring_cardinality(roaring) == count1
+           && memcmp(values1, values2, count1 * sizeof(CFL_UINT32)) == 0;
+}
+
+TEST_CASE(test_cfl_roaring_add_remove) {
+    CFL_ROARINGP roaring = cfl_roaring_new();
+    CFL_ROARING local;
+    CFL_UINT32 values[10];
+    CFL_UINT32 i;
+
+    TEST_ASSERT(roaring != NULL);
+    TEST_ASSERT(cfl_roaring_isEmpty(roaring));
+    TEST_ASSERT(cfl_roaring_add(roaring, 10));
+    TEST_ASSERT(cfl_roaring_add(roaring, 0xFFFFFFFF));
+    TEST_ASSERT(cfl_roaring_add(roaring, 70000));
+    TEST_ASSERT(cfl_roaring_add(roaring, 10));
+    TEST_ASSERT_EQUAL_INT(3, (int)cfl_roaring_cardinality(roaring));
+    TEST_ASSERT(cfl_roaring_contains(roaring, 10));
+    TEST_ASSERT(cfl_roaring_contains(roaring, 70000));
+    TEST_ASSERT(cfl_roaring_contains(roaring, 0xFFFFFFFF));
+    TEST_ASSERT(!cfl_roaring_contains(roaring, 11));
+    TEST_ASSERT(!cfl_roaring_contains(roaring, 0x10000 | 10));
+
+    values[0] = 0;
+    TEST_ASSERT(cfl_roaring_forEach(roaring, collect_values, values));
+    TEST_ASSERT_EQUAL_INT(3, values[0]);
+    TEST_ASSERT_EQUAL_INT(10, values[1]);
+    TEST_ASSERT_EQUAL_INT(70000, values[2]);
+    TEST_ASSERT(values[3] == 0xFFFFFFFF);
+
+    TEST_ASSERT(cfl_roaring_remove(roaring, 70000));
+    TEST_ASSERT(cfl_roaring_remove(roaring, 70001));
+    TEST_ASSERT(!cfl_roaring_contains(roaring, 70000));
+    TEST_ASSERT_EQUAL_INT(2, (int)cfl_roaring_cardinality(roaring));
+
+    // An array container becomes a bitmap past 4096 values and back
+    cfl_roaring_clear(roaring);
+    for (i = 0; i < 10000; i += 2) {
+        TEST_ASSERT(cfl_roaring_add(roaring, i));
+    }
+    TEST_ASSERT_EQUAL_INT(5000, (int)cfl_roaring_cardinality(roaring));
+    TEST_ASSERT(cfl_roaring_contains(roaring, 9998));
+    TEST_ASSERT(!cfl_roaring_contains(roaring, 9999));
+    for (i = 0; i < 10000; i += 4) {
+        TEST_ASSERT(cfl_roaring_remove(roaring, i));
+    }
+    TEST_ASSERT_EQUAL_INT(2500, (int)cfl_roaring_cardinality(roaring));
+    TEST_ASSERT(cfl_roaring_contains(roaring, 9998));
+    TEST_ASSERT(!cfl_roaring_contains(roaring, 9996));
+    TEST_ASSERT_EQUAL_INT(2, (int)cfl_roaring_toArray(roaring, values, 2));
+    TEST_ASSERT_EQUAL_INT(2, values[0]);
+    TEST_ASSERT_EQUAL_INT(6, values[1]);
+    cfl_roaring_free(roaring);
+
+    // Runs grow, merge and split
+    cfl_roaring_init(&local);
+    TEST_ASSERT(cfl_roaring_addRange(&local, 100, 199));
+    TEST_ASSERT(cfl_roaring_addRange(&local, 300, 399));
+    TEST_ASSERT(cfl_roaring_add(&local, 200));
+    TEST_ASSERT(cfl_roaring_add(&local, 299));
+    TEST_ASSERT_EQUAL_INT(202, (int)cfl_roaring_cardinality(&local));
+    for (i = 201; i < 299; i++) {
+        TEST_ASSERT(cfl_roaring_add(&local, i));
+    }
+    TEST_ASSERT_EQUAL_INT(300, (int)cfl_roaring_cardinality(&local));
+    TEST_ASSERT(cfl_roaring_remove(&local, 250));
+    TEST_ASSERT(cfl_roaring_remove(&local, 100));
+    TEST_ASSERT(cfl_roaring_remove(&local, 399));
+    TEST_ASSERT_EQUAL_INT(297, (int)cfl_roaring_cardinality(&local));
+    TEST_ASSERT(!cfl_roaring_contains(&local, 250));
+    TEST_ASSERT(cfl_roaring_contains(&local, 249));
+    TEST_ASSERT(cfl_roaring_contains(&local, 251));
+    TEST_ASSERT(!cfl_roaring_contains(&local, 100));
+    TEST_ASSERT(cfl_roaring_contains(&local, 101));
+    TEST_ASSERT(!cfl_roaring_contains(&local, 399));
+    TEST_ASSERT(cfl_roaring_contains(&local, 398));
+
+    // Ranges across chunks, up to the last value
+    cfl_roaring_clear(&local);
+    TEST_ASSERT(cfl_roaring_addRange(&local, 0xFFFF0000 - 5, 0xFFFFFFFF));
+    TEST_ASSERT_EQUAL_INT(65541, (int)cfl_roaring_cardinality(&local));
+    TEST_ASSERT(cfl_roaring_contains(&local, 0xFFFEFFFB));
+    TEST_ASSERT(!cfl_roaring_contains(&local, 0xFFFEFFFA));
+    TEST_ASSERT(cfl_roaring_contains(&local, 0xFFFFFFFF));
+    TEST_ASSERT(cfl_roaring_addRange(&local, 1, 0));
+    TEST_ASSERT_EQUAL_INT(65541, (int)cfl_roaring_cardinality(&local));
+    cfl_roaring_free(&local);
+}
+
+TEST_CASE(test_cfl_roaring_operations) {
+    CFL_ROARINGP roaring1 = cfl_roaring_new();
+    CFL_ROARINGP roaring2 = cfl_roaring_new();
+    CFL_BITSETP bitset1 = cfl_bitset_new(TEST_RANGE);
+    CFL_BITSETP bitset2 = cfl_bitset_new(TEST_RANGE);
+    CFL_ROARINGP result;
+    CFL_BITSETP expected;
+
+    fill_mixed(roaring1, bitset1, 1);
+    fill_mixed(roaring2, bitset2, 2);
+    TEST_ASSERT(same_values(roaring1, bitset1));
+    TEST_ASSERT(same_values(roaring2, bitset2));
+
+    result = cfl_roaring_clone(roaring1);
+    TEST_ASSERT(cfl_roaring_equals(result, roaring1));
+    TEST_ASSERT(!cfl_roaring_equals(result, roaring2));
+    TEST_ASSERT(cfl_roaring_or(result, roaring2));
+    expected = cfl_bitset_clone(bitset1);
+    cfl_bitset_or(expected, bitset2);
+    TEST_ASSERT(same_values(result, expected));
+    cfl_bitset_free(expected);
+    cfl_roaring_free(result);
+
+    result = cfl_roaring_clone(roaring1);
+    TEST_ASSERT(cfl_roaring_and(result, roaring2));
+    expected = cfl_bitset_clone(bitset1);
+    cfl_bitset_and(expected, bitset2);
+    TEST_ASSERT(same_values(result, expected));
+    TEST_ASSERT(cfl_roaring_cardinality(result) == cfl_bitset_andCount(bitset1, bitset2));
+    cfl_bitset_free(expected);
+
+    // Optimizing changes the containers but not the values
+    TEST_ASSERT(cfl_roaring_optimize(roaring1));
+    TEST_ASSERT(same_values(roaring1, bitset1));
+    TEST_ASSERT(cfl_roaring_and(result, roaring1));
+    TEST_ASSERT(cfl_roaring_and(roaring1, roaring2));
+    TEST_ASSERT(cfl_roaring_equals(result, roaring1));
+
+    // Operations with an empty bitmap
+    cfl_roaring_clear(result);
+    TEST_ASSERT(cfl_roaring_or(result, roaring2));
+    TEST_ASSERT(cfl_roaring_equals(result, roaring2));
+    cfl_roaring_clear(roaring1);
+    TEST_ASSERT(cfl_roaring_and(result, roaring1));
+    TEST_ASSERT(cfl_roaring_isEmpty(result));
+    cfl_roaring_free(result);
+
+    cfl_roaring_free(roaring1);
+    cfl_roaring_free(roaring2);
+    cfl_bitset_free(bitset1);
+    cfl_bitset_free(bitset2);
+}
+
+TEST_CASE(test_cfl_roaring_serialize) {
+    CFL_ROARINGP roaring = cfl_roaring_new();
+    CFL_BITSETP bitset = cfl_bitset_new(TEST_RANGE);
+    CFL_BUFFERP buffer = cfl_buffer_new();
+    CFL_ROARINGP copy;
+    CFL_UINT32 length;
+
+    fill_mixed(roaring, bitset, 3);
+    TEST_ASSERT(cfl_roaring_optimize(roaring));
+    TEST_ASSERT(cfl_roaring_serialize(roaring, buffer));
+    length = cfl_buffer_length(buffer);
+    cfl_buffer_flip(buffer);
+    copy = cfl_roaring_deserialize(buffer);
+    TEST_ASSERT(copy != NULL);
+    TEST_ASSERT(cfl_roaring_equals(copy, roaring));
+    TEST_ASSERT(same_values(copy, bitset));
+    TEST_ASSERT_EQUAL_INT(0, (int)cfl_buffer_remaining(buffer));
+    cfl_roaring_free(copy);
+
+    // Truncated data is rejected
+    cfl_buffer_setLength(buffer, length - 1);
+    cfl_buffer_rewind(buffer);
+    TEST_ASSERT(cfl_roaring_deserialize(buffer) == NULL);
+
+    // One million values in runs take a few bytes
+    cfl_roaring_clear(roaring);
+    TEST_ASSERT(cfl_roaring_addRange(roaring, 1000, 500999));
+    TEST_ASSERT(cfl_roaring_addRange(roaring, 600000, 1099999));
+    TEST_ASSERT(cfl_roaring_cardinality(roaring) == 1000000);
+    cfl_buffer_reset(buffer);
+    TEST_ASSERT(cfl_roaring_serialize(roaring, buffer));
+    TEST_ASSERT(cfl_buffer_length(buffer) < 256);
+    cfl_buffer_flip(buffer);
+    copy = cfl_roaring_deserialize(buffer);
+    TEST_ASSERT(copy != NULL);
+    TEST_ASSERT(cfl_roaring_equals(copy, roaring));
+    cfl_roaring_free(copy);
+
+    cfl_buffer_free(buffer);
+    cfl_roaring_free(roaring);
+    cfl_bitset_free(bitset);
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_roaring_add_remove);
+    RUN_TEST(test_cfl_roaring_operations);
+    RUN_TEST(test_cfl_roaring_serialize);
+TEST_SUITE_END()
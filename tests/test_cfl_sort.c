@@ -0,0 +1,126 @@
+#include "cfl_test.h"
+#include "cfl_sort.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define COUNT 5000
+
+typedef struct {
+    int key;
+    int seq;
+    char padding[20];
+} RECORD;
+
+static int compare_ints(const void *a, const void *b) {
+    int i1 = *(const int *)a;
+    int i2 = *(const int *)b;
+    return i1 < i2 ? -1 : (i1 > i2 ? 1 : 0);
+}
+
+static int compare_records(const void *a, const void *b) {
+    return compare_ints(&((const RECORD *)a)->key, &((const RECORD *)b)->key);
+}
+
+static int is_sorted(const int *values, int count) {
+    int i;
+    for (i = 1; i < count; i++) {
+        if (values[i - 1] > values[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Fills the values with one of several patterns: random, sorted, reversed, few distinct, organ pipe and equal
+static void fill(int *values, int count, int pattern) {
+    int i;
+    for (i = 0; i < count; i++) {
+        switch (pattern) {
+            case 0: values[i] = rand() - RAND_MAX / 2; break;
+            case 1: values[i] = i; break;
+            case 2: values[i] = count - i; break;
+            case 3: values[i] = rand() % 4; break;
+            case 4: values[i] = i < count / 2 ? i : count - i; break;
+            default: values[i] = 7; break;
+        }
+    }
+}
+
+TEST_CASE(test_cfl_sort_patterns) {
+    static int values[COUNT];
+    static int copy[COUNT];
+    static int original[COUNT];
+    int pattern;
+    int count;
+
+    srand(42);
+    for (pattern = 0; pattern < 6; pattern++) {
+        for (count = 0; count <= COUNT; count = count * 3 + 1) {
+            fill(original, count, pattern);
+            memcpy(values, original, count * sizeof(int));
+            memcpy(copy, original, count * sizeof(int));
+            cfl_sort(values, count, sizeof(int), compare_ints);
+            TEST_ASSERT(is_sorted(values, count));
+            TEST_ASSERT(cfl_sort_stable(copy, count, sizeof(int), compare_ints));
+            TEST_ASSERT(memcmp(values, copy, count * sizeof(int)) == 0);
+            memcpy(copy, original, count * sizeof(int));
+            TEST_ASSERT(cfl_sort_radix(copy, count, sizeof(int), 0, sizeof(int), CFL_SORT_KEY_SIGNED));
+            TEST_ASSERT(memcmp(values, copy, count * sizeof(int)) == 0);
+        }
+    }
+}
+
+TEST_CASE(test_cfl_sort_records) {
+    static RECORD records[COUNT];
+    static RECORD copy[COUNT];
+    int i;
+
+    for (i = 0; i < COUNT; i++) {
+        records[i].key = rand() % 100;
+        records[i].seq = i;
+    }
+    memcpy(copy, records, sizeof(records));
+    cfl_sort(records, COUNT, sizeof(RECORD), compare_records);
+    for (i = 1; i < COUNT; i++) {
+        TEST_ASSERT(records[i - 1].key <= records[i].key);
+    }
+
+    // equal keys keep their original order
+    memcpy(records, copy, sizeof(records));
+    TEST_ASSERT(cfl_sort_stable(records, COUNT, sizeof(RECORD), compare_records));
+    for (i = 1; i < COUNT; i++) {
+        TEST_ASSERT(records[i - 1].key < records[i].key ||
+                    (records[i - 1].key == records[i].key && records[i - 1].seq < records[i].seq));
+    }
+    memcpy(records, copy, sizeof(records));
+    TEST_ASSERT(cfl_sort_radix(copy, COUNT, sizeof(RECORD), 0, sizeof(int), CFL_SORT_KEY_UNSIGNED));
+    TEST_ASSERT(cfl_sort_stable(records, COUNT, sizeof(RECORD), compare_records));
+    TEST_ASSERT(memcmp(records, copy, sizeof(records)) == 0);
+}
+
+TEST_CASE(test_cfl_sort_radix_keys) {
+    CFL_INT64 signedKeys[] = { 5, -1, 0, CFL_INT64_MAX, -CFL_INT64_MAX - 1, -300, 300 };
+    CFL_INT64 signedSorted[] = { -CFL_INT64_MAX - 1, -300, -1, 0, 5, 300, CFL_INT64_MAX };
+    CFL_UINT16 unsignedKeys[] = { 65535, 1, 256, 0, 255 };
+    CFL_UINT16 unsignedSorted[] = { 0, 1, 255, 256, 65535 };
+    char names[][6] = { "pear", "apple", "fig", "apply", "app" };
+    char namesSorted[][6] = { "app", "apple", "apply", "fig", "pear" };
+
+    TEST_ASSERT(cfl_sort_radix(signedKeys, 7, sizeof(CFL_INT64), 0, sizeof(CFL_INT64), CFL_SORT_KEY_SIGNED));
+    TEST_ASSERT(memcmp(signedKeys, signedSorted, sizeof(signedKeys)) == 0);
+    TEST_ASSERT(cfl_sort_radix(unsignedKeys, 5, sizeof(CFL_UINT16), 0, sizeof(CFL_UINT16), CFL_SORT_KEY_UNSIGNED));
+    TEST_ASSERT(memcmp(unsignedKeys, unsignedSorted, sizeof(unsignedKeys)) == 0);
+    TEST_ASSERT(cfl_sort_radix(names, 5, 6, 0, 6, CFL_SORT_KEY_BYTES));
+    TEST_ASSERT(memcmp(names, namesSorted, sizeof(names)) == 0);
+
+    // invalid keys
+    TEST_ASSERT(!cfl_sort_radix(names, 5, 6, 0, 3, CFL_SORT_KEY_UNSIGNED));
+    TEST_ASSERT(!cfl_sort_radix(names, 5, 6, 4, 4, CFL_SORT_KEY_BYTES));
+    TEST_ASSERT(!cfl_sort_radix(names, 5, 6, 0, 0, CFL_SORT_KEY_BYTES));
+}
+
+TEST_SUITE_BEGIN()
+    RUN_TEST(test_cfl_sort_patterns);
+    RUN_TEST(test_cfl_sort_records);
+    RUN_TEST(test_cfl_sort_radix_keys);
+TEST_SUITE_END()